@@ -35,8 +35,10 @@
 #include <arch/arm.h>
 #include <string.h>
 #include <stdlib.h>
+#include <err.h>
 #include <limits.h>
 #include <kernel/thread.h>
+#include <kernel/event.h>
 #include <arch/ops.h>
 
 #include <dev/flash.h>
@@ -56,6 +58,9 @@
 #include <boot_device.h>
 #include <boot_verifier.h>
 #include <image_verify.h>
+#if WITH_DLOG
+#include <lib/dlog.h>
+#endif
 
 #if DEVICE_TREE
 #include <libfdt.h>
@@ -80,7 +85,10 @@ extern int get_target_boot_params(const char *cmdline, const char *part,
 
 void write_device_info_mmc(device_info *dev);
 void write_device_info_flash(device_info *dev);
+void write_device_info(device_info *dev);
+void commit_device_info(void);
 static int aboot_save_boot_hash_mmc(uint32_t image_addr, uint32_t image_size);
+void aboot_display_init_join(void);
 
 /* fastboot command function pointer */
 typedef void (*fastboot_cmd_fn) (const char *, void *, unsigned);
@@ -159,6 +167,28 @@ static int auth_kernel_img = 0;
 
 static device_info device = {DEVICE_MAGIC, 0, 0, 0, 0, {0}};
 
+/*
+ * write_device_info() only marks the in-RAM copy dirty, commit_device_info()
+ * writes it out at boot handoff and before fastboot reboots. Fastboot
+ * settings, lock and tamper state are committed right away, the default
+ * record written on first boot waits for the next commit.
+ */
+static bool device_dirty;
+/* what storage holds, so a commit that changes nothing skips the write */
+static device_info device_committed;
+
+#if DISPLAY_SPLASH_SCREEN && DISPLAY_INIT_ASYNC
+/*
+ * Panel power-on is mostly fixed delays, so it runs on its own thread
+ * while the main thread reads the boot image. The display thread does
+ * not touch storage: it draws the built-in logo and the splash partition
+ * image, if any, is drawn once the thread has been joined.
+ */
+static thread_t *display_thread;
+static event_t display_init_done;
+static volatile bool display_init_async;
+#endif
+
 struct atag_ptbl_entry
 {
 	char name[16];
@@ -599,6 +629,9 @@ void boot_linux(void *kernel, unsigned *tags,
 
 	ramdisk = (void *)PA((addr_t)ramdisk);
 
+	/* The cmdline carries the panel selection, wait for the display */
+	aboot_display_init_join();
+
 	final_cmdline = update_cmdline((const char*)cmdline);
 
 #if DEVICE_TREE
@@ -619,6 +652,9 @@ void boot_linux(void *kernel, unsigned *tags,
 
 	free(final_cmdline);
 
+	/* Last chance, devinfo is write protected from here on */
+	commit_device_info();
+
 #if VERIFIED_BOOT
 	/* Write protect the device info */
 	if (mmc_write_protect("devinfo", 1))
@@ -645,6 +681,15 @@ void boot_linux(void *kernel, unsigned *tags,
 	/* do any platform specific cleanup before kernel entry */
 	platform_uninit();
 
+	/*
+	 * Last output before the jump: the log thread won't run again, and
+	 * nothing drains buffered console output once interrupts are off.
+	 */
+#if WITH_DLOG
+	dlog_flush();
+#endif
+	_dflush();
+
 	arch_disable_cache(UCACHE);
 
 #if ARM_WITH_MMU
@@ -687,14 +732,26 @@ BUF_DMA_ALIGN(buf, BOOT_IMG_MAX_PAGE_SIZE); //Equal to max-supported pagesize
 BUF_DMA_ALIGN(dt_buf, BOOT_IMG_MAX_PAGE_SIZE);
 #endif
 
-static void verify_signed_bootimg(uint32_t bootimg_addr, uint32_t bootimg_size)
+/* Hash the boot image signature is checked against */
+static crypto_auth_alg_type bootimg_auth_algo(void)
 {
-	int ret;
-#if IMAGE_VERIF_ALGO_SHA1
-	uint32_t auth_algo = CRYPTO_AUTH_ALG_SHA1;
+#if VERIFIED_BOOT
+	return CRYPTO_AUTH_ALG_SHA256;
+#elif IMAGE_VERIF_ALGO_SHA1
+	return CRYPTO_AUTH_ALG_SHA1;
 #else
-	uint32_t auth_algo = CRYPTO_AUTH_ALG_SHA256;
+	return CRYPTO_AUTH_ALG_SHA256;
 #endif
+}
+
+/*
+ * ctx, if not NULL, holds the hash of the image, streamed in while it was
+ * read. Otherwise the image is hashed here.
+ */
+static void verify_signed_bootimg(uint32_t bootimg_addr, uint32_t bootimg_size,
+				  struct hash_ctx *ctx)
+{
+	int ret;
 
 	/* Assume device is rooted at this time. */
 	device.is_tampered = 1;
@@ -704,20 +761,25 @@ static void verify_signed_bootimg(uint32_t bootimg_addr, uint32_t bootimg_size)
 #if VERIFIED_BOOT
 	if(boot_into_recovery)
 	{
-		ret = boot_verify_image((unsigned char *)bootimg_addr,
-				bootimg_size, "recovery");
+		ret = boot_verify_image_hashed((unsigned char *)bootimg_addr,
+				bootimg_size, "recovery", ctx);
 	}
 	else
 	{
-		ret = boot_verify_image((unsigned char *)bootimg_addr,
-				bootimg_size, "boot");
+		ret = boot_verify_image_hashed((unsigned char *)bootimg_addr,
+				bootimg_size, "boot", ctx);
 	}
 	boot_verify_print_state();
 #else
-	ret = image_verify((unsigned char *)bootimg_addr,
-					   (unsigned char *)(bootimg_addr + bootimg_size),
-					   bootimg_size,
-					   auth_algo);
+	if (ctx)
+		ret = image_verify_hashed(ctx,
+					  (unsigned char *)(bootimg_addr + bootimg_size),
+					  bootimg_auth_algo());
+	else
+		ret = image_verify((unsigned char *)bootimg_addr,
+						   (unsigned char *)(bootimg_addr + bootimg_size),
+						   bootimg_size,
+						   bootimg_auth_algo());
 #endif
 	dprintf(INFO, "Authenticating boot image: done return value = %d\n", ret);
 
@@ -734,7 +796,8 @@ static void verify_signed_bootimg(uint32_t bootimg_addr, uint32_t bootimg_size)
 
 	if(device.is_tampered)
 	{
-		write_device_info_mmc(&device);
+		write_device_info(&device);
+		commit_device_info();
 	#ifdef TZ_TAMPER_FUSE
 		set_tamper_fuse_cmd();
 	#endif
@@ -751,6 +814,7 @@ static void verify_signed_bootimg(uint32_t bootimg_addr, uint32_t bootimg_size)
 		{
 			dprintf(CRITICAL,
 					"Device verification failed. Rebooting into recovery.\n");
+			commit_device_info();
 			reboot_device(RECOVERY_MODE);
 		}
 		else
@@ -832,6 +896,148 @@ void boot_verifier_init()
 	}
 }
 
+/* Size of the pieces a signed boot image is read, and hashed, in */
+#define BOOT_IMG_READ_CHUNK (4 * 1024 * 1024)
+
+typedef void (*boot_img_chunk_cb)(unsigned char *chunk, unsigned len, void *arg);
+
+/*
+ * Read a boot image from eMMC/UFS in BOOT_IMG_READ_CHUNK pieces. All the
+ * pieces are queued on the storage worker up front and handed to chunk_cb
+ * (may be NULL) in order, each as soon as it has landed, so the caller
+ * can work on the image while the rest of it is still being read.
+ */
+static int read_boot_image_chunked(unsigned long long data_addr, unsigned char *image,
+				   unsigned size, boot_img_chunk_cb chunk_cb, void *arg)
+{
+#if MMC_SDHCI_SUPPORT
+	struct boot_img_chunk {
+		struct mmc_async_req req;
+		work_group_t group;
+	} *chunks;
+	unsigned count = (size + BOOT_IMG_READ_CHUNK - 1) / BOOT_IMG_READ_CHUNK;
+	unsigned queued;
+	unsigned off;
+	unsigned len;
+	unsigned i;
+	int ret = 0;
+
+	chunks = malloc(count * sizeof(*chunks));
+	if (!chunks)
+	{
+		dprintf(CRITICAL, "ERROR: No memory for boot image read requests\n");
+		return -1;
+	}
+
+	for (queued = 0; queued < count; queued++)
+	{
+		off = queued * BOOT_IMG_READ_CHUNK;
+		len = MIN(size - off, BOOT_IMG_READ_CHUNK);
+
+		work_group_init(&chunks[queued].group);
+		if (mmc_read_async(&chunks[queued].req, mmc_get_lun(), data_addr + off,
+				   (uint32_t *) (image + off), len, &chunks[queued].group))
+		{
+			ret = -1;
+			break;
+		}
+	}
+
+	/* Join everything that was queued, even after a failure */
+	for (i = 0; i < queued; i++)
+	{
+		off = i * BOOT_IMG_READ_CHUNK;
+		len = MIN(size - off, BOOT_IMG_READ_CHUNK);
+
+		if (work_group_wait(&chunks[i].group, INFINITE_TIME) != NO_ERROR)
+			ret = -1;
+		else if (!ret && chunk_cb)
+			chunk_cb(image + off, len, arg);
+	}
+
+	free(chunks);
+
+	return ret;
+#else
+	if (mmc_read(data_addr, (uint32_t *) image, size))
+		return -1;
+
+	if (chunk_cb)
+		chunk_cb(image, size, arg);
+
+	return 0;
+#endif
+}
+
+/* Hash each piece of the boot image as soon as it has been read */
+static void bootimg_hash_chunk(unsigned char *chunk, unsigned len, void *arg)
+{
+	if (hash_update((struct hash_ctx *) arg, chunk, len) != CRYPTO_SHA_ERR_NONE)
+		dprintf(CRITICAL, "ERROR: Cannot hash boot image\n");
+}
+
+#if MMC_SDHCI_SUPPORT && !defined(TZ_SAVE_KERNEL_HASH)
+static int boot_ranges_overlap(uint32_t a, unsigned a_len, uint32_t b, unsigned b_len)
+{
+	return a < b + b_len && b < a + a_len;
+}
+#endif
+
+/*
+ * Read an unsigned boot image of size bytes in one sg transfer, the kernel
+ * and ramdisk going straight to their load addresses instead of through
+ * image and memmove. The header and device tree pages land in image at
+ * their usual offsets. Returns 1 without reading anything when the load
+ * addresses do not allow it, the caller then reads the image staged.
+ */
+static int read_boot_image_sg(unsigned long long data_addr, unsigned char *image,
+			      struct boot_img_hdr *hdr, unsigned page_size,
+			      unsigned kernel_actual, unsigned ramdisk_actual, unsigned size)
+{
+#if MMC_SDHCI_SUPPORT && !defined(TZ_SAVE_KERNEL_HASH)
+	struct mmc_sg sg[4];
+	uint32_t sg_cnt = 0;
+	unsigned tail = size - page_size - kernel_actual - ramdisk_actual;
+
+	/* Segments are DMA'd, each has to own its cache lines */
+	if (!IS_CACHE_LINE_ALIGNED(hdr->kernel_addr) || !IS_CACHE_LINE_ALIGNED(hdr->ramdisk_addr))
+		return 1;
+
+	if (boot_ranges_overlap(hdr->kernel_addr, kernel_actual, (uint32_t) image, size) ||
+		boot_ranges_overlap(hdr->ramdisk_addr, ramdisk_actual, (uint32_t) image, size) ||
+		boot_ranges_overlap(hdr->kernel_addr, kernel_actual, hdr->ramdisk_addr, ramdisk_actual))
+		return 1;
+
+	sg[sg_cnt].addr = image;
+	sg[sg_cnt++].len = page_size;
+
+	if (kernel_actual)
+	{
+		sg[sg_cnt].addr = (void *) hdr->kernel_addr;
+		sg[sg_cnt++].len = kernel_actual;
+	}
+
+	if (ramdisk_actual)
+	{
+		sg[sg_cnt].addr = (void *) hdr->ramdisk_addr;
+		sg[sg_cnt++].len = ramdisk_actual;
+	}
+
+	if (tail)
+	{
+		sg[sg_cnt].addr = image + page_size + kernel_actual + ramdisk_actual;
+		sg[sg_cnt++].len = tail;
+	}
+
+	if (mmc_read_sg(data_addr, sg, sg_cnt))
+		return -1;
+
+	return 0;
+#else
+	return 1;
+#endif
+}
+
 int boot_linux_from_mmc(void)
 {
 	struct boot_img_hdr *hdr = (void*) buf;
@@ -846,6 +1052,7 @@ int boot_linux_from_mmc(void)
 	unsigned ramdisk_actual;
 	unsigned imagesize_actual;
 	unsigned second_actual = 0;
+	int staged;
 
 #if DEVICE_TREE
 	struct dt_table *table;
@@ -856,6 +1063,7 @@ int boot_linux_from_mmc(void)
 #endif
 	BUF_DMA_ALIGN(kbuf, BOOT_IMG_MAX_PAGE_SIZE);
 	struct kernel64_hdr *kptr = (void*) kbuf;
+	struct hash_ctx bootimg_hash;
 
 	if (check_format_bit())
 		boot_into_recovery = 1;
@@ -993,8 +1201,15 @@ int boot_linux_from_mmc(void)
 			return -1;
 		}
 
-		/* Read image without signature */
-		if (mmc_read(ptn + offset, (void *)image_addr, imagesize_actual))
+		if (hash_init(&bootimg_hash, bootimg_auth_algo()) != CRYPTO_SHA_ERR_NONE)
+		{
+			dprintf(CRITICAL, "ERROR: Cannot start boot image hash\n");
+			return -1;
+		}
+
+		/* Read image without signature, hashing it on the way */
+		if (read_boot_image_chunked(ptn + offset, image_addr, imagesize_actual,
+					    bootimg_hash_chunk, &bootimg_hash))
 		{
 			dprintf(CRITICAL, "ERROR: Cannot read boot image\n");
 				return -1;
@@ -1018,7 +1233,7 @@ int boot_linux_from_mmc(void)
 			return -1;
 		}
 
-		verify_signed_bootimg((uint32_t)image_addr, imagesize_actual);
+		verify_signed_bootimg((uint32_t)image_addr, imagesize_actual, &bootimg_hash);
 
 		/* Move kernel, ramdisk and device tree to correct address */
 		memmove((void*) hdr->kernel_addr, (char *)(image_addr + page_size), hdr->kernel_size);
@@ -1095,8 +1310,13 @@ int boot_linux_from_mmc(void)
 
 		offset = 0;
 
-		/* Load the entire boot image */
-		if (mmc_read(ptn + offset, (void *)image_addr, imagesize_actual)) {
+		/* Load the entire boot image, kernel and ramdisk in place when possible */
+		rcode = read_boot_image_sg(ptn + offset, image_addr, hdr, page_size,
+					   kernel_actual, ramdisk_actual, imagesize_actual);
+		staged = rcode > 0;
+		if (staged)
+			rcode = mmc_read(ptn + offset, (void *)image_addr, imagesize_actual);
+		if (rcode) {
 			dprintf(CRITICAL, "ERROR: Cannot read boot image\n");
 					return -1;
 		}
@@ -1110,8 +1330,11 @@ int boot_linux_from_mmc(void)
 		#endif /* TZ_SAVE_KERNEL_HASH */
 
 		/* Move kernel, ramdisk and device tree to correct address */
-		memmove((void*) hdr->kernel_addr, (char *)(image_addr + page_size), hdr->kernel_size);
-		memmove((void*) hdr->ramdisk_addr, (char *)(image_addr + page_size + kernel_actual), hdr->ramdisk_size);
+		if (staged)
+		{
+			memmove((void*) hdr->kernel_addr, (char *)(image_addr + page_size), hdr->kernel_size);
+			memmove((void*) hdr->ramdisk_addr, (char *)(image_addr + page_size + kernel_actual), hdr->ramdisk_size);
+		}
 
 		#if DEVICE_TREE
 		if(hdr->dt_size) {
@@ -1312,7 +1535,7 @@ int boot_linux_from_flash(void)
 			return -1;
 		}
 
-		verify_signed_bootimg((uint32_t)image_addr, imagesize_actual);
+		verify_signed_bootimg((uint32_t)image_addr, imagesize_actual, NULL);
 
 		/* Move kernel and ramdisk to correct address */
 		memmove((void*) hdr->kernel_addr, (char *)(image_addr + page_size), hdr->kernel_size);
@@ -1331,7 +1554,8 @@ int boot_linux_from_flash(void)
 		/* Make sure everything from scratch address is read before next step!*/
 		if(device.is_tampered)
 		{
-			write_device_info_flash(&device);
+			write_device_info(&device);
+			commit_device_info();
 		}
 #if USE_PCOM_SECBOOT
 		set_tamper_flag(device.is_tampered);
@@ -1441,6 +1665,7 @@ void write_device_info_mmc(device_info *dev)
 	int index = INVALID_PTN;
 	uint32_t blocksize;
 	uint8_t lun = 0;
+	bool legacy;
 
 #if VERIFIED_BOOT
 	index = partition_get_index("devinfo");
@@ -1454,6 +1679,19 @@ void write_device_info_mmc(device_info *dev)
 		return;
 	}
 
+	/* The legacy block is only rewritten for lock state changes, which
+	 * keeps it meaningful to a bootloader without journal support. It is
+	 * written before the journal record that names it, so stopping in
+	 * between leaves the legacy block winning on the next load.
+	 */
+	legacy = dev->is_unlocked != device_committed.is_unlocked ||
+		dev->is_tampered != device_committed.is_tampered ||
+		dev->is_verified != device_committed.is_verified ||
+		memcmp(device_committed.magic, DEVICE_MAGIC, DEVICE_MAGIC_SIZE);
+
+	if (!legacy && !devinfo_journal_store(dev, false))
+		return;
+
 	lun = partition_get_lun(index);
 	mmc_set_lun(lun);
 
@@ -1472,6 +1710,9 @@ void write_device_info_mmc(device_info *dev)
 		dprintf(CRITICAL, "ERROR: Cannot write device info\n");
 		return;
 	}
+
+	if (legacy)
+		devinfo_journal_store(dev, true);
 }
 
 void read_device_info_mmc(device_info *dev)
@@ -1494,6 +1735,12 @@ void read_device_info_mmc(device_info *dev)
 		return;
 	}
 
+	if (!devinfo_journal_load(dev))
+	{
+		memcpy(&device_committed, dev, sizeof(device_info));
+		return;
+	}
+
 	mmc_set_lun(partition_get_lun(index));
 
 	size = partition_get_size(index);
@@ -1522,7 +1769,12 @@ void read_device_info_mmc(device_info *dev)
 		info->is_tampered = 0;
 		info->charger_screen_enabled = 0;
 
-		write_device_info_mmc(info);
+		/* written at the next commit, not on the boot path */
+		device_dirty = true;
+	}
+	else
+	{
+		memcpy(&device_committed, info, sizeof(device_info));
 	}
 	memcpy(dev, info, sizeof(device_info));
 }
@@ -1587,21 +1839,43 @@ void read_device_info_flash(device_info *dev)
 		memcpy(info->magic, DEVICE_MAGIC, DEVICE_MAGIC_SIZE);
 		info->is_unlocked = 0;
 		info->is_tampered = 0;
-		write_device_info_flash(info);
+		device_dirty = true;
+	}
+	else
+	{
+		memcpy(&device_committed, info, sizeof(device_info));
 	}
 	memcpy(dev, info, sizeof(device_info));
 }
 
 void write_device_info(device_info *dev)
 {
+	if (dev != &device)
+		memcpy(&device, dev, sizeof(device_info));
+
+	device_dirty = true;
+}
+
+void commit_device_info(void)
+{
+	if (!device_dirty)
+		return;
+
+	device_dirty = false;
+
+	if (!memcmp(&device, &device_committed, sizeof(device_info)))
+		return;
+
 	if(target_is_emmc_boot())
 	{
-		write_device_info_mmc(dev);
+		write_device_info_mmc(&device);
 	}
 	else
 	{
-		write_device_info_flash(dev);
+		write_device_info_flash(&device);
 	}
+
+	memcpy(&device_committed, &device, sizeof(device_info));
 }
 
 void read_device_info(device_info *dev)
@@ -1621,6 +1895,12 @@ void reset_device_info()
 	dprintf(ALWAYS, "reset_device_info called.");
 	device.is_tampered = 0;
 	write_device_info(&device);
+	commit_device_info();
+}
+
+bool device_is_unlocked(void)
+{
+	return device.is_unlocked;
 }
 
 void set_device_root()
@@ -1628,6 +1908,7 @@ void set_device_root()
 	dprintf(ALWAYS, "set_device_root called.");
 	device.is_tampered = 1;
 	write_device_info(&device);
+	commit_device_info();
 }
 
 #if DEVICE_TREE
@@ -1752,7 +2033,7 @@ void cmd_boot(const char *arg, void *data, unsigned sz)
 		/* Pass size excluding signature size, otherwise we would try to
 		 * access signature beyond its length
 		 */
-		verify_signed_bootimg((uint32_t)data, (image_actual - sig_actual));
+		verify_signed_bootimg((uint32_t)data, (image_actual - sig_actual), NULL);
 
 	/*
 	 * Update the kernel/ramdisk/tags address if the boot image header
@@ -2336,14 +2617,18 @@ void cmd_continue(const char *arg, void *data, unsigned sz)
 void cmd_reboot(const char *arg, void *data, unsigned sz)
 {
 	dprintf(INFO, "rebooting the device\n");
+	commit_device_info();
 	fastboot_okay("");
+	fastboot_flush();
 	reboot_device(0);
 }
 
 void cmd_reboot_bootloader(const char *arg, void *data, unsigned sz)
 {
 	dprintf(INFO, "rebooting the device\n");
+	commit_device_info();
 	fastboot_okay("");
+	fastboot_flush();
 	reboot_device(FASTBOOT_MODE);
 }
 
@@ -2352,6 +2637,7 @@ void cmd_oem_enable_charger_screen(const char *arg, void *data, unsigned size)
 	dprintf(INFO, "Enabling charger screen check\n");
 	device.charger_screen_enabled = 1;
 	write_device_info(&device);
+	commit_device_info();
 	fastboot_okay("");
 }
 
@@ -2360,6 +2646,7 @@ void cmd_oem_disable_charger_screen(const char *arg, void *data, unsigned size)
 	dprintf(INFO, "Disabling charger screen check\n");
 	device.charger_screen_enabled = 0;
 	write_device_info(&device);
+	commit_device_info();
 	fastboot_okay("");
 }
 
@@ -2370,6 +2657,7 @@ void cmd_oem_select_display_panel(const char *arg, void *data, unsigned size)
 		strlcpy(device.display_panel, arg,
 			sizeof(device.display_panel));
 	write_device_info(&device);
+	commit_device_info();
 	fastboot_okay("");
 }
 
@@ -2381,6 +2669,7 @@ void cmd_oem_unlock(const char *arg, void *data, unsigned sz)
 		device.is_unlocked = 1;
 		device.is_verified = 0;
 		write_device_info(&device);
+		commit_device_info();
 	}
 	fastboot_okay("");
 }
@@ -2393,6 +2682,7 @@ void cmd_oem_lock(const char *arg, void *data, unsigned sz)
 		device.is_unlocked = 0;
 		device.is_verified = 0;
 		write_device_info(&device);
+		commit_device_info();
 	}
 	fastboot_okay("");
 }
@@ -2405,6 +2695,7 @@ void cmd_oem_verified(const char *arg, void *data, unsigned sz)
 		device.is_unlocked = 0;
 		device.is_verified = 1;
 		write_device_info(&device);
+		commit_device_info();
 	}
 	fastboot_okay("");
 }
@@ -2423,6 +2714,39 @@ void cmd_oem_devinfo(const char *arg, void *data, unsigned sz)
 	fastboot_okay("");
 }
 
+#if WITH_DLOG
+static void cmd_oem_dlog_line(const char *text, void *arg)
+{
+	char response[MAX_RSP_SIZE - 4];
+	size_t len;
+
+	/* one INFO packet per line, long lines split to fit a response */
+	while (*text) {
+		for (len = 0; text[len] && text[len] != '\n' && len < sizeof(response) - 1; len++)
+			;
+
+		memcpy(response, text, len);
+		response[len] = '\0';
+		fastboot_info(response);
+
+		text += len;
+		if (*text == '\n')
+			text++;
+	}
+}
+
+void cmd_oem_dlog(const char *arg, void *data, unsigned sz)
+{
+	char response[MAX_RSP_SIZE - 4];
+
+	dlog_dump(&cmd_oem_dlog_line, NULL);
+
+	snprintf(response, sizeof(response), "%u records dropped", dlog_dropped());
+	fastboot_info(response);
+	fastboot_okay("");
+}
+#endif
+
 void cmd_preflash(const char *arg, void *data, unsigned sz)
 {
 	fastboot_okay("");
@@ -2495,6 +2819,37 @@ err:
 	return NULL;
 }
 
+#if MMC_SDHCI_SUPPORT && DISPLAY_SPLASH_SCREEN
+/* Splash header block queued with the early boot reads */
+static struct mmc_async_req splash_hdr_req;
+static struct fbimage *splash_hdr;
+
+/* Start reading the splash header, splash_screen_mmc() collects it */
+static void splash_screen_prefetch()
+{
+	int index;
+	unsigned long long ptn;
+	uint32_t readsize;
+
+	index = partition_get_index("splash");
+	ptn = partition_get_offset(index);
+	if (ptn == 0 || splash_hdr)
+		return;
+
+	readsize = ROUNDUP(sizeof(splash_hdr->header), mmc_get_device_blocksize());
+	splash_hdr = (struct fbimage *)memalign(CACHE_LINE, ROUNDUP(readsize, CACHE_LINE));
+	if (!splash_hdr)
+		return;
+
+	if (mmc_read_async(&splash_hdr_req, partition_get_lun(index), ptn,
+			   (uint32_t *) splash_hdr, readsize, mmc_boot_reads()))
+	{
+		free(splash_hdr);
+		splash_hdr = NULL;
+	}
+}
+#endif
+
 struct fbimage* splash_screen_mmc()
 {
 	int index = INVALID_PTN;
@@ -2505,6 +2860,21 @@ struct fbimage* splash_screen_mmc()
 	uint32_t readsize;
 	uint32_t ptn_size;
 
+#if MMC_SDHCI_SUPPORT
+	/* No synchronous read while the early reads are in flight */
+	mmc_boot_reads_wait();
+#if DISPLAY_SPLASH_SCREEN
+	if (splash_hdr)
+	{
+		if (!splash_hdr_req.ret)
+			logo = splash_hdr;
+		else
+			free(splash_hdr);
+		splash_hdr = NULL;
+	}
+#endif
+#endif
+
 	index = partition_get_index("splash");
 	if (index == 0) {
 		dprintf(CRITICAL, "ERROR: splash Partition table not found\n");
@@ -2521,12 +2891,15 @@ struct fbimage* splash_screen_mmc()
 	blocksize = mmc_get_device_blocksize();
 	readsize = ROUNDUP(sizeof(logo->header), blocksize);
 
-	logo = (struct fbimage *)memalign(CACHE_LINE, ROUNDUP(readsize, CACHE_LINE));
-	ASSERT(logo);
+	if (!logo)
+	{
+		logo = (struct fbimage *)memalign(CACHE_LINE, ROUNDUP(readsize, CACHE_LINE));
+		ASSERT(logo);
 
-	if (mmc_read(ptn, (uint32_t *) logo, readsize)) {
-		dprintf(CRITICAL, "ERROR: Cannot read splash image header\n");
-		goto err;
+		if (mmc_read(ptn, (uint32_t *) logo, readsize)) {
+			dprintf(CRITICAL, "ERROR: Cannot read splash image header\n");
+			goto err;
+		}
 	}
 
 	if (splash_screen_check_header(logo)) {
@@ -2568,6 +2941,10 @@ err:
 
 struct fbimage* fetch_image_from_partition()
 {
+#if DISPLAY_SPLASH_SCREEN && DISPLAY_INIT_ASYNC
+	if (display_init_async)
+		return NULL;
+#endif
 	if (target_is_emmc_boot()) {
 		return splash_screen_mmc();
 	} else {
@@ -2661,6 +3038,9 @@ void aboot_fastboot_register_commands(void)
 											{"oem enable-charger-screen", cmd_oem_enable_charger_screen},
 											{"oem disable-charger-screen", cmd_oem_disable_charger_screen},
 											{"oem select-display-panel", cmd_oem_select_display_panel},
+#if WITH_DLOG
+											{"oem dlog", cmd_oem_dlog},
+#endif
 #endif
 										  };
 
@@ -2697,6 +3077,83 @@ void aboot_fastboot_register_commands(void)
 			(const char *) panel_display_mode);
 }
 
+#if DISPLAY_SPLASH_SCREEN && DISPLAY_INIT_ASYNC
+static int aboot_display_init_thread(void *arg)
+{
+	dprintf(SPEW, "Display Init: Start\n");
+	target_display_init(device.display_panel);
+	dprintf(SPEW, "Display Init: Done\n");
+
+	event_signal(&display_init_done, true);
+	return 0;
+}
+#endif
+
+/*
+ * Queue the keystore and splash header reads on the storage worker, they
+ * run while the keys, the reboot reason and the panel are handled here.
+ * Joined at normal_boot, before the first synchronous read.
+ */
+static void aboot_boot_reads_start(void)
+{
+#if MMC_SDHCI_SUPPORT
+	if (!target_is_emmc_boot())
+		return;
+
+#if VERIFIED_BOOT
+	if (!device.is_unlocked)
+		boot_verify_keystore_prefetch();
+#endif
+#if DISPLAY_SPLASH_SCREEN
+	splash_screen_prefetch();
+#endif
+#endif
+}
+
+static void aboot_display_init_start(void)
+{
+#if DISPLAY_SPLASH_SCREEN
+#if DISPLAY_INIT_ASYNC
+	event_init(&display_init_done, false, EVENT_FLAG_AUTOUNSIGNAL);
+	display_init_async = true;
+
+	display_thread = thread_create("display_init", aboot_display_init_thread,
+				       NULL, DEFAULT_PRIORITY, DEFAULT_STACK_SIZE);
+	if (display_thread) {
+		thread_resume(display_thread);
+		return;
+	}
+
+	dprintf(CRITICAL, "Failed to create display thread, init inline\n");
+	display_init_async = false;
+#endif
+	dprintf(SPEW, "Display Init: Start\n");
+	target_display_init(device.display_panel);
+	dprintf(SPEW, "Display Init: Done\n");
+#endif
+}
+
+/*
+ * Wait for the display thread started by aboot_display_init_start().
+ * Safe to call more than once, and a no-op for synchronous display init.
+ */
+void aboot_display_init_join(void)
+{
+#if DISPLAY_SPLASH_SCREEN && DISPLAY_INIT_ASYNC
+	if (!display_thread)
+		return;
+
+	event_wait(&display_init_done);
+	event_destroy(&display_init_done);
+	display_thread = NULL;
+	display_init_async = false;
+
+	/* Storage is ours again, replace the built-in logo with the splash */
+	if (fbcon_display())
+		display_image_on_screen();
+#endif
+}
+
 void aboot_init(const struct app_descriptor *app)
 {
 	unsigned reboot_mode = 0;
@@ -2718,12 +3175,10 @@ void aboot_init(const struct app_descriptor *app)
 
 	read_device_info(&device);
 
+	aboot_boot_reads_start();
+
 	/* Display splash screen if enabled */
-#if DISPLAY_SPLASH_SCREEN
-	dprintf(SPEW, "Display Init: Start\n");
-	target_display_init(device.display_panel);
-	dprintf(SPEW, "Display Init: Done\n");
-#endif
+	aboot_display_init_start();
 
 
 	target_serialno((unsigned char *) sn_buf);
@@ -2748,6 +3203,7 @@ void aboot_init(const struct app_descriptor *app)
 		}
 		else
 		{
+			commit_device_info();
 			reboot_device(DLOAD);
 			dprintf(CRITICAL,"Failed to reboot into dload mode\n");
 		}
@@ -2776,6 +3232,11 @@ void aboot_init(const struct app_descriptor *app)
 	}
 
 normal_boot:
+#if MMC_SDHCI_SUPPORT
+	if (mmc_boot_reads_wait())
+		dprintf(CRITICAL, "Early boot reads failed, read again on use\n");
+#endif
+
 	if (!boot_into_fastboot)
 	{
 		if (target_is_emmc_boot())
@@ -2810,6 +3271,7 @@ normal_boot:
 	}
 
 	/* We are here means regular boot did not happen. Start fastboot. */
+	aboot_display_init_join();
 
 	/* register aboot specific fastboot commands */
 	aboot_fastboot_register_commands();
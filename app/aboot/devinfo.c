@@ -0,0 +1,237 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <debug.h>
+#include <string.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <arch/defines.h>
+#include <mmc.h>
+#include <partition_parser.h>
+#include "devinfo.h"
+
+/*
+ * Journal of device_info records in the devinfo partition, after the
+ * legacy copy in block 0. Every record is a full snapshot in its own
+ * block, written round robin over the slots so that no single block takes
+ * all the writes. The newest record with a good CRC wins, so a torn write
+ * falls back to the previous state and the oldest record is simply
+ * overwritten, without a separate compaction pass.
+ *
+ * A bootloader without journal support only reads and writes the legacy
+ * copy. Each record carries the CRC of the legacy copy it was written
+ * against, so a legacy write made after it is seen and wins on load.
+ */
+#define DEVINFO_JOURNAL_MAGIC   0x4a495644	/* "DVIJ" */
+#define DEVINFO_JOURNAL_SLOTS   8
+
+struct devinfo_record
+{
+	uint32_t magic;
+	uint32_t crc;		/* over everything after this field */
+	uint32_t seq;
+	uint32_t len;
+	uint32_t legacy_crc;	/* legacy copy when this record was written */
+	struct device_info info;
+};
+
+static struct
+{
+	bool loaded;		/* slots have been scanned */
+	bool empty;		/* no valid record found */
+	uint32_t seq;		/* sequence number of the newest record */
+	uint32_t slot;		/* slot of the newest record */
+	uint32_t legacy_crc;	/* legacy copy as it is on storage */
+} journal;
+
+/* start is the legacy copy, the journal slots follow it */
+static int devinfo_journal_region(unsigned long long *start, uint32_t *blocksize)
+{
+#if VERIFIED_BOOT
+	int index;
+	unsigned long long ptn;
+
+	index = partition_get_index("devinfo");
+	ptn = partition_get_offset(index);
+	if (ptn == 0)
+		return -1;
+
+	*blocksize = mmc_get_device_blocksize();
+	if (partition_get_size(index) < (1 + DEVINFO_JOURNAL_SLOTS) * (unsigned long long)*blocksize)
+		return -1;
+
+	mmc_set_lun(partition_get_lun(index));
+	*start = ptn;
+
+	return 0;
+#else
+	/* devinfo lives in the last block of aboot, there is no room */
+	return -1;
+#endif
+}
+
+static uint32_t devinfo_crc(const struct device_info *info)
+{
+	return calculate_crc32((unsigned char *)info, sizeof(struct device_info));
+}
+
+static bool devinfo_record_valid(struct devinfo_record *rec)
+{
+	if (rec->magic != DEVINFO_JOURNAL_MAGIC || rec->len != sizeof(struct device_info))
+		return false;
+
+	return rec->crc == calculate_crc32((unsigned char *)&rec->seq,
+					   sizeof(*rec) - offsetof(struct devinfo_record, seq));
+}
+
+/*
+ * Load the newest device_info, from the journal or from a legacy copy
+ * written after it. Returns 0 on success, 1 if neither holds a valid
+ * record yet and -1 if the partition has no room for a journal.
+ */
+int devinfo_journal_load(struct device_info *dev)
+{
+	unsigned long long start;
+	uint32_t blocksize;
+	struct devinfo_record *rec;
+	struct devinfo_record *newest = NULL;
+	struct device_info *legacy;
+	bool legacy_valid;
+	uint8_t *buf;
+	int ret = 1;
+	int i;
+
+	if (devinfo_journal_region(&start, &blocksize))
+		return -1;
+
+	buf = memalign(CACHE_LINE, ROUNDUP((1 + DEVINFO_JOURNAL_SLOTS) * blocksize, CACHE_LINE));
+	if (!buf)
+		return -1;
+
+	/* One command for the legacy copy and all the slots */
+	if (mmc_read(start, (unsigned int *)buf, (1 + DEVINFO_JOURNAL_SLOTS) * blocksize))
+	{
+		dprintf(CRITICAL, "ERROR: Cannot read devinfo journal\n");
+		free(buf);
+		return -1;
+	}
+
+	legacy = (struct device_info *)buf;
+	legacy_valid = !memcmp(legacy->magic, DEVICE_MAGIC, DEVICE_MAGIC_SIZE);
+	journal.legacy_crc = legacy_valid ? devinfo_crc(legacy) : 0;
+
+	journal.empty = true;
+	for (i = 0; i < DEVINFO_JOURNAL_SLOTS; i++)
+	{
+		rec = (struct devinfo_record *)(buf + (1 + i) * blocksize);
+		if (!devinfo_record_valid(rec))
+			continue;
+
+		if (journal.empty || (int32_t)(rec->seq - journal.seq) > 0)
+		{
+			journal.empty = false;
+			journal.seq = rec->seq;
+			journal.slot = i;
+			newest = rec;
+		}
+	}
+	journal.loaded = true;
+
+	if (legacy_valid && (!newest || newest->legacy_crc != journal.legacy_crc))
+	{
+		memcpy(dev, legacy, sizeof(struct device_info));
+		ret = 0;
+	}
+	else if (newest)
+	{
+		memcpy(dev, &newest->info, sizeof(struct device_info));
+		ret = 0;
+	}
+
+	free(buf);
+	return ret;
+}
+
+/*
+ * Append device_info to the journal, in the slot after the newest record.
+ * legacy_written says the caller has just written dev to the legacy copy.
+ * Returns 0 on success, -1 if there is no journal or the write failed.
+ */
+int devinfo_journal_store(const struct device_info *dev, bool legacy_written)
+{
+	unsigned long long start;
+	uint32_t blocksize;
+	struct devinfo_record *rec;
+	uint32_t slot;
+	uint8_t *buf;
+	int ret = 0;
+
+	if (devinfo_journal_region(&start, &blocksize))
+		return -1;
+
+	/* Never appended blind, the slot choice depends on what is there */
+	if (!journal.loaded)
+	{
+		struct device_info tmp;
+
+		if (devinfo_journal_load(&tmp) < 0)
+			return -1;
+	}
+
+	buf = memalign(CACHE_LINE, ROUNDUP(blocksize, CACHE_LINE));
+	if (!buf)
+		return -1;
+
+	memset(buf, 0, blocksize);
+	rec = (struct devinfo_record *)buf;
+	rec->magic = DEVINFO_JOURNAL_MAGIC;
+	rec->seq = journal.empty ? 1 : journal.seq + 1;
+	rec->len = sizeof(struct device_info);
+	rec->legacy_crc = legacy_written ? devinfo_crc(dev) : journal.legacy_crc;
+	memcpy(&rec->info, dev, sizeof(struct device_info));
+	rec->crc = calculate_crc32((unsigned char *)&rec->seq,
+				   sizeof(*rec) - offsetof(struct devinfo_record, seq));
+
+	slot = journal.empty ? 0 : (journal.slot + 1) % DEVINFO_JOURNAL_SLOTS;
+
+	if (mmc_write(start + (unsigned long long)(1 + slot) * blocksize, blocksize, (unsigned int *)buf))
+	{
+		dprintf(CRITICAL, "ERROR: Cannot write devinfo journal\n");
+		ret = -1;
+	}
+	else
+	{
+		journal.empty = false;
+		journal.seq = rec->seq;
+		journal.slot = slot;
+		journal.legacy_crc = rec->legacy_crc;
+	}
+
+	free(buf);
+	return ret;
+}
@@ -46,4 +46,9 @@ struct device_info
 	char display_panel[MAX_PANEL_ID_LEN];
 };
 
+int devinfo_journal_load(struct device_info *dev);
+int devinfo_journal_store(const struct device_info *dev, bool legacy_written);
+/* Unlock state of the running bootloader, for apps outside aboot */
+bool device_is_unlocked(void);
+
 #endif
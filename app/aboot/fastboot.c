@@ -29,6 +29,7 @@
  */
 
 #include <debug.h>
+#include <err.h>
 #include <string.h>
 #include <stdlib.h>
 #include <platform.h>
@@ -54,12 +55,17 @@ typedef struct
 	struct udc_request *(*udc_request_alloc)(void);
 	void (*udc_request_free)(struct udc_request *req);
 
-	int (*usb_read)(void *buf, unsigned len);
-	int (*usb_write)(void *buf, unsigned len);
 } usb_controller_interface_t;
 
 usb_controller_interface_t usb_if;
 
+static struct fastboot_transport usb_transport = {
+	.name = "usb",
+};
+
+/* Where the command loop currently reads commands from */
+static struct fastboot_transport *transport = &usb_transport;
+
 #define MAX_USBFS_BULK_SIZE (32 * 1024)
 #define MAX_USBSS_BULK_SIZE (0x1000000)
 
@@ -113,8 +119,16 @@ static unsigned hex2unsigned(const char *x)
     return n;
 }
 
+/*
+ * Commands live in a character trie: one node per prefix character, the
+ * node for the last character carries the handler. A command is looked
+ * up in a single pass over its text and the longest registered prefix
+ * wins, so "reboot-bootloader" is never taken for "reboot".
+ */
 struct fastboot_cmd {
-	struct fastboot_cmd *next;
+	struct fastboot_cmd *child;
+	struct fastboot_cmd *sibling;
+	char c;
 	const char *prefix;
 	unsigned prefix_len;
 	void (*handle)(const char *arg, void *data, unsigned sz);
@@ -126,42 +140,102 @@ struct fastboot_var {
 	const char *value;
 };
 
-static struct fastboot_cmd *cmdlist;
+static struct fastboot_cmd cmd_root;
+
+static struct fastboot_cmd *fastboot_cmd_child(struct fastboot_cmd *node, char c)
+{
+	for (node = node->child; node; node = node->sibling)
+		if (node->c == c)
+			return node;
+
+	return NULL;
+}
 
 void fastboot_register(const char *prefix,
 		       void (*handle)(const char *arg, void *data, unsigned sz))
 {
-	struct fastboot_cmd *cmd;
-	cmd = malloc(sizeof(*cmd));
-	if (cmd) {
-		cmd->prefix = prefix;
-		cmd->prefix_len = strlen(prefix);
-		cmd->handle = handle;
-		cmd->next = cmdlist;
-		cmdlist = cmd;
+	struct fastboot_cmd *node = &cmd_root;
+	struct fastboot_cmd *next;
+	const char *s;
+
+	for (s = prefix; *s; s++) {
+		next = fastboot_cmd_child(node, *s);
+		if (!next) {
+			next = calloc(1, sizeof(*next));
+			if (!next)
+				return;
+			next->c = *s;
+			next->sibling = node->child;
+			node->child = next;
+		}
+		node = next;
 	}
+
+	node->prefix = prefix;
+	node->prefix_len = s - prefix;
+	node->handle = handle;
 }
 
-static struct fastboot_var *varlist;
+static struct fastboot_cmd *fastboot_find_cmd(const char *str)
+{
+	struct fastboot_cmd *node = &cmd_root;
+	struct fastboot_cmd *match = node->handle ? node : NULL;
+
+	for (; *str; str++) {
+		node = fastboot_cmd_child(node, *str);
+		if (!node)
+			break;
+		if (node->handle)
+			match = node;
+	}
+
+	return match;
+}
+
+/* Must be a power of 2 */
+#define FASTBOOT_VAR_BUCKETS	64
+
+static struct fastboot_var *vartab[FASTBOOT_VAR_BUCKETS];
+
+/* FNV-1a, partition variables share long common prefixes */
+static unsigned fastboot_var_hash(const char *name)
+{
+	uint32_t hash = 2166136261u;
+
+	while (*name)
+		hash = (hash ^ (uint8_t) *name++) * 16777619u;
+
+	return hash & (FASTBOOT_VAR_BUCKETS - 1);
+}
 
 void fastboot_publish(const char *name, const char *value)
 {
 	struct fastboot_var *var;
+	unsigned bucket;
+
 	var = malloc(sizeof(*var));
 	if (var) {
+		bucket = fastboot_var_hash(name);
 		var->name = name;
 		var->value = value;
-		var->next = varlist;
-		varlist = var;
+		var->next = vartab[bucket];
+		vartab[bucket] = var;
 	}
 }
 
 
 static event_t usb_online;
 static event_t txn_done;
+static event_t tx_done;
 static struct udc_endpoint *in, *out;
 static struct udc_request *req;
+static struct udc_request *tx_req;
 int txn_status;
+static int tx_status;
+
+/* The last response is still on its way to the host */
+static int write_pending;
+BUF_DMA_ALIGN(ack_buf, MAX_RSP_SIZE);
 
 static void *download_base;
 static unsigned download_max;
@@ -182,6 +256,14 @@ static void req_complete(struct udc_request *req, unsigned actual, int status)
 	event_signal(&txn_done, 0);
 }
 
+static void tx_complete(struct udc_request *req, unsigned actual, int status)
+{
+	tx_status = status;
+	req->length = actual;
+
+	event_signal(&tx_done, 0);
+}
+
 #ifdef USB30_SUPPORT
 static int usb30_usb_read(void *_buf, unsigned len)
 {
@@ -254,10 +336,11 @@ oops:
 	return -1;
 }
 
-static int usb30_usb_write(void *buf, unsigned len)
+static struct udc_request usb30_tx_req;
+
+static int usb30_usb_write_queue(void *buf, unsigned len)
 {
 	int r;
-	struct udc_request req;
 
 	ASSERT(buf);
 	ASSERT(len);
@@ -270,33 +353,47 @@ static int usb30_usb_write(void *buf, unsigned len)
 	/* flush buffer to main memory before giving to udc */
 	arch_clean_invalidate_cache_range((addr_t) buf, len);
 
-	req.buf      = (void*) PA((addr_t)buf);
-	req.length   = len;
-	req.complete = req_complete;
+	usb30_tx_req.buf      = (void*) PA((addr_t)buf);
+	usb30_tx_req.length   = len;
+	usb30_tx_req.complete = tx_complete;
 
-	r = usb30_udc_request_queue(in, &req);
+	r = usb30_udc_request_queue(in, &usb30_tx_req);
 	if (r < 0) {
 		dprintf(CRITICAL, "usb_write() queue failed. r = %d\n", r);
 		goto oops;
 	}
-	event_wait(&txn_done);
-
-	dprintf(SPEW, "usb_write(): DONE: len = %d req->length = %d str = %s\n",
-			len, req.length, (char *) buf);
-
-	if (txn_status < 0) {
-		dprintf(CRITICAL, "usb_write() transaction failed. txn_status = %d\n",
-				txn_status);
-		goto oops;
-	}
 
-	return req.length;
+	return 0;
 
 oops:
 	fastboot_state = STATE_ERROR;
 	dprintf(CRITICAL, "usb_write(): DONE: ERROR: len = %d\n", len);
 	return -1;
 }
+
+static int usb30_usb_write_wait(void)
+{
+	event_wait(&tx_done);
+
+	dprintf(SPEW, "usb_write(): DONE: req->length = %d\n", usb30_tx_req.length);
+
+	if (tx_status < 0) {
+		dprintf(CRITICAL, "usb_write() transaction failed. txn_status = %d\n",
+				tx_status);
+		fastboot_state = STATE_ERROR;
+		return -1;
+	}
+
+	return usb30_tx_req.length;
+}
+
+static int usb30_usb_write(void *buf, unsigned len)
+{
+	if (usb30_usb_write_queue(buf, len) < 0)
+		return -1;
+
+	return usb30_usb_write_wait();
+}
 #endif
 
 static int hsusb_usb_read(void *_buf, unsigned len)
@@ -345,6 +442,41 @@ oops:
 	return -1;
 }
 
+static int hsusb_usb_write_queue(void *buf, unsigned len)
+{
+	int r;
+
+	if (fastboot_state == STATE_ERROR)
+		goto oops;
+
+	tx_req->buf = (unsigned char *)PA((addr_t)buf);
+	tx_req->length = len;
+	tx_req->complete = tx_complete;
+	r = udc_request_queue(in, tx_req);
+	if (r < 0) {
+		dprintf(INFO, "usb_write() queue failed\n");
+		goto oops;
+	}
+
+	return 0;
+
+oops:
+	fastboot_state = STATE_ERROR;
+	return -1;
+}
+
+static int hsusb_usb_write_wait(void)
+{
+	event_wait(&tx_done);
+	if (tx_status < 0) {
+		dprintf(INFO, "usb_write() transaction failed\n");
+		fastboot_state = STATE_ERROR;
+		return -1;
+	}
+
+	return tx_req->length;
+}
+
 static int hsusb_usb_write(void *buf, unsigned len)
 {
 	int r;
@@ -352,55 +484,65 @@ static int hsusb_usb_write(void *buf, unsigned len)
 	unsigned char *_buf = buf;
 	int count = 0;
 
-	if (fastboot_state == STATE_ERROR)
-		goto oops;
-
 	while (len > 0) {
 		xfer = (len > MAX_USBFS_BULK_SIZE) ? MAX_USBFS_BULK_SIZE : len;
-		req->buf = (unsigned char *)PA((addr_t)_buf);
-		req->length = xfer;
-		req->complete = req_complete;
-		r = udc_request_queue(in, req);
-		if (r < 0) {
-			dprintf(INFO, "usb_write() queue failed\n");
-			goto oops;
-		}
-		event_wait(&txn_done);
-		if (txn_status < 0) {
-			dprintf(INFO, "usb_write() transaction failed\n");
-			goto oops;
-		}
+		if (hsusb_usb_write_queue(_buf, xfer) < 0)
+			return -1;
 
-		count += req->length;
-		_buf += req->length;
-		len -= req->length;
+		r = hsusb_usb_write_wait();
+		if (r < 0)
+			return -1;
+
+		count += r;
+		_buf += r;
+		len -= r;
 
 		/* short transfer? */
-		if (req->length != xfer) break;
+		if ((unsigned) r != xfer) break;
 	}
 
 	return count;
+}
 
-oops:
-	fastboot_state = STATE_ERROR;
-	return -1;
+/* Wait until the last response has been sent */
+void fastboot_flush(void)
+{
+	if (!write_pending)
+		return;
+
+	write_pending = 0;
+	transport->write_wait();
 }
 
-void fastboot_ack(const char *code, const char *reason)
+static int fastboot_write(void *buf, unsigned len)
 {
-	STACKBUF_DMA_ALIGN(response, MAX_RSP_SIZE);
+	fastboot_flush();
+
+	return transport->write(buf, len);
+}
 
+/*
+ * The final response of a command is only queued. The command loop goes
+ * on to queue the read for the next command while it is being sent, and
+ * the next write of any kind waits for it.
+ */
+void fastboot_ack(const char *code, const char *reason)
+{
 	if (fastboot_state != STATE_COMMAND)
 		return;
 
 	if (reason == 0)
 		reason = "";
 
-	snprintf((char *)response, MAX_RSP_SIZE, "%s%s", code, reason);
-	fastboot_state = STATE_COMPLETE;
+	fastboot_flush();
 
-	usb_if.usb_write(response, strlen((const char *)response));
+	snprintf((char *)ack_buf, MAX_RSP_SIZE, "%s%s", code, reason);
+	fastboot_state = STATE_COMPLETE;
 
+	if (!transport->write_queue)
+		transport->write(ack_buf, strlen((const char *)ack_buf));
+	else if (!transport->write_queue(ack_buf, strlen((const char *)ack_buf)))
+		write_pending = 1;
 }
 
 void fastboot_info(const char *reason)
@@ -415,7 +557,7 @@ void fastboot_info(const char *reason)
 
 	snprintf((char *)response, MAX_RSP_SIZE, "INFO%s", reason);
 
-	usb_if.usb_write(response, strlen((const char *)response));
+	fastboot_write(response, strlen((const char *)response));
 }
 
 void fastboot_fail(const char *reason)
@@ -432,7 +574,7 @@ static void cmd_getvar(const char *arg, void *data, unsigned sz)
 {
 	struct fastboot_var *var;
 
-	for (var = varlist; var; var = var->next) {
+	for (var = vartab[fastboot_var_hash(arg)]; var; var = var->next) {
 		if (!strcmp(var->name, arg)) {
 			fastboot_okay(var->value);
 			return;
@@ -454,10 +596,10 @@ static void cmd_download(const char *arg, void *data, unsigned sz)
 	}
 
 	snprintf((char *)response, MAX_RSP_SIZE, "DATA%08x", len);
-	if (usb_if.usb_write(response, strlen((const char *)response)) < 0)
+	if (fastboot_write(response, strlen((const char *)response)) < 0)
 		return;
 
-	r = usb_if.usb_read(download_base, len);
+	r = transport->read(download_base, len);
 	if ((r < 0) || ((unsigned) r != len)) {
 		fastboot_state = STATE_ERROR;
 		return;
@@ -478,7 +620,7 @@ static void fastboot_command_loop(void)
 		dprintf(CRITICAL, "Could not allocate memory for fastboot buffer\n.");
 		ASSERT(0);
 	}
-again:
+
 	while (fastboot_state != STATE_ERROR) {
 
 		/* Read buffer must be cleared first. If buffer is not cleared,
@@ -488,25 +630,23 @@ again:
 		memset(buffer, 0, MAX_RSP_SIZE);
 		arch_clean_invalidate_cache_range((addr_t) buffer, MAX_RSP_SIZE);
 
-		r = usb_if.usb_read(buffer, MAX_RSP_SIZE);
+		r = transport->read(buffer, MAX_RSP_SIZE);
 		if (r < 0) break;
 		buffer[r] = 0;
 		dprintf(INFO,"fastboot: %s\n", buffer);
 
 		fastboot_state = STATE_COMMAND;
 
-		for (cmd = cmdlist; cmd; cmd = cmd->next) {
-			if (memcmp(buffer, cmd->prefix, cmd->prefix_len))
-				continue;
-			cmd->handle((const char*) buffer + cmd->prefix_len,
-				    (void*) download_base, download_size);
-			if (fastboot_state == STATE_COMMAND)
-				fastboot_fail("unknown reason");
-			goto again;
+		cmd = fastboot_find_cmd((const char*) buffer);
+		if (!cmd) {
+			fastboot_fail("unknown command");
+			continue;
 		}
 
-		fastboot_fail("unknown command");
-
+		cmd->handle((const char*) buffer + cmd->prefix_len,
+			    (void*) download_base, download_size);
+		if (fastboot_state == STATE_COMMAND)
+			fastboot_fail("unknown reason");
 	}
 	fastboot_state = STATE_OFFLINE;
 	dprintf(INFO,"fastboot: oops!\n");
@@ -517,6 +657,11 @@ static int fastboot_handler(void *arg)
 {
 	for (;;) {
 		event_wait(&usb_online);
+
+		/* Nothing from an earlier session is still in flight */
+		write_pending = 0;
+		event_unsignal(&tx_done);
+
 		fastboot_command_loop();
 	}
 	return 0;
@@ -561,8 +706,10 @@ int fastboot_init(void *base, unsigned size)
 		usb_if.udc_request_alloc   = usb30_udc_request_alloc;
 		usb_if.udc_request_free    = usb30_udc_request_free;
 
-		usb_if.usb_read            = usb30_usb_read;
-		usb_if.usb_write           = usb30_usb_write;
+		usb_transport.read         = usb30_usb_read;
+		usb_transport.write        = usb30_usb_write;
+		usb_transport.write_queue  = usb30_usb_write_queue;
+		usb_transport.write_wait   = usb30_usb_write_wait;
 #else
 		dprintf(CRITICAL, "USB30 needs to be enabled for this target.\n");
 		ASSERT(0);
@@ -580,8 +727,10 @@ int fastboot_init(void *base, unsigned size)
 		usb_if.udc_request_alloc   = udc_request_alloc;
 		usb_if.udc_request_free    = udc_request_free;
 
-		usb_if.usb_read            = hsusb_usb_read;
-		usb_if.usb_write           = hsusb_usb_write;
+		usb_transport.read         = hsusb_usb_read;
+		usb_transport.write        = hsusb_usb_write;
+		usb_transport.write_queue  = hsusb_usb_write_queue;
+		usb_transport.write_wait   = hsusb_usb_write_wait;
 	}
 
 	/* register udc device */
@@ -589,6 +738,7 @@ int fastboot_init(void *base, unsigned size)
 
 	event_init(&usb_online, 0, EVENT_FLAG_AUTOUNSIGNAL);
 	event_init(&txn_done, 0, EVENT_FLAG_AUTOUNSIGNAL);
+	event_init(&tx_done, 0, EVENT_FLAG_AUTOUNSIGNAL);
 
 	in = usb_if.udc_endpoint_alloc(UDC_TYPE_BULK_IN, 512);
 	if (!in)
@@ -604,6 +754,10 @@ int fastboot_init(void *base, unsigned size)
 	if (!req)
 		goto fail_alloc_req;
 
+	tx_req = usb_if.udc_request_alloc();
+	if (!tx_req)
+		goto fail_alloc_tx_req;
+
 	/* register gadget */
 	if (usb_if.udc_register_gadget(&fastboot_gadget))
 		goto fail_udc_register;
@@ -624,6 +778,8 @@ int fastboot_init(void *base, unsigned size)
 	return 0;
 
 fail_udc_register:
+	usb_if.udc_request_free(tx_req);
+fail_alloc_tx_req:
 	usb_if.udc_request_free(req);
 fail_alloc_req:
 	usb_if.udc_endpoint_free(out);
@@ -633,7 +789,40 @@ fail_alloc_in:
 	return -1;
 }
 
+/*
+ * Run the command loop over t until its read fails, with the registered
+ * commands and the download buffer set up by fastboot_init(). May be
+ * called from a command handler, the caller's transport, state and
+ * download size are restored on return. The download buffer itself is
+ * shared, a download in the nested session overwrites its contents.
+ */
+int fastboot_run(struct fastboot_transport *t)
+{
+	struct fastboot_transport *saved_transport = transport;
+	unsigned saved_state = fastboot_state;
+	unsigned saved_download_size = download_size;
+
+	if (!download_base || !t || !t->read || !t->write)
+		return ERR_INVALID_ARGS;
+
+	fastboot_flush();
+
+	transport = t;
+	fastboot_state = STATE_OFFLINE;
+
+	fastboot_command_loop();
+
+	fastboot_flush();
+
+	transport = saved_transport;
+	fastboot_state = saved_state;
+	download_size = saved_download_size;
+
+	return NO_ERROR;
+}
+
 void fastboot_stop(void)
 {
+	fastboot_flush();
 	usb_if.udc_stop();
 }
@@ -34,9 +34,22 @@
 #define MAX_RSP_SIZE            64
 #define MAX_GET_VAR_NAME_SIZE   256
 
+/* a byte pipe the command loop runs over: USB, or a loopback for tests */
+struct fastboot_transport {
+	const char *name;
+	int (*read)(void *buf, unsigned len);
+	int (*write)(void *buf, unsigned len);
+	/* optional: start a single short write, write_wait() collects it */
+	int (*write_queue)(void *buf, unsigned len);
+	int (*write_wait)(void);
+};
+
 int fastboot_init(void *xfer_buffer, unsigned max);
 void fastboot_stop(void);
 
+/* run the command loop over another transport until its read fails */
+int fastboot_run(struct fastboot_transport *t);
+
 /* register a command handler
  * - command handlers will be called if their prefix matches
  * - they are expected to call fastboot_okay() or fastboot_fail()
@@ -53,5 +66,10 @@ void fastboot_okay(const char *result);
 void fastboot_fail(const char *reason);
 void fastboot_info(const char *reason);
 
+/* wait until the last response has reached the host, for handlers
+ * that do not return to the command loop (reboot and the like)
+ */
+void fastboot_flush(void);
+
 
 #endif
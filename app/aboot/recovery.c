@@ -60,6 +60,7 @@ unsigned boot_into_recovery = 0;
 
 extern uint32_t get_page_size();
 extern void reset_device_info();
+extern void commit_device_info(void);
 extern void set_device_root();
 
 int get_recovery_message(struct recovery_message *out)
@@ -382,6 +383,7 @@ int recovery_init (void)
 SEND_RECOVERY_MSG:
 	set_recovery_message(&msg);	// send recovery message
 	boot_into_recovery = 1;		// Boot in recovery mode
+	commit_device_info();
 	reboot_device(0);
 	return 0;
 }
@@ -6,6 +6,7 @@ DEFINES += ASSERT_ON_TAMPER=1
 
 OBJS += \
 	$(LOCAL_DIR)/aboot.o \
+	$(LOCAL_DIR)/devinfo.o \
 	$(LOCAL_DIR)/fastboot.o \
 	$(LOCAL_DIR)/recovery.o
 
@@ -0,0 +1,523 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Fastboot session replay: runs a recorded host session through the real
+ * command loop and handlers over a loopback transport, and reports the
+ * latency and throughput of every command. Download the script
+ * ("fastboot stage session.txt") and run "fastboot oem fastboot-replay",
+ * or "fastboot oem fastboot-replay selftest" for the built in session.
+ * With "tcp" in front of the arguments ("oem fastboot-replay tcp ...")
+ * the session goes through the fastboot TCP framing instead, the same
+ * path a network connection takes.
+ *
+ * A session is plain text, one host command per line, optionally
+ * followed by a tab and the response prefix it must get:
+ *
+ *	getvar:version	OKAY0.5
+ *	download:00100000	OKAY
+ *
+ * The data phase of a download is fed with a fixed pattern straight into
+ * the download buffer, so the reported times are the device's command
+ * handling cost, not link throughput. flash: and erase: are redirected
+ * to a RAM block device and never touch a partition. Every other command
+ * runs for real, a session that reboots will do so. Replays do not nest.
+ */
+
+#include <debug.h>
+#include <err.h>
+#include <string.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <printf.h>
+#include <stdarg.h>
+#include <app.h>
+#include <platform.h>
+#include <lib/bio.h>
+#include "fastboot.h"
+#include "fastboot_tcp.h"
+
+#define FBR_LINE_LEN	MAX_RSP_SIZE
+#define FBR_MAX_STEPS	256
+#define FBR_DATA_BYTE	0xa5
+#define FBR_TCP_HDR_LEN	8
+#define FBR_RAM_NAME	"fbr-ram"
+#define FBR_RAM_SIZE	(2 * 1024 * 1024)
+
+struct fbr_step {
+	const char *cmd;
+	const char *expect;
+	bigtime_t usecs;
+	uint64_t bytes;
+	char rsp[MAX_RSP_SIZE];
+	bool done;
+};
+
+struct fbr_session {
+	struct fbr_step *steps;
+	unsigned num_steps;
+	unsigned next;
+	unsigned cur;
+	unsigned data_left;
+	bigtime_t start;
+
+	/* host end of the fastboot TCP framing */
+	uint8_t tx[FBR_TCP_HDR_LEN + MAX_RSP_SIZE];
+	unsigned tx_len;
+	unsigned tx_off;
+	bool greeted;
+	bool data_framed;
+	uint8_t rx[FBR_TCP_HDR_LEN + MAX_RSP_SIZE];
+	unsigned rx_len;
+	unsigned rx_need;
+	unsigned rx_skip;
+};
+
+typedef void (*fbr_report_t)(const char *line, void *arg);
+
+/* The transport callbacks have no context pointer */
+static struct fbr_session *fbr;
+
+/* Commands sent to the replay's own handlers instead of the real ones */
+static const char *fbr_redirected[] = { "flash:", "erase:" };
+#define FBR_REDIRECT_PREFIX	"fbr-"
+
+static const char fbr_selftest_session[] =
+	"getvar:version\tOKAY0.5\n"
+	"getvar:no-such-variable\tOKAY\n"
+	"no-such-command\tFAILunknown command\n"
+	"download:00000010\tOKAY\n"
+	"download:00100000\tOKAY\n"
+	"flash:boot\tOKAY\n"
+	"erase:cache\tOKAY\n";
+
+static unsigned fbr_hex(const char *x)
+{
+	unsigned n = 0;
+	int i;
+
+	for (i = 0; i < 8 && x[i]; i++) {
+		if (x[i] >= '0' && x[i] <= '9')
+			n = (n << 4) | (x[i] - '0');
+		else if (x[i] >= 'a' && x[i] <= 'f')
+			n = (n << 4) | (x[i] - 'a' + 10);
+		else if (x[i] >= 'A' && x[i] <= 'F')
+			n = (n << 4) | (x[i] - 'A' + 10);
+		else
+			break;
+	}
+
+	return n;
+}
+
+static int fbr_read(void *buf, unsigned len)
+{
+	struct fbr_step *step;
+	unsigned i;
+	unsigned n;
+	unsigned m;
+
+	if (fbr->data_left) {
+		n = MIN(len, fbr->data_left);
+		memset(buf, FBR_DATA_BYTE, n);
+		fbr->data_left -= n;
+		fbr->steps[fbr->cur].bytes += n;
+		return n;
+	}
+
+	/* End of the session ends the command loop */
+	if (fbr->next == fbr->num_steps)
+		return -1;
+
+	fbr->cur = fbr->next++;
+	step = &fbr->steps[fbr->cur];
+
+	n = 0;
+	for (i = 0; i < countof(fbr_redirected); i++) {
+		if (!strncmp(step->cmd, fbr_redirected[i], strlen(fbr_redirected[i]))) {
+			n = MIN(strlen(FBR_REDIRECT_PREFIX), len);
+			memcpy(buf, FBR_REDIRECT_PREFIX, n);
+			break;
+		}
+	}
+
+	m = MIN(strlen(step->cmd), len - n);
+	memcpy((char *)buf + n, step->cmd, m);
+	n += m;
+	fbr->start = current_time_hires();
+
+	return n;
+}
+
+static int fbr_write(void *buf, unsigned len)
+{
+	struct fbr_step *step = &fbr->steps[fbr->cur];
+	const char *rsp = buf;
+
+	if (len >= 4 && !memcmp(rsp, "DATA", 4)) {
+		fbr->data_left = fbr_hex(rsp + 4);
+		fbr->data_framed = false;
+		return len;
+	}
+
+	if (len >= 4 && !memcmp(rsp, "INFO", 4))
+		return len;
+
+	/* OKAY or FAIL ends the command */
+	step->usecs = current_time_hires() - fbr->start;
+	len = MIN(len, sizeof(step->rsp) - 1);
+	memcpy(step->rsp, rsp, len);
+	step->rsp[len] = '\0';
+	step->done = true;
+
+	return len;
+}
+
+static struct fastboot_transport fbr_transport = {
+	.name  = "loopback",
+	.read  = fbr_read,
+	.write = fbr_write,
+};
+
+static void fbr_tcp_header(uint8_t *hdr, unsigned len)
+{
+	int i;
+
+	for (i = 0; i < FBR_TCP_HDR_LEN; i++)
+		hdr[i] = (uint8_t) ((uint64_t) len >> (8 * (FBR_TCP_HDR_LEN - 1 - i)));
+}
+
+/* Bytes the host sends: handshake, then framed commands and data */
+static int fbr_tcp_recv(void *buf, unsigned len)
+{
+	int n;
+
+	if (fbr->tx_off == fbr->tx_len) {
+		fbr->tx_off = fbr->tx_len = 0;
+
+		if (!fbr->greeted) {
+			memcpy(fbr->tx, "FB01", 4);
+			fbr->tx_len = 4;
+			fbr->greeted = true;
+		} else if (fbr->data_left && !fbr->data_framed) {
+			/* the whole download as one packet, like the host tool */
+			fbr_tcp_header(fbr->tx, fbr->data_left);
+			fbr->tx_len = FBR_TCP_HDR_LEN;
+			fbr->data_framed = true;
+		} else if (fbr->data_left) {
+			return fbr_read(buf, len);
+		} else {
+			n = fbr_read(fbr->tx + FBR_TCP_HDR_LEN, MAX_RSP_SIZE);
+			if (n < 0)
+				return -1;
+			fbr_tcp_header(fbr->tx, n);
+			fbr->tx_len = FBR_TCP_HDR_LEN + n;
+		}
+	}
+
+	n = MIN(len, fbr->tx_len - fbr->tx_off);
+	memcpy(buf, fbr->tx + fbr->tx_off, n);
+	fbr->tx_off += n;
+
+	return n;
+}
+
+/* Bytes the device sends: handshake reply, then framed responses */
+static int fbr_tcp_send(const void *buf, unsigned len)
+{
+	const uint8_t *p = buf;
+	unsigned i;
+	int j;
+
+	for (i = 0; i < len; i++) {
+		if (fbr->rx_skip) {
+			fbr->rx_skip--;
+			continue;
+		}
+
+		fbr->rx[fbr->rx_len++] = p[i];
+
+		if (fbr->rx_len == FBR_TCP_HDR_LEN) {
+			fbr->rx_need = 0;
+			for (j = 0; j < FBR_TCP_HDR_LEN; j++)
+				fbr->rx_need = (fbr->rx_need << 8) | fbr->rx[j];
+			if (fbr->rx_need > MAX_RSP_SIZE)
+				return -1;
+		}
+
+		if (fbr->rx_len >= FBR_TCP_HDR_LEN &&
+		    fbr->rx_len == FBR_TCP_HDR_LEN + fbr->rx_need) {
+			fbr_write(fbr->rx + FBR_TCP_HDR_LEN, fbr->rx_need);
+			fbr->rx_len = 0;
+		}
+	}
+
+	return len;
+}
+
+static struct fastboot_tcp_stream fbr_tcp_stream = {
+	.recv = fbr_tcp_recv,
+	.send = fbr_tcp_send,
+};
+
+static void fbr_line(fbr_report_t report, void *arg, const char *fmt, ...)
+{
+	char line[FBR_LINE_LEN];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+
+	report(line, arg);
+}
+
+/* Split the script in place into steps, returns the step count */
+static unsigned fbr_parse(char *script, struct fbr_step *steps, unsigned max)
+{
+	unsigned num = 0;
+	char *line, *end, *tab;
+
+	for (line = script; *line && num < max; line = end) {
+		end = strchr(line, '\n');
+		if (end)
+			*end++ = '\0';
+		else
+			end = line + strlen(line);
+
+		if (*line && line[strlen(line) - 1] == '\r')
+			line[strlen(line) - 1] = '\0';
+		if (line[0] == '\0' || line[0] == '#')
+			continue;
+
+		tab = strchr(line, '\t');
+		if (tab)
+			*tab++ = '\0';
+
+		memset(&steps[num], 0, sizeof(steps[num]));
+		steps[num].cmd = line;
+		steps[num].expect = tab;
+		num++;
+	}
+
+	return num;
+}
+
+/**
+ * fbr_replay() - Replay a session script and report per command results
+ * @script: session text, need not be NUL terminated
+ * @len: length of the script
+ * @tcp: run the session through the fastboot TCP framing
+ *
+ * Returns NO_ERROR if every command completed with the expected
+ * response, ERR_IO otherwise.
+ */
+static int fbr_replay(const char *script, unsigned len, bool tcp,
+		      fbr_report_t report, void *arg)
+{
+	struct fbr_session session;
+	struct fbr_step *steps;
+	struct fbr_step *step;
+	bigtime_t total = 0;
+	uint64_t bytes = 0;
+	unsigned errors = 0;
+	unsigned i;
+	bool bad;
+	char *text;
+	int ret;
+
+	/* The transport callbacks only know one session */
+	if (fbr)
+		return ERR_ALREADY_STARTED;
+
+	/* A download in the session reuses the buffer the script came in */
+	text = malloc(len + 1);
+	steps = malloc(FBR_MAX_STEPS * sizeof(struct fbr_step));
+	if (!text || !steps) {
+		free(text);
+		free(steps);
+		return ERR_NO_MEMORY;
+	}
+
+	memcpy(text, script, len);
+	text[len] = '\0';
+
+	memset(&session, 0, sizeof(session));
+	session.steps = steps;
+	session.num_steps = fbr_parse(text, steps, FBR_MAX_STEPS);
+	/* the "FB01" the device answers the handshake with */
+	session.rx_skip = 4;
+
+	fbr = &session;
+	if (tcp)
+		ret = fastboot_tcp_run(&fbr_tcp_stream);
+	else
+		ret = fastboot_run(&fbr_transport);
+	fbr = NULL;
+
+	if (ret)
+		goto out;
+
+	for (i = 0; i < session.num_steps; i++) {
+		step = &session.steps[i];
+
+		bad = !step->done || (step->expect &&
+			strncmp(step->rsp, step->expect, strlen(step->expect)));
+		if (bad)
+			errors++;
+
+		total += step->usecs;
+		bytes += step->bytes;
+
+		/* the command goes last, long ones get cut at the line length */
+		fbr_line(report, arg, "%s %6lluus %8lluB %s",
+			 bad ? "ERR " : "ok  ", step->usecs,
+			 step->bytes, step->cmd);
+	}
+
+	fbr_line(report, arg, "%u cmds %lluus %llu bytes %u errors",
+		 session.num_steps, total, bytes, errors);
+
+	ret = errors ? ERR_IO : NO_ERROR;
+out:
+	free(steps);
+	free(text);
+	return ret;
+}
+
+static void fbr_fastboot_line(const char *line, void *arg)
+{
+	fastboot_info(line);
+}
+
+/* Stand-in for the partitions a replayed session flashes or erases */
+static bdev_t *fbr_ram_open(void)
+{
+	static void *mem;
+
+	if (!mem) {
+		mem = memalign(CACHE_LINE, FBR_RAM_SIZE);
+		if (!mem)
+			return NULL;
+		create_membdev(FBR_RAM_NAME, mem, FBR_RAM_SIZE);
+	}
+
+	return bio_open(FBR_RAM_NAME);
+}
+
+/* fbr-flash:<partition>, only sent by a replay: the data lands in RAM */
+static void cmd_fbr_flash(const char *arg, void *data, unsigned sz)
+{
+	bdev_t *dev;
+	unsigned off;
+	unsigned n;
+
+	if (!fbr || !(dev = fbr_ram_open())) {
+		fastboot_fail("not replaying");
+		return;
+	}
+
+	/* Images larger than the device wrap around, every byte is still copied */
+	for (off = 0; off < sz; off += n) {
+		n = MIN(sz - off, (unsigned) dev->size);
+		if (bio_write(dev, (uint8_t *)data + off, 0, n) != (ssize_t) n) {
+			bio_close(dev);
+			fastboot_fail("ram write failed");
+			return;
+		}
+	}
+
+	bio_close(dev);
+	fastboot_okay("");
+}
+
+/* fbr-erase:<partition>, only sent by a replay */
+static void cmd_fbr_erase(const char *arg, void *data, unsigned sz)
+{
+	bdev_t *dev;
+	ssize_t ret;
+	off_t size;
+
+	if (!fbr || !(dev = fbr_ram_open())) {
+		fastboot_fail("not replaying");
+		return;
+	}
+
+	size = dev->size;
+	ret = bio_erase(dev, 0, size);
+	bio_close(dev);
+
+	if (ret != size)
+		fastboot_fail("ram erase failed");
+	else
+		fastboot_okay("");
+}
+
+/* fastboot oem fastboot-replay [tcp] [selftest], replays the downloaded script */
+static void cmd_oem_fastboot_replay(const char *arg, void *data, unsigned sz)
+{
+	bool tcp = false;
+	int ret;
+
+	while (*arg == ' ')
+		arg++;
+
+	if (!strncmp(arg, "tcp", 3)) {
+		tcp = true;
+		for (arg += 3; *arg == ' '; arg++);
+	}
+
+	if (!strcmp(arg, "selftest"))
+		ret = fbr_replay(fbr_selftest_session, strlen(fbr_selftest_session),
+				 tcp, fbr_fastboot_line, NULL);
+	else if (sz)
+		ret = fbr_replay(data, sz, tcp, fbr_fastboot_line, NULL);
+	else {
+		fastboot_fail("download a session script first");
+		return;
+	}
+
+	if (ret == ERR_ALREADY_STARTED)
+		fastboot_fail("replay already running");
+	else if (ret)
+		fastboot_fail("replay failed");
+	else
+		fastboot_okay("");
+}
+
+static void fastbootreplay_init(const struct app_descriptor *app)
+{
+	fastboot_register("oem fastboot-replay", cmd_oem_fastboot_replay);
+	fastboot_register(FBR_REDIRECT_PREFIX "flash:", cmd_fbr_flash);
+	fastboot_register(FBR_REDIRECT_PREFIX "erase:", cmd_fbr_erase);
+}
+
+APP_START(fastbootreplay)
+	.init = fastbootreplay_init,
+APP_END
@@ -0,0 +1,236 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Fastboot over a TCP style byte stream, with the framing of the fastboot
+ * TCP protocol: both ends exchange a "FBnn" version handshake, then every
+ * packet in either direction is an 8 byte big endian length followed by
+ * the payload. Commands and responses are one packet each, download data
+ * may be split over any number of packets.
+ */
+
+#include <debug.h>
+#include <err.h>
+#include <string.h>
+#include <stdlib.h>
+#include "fastboot.h"
+#include "fastboot_tcp.h"
+
+#define FASTBOOT_TCP_VERSION	"FB01"
+#define FASTBOOT_TCP_HDR_LEN	8
+
+static struct fastboot_tcp_stream *stream;
+/* payload bytes of the current incoming packet not read yet */
+static uint64_t packet_left;
+/* set by our DATA response, the next read is that many download bytes */
+static bool data_phase;
+static unsigned data_left;
+
+static int tcp_recv_all(void *_buf, unsigned len)
+{
+	uint8_t *buf = _buf;
+	int r;
+
+	while (len) {
+		r = stream->recv(buf, len);
+		if (r <= 0)
+			return -1;
+		buf += r;
+		len -= r;
+	}
+
+	return 0;
+}
+
+static int tcp_send_all(const void *_buf, unsigned len)
+{
+	const uint8_t *buf = _buf;
+	int r;
+
+	while (len) {
+		r = stream->send(buf, len);
+		if (r <= 0)
+			return -1;
+		buf += r;
+		len -= r;
+	}
+
+	return 0;
+}
+
+/* Throw away the rest of the current packet */
+static int tcp_skip_packet(void)
+{
+	uint8_t scratch[64];
+	unsigned xfer;
+
+	while (packet_left) {
+		xfer = MIN(sizeof(scratch), packet_left);
+		if (tcp_recv_all(scratch, xfer))
+			return -1;
+		packet_left -= xfer;
+	}
+
+	return 0;
+}
+
+static int tcp_next_packet(void)
+{
+	uint8_t hdr[FASTBOOT_TCP_HDR_LEN];
+	int i;
+
+	if (tcp_recv_all(hdr, sizeof(hdr)))
+		return -1;
+
+	packet_left = 0;
+	for (i = 0; i < FASTBOOT_TCP_HDR_LEN; i++)
+		packet_left = (packet_left << 8) | hdr[i];
+
+	return 0;
+}
+
+/*
+ * Reads after a DATA response are download data and keep going across
+ * packets until len bytes are in. Any other read is a command, which is
+ * exactly one packet: the host sends nothing else before it gets our
+ * response, and whatever does not fit in buf is dropped.
+ */
+static int tcp_read(void *_buf, unsigned len)
+{
+	uint8_t *buf = _buf;
+	unsigned count = 0;
+	unsigned xfer;
+	bool data = data_phase;
+
+	if (data)
+		len = MIN(len, data_left);
+	else if (tcp_skip_packet())
+		return -1;
+
+	while (count < len) {
+		while (!packet_left)
+			if (tcp_next_packet())
+				return -1;
+
+		xfer = MIN(len - count, packet_left);
+		if (tcp_recv_all(buf + count, xfer))
+			return -1;
+
+		count += xfer;
+		packet_left -= xfer;
+
+		if (!data && !packet_left)
+			break;
+	}
+
+	if (data) {
+		data_left -= count;
+		data_phase = data_left != 0;
+	} else if (tcp_skip_packet())
+		return -1;
+
+	return count;
+}
+
+static unsigned tcp_hex(const char *x)
+{
+	unsigned n = 0;
+	int i;
+
+	for (i = 0; i < 8; i++) {
+		if (x[i] >= '0' && x[i] <= '9')
+			n = (n << 4) | (x[i] - '0');
+		else if (x[i] >= 'a' && x[i] <= 'f')
+			n = (n << 4) | (x[i] - 'a' + 10);
+		else
+			return 0;
+	}
+
+	return n;
+}
+
+static int tcp_write(void *buf, unsigned len)
+{
+	uint8_t hdr[FASTBOOT_TCP_HDR_LEN];
+	int i;
+
+	for (i = 0; i < FASTBOOT_TCP_HDR_LEN; i++)
+		hdr[i] = (uint8_t) ((uint64_t) len >> (8 * (FASTBOOT_TCP_HDR_LEN - 1 - i)));
+
+	if (tcp_send_all(hdr, sizeof(hdr)) || tcp_send_all(buf, len))
+		return -1;
+
+	/* "DATA%08x" tells the host to send that many bytes next */
+	if (len == 12 && !memcmp(buf, "DATA", 4)) {
+		data_left = tcp_hex((char *)buf + 4);
+		data_phase = true;
+	}
+
+	return len;
+}
+
+static struct fastboot_transport tcp_transport = {
+	.name  = "tcp",
+	.read  = tcp_read,
+	.write = tcp_write,
+};
+
+/**
+ * fastboot_tcp_run() - Serve one fastboot TCP connection
+ * @s: connected byte stream, e.g. an accepted socket
+ *
+ * Does the version handshake and runs the command loop until the
+ * stream closes.
+ *
+ * Returns NO_ERROR, or ERR_IO if the handshake failed.
+ */
+int fastboot_tcp_run(struct fastboot_tcp_stream *s)
+{
+	char version[4];
+	int ret;
+
+	stream = s;
+	packet_left = 0;
+	data_phase = false;
+	data_left = 0;
+
+	/* "FB" and a two digit version, version 1 is all we speak */
+	if (tcp_recv_all(version, sizeof(version)) ||
+	    version[0] != 'F' || version[1] != 'B' ||
+	    tcp_send_all(FASTBOOT_TCP_VERSION, sizeof(version))) {
+		dprintf(CRITICAL, "fastboot tcp: bad handshake\n");
+		stream = NULL;
+		return ERR_IO;
+	}
+
+	ret = fastboot_run(&tcp_transport);
+
+	stream = NULL;
+	return ret;
+}
@@ -0,0 +1,9 @@
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+INCLUDES += -I$(LK_TOP_DIR)/app/aboot
+
+MODULES += lib/bio
+
+OBJS += \
+	$(LOCAL_DIR)/fastboot_replay.o \
+	$(LOCAL_DIR)/fastboot_tcp.o
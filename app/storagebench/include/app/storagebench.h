@@ -0,0 +1,87 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Fundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __APP_STORAGEBENCH_H
+#define __APP_STORAGEBENCH_H
+
+#include <sys/types.h>
+#include <lib/bio.h>
+
+/* Smallest transfer and alignment used by the sweeps, so that 4K block
+ * UFS LUNs and 2K/4K page NAND can sit behind a 512 byte bio device.
+ */
+#define SBENCH_MIN_XFER          4096
+#define SBENCH_MAX_XFER          (1024 * 1024)
+#define SBENCH_HIST_BUCKETS      32
+
+enum sbench_pattern {
+	SBENCH_SEQ_WRITE,
+	SBENCH_SEQ_READ,
+	SBENCH_RAND_WRITE,
+	SBENCH_RAND_READ,
+	SBENCH_PATTERNS,
+};
+
+struct sbench_result {
+	enum sbench_pattern pattern;
+	uint32_t xfer;
+	uint32_t ops;
+	uint32_t errors;
+	uint64_t bytes;
+	/* sum of the per op latencies in us */
+	bigtime_t elapsed;
+	/* bucket n counts latencies of [2^n, 2^(n+1)) us */
+	uint32_t hist[SBENCH_HIST_BUCKETS];
+};
+
+struct sbench_config {
+	bdev_t *dev;
+	/* device and LUN, printed ahead of the results */
+	const char *label;
+	bool read_only;
+	/* check the data read back against what was written */
+	bool verify;
+	/* bytes moved per sequential point and ops per random point */
+	uint32_t seq_bytes;
+	uint32_t rand_ops;
+	/* optional setting swept around the whole run, e.g. NAND read batch */
+	const char *knob_name;
+	uint32_t (*knob)(uint32_t val);
+	const uint32_t *knob_vals;
+	unsigned knob_cnt;
+	/* called with each line of the report */
+	void (*report)(const char *line, void *arg);
+	void *arg;
+};
+
+int sbench_run(struct sbench_config *cfg);
+uint32_t sbench_percentile(const struct sbench_result *res, unsigned pct);
+int sbench_selftest(void (*report)(const char *line, void *arg), void *arg);
+
+#endif
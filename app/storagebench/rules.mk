@@ -0,0 +1,11 @@
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+INCLUDES += -I$(LOCAL_DIR)/include \
+	-I$(LK_TOP_DIR)/platform/msm_shared/include \
+	-I$(LK_TOP_DIR)/app/aboot
+
+MODULES += lib/bio
+
+OBJS += \
+	$(LOCAL_DIR)/storage_bench.o \
+	$(LOCAL_DIR)/storage_bench_app.o
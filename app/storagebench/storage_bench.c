@@ -0,0 +1,322 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Fundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Device independent core of the storage benchmark. It only talks to a
+ * lib/bio block device, so the same sweeps run against eMMC/UFS/NAND
+ * partitions and against a RAM backed mem bdev for regression testing.
+ */
+
+#include <debug.h>
+#include <err.h>
+#include <string.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <printf.h>
+#include <rand.h>
+#include <platform.h>
+#include <arch/defines.h>
+#include <lib/bio.h>
+#include <app/storagebench.h>
+
+#define SBENCH_PATTERN_SEED      0x5a17c0de
+#define SBENCH_LINE_LEN          64
+#define SBENCH_SELFTEST_SIZE     (2 * 1024 * 1024)
+#define SBENCH_SELFTEST_OPS      64
+
+static const uint32_t sbench_xfers[] = { 4096, 16384, 65536, 262144, SBENCH_MAX_XFER };
+
+static const char *sbench_pattern_name[SBENCH_PATTERNS] = {
+	[SBENCH_SEQ_WRITE]  = "sw",
+	[SBENCH_SEQ_READ]   = "sr",
+	[SBENCH_RAND_WRITE] = "rw",
+	[SBENCH_RAND_READ]  = "rr",
+};
+
+static void sbench_line(struct sbench_config *cfg, const char *fmt, ...)
+{
+	char line[SBENCH_LINE_LEN];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+
+	cfg->report(line, cfg->arg);
+}
+
+/* Every word holds its own byte offset on the device, so data that lands
+ * at the wrong offset is caught as well as corrupted data.
+ */
+static void sbench_fill(uint32_t *buf, uint64_t offset, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len / sizeof(uint32_t); i++)
+		buf[i] = (uint32_t)(offset + i * sizeof(uint32_t)) ^ SBENCH_PATTERN_SEED;
+}
+
+static bool sbench_check(const uint32_t *buf, uint64_t offset, uint32_t len)
+{
+	uint32_t i;
+
+	for (i = 0; i < len / sizeof(uint32_t); i++)
+		if (buf[i] != ((uint32_t)(offset + i * sizeof(uint32_t)) ^ SBENCH_PATTERN_SEED))
+			return false;
+
+	return true;
+}
+
+static void sbench_account(struct sbench_result *res, bigtime_t lat)
+{
+	uint32_t us = lat > 0xFFFFFFFF ? 0xFFFFFFFF : (uint32_t) lat;
+
+	res->ops++;
+	res->bytes += res->xfer;
+	res->elapsed += lat;
+	res->hist[us ? 31 - __builtin_clz(us) : 0]++;
+}
+
+/* Run one pattern at one transfer size */
+static void sbench_point(struct sbench_config *cfg, enum sbench_pattern pattern,
+			 uint32_t xfer, uint8_t *buf, struct sbench_result *res)
+{
+	bdev_t *dev = cfg->dev;
+	uint32_t slots = dev->size / xfer;
+	uint32_t blocks = xfer / dev->block_size;
+	bool write = (pattern == SBENCH_SEQ_WRITE || pattern == SBENCH_RAND_WRITE);
+	bool seq = (pattern == SBENCH_SEQ_WRITE || pattern == SBENCH_SEQ_READ);
+	uint32_t num_ops = seq ? MIN(cfg->seq_bytes / xfer, slots) : cfg->rand_ops;
+	uint32_t i, slot;
+	uint64_t offset;
+	bigtime_t t0, lat;
+	ssize_t ret;
+
+	memset(res, 0, sizeof(*res));
+	res->pattern = pattern;
+	res->xfer = xfer;
+
+	for (i = 0; i < num_ops; i++)
+	{
+		slot = seq ? i : (uint32_t) rand() % slots;
+		offset = (uint64_t) slot * xfer;
+
+		if (write)
+			sbench_fill((uint32_t *) buf, offset, xfer);
+
+		t0 = current_time_hires();
+		if (write)
+			ret = bio_write_block(dev, buf, offset / dev->block_size, blocks);
+		else
+			ret = bio_read_block(dev, buf, offset / dev->block_size, blocks);
+		lat = current_time_hires() - t0;
+
+		if (ret != (ssize_t) xfer)
+		{
+			res->errors++;
+			continue;
+		}
+
+		sbench_account(res, lat);
+
+		if (!write && cfg->verify && !sbench_check((uint32_t *) buf, offset, xfer))
+			res->errors++;
+	}
+}
+
+/**
+ * sbench_percentile() - Latency below which pct percent of the ops completed
+ *
+ * Returns the upper bound of the histogram bucket in us.
+ */
+uint32_t sbench_percentile(const struct sbench_result *res, unsigned pct)
+{
+	uint32_t target = (res->ops * pct + 99) / 100;
+	uint32_t seen = 0;
+	unsigned i;
+
+	for (i = 0; i < SBENCH_HIST_BUCKETS - 1; i++)
+	{
+		seen += res->hist[i];
+		if (seen >= target)
+			break;
+	}
+
+	return (i == SBENCH_HIST_BUCKETS - 1) ? 0xFFFFFFFF : (2U << i);
+}
+
+static void sbench_report(struct sbench_config *cfg, const struct sbench_result *res)
+{
+	bigtime_t elapsed = res->elapsed ? res->elapsed : 1;
+	/* bytes per us is MB/s, keep two decimals */
+	uint32_t mbps = (uint32_t) (res->bytes * 100 / elapsed);
+	uint32_t iops = (uint32_t) ((uint64_t) res->ops * 1000000 / elapsed);
+
+	sbench_line(cfg, "%s %7u: %u.%02uMB/s %uiops p50 %u p99 %uus%s",
+		    sbench_pattern_name[res->pattern], res->xfer,
+		    mbps / 100, mbps % 100, iops,
+		    sbench_percentile(res, 50), sbench_percentile(res, 99),
+		    res->errors ? " ERR" : "");
+}
+
+/**
+ * sbench_run() - Sequential and random read/write sweeps across transfer sizes
+ * @cfg: device, sweep sizes and report callback
+ *
+ * Write patterns overwrite the device, point it at a scratch partition.
+ *
+ * Returns NO_ERROR, ERR_IO if any op failed or returned bad data.
+ */
+int sbench_run(struct sbench_config *cfg)
+{
+	struct sbench_result res;
+	uint8_t *buf;
+	uint32_t errors = 0;
+	uint32_t val, prev = 0;
+	unsigned k, pattern, i;
+
+	if (!cfg->dev || cfg->dev->size < SBENCH_MIN_XFER ||
+		SBENCH_MIN_XFER % cfg->dev->block_size)
+		return ERR_INVALID_ARGS;
+
+	buf = memalign(CACHE_LINE, SBENCH_MAX_XFER);
+	if (!buf)
+		return ERR_NO_MEMORY;
+
+	for (k = 0; k < (cfg->knob ? cfg->knob_cnt : 1); k++)
+	{
+		if (cfg->knob)
+		{
+			/* The knob clamps to what the device supports, skip repeats */
+			val = cfg->knob(cfg->knob_vals[k]);
+			if (k && val == prev)
+				continue;
+			prev = val;
+			sbench_line(cfg, "%s %s=%u", cfg->label, cfg->knob_name, val);
+		}
+		else
+			sbench_line(cfg, "%s", cfg->label);
+
+		for (pattern = 0; pattern < SBENCH_PATTERNS; pattern++)
+		{
+			if (cfg->read_only &&
+				(pattern == SBENCH_SEQ_WRITE || pattern == SBENCH_RAND_WRITE))
+				continue;
+
+			for (i = 0; i < countof(sbench_xfers); i++)
+			{
+				if (sbench_xfers[i] > cfg->dev->size)
+					break;
+
+				sbench_point(cfg, pattern, sbench_xfers[i], buf, &res);
+				sbench_report(cfg, &res);
+				errors += res.errors;
+			}
+		}
+	}
+
+	free(buf);
+
+	return errors ? ERR_IO : NO_ERROR;
+}
+
+/**
+ * sbench_selftest() - Runs the benchmark against a mem bdev
+ *
+ * Checks the data path and offsets with verification on, that a corrupted
+ * word is caught and that the per point accounting adds up.
+ *
+ * Returns NO_ERROR on success.
+ */
+int sbench_selftest(void (*report)(const char *line, void *arg), void *arg)
+{
+	static uint32_t *mem;
+	struct sbench_config cfg;
+	struct sbench_result res;
+	uint8_t *buf;
+	bdev_t *dev;
+	int ret;
+
+	if (!mem)
+	{
+		mem = memalign(CACHE_LINE, SBENCH_SELFTEST_SIZE);
+		if (!mem)
+			return ERR_NO_MEMORY;
+		create_membdev("sbench-mem", mem, SBENCH_SELFTEST_SIZE);
+	}
+
+	dev = bio_open("sbench-mem");
+	if (!dev)
+		return ERR_NOT_FOUND;
+
+	memset(&cfg, 0, sizeof(cfg));
+	cfg.dev = dev;
+	cfg.label = "mem";
+	cfg.verify = true;
+	cfg.seq_bytes = SBENCH_SELFTEST_SIZE;
+	cfg.rand_ops = SBENCH_SELFTEST_OPS;
+	cfg.report = report;
+	cfg.arg = arg;
+
+	ret = sbench_run(&cfg);
+	if (ret)
+		goto out;
+
+	buf = memalign(CACHE_LINE, SBENCH_MIN_XFER);
+	if (!buf)
+	{
+		ret = ERR_NO_MEMORY;
+		goto out;
+	}
+
+	/* A full sequential pass must cover the device exactly once */
+	sbench_point(&cfg, SBENCH_SEQ_READ, SBENCH_MIN_XFER, buf, &res);
+	if (res.errors || res.ops != SBENCH_SELFTEST_SIZE / SBENCH_MIN_XFER ||
+		res.bytes != SBENCH_SELFTEST_SIZE || sbench_percentile(&res, 100) == 0xFFFFFFFF)
+	{
+		sbench_line(&cfg, "selftest: bad accounting %u ops %u errors", res.ops, res.errors);
+		ret = ERR_NOT_VALID;
+	}
+
+	/* A single flipped bit has to be reported */
+	mem[SBENCH_SELFTEST_SIZE / sizeof(uint32_t) / 2] ^= 1;
+	sbench_point(&cfg, SBENCH_SEQ_READ, SBENCH_MIN_XFER, buf, &res);
+	mem[SBENCH_SELFTEST_SIZE / sizeof(uint32_t) / 2] ^= 1;
+	if (res.errors != 1)
+	{
+		sbench_line(&cfg, "selftest: corruption missed, %u errors", res.errors);
+		ret = ERR_NOT_VALID;
+	}
+
+	free(buf);
+out:
+	bio_close(dev);
+	sbench_line(&cfg, "selftest: %s", ret ? "FAIL" : "PASS");
+	return ret;
+}
@@ -0,0 +1,350 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Fundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Storage benchmark front end: wraps an eMMC/UFS or NAND partition in a
+ * lib/bio device and runs the sweeps from the console ("sbench") or over
+ * fastboot ("fastboot oem storage-bench").
+ */
+
+#include <debug.h>
+#include <err.h>
+#include <string.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <printf.h>
+#include <app.h>
+#include <target.h>
+#include <lib/bio.h>
+#include <lib/ptable.h>
+#include <dev/flash.h>
+#include <qpic_nand.h>
+#include <app/storagebench.h>
+#include "fastboot.h"
+#include "devinfo.h"
+#if MMC_SDHCI_SUPPORT
+#include <partition_parser.h>
+#include <mmc_wrapper.h>
+#include <mmc_sdhci.h>
+#include <boot_device.h>
+#endif
+#if UFS_SUPPORT
+#include <ufs.h>
+#endif
+
+#define SBENCH_SEQ_BYTES         (32 * 1024 * 1024)
+#define SBENCH_RAND_OPS          256
+#define SBENCH_BDEV_BLOCK_SIZE   512
+#define SBENCH_LABEL_LEN         32
+
+struct sbench_part {
+	bdev_t dev;
+	uint64_t offset;
+	uint8_t lun;
+	struct ptentry *ptn;
+};
+
+static const uint32_t sbench_nand_batches[] = { 1, QPIC_NAND_READ_BATCH_PAGES };
+
+/*
+ * Partitions the write sweeps may scribble over. Anything else can only be
+ * benchmarked read-only, and nothing at all while the device is locked.
+ */
+static const char *sbench_scratch_parts[] = { "sbench", "cache" };
+
+static bool sbench_is_scratch(const char *name)
+{
+	unsigned i;
+
+	for (i = 0; i < countof(sbench_scratch_parts); i++)
+		if (!strcmp(name, sbench_scratch_parts[i]))
+			return true;
+
+	return false;
+}
+
+static ssize_t sbench_nand_read_block(struct bdev *bdev, void *buf, bnum_t block, uint count)
+{
+	struct sbench_part *part = (struct sbench_part *) bdev;
+
+	if (flash_read(part->ptn, block * bdev->block_size, buf, count * bdev->block_size))
+		return ERR_IO;
+
+	return count * bdev->block_size;
+}
+
+#if MMC_SDHCI_SUPPORT
+static ssize_t sbench_mmc_read_block(struct bdev *bdev, void *buf, bnum_t block, uint count)
+{
+	struct sbench_part *part = (struct sbench_part *) bdev;
+
+	mmc_set_lun(part->lun);
+	if (mmc_read(part->offset + (uint64_t) block * bdev->block_size,
+				 (uint32_t *) buf, count * bdev->block_size))
+		return ERR_IO;
+
+	return count * bdev->block_size;
+}
+
+static ssize_t sbench_mmc_write_block(struct bdev *bdev, const void *buf, bnum_t block, uint count)
+{
+	struct sbench_part *part = (struct sbench_part *) bdev;
+
+	mmc_set_lun(part->lun);
+	if (mmc_write(part->offset + (uint64_t) block * bdev->block_size,
+				  count * bdev->block_size, (void *) buf))
+		return ERR_IO;
+
+	return count * bdev->block_size;
+}
+#endif
+
+/* Wrap the named partition in a bio device and pick the settings to sweep */
+static struct sbench_part *sbench_open(const char *name, struct sbench_config *cfg, char *label)
+{
+	struct sbench_part *part;
+	struct ptable *ptable;
+
+	part = malloc(sizeof(*part));
+	if (!part)
+		return NULL;
+
+	memset(part, 0, sizeof(*part));
+
+	if (target_is_emmc_boot())
+	{
+#if MMC_SDHCI_SUPPORT
+		int index = partition_get_index(name);
+
+		if (index == INVALID_PTN)
+			goto err;
+
+		part->offset = partition_get_offset(index);
+		part->lun = partition_get_lun(index);
+		bio_initialize_bdev(&part->dev, name, SBENCH_BDEV_BLOCK_SIZE,
+							partition_get_size(index) / SBENCH_BDEV_BLOCK_SIZE);
+		part->dev.read_block = sbench_mmc_read_block;
+		part->dev.write_block = sbench_mmc_write_block;
+
+		snprintf(label, SBENCH_LABEL_LEN, "%s lun%u %s",
+				 platform_boot_dev_isemmc() ? "emmc" : "ufs", part->lun, name);
+#else
+		goto err;
+#endif
+	}
+	else
+	{
+		ptable = flash_get_ptable();
+		part->ptn = ptable ? ptable_find(ptable, name) : NULL;
+		if (!part->ptn)
+			goto err;
+
+		bio_initialize_bdev(&part->dev, name, SBENCH_BDEV_BLOCK_SIZE,
+							((uint64_t) part->ptn->length * flash_block_size()) / SBENCH_BDEV_BLOCK_SIZE);
+		part->dev.read_block = sbench_nand_read_block;
+
+		/* dev/flash can only rewrite a whole partition, no block writes */
+		cfg->read_only = true;
+
+		snprintf(label, SBENCH_LABEL_LEN, "nand %s", name);
+
+		cfg->knob_name = "batch";
+		cfg->knob = qpic_nand_set_read_batch;
+		cfg->knob_vals = sbench_nand_batches;
+		cfg->knob_cnt = countof(sbench_nand_batches);
+	}
+
+	bio_register_device(&part->dev);
+	return part;
+
+err:
+	free(part);
+	return NULL;
+}
+
+/* Dropping the last reference frees the part along with the bio device */
+static void sbench_close(struct sbench_part *part, struct sbench_config *cfg)
+{
+	/* Leave the sweep knob at its most parallel setting, the default */
+	if (cfg->knob)
+		cfg->knob(cfg->knob_vals[cfg->knob_cnt - 1]);
+
+	bio_unregister_device(&part->dev);
+}
+
+static int sbench_partition(const char *name, bool read_only,
+							void (*report)(const char *line, void *arg), void *arg)
+{
+	struct sbench_config cfg;
+	struct sbench_part *part;
+	char label[SBENCH_LABEL_LEN];
+#if MMC_SDHCI_SUPPORT
+	uint8_t lun = mmc_get_lun();
+#endif
+	int ret;
+
+	if (!device_is_unlocked())
+		return ERR_NOT_ALLOWED;
+
+	if (!read_only && !sbench_is_scratch(name))
+		return ERR_INVALID_ARGS;
+
+	memset(&cfg, 0, sizeof(cfg));
+
+	part = sbench_open(name, &cfg, label);
+	if (!part)
+		return ERR_NOT_FOUND;
+
+	cfg.dev = &part->dev;
+	cfg.label = label;
+	cfg.read_only |= read_only;
+	cfg.seq_bytes = SBENCH_SEQ_BYTES;
+	cfg.rand_ops = SBENCH_RAND_OPS;
+	cfg.report = report;
+	cfg.arg = arg;
+
+#if UFS_SUPPORT
+	if (target_is_emmc_boot() && !platform_boot_dev_isemmc())
+		ufs_reset_queue_stats(target_mmc_device());
+#endif
+
+	ret = sbench_run(&cfg);
+
+#if UFS_SUPPORT
+	/* Per command latency and queue depth over the whole run */
+	if (target_is_emmc_boot() && !platform_boot_dev_isemmc())
+		ufs_dump_queue_stats(target_mmc_device(), report, arg);
+#endif
+
+	sbench_close(part, &cfg);
+#if MMC_SDHCI_SUPPORT
+	mmc_set_lun(lun);
+#endif
+
+	return ret;
+}
+
+static void sbench_fastboot_line(const char *line, void *arg)
+{
+	fastboot_info(line);
+}
+
+/* fastboot oem storage-bench <partition> [ro] | selftest */
+static void cmd_oem_storage_bench(const char *arg, void *data, unsigned sz)
+{
+	char name[MAX_PTENTRY_NAME];
+	bool read_only = false;
+	unsigned len;
+	int ret;
+
+	while (*arg == ' ')
+		arg++;
+
+	for (len = 0; arg[len] && arg[len] != ' ' && len < sizeof(name) - 1; len++)
+		name[len] = arg[len];
+	name[len] = '\0';
+	arg += len;
+
+	while (*arg == ' ')
+		arg++;
+
+	if (!strcmp(arg, "ro"))
+		read_only = true;
+	else if (*arg)
+		len = 0;
+
+	if (!len)
+	{
+		fastboot_fail("usage: oem storage-bench <partition> [ro] | selftest");
+		return;
+	}
+
+	if (!strcmp(name, "selftest"))
+		ret = sbench_selftest(sbench_fastboot_line, NULL);
+	else
+		ret = sbench_partition(name, read_only, sbench_fastboot_line, NULL);
+
+	if (ret == ERR_NOT_FOUND)
+		fastboot_fail("partition not found");
+	else if (ret == ERR_NOT_ALLOWED)
+		fastboot_fail("device is locked");
+	else if (ret == ERR_INVALID_ARGS)
+		fastboot_fail("writes need a scratch partition, or pass ro");
+	else if (ret)
+		fastboot_fail("storage bench failed");
+	else
+		fastboot_okay("");
+}
+
+#if defined(WITH_LIB_CONSOLE)
+#include <lib/console.h>
+
+static void sbench_console_line(const char *line, void *arg)
+{
+	printf("%s\n", line);
+}
+
+static int sbench_cmd(int argc, const cmd_args *argv)
+{
+	int ret;
+
+	if (argc < 2) {
+		printf("usage:\n");
+		printf("%s <partition> [ro]\n", argv[0].str);
+		printf("%s selftest\n", argv[0].str);
+		return ERR_INVALID_ARGS;
+	}
+
+	if (!strcmp(argv[1].str, "selftest"))
+		ret = sbench_selftest(sbench_console_line, NULL);
+	else
+		ret = sbench_partition(argv[1].str, argc > 2 && !strcmp(argv[2].str, "ro"),
+							   sbench_console_line, NULL);
+
+	if (ret == ERR_INVALID_ARGS)
+		printf("writes need a scratch partition, or pass ro\n");
+	else if (ret)
+		printf("storage bench failed: %d\n", ret);
+
+	return ret;
+}
+
+STATIC_COMMAND_START
+{ "sbench", "storage benchmark", &sbench_cmd },
+STATIC_COMMAND_END(storagebench);
+#endif
+
+static void storagebench_init(const struct app_descriptor *app)
+{
+	fastboot_register("oem storage-bench", cmd_oem_storage_bench);
+}
+
+APP_START(storagebench)
+	.init = storagebench_init,
+APP_END
@@ -25,6 +25,7 @@
 #include <malloc.h>
 #include <app.h>
 #include <platform.h>
+#include <arch/ops.h>
 #include <kernel/thread.h>
 
 static uint8_t *src;
@@ -226,6 +227,201 @@ static void validate_memset(void)
 	}
 }
 
+static int ref_memcmp(const void *cs, const void *ct, size_t count)
+{
+	const unsigned char *su1 = cs, *su2 = ct;
+
+	for (; count > 0; su1++, su2++, count--)
+		if (*su1 != *su2)
+			return *su1 - *su2;
+	return 0;
+}
+
+static int sign(int x)
+{
+	return (x > 0) - (x < 0);
+}
+
+static void validate_memcmp(void)
+{
+	size_t srcalign, dstalign, size, pos;
+	const size_t maxsize = 256;
+
+	printf("testing memcmp for correctness\n");
+
+	for (srcalign = 0; srcalign < 16; srcalign++) {
+		for (dstalign = 0; dstalign < 16; dstalign++) {
+			for (size = 0; size < maxsize; size++) {
+				fillbuf(src, maxsize * 2, 567);
+				memcpy(dst + dstalign, src + srcalign, size);
+
+				if (memcmp(dst + dstalign, src + srcalign, size) != 0)
+					printf("error! equal srcalign %zu, dstalign %zu, size %zu\n", srcalign, dstalign, size);
+
+				/* flip one byte at a time, both directions */
+				for (pos = 0; pos < size; pos += 7) {
+					dst[dstalign + pos] ^= 0x81;
+					if (sign(memcmp(dst + dstalign, src + srcalign, size)) !=
+						sign(ref_memcmp(dst + dstalign, src + srcalign, size)) ||
+						sign(memcmp(src + srcalign, dst + dstalign, size)) !=
+						sign(ref_memcmp(src + srcalign, dst + dstalign, size)))
+						printf("error! srcalign %zu, dstalign %zu, size %zu, pos %zu\n",
+							srcalign, dstalign, size, pos);
+					dst[dstalign + pos] ^= 0x81;
+				}
+			}
+		}
+	}
+}
+
+static void validate_strlen(void)
+{
+	size_t align, size;
+	const size_t maxsize = 256;
+
+	printf("testing strlen for correctness\n");
+
+	for (align = 0; align < 16; align++) {
+		for (size = 0; size < maxsize; size++) {
+			/* no zero bytes in the string, garbage after the terminator */
+			memset(dst, 0x80, maxsize * 2);
+			memset(dst + align, 0x01, size);
+			dst[align + size] = 0;
+
+			if (strlen((char *)dst + align) != size)
+				printf("error! align %zu, size %zu, got %zu\n", align, size, strlen((char *)dst + align));
+		}
+	}
+}
+
+static void validate_memchr(void)
+{
+	size_t align, size, pos;
+	const size_t maxsize = 256;
+	void *p;
+
+	printf("testing memchr for correctness\n");
+
+	for (align = 0; align < 16; align++) {
+		for (size = 0; size < maxsize; size++) {
+			memset(dst, 0xfe, maxsize * 2);
+
+			/* the byte just past the end must not be found */
+			dst[align + size] = 0xff;
+			if ((p = memchr(dst + align, 0xff, size)) != NULL)
+				printf("error! align %zu, size %zu, found %p past end\n", align, size, p);
+
+			for (pos = 0; pos < size; pos++) {
+				dst[align + pos] = 0xff;
+				if ((p = memchr(dst + align, 0xff, size)) != dst + align + pos)
+					printf("error! align %zu, size %zu, pos %zu, got %p\n", align, size, pos, p);
+				dst[align + pos] = 0xfe;
+			}
+		}
+	}
+}
+
+/*
+ * cycle accurate throughput of the libc routines across sizes and alignments,
+ * reported as bytes/cycle (in hundredths, so 1.00 bytes/cycle prints 100).
+ */
+enum string_routine {
+	ROUTINE_MEMCPY,
+	ROUTINE_MEMSET,
+	ROUTINE_MEMCMP,
+	ROUTINE_MEMCHR,
+	ROUTINE_STRLEN,
+	ROUTINE_COUNT,
+};
+
+static const char *routine_name[ROUTINE_COUNT] = {
+	"memcpy", "memset", "memcmp", "memchr", "strlen",
+};
+
+static const size_t cycle_sizes[] = { 8, 32, 128, 512, 4096, 65536, BUFFER_SIZE };
+static const size_t cycle_aligns[] = { 0, 1, 2, 3, 4, 8 };
+
+static uint32_t cycles_routine(enum string_routine r, size_t size, size_t srcalign, size_t dstalign)
+{
+	uint32_t t0;
+	volatile int sink;
+
+	t0 = arch_cycle_count();
+	switch (r) {
+		case ROUTINE_MEMCPY:
+			memcpy(dst + dstalign, src + srcalign, size);
+			break;
+		case ROUTINE_MEMSET:
+			memset(dst + dstalign, 0, size);
+			break;
+		case ROUTINE_MEMCMP:
+			sink = memcmp(dst + dstalign, src + srcalign, size);
+			break;
+		case ROUTINE_MEMCHR:
+			sink = (memchr(src + srcalign, 0xff, size) != NULL);
+			break;
+		case ROUTINE_STRLEN:
+			sink = strlen((char *)src + srcalign);
+			break;
+		default:
+			break;
+	}
+	(void)sink;
+	return arch_cycle_count() - t0;
+}
+
+static void bench_cycles_routine(enum string_routine r)
+{
+	uint i, j;
+	int iter;
+	size_t size;
+	uint32_t c, best;
+
+	printf("%s bytes/cycle x100, srcalign/dstalign across the top\n", routine_name[r]);
+	printf("%8s", "size");
+	for (j = 0; j < countof(cycle_aligns); j++)
+		printf("   %zu/%zu", cycle_aligns[j], cycle_aligns[countof(cycle_aligns) - 1 - j]);
+	printf("\n");
+
+	for (i = 0; i < countof(cycle_sizes); i++) {
+		size = cycle_sizes[i];
+		printf("%8zu", size);
+
+		for (j = 0; j < countof(cycle_aligns); j++) {
+			size_t sa = cycle_aligns[j];
+			size_t da = cycle_aligns[countof(cycle_aligns) - 1 - j];
+
+			/* equal buffers for memcmp, no match for memchr, one long string for strlen */
+			memset(src, 0x5a, size + sa + 1);
+			memset(dst, 0x5a, size + da + 1);
+			src[sa + size] = 0;
+
+			/* warm up, then take the best of a few runs */
+			cycles_routine(r, size, sa, da);
+			best = ~0U;
+			for (iter = 0; iter < ITERATIONS; iter++) {
+				c = cycles_routine(r, size, sa, da);
+				if (c < best)
+					best = c;
+			}
+			printf(" %7llu", best ? size * 100ULL / best : 0ULL);
+		}
+		printf("\n");
+	}
+}
+
+static void bench_cycles(const char *name)
+{
+	int r;
+
+	thread_sleep(200); // let the debug string clear the serial port
+
+	for (r = 0; r < ROUTINE_COUNT; r++) {
+		if (!strcmp(name, "all") || !strcmp(name, routine_name[r]))
+			bench_cycles_routine(r);
+	}
+}
+
 #if defined(WITH_LIB_CONSOLE)
 #include <lib/console.h>
 
@@ -244,6 +440,7 @@ static int string_tests(int argc, cmd_args *argv)
 usage:
 		printf("%s validate <routine>\n", argv[0].str);
 		printf("%s bench <routine>\n", argv[0].str);
+		printf("%s cycles <memcpy|memset|memcmp|memchr|strlen|all>\n", argv[0].str);
 		goto out;
 	}
 
@@ -254,6 +451,12 @@ usage:
 			validate_memset();
 		} else if (!strcmp(argv[2].str, "memcpy_overlap")) {
 			validate_memcpy_overlap();
+		} else if (!strcmp(argv[2].str, "memcmp")) {
+			validate_memcmp();
+		} else if (!strcmp(argv[2].str, "strlen")) {
+			validate_strlen();
+		} else if (!strcmp(argv[2].str, "memchr")) {
+			validate_memchr();
 		}
 	} else if (!strcmp(argv[1].str, "bench")) {
 		if (!strcmp(argv[2].str, "memcpy")) {
@@ -261,6 +464,8 @@ usage:
 		} else if (!strcmp(argv[2].str, "memset")) {
 			bench_memset();
 		}
+	} else if (!strcmp(argv[1].str, "cycles")) {
+		bench_cycles(argv[2].str);
 	} else {
 		goto usage;
 	}
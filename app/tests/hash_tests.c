@@ -0,0 +1,303 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <debug.h>
+#include <string.h>
+#include <stdlib.h>
+#include <err.h>
+#include <arch/defines.h>
+#include <crypto_hash.h>
+#include <kernel/workqueue.h>
+#include <arch/ops.h>
+#include <app/tests.h>
+#if CRYPTO_SHA_ARMV8
+#include <sha_armv8.h>
+#endif
+
+#define HASH_TEST_LEN 3000
+#define HASH_BENCH_LEN (256 * 1024)
+
+/* SHA1("abc") */
+static const unsigned char sha1_abc[] = {
+	0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a,
+	0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+	0x9c, 0xd0, 0xd8, 0x9d,
+};
+
+/* SHA256("abc") */
+static const unsigned char sha256_abc[] = {
+	0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+	0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+	0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+	0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+};
+
+/* SHA256 of the empty message */
+static const unsigned char sha256_empty[] = {
+	0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+	0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+	0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+	0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55,
+};
+
+/* piece sizes straddling the SHA block size, the rest goes in the last piece */
+static const uint32_t piece_len[] = { 1, 63, 64, 65, 127, 1000 };
+#define NUM_PIECES (sizeof(piece_len) / sizeof(piece_len[0]) + 1)
+
+static int check(const char *name, const unsigned char *got,
+		 const unsigned char *expected, uint32_t len)
+{
+	if (!memcmp(got, expected, len))
+		return 0;
+
+	tests_printf("%s: digest mismatch\n", name);
+	return 1;
+}
+
+static int hash_alg_tests(crypto_auth_alg_type alg, crypto_engine_type engine,
+			  unsigned char *buf)
+{
+	struct hash_ctx ctx;
+	struct hash_sg sg[NUM_PIECES];
+	struct hash_async_req req[2];
+	work_group_t group;
+	unsigned char ref[SHA256_DIGEST_LENGTH];
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	uint32_t len = hash_digest_len(alg);
+	uint32_t off = 0;
+	uint32_t i;
+	int failures = 0;
+
+	hash_find(buf, HASH_TEST_LEN, ref, alg);
+
+	for (i = 0; i < NUM_PIECES - 1; i++) {
+		sg[i].addr = buf + off;
+		sg[i].len = piece_len[i];
+		off += piece_len[i];
+	}
+	sg[i].addr = buf + off;
+	sg[i].len = HASH_TEST_LEN - off;
+
+	/* uneven scatter-gather pieces match the one shot digest */
+	if (hash_init_engine(&ctx, alg, engine) != CRYPTO_SHA_ERR_NONE ||
+	    hash_update_sg(&ctx, sg, NUM_PIECES) != CRYPTO_SHA_ERR_NONE ||
+	    hash_final(&ctx, digest) != CRYPTO_SHA_ERR_NONE) {
+		tests_printf("sg hash failed\n");
+		failures++;
+	} else {
+		failures += check("sg", digest, ref, len);
+	}
+
+	/* a single contiguous update */
+	hash_init_engine(&ctx, alg, engine);
+	hash_update(&ctx, buf, HASH_TEST_LEN);
+	hash_final(&ctx, digest);
+	failures += check("contiguous", digest, ref, len);
+
+	/* the same list split over two queued requests */
+	hash_init_engine(&ctx, alg, engine);
+	work_group_init(&group);
+	hash_update_async(&req[0], &ctx, sg, 3, &group);
+	hash_update_async(&req[1], &ctx, sg + 3, NUM_PIECES - 3, &group);
+	if (work_group_wait(&group, INFINITE_TIME) != NO_ERROR ||
+	    req[0].ret != CRYPTO_SHA_ERR_NONE || req[1].ret != CRYPTO_SHA_ERR_NONE) {
+		tests_printf("async hash failed\n");
+		failures++;
+	} else {
+		hash_final(&ctx, digest);
+		failures += check("async", digest, ref, len);
+	}
+
+	return failures;
+}
+
+#if CRYPTO_SHA_ARMV8
+/* the ARMv8 update functions against OpenSSL, with a partial block carried over */
+static int sha_armv8_tests(unsigned char *buf)
+{
+	SHA_CTX c1;
+	SHA256_CTX c256;
+	unsigned char ref[SHA256_DIGEST_LENGTH];
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	int failures = 0;
+
+	if (!sha_armv8_supported()) {
+		tests_printf("no ARMv8 SHA instructions, skipping\n");
+		return 0;
+	}
+
+	SHA1(buf, HASH_TEST_LEN, ref);
+	SHA1_Init(&c1);
+	sha1_armv8_update(&c1, buf, 5);
+	sha1_armv8_update(&c1, buf + 5, HASH_TEST_LEN - 5);
+	SHA1_Final(digest, &c1);
+	failures += check("armv8 sha1", digest, ref, SHA_DIGEST_LENGTH);
+
+	SHA256(buf, HASH_TEST_LEN, ref);
+	SHA256_Init(&c256);
+	sha256_armv8_update(&c256, buf, 5);
+	sha256_armv8_update(&c256, buf + 5, HASH_TEST_LEN - 5);
+	SHA256_Final(digest, &c256);
+	failures += check("armv8 sha256", digest, ref, SHA256_DIGEST_LENGTH);
+
+	return failures;
+}
+#endif
+
+int hash_tests(void)
+{
+	struct hash_ctx ctx;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	unsigned char *buf;
+	uint32_t i;
+	int failures = 0;
+
+	tests_printf("hash tests\n");
+
+	buf = memalign(CACHE_LINE, ROUNDUP(HASH_TEST_LEN, CACHE_LINE));
+	if (!buf) {
+		tests_printf("failed to allocate test buffer\n");
+		return -1;
+	}
+
+	for (i = 0; i < HASH_TEST_LEN; i++)
+		buf[i] = (i * 7) ^ (i >> 8);
+
+	/* known answers */
+	hash_init(&ctx, CRYPTO_AUTH_ALG_SHA256);
+	hash_update(&ctx, "a", 1);
+	hash_update(&ctx, "bc", 2);
+	hash_final(&ctx, digest);
+	failures += check("abc", digest, sha256_abc, sizeof(sha256_abc));
+
+	hash_init(&ctx, CRYPTO_AUTH_ALG_SHA1);
+	hash_update(&ctx, "abc", 3);
+	hash_final(&ctx, digest);
+	failures += check("sha1 abc", digest, sha1_abc, sizeof(sha1_abc));
+
+	hash_init(&ctx, CRYPTO_AUTH_ALG_SHA256);
+	hash_final(&ctx, digest);
+	failures += check("empty", digest, sha256_empty, sizeof(sha256_empty));
+
+	/* hash_find() is the reference, whichever engine it picked */
+	failures += hash_alg_tests(CRYPTO_AUTH_ALG_SHA1, CRYPTO_ENGINE_TYPE_SW, buf);
+	failures += hash_alg_tests(CRYPTO_AUTH_ALG_SHA256, CRYPTO_ENGINE_TYPE_SW, buf);
+	if (board_ce_type() == CRYPTO_ENGINE_TYPE_HW) {
+		failures += hash_alg_tests(CRYPTO_AUTH_ALG_SHA1, CRYPTO_ENGINE_TYPE_HW, buf);
+		failures += hash_alg_tests(CRYPTO_AUTH_ALG_SHA256, CRYPTO_ENGINE_TYPE_HW, buf);
+	}
+#if CRYPTO_SHA_ARMV8
+	failures += sha_armv8_tests(buf);
+#endif
+
+	free(buf);
+
+	tests_printf("hash tests %s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+
+	return failures ? -1 : 0;
+}
+
+/* cycles/byte (in hundredths) of one pass over the bench buffer */
+static uint32_t bench_cpb(uint32_t t0)
+{
+	return (uint32_t)(((uint64_t)(arch_cycle_count() - t0) * 100) / HASH_BENCH_LEN);
+}
+
+/* one streamed SHA256 pass over the bench buffer on the given engine */
+static uint32_t bench_engine(crypto_engine_type engine, unsigned char *buf,
+			     unsigned char *digest)
+{
+	struct hash_ctx ctx;
+	uint32_t t0;
+
+	t0 = arch_cycle_count();
+	hash_init_engine(&ctx, CRYPTO_AUTH_ALG_SHA256, engine);
+	hash_update(&ctx, buf, HASH_BENCH_LEN);
+	hash_final(&ctx, digest);
+
+	return bench_cpb(t0);
+}
+
+int hash_bench(void)
+{
+	SHA_CTX c1;
+	SHA256_CTX c256;
+	struct hash_ctx ctx;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	unsigned char *buf;
+	uint32_t t0;
+
+	buf = memalign(CACHE_LINE, HASH_BENCH_LEN);
+	if (!buf) {
+		tests_printf("failed to allocate bench buffer\n");
+		return -1;
+	}
+	memset(buf, 0xa5, HASH_BENCH_LEN);
+
+	tests_printf("hash cycles/byte x100 over %d bytes\n", HASH_BENCH_LEN);
+
+	t0 = arch_cycle_count();
+	SHA1_Init(&c1);
+	SHA1_Update(&c1, buf, HASH_BENCH_LEN);
+	SHA1_Final(digest, &c1);
+	tests_printf("openssl sha1     %6u\n", bench_cpb(t0));
+
+	t0 = arch_cycle_count();
+	SHA256_Init(&c256);
+	SHA256_Update(&c256, buf, HASH_BENCH_LEN);
+	SHA256_Final(digest, &c256);
+	tests_printf("openssl sha256   %6u\n", bench_cpb(t0));
+
+#if CRYPTO_SHA_ARMV8
+	if (sha_armv8_supported()) {
+		t0 = arch_cycle_count();
+		SHA1_Init(&c1);
+		sha1_armv8_update(&c1, buf, HASH_BENCH_LEN);
+		SHA1_Final(digest, &c1);
+		tests_printf("armv8 sha1       %6u\n", bench_cpb(t0));
+
+		t0 = arch_cycle_count();
+		SHA256_Init(&c256);
+		sha256_armv8_update(&c256, buf, HASH_BENCH_LEN);
+		SHA256_Final(digest, &c256);
+		tests_printf("armv8 sha256     %6u\n", bench_cpb(t0));
+	}
+#endif
+
+	tests_printf("stream sw sha256 %6u\n", bench_engine(CRYPTO_ENGINE_TYPE_SW, buf, digest));
+
+	if (board_ce_type() == CRYPTO_ENGINE_TYPE_HW) {
+		/* bring the engine and its clocks up outside the timed pass */
+		hash_init_engine(&ctx, CRYPTO_AUTH_ALG_SHA256, CRYPTO_ENGINE_TYPE_HW);
+		hash_final(&ctx, digest);
+
+		tests_printf("stream ce sha256 %6u\n", bench_engine(CRYPTO_ENGINE_TYPE_HW, buf, digest));
+	}
+
+	t0 = arch_cycle_count();
+	hash_find(buf, HASH_BENCH_LEN, digest, CRYPTO_AUTH_ALG_SHA256);
+	tests_printf("hash_find sha256 %6u\n", bench_cpb(t0));
+
+	free(buf);
+
+	return 0;
+}
@@ -23,8 +23,21 @@
 #ifndef __APP_TESTS_H
 #define __APP_TESTS_H
 
+#include <compiler.h>
+
 int thread_tests(void);
+int smp_tests(void);
 void printf_tests(void);
+int workqueue_tests(void);
+int hash_tests(void);
+int hash_bench(void);
+int rsa_tests(void);
+int pmic_batch_tests(void);
+
+/* one response worth of test output */
+#define MAX_TESTS_LINE 60
+
+void tests_printf(const char *fmt, ...) __PRINTFLIKE(1, 2);
 
 #endif
 
@@ -30,6 +30,7 @@
 #include <app/kauth_test.h>
 #include <crypto_hash.h>
 #include <partition_parser.h>
+#include <image_verify.h>
 #include <arch/defines.h>
 #include <debug.h>
 #include <stdlib.h>
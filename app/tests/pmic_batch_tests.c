@@ -0,0 +1,268 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <debug.h>
+#include <string.h>
+#include <err.h>
+#include <spmi.h>
+#include <platform.h>
+#include <pm8x41_hw.h>
+#include <pm8x41_batch.h>
+#include <app/tests.h>
+
+/*
+ * Test double for the PMIC arbiter: one register file per peripheral and a
+ * log of the commands the batch layer issued.
+ */
+#define FAKE_PERIPH_A   0xC0
+#define FAKE_PERIPH_B   0xC1
+#define FAKE_LOG_MAX    32
+
+/* read only identification registers, safe to read on any board */
+#define REVID_REVISION1 (REVID_REVISION4 - 3)
+#define REVID_REGS      4
+#define HW_BENCH_ITERS  100
+
+struct fake_cmd {
+	bool write;
+	uint32_t addr;
+	uint8_t size;
+};
+
+static uint8_t fake_regs[2][256];
+static struct fake_cmd fake_log[FAKE_LOG_MAX];
+static unsigned fake_log_num;
+
+static uint8_t *fake_reg(struct pmic_arb_cmd *cmd, unsigned i)
+{
+	ASSERT(cmd->slave_id == 0);
+	ASSERT(cmd->address == FAKE_PERIPH_A || cmd->address == FAKE_PERIPH_B);
+	ASSERT(cmd->offset + i < 256);
+
+	return &fake_regs[cmd->address - FAKE_PERIPH_A][cmd->offset + i];
+}
+
+static void fake_record(struct pmic_arb_cmd *cmd, struct pmic_arb_param *param, bool write)
+{
+	ASSERT(fake_log_num < FAKE_LOG_MAX);
+	ASSERT(param->size >= 1 && param->size <= PM_BATCH_MAX_BURST);
+
+	fake_log[fake_log_num].write = write;
+	fake_log[fake_log_num].addr = (cmd->address << 8) | cmd->offset;
+	fake_log[fake_log_num].size = param->size;
+	fake_log_num++;
+}
+
+static unsigned int fake_arb_read(struct pmic_arb_cmd *cmd, struct pmic_arb_param *param)
+{
+	unsigned i;
+
+	fake_record(cmd, param, false);
+	for (i = 0; i < param->size; i++)
+		param->buffer[i] = *fake_reg(cmd, i);
+
+	return 0;
+}
+
+static unsigned int fake_arb_write(struct pmic_arb_cmd *cmd, struct pmic_arb_param *param)
+{
+	unsigned i;
+
+	fake_record(cmd, param, true);
+	for (i = 0; i < param->size; i++)
+		*fake_reg(cmd, i) = param->buffer[i];
+
+	return 0;
+}
+
+static const struct pm_batch_arb fake_arb = {
+	.read  = fake_arb_read,
+	.write = fake_arb_write,
+};
+
+static void fake_reset(void)
+{
+	memset(fake_regs, 0, sizeof(fake_regs));
+	fake_log_num = 0;
+}
+
+#define REG_A(off) ((FAKE_PERIPH_A << 8) | (off))
+#define REG_B(off) ((FAKE_PERIPH_B << 8) | (off))
+
+static int expect_cmd(const char *name, unsigned idx, bool write, uint32_t addr, uint8_t size)
+{
+	if (idx < fake_log_num && fake_log[idx].write == write &&
+	    fake_log[idx].addr == addr && fake_log[idx].size == size)
+		return 0;
+
+	tests_printf("%s: command %u is not %s 0x%x/%u\n", name, idx,
+	       write ? "write" : "read", addr, size);
+	return 1;
+}
+
+static int expect_count(const char *name, unsigned num)
+{
+	if (fake_log_num == num)
+		return 0;
+
+	tests_printf("%s: %u arbiter commands, expected %u\n", name, fake_log_num, num);
+	return 1;
+}
+
+/* On the real arbiter: one burst over REVID matches single reads, and is timed */
+static int pmic_batch_hw_tests(void)
+{
+	struct pm_batch b;
+	uint8_t out[REVID_REGS];
+	bigtime_t t0;
+	unsigned single_us;
+	unsigned burst_us;
+	int fail = 0;
+	int i;
+	int n;
+
+	pm_batch_init(&b);
+	for (i = 0; i < REVID_REGS; i++)
+		pm_batch_read(&b, REVID_REVISION1 + i, &out[i]);
+	fail |= pm_batch_run(&b) != NO_ERROR;
+
+	for (i = 0; i < REVID_REGS; i++) {
+		if (out[i] != REG_READ(REVID_REVISION1 + i)) {
+			tests_printf("revid %d: burst 0x%x, single read 0x%x\n", i, out[i],
+				     REG_READ(REVID_REVISION1 + i));
+			fail = 1;
+		}
+	}
+
+	t0 = current_time_hires();
+	for (n = 0; n < HW_BENCH_ITERS; n++)
+		for (i = 0; i < REVID_REGS; i++)
+			out[i] = REG_READ(REVID_REVISION1 + i);
+	single_us = (current_time_hires() - t0) / HW_BENCH_ITERS;
+
+	t0 = current_time_hires();
+	for (n = 0; n < HW_BENCH_ITERS; n++) {
+		pm_batch_init(&b);
+		for (i = 0; i < REVID_REGS; i++)
+			pm_batch_read(&b, REVID_REVISION1 + i, &out[i]);
+		pm_batch_run(&b);
+	}
+	burst_us = (current_time_hires() - t0) / HW_BENCH_ITERS;
+
+	tests_printf("%d regs: single reads %u us, burst %u us\n", REVID_REGS,
+		     single_us, burst_us);
+
+	return fail;
+}
+
+int pmic_batch_tests(void)
+{
+	struct pm_batch b;
+	uint8_t out[4];
+	int fail = 0;
+	int i;
+
+	pm_batch_set_arb(&fake_arb);
+
+	/* adjacent writes merge, up to the burst length */
+	fake_reset();
+	pm_batch_init(&b);
+	for (i = 0; i < 10; i++)
+		pm_batch_write(&b, REG_A(0x40 + i), 0x10 + i);
+	fail |= pm_batch_run(&b) != NO_ERROR;
+	fail |= expect_count("burst", 2);
+	fail |= expect_cmd("burst", 0, true, REG_A(0x40), 8);
+	fail |= expect_cmd("burst", 1, true, REG_A(0x48), 2);
+	fail |= fake_regs[0][0x49] != 0x19;
+
+	/* adjacent reads merge and land in their destinations */
+	pm_batch_init(&b);
+	for (i = 0; i < 4; i++)
+		pm_batch_read(&b, REG_A(0x42 + i), &out[i]);
+	fake_log_num = 0;
+	fail |= pm_batch_run(&b) != NO_ERROR;
+	fail |= expect_count("read burst", 1);
+	fail |= expect_cmd("read burst", 0, false, REG_A(0x42), 4);
+	for (i = 0; i < 4; i++)
+		fail |= out[i] != 0x12 + i;
+
+	/* a burst never crosses into the next peripheral */
+	fake_reset();
+	pm_batch_init(&b);
+	pm_batch_write(&b, REG_A(0xFF), 1);
+	pm_batch_write(&b, REG_B(0x00), 2);
+	fail |= pm_batch_run(&b) != NO_ERROR;
+	fail |= expect_count("periph", 2);
+
+	/* RMW reads once, later RMWs and no-op updates use the shadow */
+	fake_reset();
+	fake_regs[0][0x46] = 0x81;
+	pm_batch_init(&b);
+	pm_batch_rmw(&b, REG_A(0x46), 0x80, 0x00);
+	pm_batch_rmw(&b, REG_A(0x46), 0x01, 0x01);
+	pm_batch_rmw(&b, REG_A(0x46), 0x80, 0x80);
+	fail |= pm_batch_run(&b) != NO_ERROR;
+	fail |= expect_count("rmw", 3);
+	fail |= expect_cmd("rmw", 0, false, REG_A(0x46), 1);
+	fail |= expect_cmd("rmw", 1, true, REG_A(0x46), 1);
+	fail |= expect_cmd("rmw", 2, true, REG_A(0x46), 1);
+	fail |= fake_regs[0][0x46] != 0x81;
+
+	/* order is kept: a read after a write sees the written value */
+	fake_reset();
+	pm_batch_init(&b);
+	pm_batch_write(&b, REG_A(0x10), 0x5a);
+	pm_batch_read(&b, REG_A(0x10), &out[0]);
+	fail |= pm_batch_run(&b) != NO_ERROR;
+	fail |= expect_count("order", 2);
+	fail |= out[0] != 0x5a;
+
+	/* the GPIO configuration pattern: disable, configure, enable */
+	fake_reset();
+	fake_regs[0][0x46] = 0x80;
+	pm_batch_init(&b);
+	pm_batch_rmw(&b, REG_A(0x46), 0x80, 0x00);
+	pm_batch_write(&b, REG_A(0x40), 0x11);
+	pm_batch_write(&b, REG_A(0x41), 0x02);
+	pm_batch_write(&b, REG_A(0x42), 0x05);
+	pm_batch_write(&b, REG_A(0x45), 0x21);
+	pm_batch_rmw(&b, REG_A(0x46), 0x80, 0x80);
+	fail |= pm_batch_run(&b) != NO_ERROR;
+	fail |= expect_count("gpio", 4);
+	fail |= expect_cmd("gpio", 3, true, REG_A(0x45), 2);
+	fail |= fake_regs[0][0x46] != 0x80;
+
+	/* an overfull batch is rejected without touching the arbiter */
+	fake_reset();
+	pm_batch_init(&b);
+	for (i = 0; i <= PM_BATCH_MAX_OPS; i++)
+		pm_batch_write(&b, REG_A(i), i);
+	fail |= pm_batch_run(&b) != ERR_TOO_BIG;
+	fail |= expect_count("overflow", 0);
+
+	pm_batch_set_arb(NULL);
+
+	fail |= pmic_batch_hw_tests();
+
+	tests_printf("pmic_batch_tests: %s\n", fail ? "FAILED" : "PASSED");
+	return fail ? ERROR : NO_ERROR;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <debug.h>
+#include <string.h>
+#include <platform.h>
+#include <rsa.h>
+#include <bn.h>
+#include <image_verify.h>
+#include <app/tests.h>
+
+#define RSA_BENCH_ITERS 20
+
+/* SHA-256 of the signed message */
+static const unsigned char rsa_msg_digest[] = {
+	0x1b, 0xf6, 0x11, 0xd2, 0xf1, 0xfd, 0x7a, 0xcb, 0xb5, 0x92, 0xb9, 0xd2,
+	0x04, 0x2d, 0xb7, 0x15, 0x44, 0x78, 0x0a, 0x80, 0xfe, 0x9b, 0xe6, 0x48,
+	0xdc, 0xb3, 0x66, 0x1f, 0x95, 0xce, 0xd8, 0x41,
+};
+
+/* RSA-2048, e = 65537 */
+static const unsigned char rsa2048_n[] = {
+	0xcd, 0xac, 0x24, 0x3e, 0x7f, 0xff, 0x3e, 0x0b, 0x9a, 0x4d, 0x8f, 0xff,
+	0xe8, 0x40, 0xf7, 0xac, 0x64, 0x56, 0x4d, 0x95, 0x9d, 0x1e, 0xd4, 0x00,
+	0xc5, 0xcf, 0x6e, 0x2b, 0xdc, 0x8c, 0x2d, 0x24, 0x35, 0xa5, 0x74, 0x66,
+	0x5d, 0xb1, 0x32, 0x02, 0x66, 0x52, 0x0e, 0x39, 0xf8, 0x5a, 0xfe, 0xdb,
+	0xc5, 0x4f, 0xcd, 0x9e, 0x13, 0xf2, 0x66, 0x57, 0x34, 0x4b, 0x40, 0xc6,
+	0xea, 0x30, 0x9c, 0x9c, 0x54, 0x9d, 0xe1, 0xdf, 0x6f, 0x04, 0xb2, 0xb9,
+	0xa9, 0xca, 0x5d, 0x1a, 0x7c, 0x5d, 0x82, 0xb0, 0x37, 0xd3, 0xec, 0x02,
+	0x7a, 0xa5, 0x78, 0x26, 0x29, 0x9e, 0x43, 0x4f, 0xfd, 0xf8, 0x6c, 0x1f,
+	0xf4, 0x70, 0xcd, 0xf6, 0x2e, 0x23, 0xfa, 0xee, 0x0b, 0x73, 0x30, 0x66,
+	0xfe, 0x7d, 0xdc, 0x86, 0xf1, 0x97, 0x58, 0xbf, 0x76, 0x57, 0x5e, 0xc5,
+	0x81, 0xd5, 0x2b, 0x34, 0x40, 0xd4, 0xb3, 0x59, 0x76, 0xd5, 0x2b, 0x36,
+	0xf9, 0x81, 0x6c, 0xc0, 0x0e, 0xd3, 0x95, 0x00, 0x13, 0x89, 0x8b, 0x6d,
+	0x3d, 0x4d, 0xd2, 0xfb, 0xc7, 0xcb, 0xc7, 0xc4, 0x97, 0xea, 0xaa, 0x47,
+	0xe0, 0xfa, 0x13, 0x58, 0x70, 0xba, 0x24, 0x83, 0x7a, 0xc4, 0x32, 0x7f,
+	0xc5, 0xf7, 0x29, 0x2a, 0x9f, 0x57, 0xc2, 0xfb, 0x1d, 0x61, 0x86, 0xc1,
+	0x8a, 0x39, 0x58, 0x1c, 0x13, 0x7c, 0xd5, 0xa6, 0x35, 0xd2, 0x41, 0xac,
+	0x1f, 0x70, 0xfd, 0xe5, 0x79, 0xb6, 0x8d, 0x49, 0x9e, 0xfd, 0xb6, 0xd9,
+	0xb0, 0xab, 0x5d, 0x8a, 0x68, 0x35, 0x81, 0x55, 0xf2, 0x24, 0x3a, 0x3a,
+	0xfb, 0x28, 0x9f, 0x6d, 0x97, 0x40, 0xa0, 0xdf, 0x31, 0xdf, 0x5c, 0xc0,
+	0x42, 0x5b, 0xff, 0xc4, 0x75, 0xa5, 0x77, 0x62, 0x5e, 0xb8, 0x8c, 0x31,
+	0x71, 0xd7, 0x1a, 0x71, 0x9d, 0xeb, 0xe9, 0x92, 0xba, 0x9f, 0x58, 0x1d,
+	0x3f, 0xf4, 0x26, 0x35,
+};
+
+static const unsigned char rsa2048_sig[] = {
+	0x26, 0x90, 0x08, 0x4b, 0xed, 0x90, 0x1c, 0x32, 0x6b, 0x48, 0x5b, 0xaa,
+	0x8b, 0x0b, 0x0f, 0x75, 0x25, 0xc2, 0xde, 0xd4, 0xa3, 0x88, 0x95, 0x2d,
+	0x52, 0xfb, 0xf7, 0xfe, 0xe4, 0x38, 0xa9, 0x44, 0x77, 0x82, 0x4a, 0x0f,
+	0x10, 0xfa, 0x1b, 0xf2, 0xbd, 0xa7, 0xce, 0x2d, 0xc0, 0x73, 0xef, 0xc9,
+	0x13, 0xd8, 0xd7, 0xa0, 0xff, 0xc5, 0xb3, 0x80, 0x80, 0x01, 0x80, 0xf2,
+	0x55, 0xfb, 0xe6, 0x6e, 0x44, 0x72, 0x66, 0xf4, 0xc4, 0xaf, 0xfa, 0x16,
+	0xe6, 0xab, 0x1f, 0x07, 0xce, 0x3e, 0xb2, 0x84, 0x0e, 0x72, 0xab, 0x64,
+	0xe5, 0x72, 0xba, 0x91, 0x22, 0x7e, 0xf7, 0x0f, 0x35, 0x48, 0x51, 0x7d,
+	0x4e, 0xc7, 0xdd, 0xf5, 0x93, 0xdf, 0x98, 0x7f, 0xa4, 0xad, 0xda, 0x7b,
+	0xb1, 0x5d, 0xc5, 0x18, 0xc0, 0x44, 0x3f, 0xe5, 0xa3, 0x2e, 0xdb, 0x6f,
+	0xa9, 0x1c, 0xbd, 0x71, 0x44, 0xb8, 0x30, 0x81, 0x54, 0xda, 0x9d, 0x93,
+	0x48, 0x86, 0xb4, 0xed, 0x3e, 0x3a, 0xe0, 0x51, 0x36, 0xb9, 0x35, 0xa2,
+	0x6d, 0x98, 0xd7, 0x9e, 0x38, 0x01, 0x25, 0xea, 0x53, 0x38, 0x07, 0x4a,
+	0x2a, 0xde, 0xb2, 0xb7, 0x70, 0xa0, 0xeb, 0xc6, 0xa9, 0x6b, 0x79, 0x5c,
+	0x78, 0x08, 0x9e, 0x25, 0x21, 0x22, 0xb3, 0x50, 0xd9, 0xcd, 0x5a, 0xba,
+	0x13, 0x32, 0x21, 0x35, 0x82, 0xe3, 0x62, 0x13, 0xf2, 0xd1, 0x1f, 0xdb,
+	0x52, 0xe1, 0xee, 0xc0, 0x66, 0xe3, 0xf9, 0xcc, 0xb7, 0x95, 0xf6, 0x88,
+	0x45, 0x90, 0x54, 0x62, 0x49, 0x63, 0xcf, 0x13, 0xa7, 0xce, 0xad, 0x51,
+	0xc3, 0x0e, 0x17, 0x98, 0xa6, 0x54, 0x8e, 0xf2, 0x67, 0xc5, 0xbf, 0xb2,
+	0x9f, 0x4e, 0x49, 0xea, 0x1b, 0x2f, 0xdc, 0xe0, 0x5a, 0xf9, 0x58, 0xdf,
+	0x8a, 0xe4, 0xea, 0xf7, 0x51, 0x23, 0x01, 0x38, 0xcc, 0x09, 0x88, 0x84,
+	0x31, 0xd9, 0xba, 0xa9,
+};
+
+/* RSA-4096, e = 65537 */
+static const unsigned char rsa4096_n[] = {
+	0xa7, 0x4f, 0xfd, 0x91, 0xc5, 0x10, 0x45, 0x90, 0xf1, 0xe4, 0xe4, 0xd2,
+	0x9c, 0x28, 0xc4, 0x6d, 0xc0, 0x19, 0x35, 0xc5, 0xdb, 0x6f, 0x2f, 0x51,
+	0xd2, 0xbb, 0x94, 0xd6, 0x70, 0x96, 0x17, 0x68, 0xa5, 0xd1, 0x86, 0x5f,
+	0x21, 0xef, 0xbe, 0x49, 0x29, 0x17, 0x2b, 0xe2, 0x98, 0xb4, 0x59, 0xbb,
+	0x01, 0x71, 0x97, 0x25, 0xb7, 0x37, 0x5e, 0xb2, 0x50, 0x70, 0xa9, 0x45,
+	0x6f, 0x52, 0xe7, 0x50, 0xfe, 0xc9, 0x4c, 0xeb, 0x83, 0x6a, 0xd7, 0x2f,
+	0xd9, 0x81, 0x75, 0x5a, 0xab, 0x6f, 0x2a, 0xec, 0x0f, 0x34, 0x4b, 0x01,
+	0x82, 0x6c, 0xae, 0xd4, 0xe7, 0x44, 0xc6, 0xd9, 0x1f, 0xa7, 0x13, 0x80,
+	0x1d, 0xd4, 0x37, 0x34, 0xe9, 0xb3, 0x03, 0xf2, 0x95, 0xa2, 0xee, 0x59,
+	0xcc, 0x2b, 0x25, 0xb4, 0x1e, 0x87, 0x3d, 0x0f, 0x5c, 0xc1, 0x6a, 0x2e,
+	0x54, 0xe5, 0xad, 0xd2, 0x22, 0x5e, 0xe5, 0xfe, 0xb2, 0x4e, 0x3a, 0xc3,
+	0x0d, 0xac, 0xad, 0x74, 0x3d, 0x26, 0xa0, 0x0d, 0x3b, 0xc6, 0x04, 0x20,
+	0x96, 0x16, 0x28, 0x57, 0x1e, 0x65, 0x47, 0x1d, 0x3e, 0x53, 0x53, 0x3c,
+	0x8f, 0x9e, 0xc7, 0x02, 0xcc, 0x7a, 0x6d, 0x27, 0xb7, 0xb4, 0xa0, 0x86,
+	0xad, 0xbc, 0xba, 0xa4, 0x7a, 0x74, 0x79, 0x25, 0xe7, 0x32, 0x3c, 0x0b,
+	0x84, 0xf3, 0x96, 0xf9, 0x2e, 0x04, 0xcf, 0x21, 0xc3, 0xdd, 0xed, 0x48,
+	0x6c, 0x91, 0xef, 0x02, 0x43, 0xe6, 0xf3, 0x9b, 0x03, 0xc0, 0xd6, 0x9a,
+	0x85, 0xd3, 0x44, 0x19, 0x9a, 0x26, 0xae, 0xb0, 0x84, 0xa7, 0x16, 0x9e,
+	0x3e, 0xf7, 0x0f, 0xf3, 0x29, 0x51, 0xb9, 0x64, 0xf9, 0x56, 0x26, 0x8a,
+	0xc5, 0x1b, 0xc4, 0x86, 0xe5, 0x65, 0xf9, 0x0e, 0xd3, 0x9a, 0x33, 0x46,
+	0xed, 0x39, 0x03, 0x13, 0xaf, 0xf1, 0x7b, 0xae, 0x1e, 0x40, 0x9c, 0x63,
+	0x1f, 0xb8, 0x52, 0x39, 0xf4, 0x4c, 0xaf, 0x2c, 0x3e, 0xbd, 0xd4, 0x8e,
+	0xab, 0x3e, 0x21, 0xbe, 0xcd, 0xf5, 0x71, 0xa3, 0x6e, 0xea, 0xfb, 0xc8,
+	0x1f, 0xac, 0x40, 0x7c, 0xaf, 0x54, 0x3e, 0x6b, 0x21, 0xb8, 0x61, 0xc0,
+	0x00, 0xc8, 0x17, 0x00, 0x67, 0xf2, 0x2b, 0xfb, 0xae, 0x5e, 0xc1, 0x97,
+	0x22, 0x6b, 0x64, 0x18, 0x57, 0xcb, 0x3c, 0x7c, 0x0c, 0xd6, 0xfb, 0x7e,
+	0xe8, 0x18, 0xa1, 0xd3, 0x82, 0x8a, 0xc9, 0x8f, 0x6b, 0xd1, 0x66, 0x37,
+	0xe8, 0x71, 0xad, 0x7a, 0xfd, 0xc1, 0x1b, 0xf3, 0x83, 0xcd, 0x23, 0x0a,
+	0x70, 0x3f, 0xb0, 0xc6, 0x16, 0x0e, 0xcb, 0xb3, 0xb1, 0xb5, 0xcd, 0x46,
+	0x50, 0xb2, 0x9c, 0xc8, 0x9e, 0x84, 0x7f, 0x52, 0xf8, 0xb8, 0x0f, 0x6d,
+	0x4c, 0x64, 0x1e, 0xce, 0xe3, 0x47, 0x7e, 0x51, 0x9d, 0xc7, 0xd2, 0x27,
+	0x23, 0xb0, 0x1a, 0xb9, 0x60, 0x1e, 0xab, 0x63, 0x66, 0x3f, 0x23, 0x24,
+	0x47, 0x74, 0x97, 0xdf, 0xab, 0xa9, 0x97, 0xba, 0x69, 0x9a, 0xa4, 0x53,
+	0x00, 0x34, 0xd5, 0xba, 0x7d, 0x30, 0x3d, 0xc9, 0x4b, 0x87, 0xac, 0x2e,
+	0xa8, 0x7f, 0x8d, 0xb9, 0xa6, 0xac, 0x2c, 0xef, 0x8d, 0x4b, 0x5b, 0x06,
+	0x43, 0xe0, 0x51, 0x4f, 0xb1, 0x3e, 0x1a, 0x2d, 0x7b, 0xab, 0x22, 0x24,
+	0x35, 0x2c, 0x15, 0xe5, 0x84, 0xde, 0xe2, 0xb8, 0xf2, 0x42, 0xb0, 0xac,
+	0x25, 0xd7, 0x18, 0x11, 0x23, 0xa9, 0x44, 0xbd, 0xaf, 0x3d, 0x73, 0x4d,
+	0x16, 0x07, 0xe1, 0x37, 0x1b, 0x23, 0xe3, 0x5a, 0x1a, 0x89, 0xe8, 0xcc,
+	0xf6, 0xac, 0x9b, 0x5d, 0x64, 0x83, 0x49, 0x28, 0x3d, 0x66, 0x6c, 0xd8,
+	0x67, 0x51, 0xc5, 0x76, 0xf3, 0x5b, 0x4d, 0xbb, 0x87, 0xc7, 0x8f, 0xcf,
+	0x3c, 0xd2, 0x67, 0x59, 0xc1, 0x5a, 0x29, 0x3c, 0xcf, 0xd2, 0x12, 0xd5,
+	0x33, 0x6a, 0x71, 0xfe, 0x09, 0x7d, 0x19, 0x35,
+};
+
+static const unsigned char rsa4096_sig[] = {
+	0x01, 0x55, 0x4e, 0xad, 0xc0, 0x59, 0x36, 0x50, 0x79, 0x16, 0x30, 0x9e,
+	0xdc, 0x2d, 0x79, 0xdd, 0x32, 0x66, 0xa1, 0x5a, 0x98, 0xe8, 0xdb, 0x8c,
+	0xcb, 0x65, 0x63, 0xdc, 0xab, 0x83, 0x9b, 0x82, 0xc7, 0x8b, 0x2f, 0xff,
+	0x64, 0x9a, 0x5e, 0xb7, 0x2b, 0xbb, 0x2d, 0x47, 0xaa, 0x48, 0x24, 0x62,
+	0x5b, 0x96, 0x0e, 0x56, 0x80, 0x75, 0x7b, 0x58, 0x10, 0x4d, 0x97, 0xb3,
+	0xdf, 0x6b, 0x54, 0x66, 0xca, 0x32, 0xf9, 0x65, 0x07, 0x0f, 0x4d, 0x24,
+	0x80, 0xc9, 0xe4, 0x10, 0x41, 0xdc, 0xf1, 0xf2, 0xf8, 0xcc, 0x95, 0x12,
+	0x1a, 0xa4, 0x37, 0xbe, 0xc7, 0xe2, 0x3b, 0x0e, 0x54, 0x33, 0xe2, 0xdb,
+	0xbf, 0xfb, 0x2f, 0xe1, 0x6e, 0xd2, 0xff, 0x8e, 0x69, 0x69, 0x1f, 0x11,
+	0x06, 0x0a, 0xc4, 0xec, 0x9b, 0xcc, 0xe9, 0xda, 0xae, 0x2c, 0x7e, 0x0c,
+	0x6b, 0xd6, 0xbb, 0x9f, 0x1d, 0x63, 0x98, 0x1f, 0xdc, 0x0d, 0x11, 0x39,
+	0xe7, 0x51, 0x39, 0x0f, 0x6b, 0xdd, 0xdb, 0xbe, 0x5e, 0xab, 0x6f, 0x67,
+	0x0f, 0xbe, 0xcc, 0x91, 0x90, 0x7f, 0xa4, 0x7c, 0xa9, 0x0f, 0x93, 0x4c,
+	0x7a, 0x58, 0x47, 0xab, 0x07, 0x4c, 0x41, 0xa9, 0x9b, 0x66, 0x0a, 0x31,
+	0xe9, 0x5c, 0xf3, 0x18, 0xf1, 0x01, 0x27, 0x27, 0x64, 0x41, 0xb4, 0xa6,
+	0x59, 0x0f, 0x07, 0xb6, 0x08, 0x42, 0xc3, 0x57, 0x76, 0x68, 0xe6, 0xd9,
+	0xff, 0x84, 0xb3, 0xe2, 0x84, 0x13, 0x9e, 0xd4, 0x26, 0x5d, 0x52, 0x48,
+	0xad, 0x34, 0xd9, 0x0b, 0xb1, 0xc3, 0x6b, 0x98, 0x91, 0x8f, 0x12, 0xa5,
+	0xbf, 0x39, 0x70, 0xad, 0x34, 0xf2, 0x08, 0xec, 0xe3, 0x4a, 0xe5, 0xab,
+	0xb7, 0x86, 0x40, 0xbc, 0xbc, 0xb4, 0x09, 0x64, 0x84, 0x45, 0xc7, 0x1c,
+	0x41, 0x5e, 0x4d, 0xe3, 0x76, 0xf9, 0xae, 0xc0, 0x89, 0xf2, 0xbc, 0x87,
+	0x7e, 0xe4, 0x56, 0xfc, 0xf1, 0x0a, 0x11, 0x8f, 0xcf, 0x7e, 0x12, 0x1d,
+	0x4d, 0x74, 0xde, 0x8b, 0x58, 0x08, 0x61, 0xf9, 0x2f, 0x27, 0xa5, 0x8a,
+	0x45, 0x8b, 0xe3, 0x10, 0x11, 0x78, 0xb2, 0x29, 0x5a, 0x44, 0x28, 0xa0,
+	0x56, 0x93, 0x62, 0xe4, 0x47, 0x17, 0x6b, 0xff, 0x3b, 0xf1, 0xa3, 0x20,
+	0x32, 0x6d, 0xb4, 0xed, 0xff, 0x62, 0xb9, 0x60, 0x0f, 0xb2, 0x96, 0x37,
+	0x94, 0xb8, 0x75, 0x0e, 0xad, 0x2b, 0xd7, 0x92, 0x0f, 0x8f, 0xa5, 0xbf,
+	0x63, 0x29, 0xc0, 0x05, 0x5f, 0x52, 0xc1, 0xd6, 0x89, 0x7c, 0xb1, 0x6f,
+	0x5f, 0x5c, 0xe5, 0x09, 0x6e, 0x90, 0xdf, 0xe6, 0xcc, 0x61, 0x02, 0xc8,
+	0xf3, 0x4b, 0xd7, 0x9f, 0x4e, 0x3a, 0x14, 0xd6, 0x35, 0x3b, 0xe9, 0xcd,
+	0xf2, 0x9d, 0x25, 0x67, 0x94, 0xec, 0xf9, 0x98, 0xc7, 0xa5, 0xfa, 0xba,
+	0xc8, 0xf9, 0x80, 0x59, 0xa9, 0x5b, 0x29, 0x11, 0xe7, 0x71, 0x04, 0xe2,
+	0x2c, 0x0d, 0x71, 0x9f, 0x95, 0xb0, 0x92, 0x8a, 0xe9, 0xa6, 0xf3, 0x8a,
+	0x05, 0xad, 0x94, 0xa0, 0xb9, 0x4b, 0x7c, 0x92, 0x9a, 0x8f, 0x4b, 0xfb,
+	0xfe, 0xd1, 0x0d, 0x42, 0xac, 0x59, 0xfd, 0xc2, 0x7b, 0x87, 0xd7, 0x2f,
+	0x1d, 0x56, 0x5a, 0xc0, 0x73, 0xbf, 0xda, 0xb1, 0x89, 0x32, 0x15, 0xf3,
+	0x60, 0x94, 0x4a, 0x9c, 0x34, 0x41, 0x9c, 0x37, 0xf1, 0x99, 0x4c, 0x75,
+	0x75, 0x3e, 0x7a, 0xdc, 0xaf, 0x24, 0x99, 0xd4, 0xad, 0x80, 0x8a, 0x1a,
+	0xeb, 0x0b, 0x58, 0x4c, 0x2f, 0xcd, 0x93, 0x86, 0x8e, 0x3e, 0x3b, 0x80,
+	0xf0, 0x69, 0x20, 0xc4, 0xf5, 0x2a, 0x7c, 0xdb, 0x8b, 0x1b, 0x32, 0xd7,
+	0xc7, 0x0d, 0x1d, 0x70, 0x8e, 0x6a, 0x0d, 0x55, 0xb7, 0xc9, 0x27, 0xcc,
+	0x5c, 0x33, 0xd8, 0x69, 0x6d, 0xbf, 0x94, 0x1f, 0x45, 0x5e, 0x4e, 0xbf,
+	0x49, 0x38, 0x4c, 0xce, 0x16, 0xca, 0x8c, 0xeb,
+};
+
+static RSA *rsa_test_key(const unsigned char *n, unsigned int len)
+{
+	RSA *rsa = RSA_new();
+
+	if (rsa == NULL)
+		return NULL;
+
+	rsa->n = BN_bin2bn(n, len, NULL);
+	rsa->e = BN_new();
+	if (rsa->n == NULL || rsa->e == NULL || !BN_set_word(rsa->e, RSA_F4)) {
+		RSA_free(rsa);
+		return NULL;
+	}
+
+	return rsa;
+}
+
+/* microseconds per verification, old path: fresh key, OpenSSL decrypt */
+static unsigned int rsa_bench_openssl(const unsigned char *n,
+				      const unsigned char *sig, unsigned int k,
+				      unsigned char *out)
+{
+	bigtime_t t0 = current_time_hires();
+	RSA *rsa;
+	int i;
+
+	for (i = 0; i < RSA_BENCH_ITERS; i++) {
+		rsa = rsa_test_key(n, k);
+		if (rsa == NULL)
+			return 0;
+		RSA_public_decrypt(k, sig, out, rsa, RSA_PKCS1_PADDING);
+		RSA_free(rsa);
+	}
+
+	return (current_time_hires() - t0) / RSA_BENCH_ITERS;
+}
+
+/* microseconds per verification on a prepared key */
+static unsigned int rsa_bench_cached(RSA *rsa, const unsigned char *sig,
+				     unsigned int k, unsigned char *out)
+{
+	bigtime_t t0 = current_time_hires();
+	int i;
+
+	for (i = 0; i < RSA_BENCH_ITERS; i++)
+		image_rsa_public_decrypt(rsa, sig, k, out, k);
+
+	return (current_time_hires() - t0) / RSA_BENCH_ITERS;
+}
+
+static int rsa_key_tests(const char *name, const unsigned char *n,
+			 const unsigned char *sig, unsigned int k)
+{
+	static unsigned char out[IMAGE_RSA_MAX_BYTES];
+	static unsigned char ref[IMAGE_RSA_MAX_BYTES];
+	static unsigned char bad[IMAGE_RSA_MAX_BYTES];
+	RSA *rsa;
+	int len, ref_len;
+	int failures = 0;
+
+	rsa = rsa_test_key(n, k);
+	if (rsa == NULL || image_rsa_key_prepare(rsa)) {
+		tests_printf("%s: failed to set up key\n", name);
+		RSA_free(rsa);
+		return 1;
+	}
+
+	/* fast path agrees with OpenSSL and yields the signed DigestInfo */
+	len = image_rsa_public_decrypt(rsa, sig, k, out, k);
+	ref_len = RSA_public_decrypt(k, sig, ref, rsa, RSA_PKCS1_PADDING);
+	if (len != ref_len || len < 0 || memcmp(out, ref, len)) {
+		tests_printf("%s: fast path returned %d, openssl %d\n", name, len, ref_len);
+		failures++;
+	} else if (image_verify_sha256_digest_info(out, len, rsa_msg_digest)) {
+		tests_printf("%s: digest mismatch\n", name);
+		failures++;
+	}
+
+	/* a corrupted signature must not verify */
+	memcpy(bad, sig, k);
+	bad[k / 2] ^= 0x10;
+	len = image_rsa_public_decrypt(rsa, bad, k, out, k);
+	if (len >= 0 && !image_verify_sha256_digest_info(out, len, rsa_msg_digest)) {
+		tests_printf("%s: corrupted signature verified\n", name);
+		failures++;
+	}
+
+	tests_printf("%s verify: openssl %u us, cached f4 %u us\n", name,
+	       rsa_bench_openssl(n, sig, k, ref), rsa_bench_cached(rsa, sig, k, out));
+
+	RSA_free(rsa);
+
+	return failures;
+}
+
+int rsa_tests(void)
+{
+	int failures = 0;
+
+	tests_printf("rsa tests\n");
+
+	failures += rsa_key_tests("rsa2048", rsa2048_n, rsa2048_sig, sizeof(rsa2048_n));
+	failures += rsa_key_tests("rsa4096", rsa4096_n, rsa4096_sig, sizeof(rsa4096_n));
+
+	tests_printf("rsa tests %s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+
+	return failures ? -1 : 0;
+}
@@ -5,7 +5,18 @@ INCLUDES += -I$(LOCAL_DIR)/include
 OBJS += \
 	$(LOCAL_DIR)/tests.o \
 	$(LOCAL_DIR)/thread_tests.o \
-	$(LOCAL_DIR)/printf_tests.o \
-	$(LOCAL_DIR)/i2c_tests.o \
+	$(LOCAL_DIR)/workqueue_tests.o \
+	$(LOCAL_DIR)/printf_tests.o
+
+# msm_shared driver tests, run with "fastboot oem run-test" on the msm projects
+ifneq ($(filter app/aboot,$(ALLMODULES)),)
+INCLUDES += -I$(LK_TOP_DIR)/app/aboot
+
+OBJS += \
+	$(LOCAL_DIR)/hash_tests.o \
+	$(LOCAL_DIR)/rsa_tests.o \
+	$(LOCAL_DIR)/pmic_batch_tests.o \
+	$(LOCAL_DIR)/i2c_test.o \
 	$(LOCAL_DIR)/adc_tests.o \
 	$(LOCAL_DIR)/kauth_test.o
+endif
@@ -22,8 +22,14 @@
  */
 #include <app.h>
 #include <debug.h>
+#include <string.h>
+#include <stdarg.h>
+#include <printf.h>
 #include <app/tests.h>
 #include <compiler.h>
+#if WITH_APP_ABOOT
+#include "fastboot.h"
+#endif
 
 #if defined(WITH_LIB_CONSOLE)
 #include <lib/console.h>
@@ -31,12 +37,87 @@
 STATIC_COMMAND_START
 STATIC_COMMAND("printf_tests", NULL, (console_cmd)&printf_tests)
 STATIC_COMMAND("thread_tests", NULL, (console_cmd)&thread_tests)
+STATIC_COMMAND("smp_tests", NULL, (console_cmd)&smp_tests)
+STATIC_COMMAND("workqueue_tests", NULL, (console_cmd)&workqueue_tests)
+#if WITH_APP_ABOOT
+STATIC_COMMAND("hash_tests", NULL, (console_cmd)&hash_tests)
+STATIC_COMMAND("hash_bench", NULL, (console_cmd)&hash_bench)
+STATIC_COMMAND("rsa_tests", NULL, (console_cmd)&rsa_tests)
+STATIC_COMMAND("pmic_batch_tests", NULL, (console_cmd)&pmic_batch_tests)
+#endif
 STATIC_COMMAND_END(tests);
 
 #endif
 
+/*
+ * printf() for the tests, a run started over fastboot also gets each
+ * line back as an INFO response. Lines longer than one response are cut.
+ */
+void tests_printf(const char *fmt, ...)
+{
+	char line[MAX_TESTS_LINE];
+	va_list ap;
+#if WITH_APP_ABOOT
+	size_t len;
+#endif
+
+	va_start(ap, fmt);
+	vsnprintf(line, sizeof(line), fmt, ap);
+	va_end(ap);
+
+	printf("%s", line);
+
+#if WITH_APP_ABOOT
+	len = strlen(line);
+	if (len && line[len - 1] == '\n')
+		line[len - 1] = '\0';
+	fastboot_info(line);
+#endif
+}
+
+#if WITH_APP_ABOOT
+struct fastboot_test {
+	const char *name;
+	int (*run)(void);
+};
+
+static const struct fastboot_test fastboot_tests[] = {
+	{ "workqueue", workqueue_tests },
+	{ "smp", smp_tests },
+	{ "hash", hash_tests },
+	{ "hash-bench", hash_bench },
+	{ "rsa", rsa_tests },
+	{ "pmic-batch", pmic_batch_tests },
+};
+
+/* fastboot oem run-test <name> */
+static void cmd_oem_run_test(const char *arg, void *data, unsigned sz)
+{
+	unsigned i;
+
+	while (*arg == ' ')
+		arg++;
+
+	for (i = 0; i < countof(fastboot_tests); i++) {
+		if (strcmp(arg, fastboot_tests[i].name))
+			continue;
+
+		if (fastboot_tests[i].run())
+			fastboot_fail("test failed");
+		else
+			fastboot_okay("");
+		return;
+	}
+
+	fastboot_fail("usage: oem run-test workqueue|smp|hash|hash-bench|rsa|pmic-batch");
+}
+#endif
+
 static void tests_init(const struct app_descriptor *app)
 {
+#if WITH_APP_ABOOT
+	fastboot_register("oem run-test", cmd_oem_run_test);
+#endif
 }
 
 APP_START(tests)
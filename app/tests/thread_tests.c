@@ -26,6 +26,8 @@
 #include <kernel/thread.h>
 #include <kernel/mutex.h>
 #include <kernel/event.h>
+#include <kernel/spinlock.h>
+#include <kernel/mp.h>
 
 static int sleep_thread(void *arg)
 {
@@ -308,6 +310,68 @@ static void atomic_test(void)
 	printf("atomic count == %d (should be zero)\n", atomic);
 }
 
+static spin_lock_t spin_test_lock;
+static volatile int spin_shared;
+static volatile int spin_count;
+static volatile int spin_cpus;
+
+static int spinlock_tester(void *arg)
+{
+	uint32_t state;
+	int i;
+
+	for (i=0; i < 100000; i++) {
+		spin_lock_irqsave(&spin_test_lock, &state);
+		spin_shared++;
+		spin_unlock_irqrestore(&spin_test_lock, state);
+	}
+
+	atomic_or(&spin_cpus, 1 << curr_cpu_num());
+	atomic_add(&spin_count, -1);
+
+	return 0;
+}
+
+/* the testers are migratable, so idle secondary cpus pick them up */
+static int spinlock_test(void)
+{
+	thread_t *t;
+	int i;
+
+	spin_lock_init(&spin_test_lock);
+	spin_shared = 0;
+	spin_cpus = 0;
+	spin_count = 4;
+
+	for (i=0; i < 4; i++) {
+		t = thread_create("spinlock tester", &spinlock_tester, NULL, LOW_PRIORITY, DEFAULT_STACK_SIZE);
+		thread_set_migratable(t);
+		thread_resume(t);
+	}
+
+	while (spin_count > 0) {
+		thread_sleep(1);
+	}
+
+	tests_printf("spinlock shared == %d (should be %d), ran on cpus 0x%x of 0x%x\n",
+			spin_shared, 4 * 100000, spin_cpus, mp_active_cpus);
+
+	if (spin_shared != 4 * 100000)
+		return -1;
+
+	/* with secondaries up, the testers should not all stay on the boot cpu */
+	if (mp_num_active_cpus() > 1 && spin_cpus == 1)
+		return -1;
+
+	return 0;
+}
+
+/* fastboot oem run-test smp */
+int smp_tests(void)
+{
+	return spinlock_test();
+}
+
 int thread_tests(void) 
 {
 	mutex_test();
@@ -317,6 +381,8 @@ int thread_tests(void)
 	context_switch_test();
 
 	atomic_test();
+
+	spinlock_test();
 	
 	return 0;
 }
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <debug.h>
+#include <err.h>
+#include <app/tests.h>
+#include <kernel/thread.h>
+#include <kernel/workqueue.h>
+
+#define NUM_WORK 16
+
+static work_t work[NUM_WORK];
+static int work_out[NUM_WORK];
+static volatile int done_count;
+
+/* the workers live forever, so the queue has to as well */
+static workqueue_t wq;
+static bool wq_created;
+
+/* sum of 0..n, slept on so the workers genuinely interleave */
+static int sum_work(void *arg)
+{
+	int n = (int)arg;
+	int i, sum = 0;
+
+	for (i = 0; i <= n; i++)
+		sum += i;
+
+	thread_sleep(n % 3);
+	work_out[n] = sum;
+
+	return NO_ERROR;
+}
+
+static int fail_work(void *arg)
+{
+	return ERR_IO;
+}
+
+static void count_done(work_t *w)
+{
+	atomic_add(&done_count, 1);
+}
+
+int workqueue_tests(void)
+{
+	work_group_t group;
+	status_t err;
+	int i, failures = 0;
+
+	tests_printf("workqueue tests\n");
+
+	if (!wq_created) {
+		if (workqueue_create(&wq, "wq tester", 3, DEFAULT_PRIORITY) != NO_ERROR) {
+			tests_printf("failed to create work queue\n");
+			return -1;
+		}
+		wq_created = true;
+	}
+
+	/* fork/join: every item runs exactly once and the group sees all of them */
+	done_count = 0;
+	work_group_init(&group);
+	for (i = 0; i < NUM_WORK; i++) {
+		work_out[i] = -1;
+		work_init(&work[i], sum_work, (void *)i, count_done);
+		workqueue_submit(&wq, &work[i], &group);
+	}
+
+	err = work_group_wait(&group, INFINITE_TIME);
+	for (i = 0; i < NUM_WORK; i++) {
+		if (work_out[i] != i * (i + 1) / 2) {
+			tests_printf("work %d: got %d expected %d\n", i, work_out[i], i * (i + 1) / 2);
+			failures++;
+		}
+	}
+	if (err != NO_ERROR || done_count != NUM_WORK) {
+		tests_printf("group status %d, %d of %d callbacks\n", err, done_count, NUM_WORK);
+		failures++;
+	}
+
+	/* a failing item is reported by the group wait */
+	work_group_init(&group);
+	work_init(&work[0], sum_work, (void *)0, NULL);
+	work_init(&work[1], fail_work, NULL, NULL);
+	workqueue_submit(&wq, &work[0], &group);
+	workqueue_submit(&wq, &work[1], &group);
+	err = work_group_wait(&group, INFINITE_TIME);
+	if (err != ERR_IO) {
+		tests_printf("failing group returned %d, expected %d\n", err, ERR_IO);
+		failures++;
+	}
+
+	/* an empty group is already complete */
+	work_group_init(&group);
+	if (work_group_wait(&group, 0) != NO_ERROR) {
+		tests_printf("empty group did not complete\n");
+		failures++;
+	}
+
+	tests_printf("workqueue tests %s (%d failures)\n", failures ? "FAILED" : "passed", failures);
+
+	return failures ? -1 : 0;
+}
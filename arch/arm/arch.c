@@ -26,6 +26,7 @@
 #include <arch/arm.h>
 #include <arch/arm/mmu.h>
 #include <platform.h>
+#include <kernel/mp.h>
 
 #if ARM_CPU_CORTEX_A8
 static void set_vector_base(addr_t addr)
@@ -34,24 +35,9 @@ static void set_vector_base(addr_t addr)
 }
 #endif
 
-void arch_early_init(void)
+/* per cpu core setup, shared by the boot cpu and the secondaries */
+static void arch_cpu_init(void)
 {
-	/* turn off the cache */
-	arch_disable_cache(UCACHE);
-
-	/* set the vector base to our exception vectors so we dont need to double map at 0 */
-#if ARM_CPU_CORTEX_A8
-	set_vector_base(MEMBASE);
-#endif
-
-#if ARM_WITH_MMU
-	arm_mmu_init();
-
-#endif
-
-	/* turn the cache back on */
-	arch_enable_cache(UCACHE);
-
 #if ARM_WITH_NEON
 	/* enable cp10 and cp11 */
 	uint32_t val;
@@ -79,7 +65,51 @@ void arch_early_init(void)
 #endif
 }
 
+void arch_early_init(void)
+{
+	/* turn off the cache */
+	arch_disable_cache(UCACHE);
+
+	/* set the vector base to our exception vectors so we dont need to double map at 0 */
+#if ARM_CPU_CORTEX_A8
+	set_vector_base(MEMBASE);
+#endif
+
+#if ARM_WITH_MMU
+	arm_mmu_init();
+
+#endif
+
+	/* turn the cache back on */
+	arch_enable_cache(UCACHE);
+
+	arch_cpu_init();
+}
+
 void arch_init(void)
 {
 }
 
+#if WITH_SMP
+void arm_secondary_entry(uint cpu) __NO_RETURN;
+void arm_secondary_entry(uint cpu)
+{
+	arch_disable_cache(UCACHE);
+
+#if ARM_CPU_CORTEX_A8
+	set_vector_base(MEMBASE);
+#endif
+
+#if ARM_WITH_MMU
+	/* the translation table was built by the boot cpu */
+	arm_mmu_secondary_init();
+#endif
+
+	arch_enable_cache(UCACHE);
+
+	arch_cpu_init();
+
+	mp_secondary_entry(cpu);
+}
+#endif
+
@@ -30,6 +30,7 @@ extern "C" {
 #endif
 
 void arm_mmu_init(void);
+void arm_mmu_secondary_init(void);
 
 #if defined(ARM_ISA_ARMV6) | defined(ARM_ISA_ARMV7)
 
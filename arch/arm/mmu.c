@@ -94,6 +94,20 @@ void arm_mmu_init(void)
 	arm_write_cr1(arm_read_cr1() | 0x1);
 }
 
+#if WITH_SMP
+/* point a secondary cpu at the table arm_mmu_init() built and turn its mmu on */
+void arm_mmu_secondary_init(void)
+{
+	arm_write_cr1(arm_read_cr1() & ~((1<<29)|(1<<28)|(1<<0)));
+
+	arm_invalidate_tlb();
+	arm_write_ttbr((uint32_t)tt);
+	arm_write_dacr(0x00000001);
+
+	arm_write_cr1(arm_read_cr1() | 0x1);
+}
+#endif
+
 void arch_disable_mmu(void)
 {
 	/* Ensure all memory access are complete
@@ -49,8 +49,8 @@ static void initial_thread_func(void)
 //	dprintf("initial_thread_func: thread %p calling %p with arg %p\n", current_thread, current_thread->entry, current_thread->arg);
 //	dump_thread(current_thread);
 
-	/* exit the implicit critical section we're within */
-	exit_critical_section();
+	/* exit the implicit critical section and thread lock we're within */
+	thread_lock_release();
 
 	ret = current_thread->entry(current_thread->arg);
 
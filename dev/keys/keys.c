@@ -31,32 +31,232 @@
 
 #include <bits.h>
 #include <debug.h>
+#include <err.h>
 #include <string.h>
 #include <dev/keys.h>
+#include <kernel/thread.h>
+#include <kernel/timer.h>
+#include <lib/cbuf.h>
+#include <platform.h>
+
+/* Must be a power of two, in struct key_event units */
+#define KEY_EVENT_QUEUE_LEN	64
+#define KEYS_MAX_SOURCES	8
+/* A source has to read the same this many times in a row to count */
+#define KEYS_DEBOUNCE_COUNT	3
+#define KEYS_DEBOUNCE_MS	10
+/* Sampling period while someone waits */
+#define KEYS_POLL_MS		50
+
+struct keys_source {
+	uint16_t code;
+	int (*get_state)(void);
+	int sample;
+	unsigned stable;
+};
 
 static unsigned long key_bitmap[BITMAP_NUM_WORDS(MAX_KEYS)];
 
+static cbuf_t key_events;
+static unsigned key_events_queued;
+static bool key_events_ready;
+
+static struct keys_source key_sources[KEYS_MAX_SOURCES];
+static unsigned key_sources_num;
+static unsigned key_waiters;
+
+static timer_t debounce_timer;
+static bool debounce_armed;
+
 void keys_init(void)
 {
 	memset(key_bitmap, 0, sizeof(key_bitmap));
+
+	if (!key_events_ready) {
+		cbuf_initialize(&key_events,
+			KEY_EVENT_QUEUE_LEN * sizeof(struct key_event));
+		timer_initialize(&debounce_timer);
+		key_events_ready = true;
+	}
+}
+
+/* Caller holds the critical section */
+static void keys_debounce_arm(time_t delay);
+
+static enum handler_return
+keys_debounce_timer_func(struct timer *timer, time_t now, void *arg)
+{
+	struct keys_source *src;
+	bool unsettled = false;
+	bool posted = false;
+	unsigned i;
+	int state;
+
+	debounce_armed = false;
+
+	for (i = 0; i < key_sources_num; i++) {
+		src = &key_sources[i];
+		state = !!src->get_state();
+
+		if (state != src->sample) {
+			src->sample = state;
+			src->stable = 1;
+		} else if (src->stable < KEYS_DEBOUNCE_COUNT) {
+			src->stable++;
+		}
+
+		if (src->stable < KEYS_DEBOUNCE_COUNT)
+			unsettled = true;
+		else if (state != keys_get_state(src->code)) {
+			keys_post_event(src->code, state);
+			posted = true;
+		}
+	}
+
+	if (unsettled)
+		keys_debounce_arm(KEYS_DEBOUNCE_MS);
+	else if (key_waiters && key_sources_num)
+		keys_debounce_arm(KEYS_POLL_MS);
+
+	return posted ? INT_RESCHEDULE : INT_NO_RESCHEDULE;
+}
+
+static void keys_debounce_arm(time_t delay)
+{
+	if (debounce_armed)
+		return;
+
+	debounce_armed = true;
+	timer_set_oneshot(&debounce_timer, delay, keys_debounce_timer_func, NULL);
+}
+
+/*
+ * Register a key line. get_state() returns non zero while the key is
+ * pressed and is called from the debounce timer, so it must not sleep.
+ * No key line here can raise an interrupt, so sources are only sampled
+ * while a reader waits for events.
+ * The state sampled now is taken as is, so boot time checks cost one read.
+ */
+int keys_add_source(uint16_t code, int (*get_state)(void))
+{
+	struct keys_source *src;
+
+	if (code >= MAX_KEYS || !get_state)
+		return ERR_INVALID_ARGS;
+
+	if (key_sources_num == KEYS_MAX_SOURCES)
+		return ERR_NO_MEMORY;
+
+	src = &key_sources[key_sources_num];
+	src->code = code;
+	src->get_state = get_state;
+	src->sample = !!get_state();
+	src->stable = KEYS_DEBOUNCE_COUNT;
+
+	if (src->sample)
+		keys_post_event(code, 1);
+
+	enter_critical_section();
+	key_sources_num++;
+	exit_critical_section();
+
+	return NO_ERROR;
 }
 
 void keys_post_event(uint16_t code, int16_t value)
 {
+	struct key_event ev;
+
 	if (code >= MAX_KEYS) {
 		dprintf(INFO, "Invalid keycode posted: %d\n", code);
 		return;
 	}
 
-	/* TODO: Implement an actual event queue if it becomes necessary */
-	if (value)
-		bitmap_set(key_bitmap, code);
-	else
-		bitmap_clear(key_bitmap, code);
+	enter_critical_section();
+
+	if (value) {
+		if (bitmap_set(key_bitmap, code))
+			goto out;
+	} else {
+		if (!bitmap_clear(key_bitmap, code))
+			goto out;
+	}
+
+	/* Only state changes are queued, the oldest events win on overflow */
+	if (key_events_ready && key_events_queued < KEY_EVENT_QUEUE_LEN - 1) {
+		ev.code = code;
+		ev.value = value ? 1 : 0;
+		cbuf_write(&key_events, &ev, sizeof(ev), false);
+		key_events_queued++;
+	}
+
+out:
+	exit_critical_section();
 
 //	dprintf(INFO, "key state change: %d %d\n", code, value);
 }
 
+/* Fetch the next queued key event, ERR_NOT_READY if there is none */
+int keys_get_event(struct key_event *ev)
+{
+	int ret = ERR_NOT_READY;
+
+	if (!key_events_ready)
+		return ret;
+
+	enter_critical_section();
+	if (key_events_queued) {
+		cbuf_read(&key_events, ev, sizeof(*ev), false);
+		key_events_queued--;
+		ret = NO_ERROR;
+	}
+	exit_critical_section();
+
+	return ret;
+}
+
+/*
+ * Block until a key event is queued or timeout ms pass (INFINITE_TIME
+ * waits forever). Returns NO_ERROR with *ev filled in, or ERR_TIMED_OUT.
+ */
+int keys_wait_event(struct key_event *ev, time_t timeout)
+{
+	time_t start = current_time();
+	time_t left = timeout;
+	status_t ret;
+
+	if (!key_events_ready)
+		return ERR_NOT_READY;
+
+	enter_critical_section();
+	key_waiters++;
+	if (key_sources_num)
+		keys_debounce_arm(KEYS_POLL_MS);
+	exit_critical_section();
+
+	while (keys_get_event(ev) != NO_ERROR) {
+		if (timeout != INFINITE_TIME) {
+			left = timeout - (current_time() - start);
+			if ((int)left <= 0) {
+				ret = ERR_TIMED_OUT;
+				goto out;
+			}
+		}
+
+		ret = event_wait_timeout(&key_events.event, left);
+		if (ret != NO_ERROR)
+			goto out;
+	}
+	ret = NO_ERROR;
+
+out:
+	enter_critical_section();
+	key_waiters--;
+	exit_critical_section();
+
+	return ret;
+}
+
 int keys_get_state(uint16_t code)
 {
 	if (code >= MAX_KEYS) {
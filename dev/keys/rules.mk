@@ -1,5 +1,7 @@
 LOCAL_DIR := $(GET_LOCAL_DIR)
 
+MODULES += lib/cbuf
+
 OBJS += \
 	$(LOCAL_DIR)/keys.o
 
@@ -0,0 +1,83 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _PM8X41_BATCH_H_
+#define _PM8X41_BATCH_H_
+
+#include <sys/types.h>
+#include <spmi.h>
+
+/*
+ * Queued PMIC register access. Register addresses use the REG_READ/
+ * REG_WRITE encoding (slave id << 16 | peripheral << 8 | offset).
+ * pm_batch_run() executes the queue in order, merging accesses of the
+ * same kind to consecutive registers of a peripheral into one arbiter
+ * command of up to PM_BATCH_MAX_BURST bytes.
+ */
+#define PM_BATCH_MAX_OPS        32
+#define PM_BATCH_MAX_BURST      8
+
+enum pm_batch_op_type
+{
+	PM_BATCH_READ,
+	PM_BATCH_WRITE,
+	PM_BATCH_RMW,
+};
+
+struct pm_batch_op
+{
+	uint32_t addr;
+	uint8_t type;
+	uint8_t mask;		/* RMW: bits to update */
+	uint8_t val;		/* WRITE value, RMW new bits */
+	uint8_t *out;		/* READ destination */
+};
+
+struct pm_batch
+{
+	struct pm_batch_op ops[PM_BATCH_MAX_OPS];
+	unsigned num;
+	int err;
+};
+
+/* Arbiter entry points, replaceable by a test double */
+struct pm_batch_arb
+{
+	unsigned int (*read)(struct pmic_arb_cmd *cmd, struct pmic_arb_param *param);
+	unsigned int (*write)(struct pmic_arb_cmd *cmd, struct pmic_arb_param *param);
+};
+
+void pm_batch_init(struct pm_batch *b);
+void pm_batch_read(struct pm_batch *b, uint32_t addr, uint8_t *out);
+void pm_batch_write(struct pm_batch *b, uint32_t addr, uint8_t val);
+void pm_batch_rmw(struct pm_batch *b, uint32_t addr, uint8_t mask, uint8_t val);
+int pm_batch_run(struct pm_batch *b);
+void pm_batch_set_arb(const struct pm_batch_arb *arb);
+
+#endif
@@ -33,6 +33,7 @@
 #include <string.h>
 #include <pm8x41_hw.h>
 #include <pm8x41.h>
+#include <pm8x41_batch.h>
 #include <rpm-smd.h>
 #include <regulator.h>
 #include <platform/timer.h>
@@ -105,41 +106,45 @@ void pm8x41_set_boot_done()
 	REG_WRITE(SMBB_MISC_BOOT_DONE, val);
 }
 
-/* Configure GPIO */
-int pm8x41_gpio_config(uint8_t gpio, struct pm8x41_gpio *config)
+/*
+ * Program a GPIO peripheral as one PMIC batch. The mode, VIN and pull
+ * registers are adjacent and go out as one burst while the GPIO is
+ * disabled, so the order they are written in does not matter. The
+ * enable bit is known from the disable step, no second read is needed.
+ */
+static int pm8x41_gpio_batch_config(uint32_t gpio_base, struct pm8x41_gpio *config)
 {
-	uint8_t  val;
-	uint32_t gpio_base = GPIO_N_PERIPHERAL_BASE(gpio);
-
-	/* Disable the GPIO */
-	val  = REG_READ(gpio_base + GPIO_EN_CTL);
-	val &= ~BIT(PERPH_EN_BIT);
-	REG_WRITE(gpio_base + GPIO_EN_CTL, val);
+	struct pm_batch b;
 
-	/* Select the mode */
-	val = config->function | (config->direction << 4);
-	REG_WRITE(gpio_base + GPIO_MODE_CTL, val);
+	pm_batch_init(&b);
 
-	/* Set the right pull */
-	val = config->pull;
-	REG_WRITE(gpio_base + GPIO_DIG_PULL_CTL, val);
+	/* Disable the GPIO */
+	pm_batch_rmw(&b, gpio_base + GPIO_EN_CTL, BIT(PERPH_EN_BIT), 0);
 
-	/* Select the VIN */
-	val = config->vin_sel;
-	REG_WRITE(gpio_base + GPIO_DIG_VIN_CTL, val);
+	/* Select the mode, VIN and pull */
+	pm_batch_write(&b, gpio_base + GPIO_MODE_CTL,
+		       config->function | (config->direction << 4));
+	pm_batch_write(&b, gpio_base + GPIO_DIG_VIN_CTL, config->vin_sel);
+	pm_batch_write(&b, gpio_base + GPIO_DIG_PULL_CTL, config->pull);
 
 	if (config->direction == PM_GPIO_DIR_OUT) {
 		/* Set the right dig out control */
-		val = config->out_strength | (config->output_buffer << 4);
-		REG_WRITE(gpio_base + GPIO_DIG_OUT_CTL, val);
+		pm_batch_write(&b, gpio_base + GPIO_DIG_OUT_CTL,
+			       config->out_strength | (config->output_buffer << 4));
 	}
 
 	/* Enable the GPIO */
-	val  = REG_READ(gpio_base + GPIO_EN_CTL);
-	val |= BIT(PERPH_EN_BIT);
-	REG_WRITE(gpio_base + GPIO_EN_CTL, val);
+	pm_batch_rmw(&b, gpio_base + GPIO_EN_CTL, BIT(PERPH_EN_BIT), BIT(PERPH_EN_BIT));
 
-	return 0;
+	return pm_batch_run(&b) ? 1 : 0;
+}
+
+/* Configure GPIO */
+int pm8x41_gpio_config(uint8_t gpio, struct pm8x41_gpio *config)
+{
+	uint32_t gpio_base = GPIO_N_PERIPHERAL_BASE(gpio);
+
+	return pm8x41_gpio_batch_config(gpio_base, config);
 }
 
 /* Reads the status of requested gpio */
@@ -174,7 +179,6 @@ int pm8x41_gpio_set(uint8_t gpio, uint8_t value)
 /* Configure PM and PMI GPIO with slave id */
 int pm8x41_gpio_config_sid(uint8_t sid, uint8_t gpio, struct pm8x41_gpio *config)
 {
-	uint8_t  val;
 	uint32_t gpio_base = GPIO_N_PERIPHERAL_BASE(gpio);
 
 	gpio_base &= 0x0ffff;	/* clear sid */
@@ -182,35 +186,7 @@ int pm8x41_gpio_config_sid(uint8_t sid, uint8_t gpio, struct pm8x41_gpio *config
 
 	dprintf(SPEW, "%s: gpio=%d base=%x\n", __func__, gpio, gpio_base);
 
-	/* Disable the GPIO */
-	val  = REG_READ(gpio_base + GPIO_EN_CTL);
-	val &= ~BIT(PERPH_EN_BIT);
-	REG_WRITE(gpio_base + GPIO_EN_CTL, val);
-
-	/* Select the mode */
-	val = config->function | (config->direction << 4);
-	REG_WRITE(gpio_base + GPIO_MODE_CTL, val);
-
-	/* Set the right pull */
-	val = config->pull;
-	REG_WRITE(gpio_base + GPIO_DIG_PULL_CTL, val);
-
-	/* Select the VIN */
-	val = config->vin_sel;
-	REG_WRITE(gpio_base + GPIO_DIG_VIN_CTL, val);
-
-	if (config->direction == PM_GPIO_DIR_OUT) {
-		/* Set the right dig out control */
-		val = config->out_strength | (config->output_buffer << 4);
-		REG_WRITE(gpio_base + GPIO_DIG_OUT_CTL, val);
-	}
-
-	/* Enable the GPIO */
-	val  = REG_READ(gpio_base + GPIO_EN_CTL);
-	val |= BIT(PERPH_EN_BIT);
-	REG_WRITE(gpio_base + GPIO_EN_CTL, val);
-
-	return 0;
+	return pm8x41_gpio_batch_config(gpio_base, config);
 }
 
 /* Reads the status of requested gpio */
@@ -0,0 +1,304 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <debug.h>
+#include <err.h>
+#include <string.h>
+#include <spmi.h>
+#include <kernel/thread.h>
+#include <pm8x41_hw.h>
+#include <pm8x41_batch.h>
+
+#define PERIPH_BASE(_addr)  ((_addr) & ~0xFF)
+
+static const struct pm_batch_arb pm_batch_default_arb = {
+	.read  = pmic_arb_read_cmd,
+	.write = pmic_arb_write_cmd,
+};
+
+static const struct pm_batch_arb *batch_arb = &pm_batch_default_arb;
+
+/* Accesses collected for the next arbiter command */
+struct pm_batch_burst
+{
+	uint8_t type;
+	uint8_t len;
+	uint32_t addr;
+	uint8_t buf[PM_BATCH_MAX_BURST];
+	uint8_t *out[PM_BATCH_MAX_BURST];
+};
+
+/* Registers whose value this batch has read or written */
+struct pm_batch_shadow
+{
+	uint32_t addr[PM_BATCH_MAX_OPS];
+	uint8_t val[PM_BATCH_MAX_OPS];
+	unsigned num;
+};
+
+static bool pm_batch_shadow_get(struct pm_batch_shadow *sh, uint32_t addr, uint8_t *val)
+{
+	unsigned i;
+
+	for (i = 0; i < sh->num; i++)
+	{
+		if (sh->addr[i] == addr)
+		{
+			*val = sh->val[i];
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void pm_batch_shadow_set(struct pm_batch_shadow *sh, uint32_t addr, uint8_t val)
+{
+	unsigned i;
+
+	for (i = 0; i < sh->num; i++)
+	{
+		if (sh->addr[i] == addr)
+		{
+			sh->val[i] = val;
+			return;
+		}
+	}
+
+	/* Every shadowed register comes from an op, so this cannot overflow */
+	ASSERT(sh->num < PM_BATCH_MAX_OPS);
+	sh->addr[sh->num] = addr;
+	sh->val[sh->num++] = val;
+}
+
+static int pm_batch_flush(struct pm_batch_burst *bu, struct pm_batch_shadow *sh)
+{
+	struct pmic_arb_cmd cmd;
+	struct pmic_arb_param param;
+	unsigned int ret;
+	unsigned i;
+
+	if (!bu->len)
+		return NO_ERROR;
+
+	cmd.address  = PERIPH_ID(bu->addr);
+	cmd.offset   = REG_OFFSET(bu->addr);
+	cmd.slave_id = SLAVE_ID(bu->addr);
+	cmd.priority = 0;
+
+	param.buffer = bu->buf;
+	param.size   = bu->len;
+
+	if (bu->type == PM_BATCH_WRITE)
+	{
+		ret = batch_arb->write(&cmd, &param);
+	}
+	else
+	{
+		ret = batch_arb->read(&cmd, &param);
+		for (i = 0; !ret && i < bu->len; i++)
+		{
+			if (bu->out[i])
+				*bu->out[i] = bu->buf[i];
+			pm_batch_shadow_set(sh, bu->addr + i, bu->buf[i]);
+		}
+	}
+
+	bu->len = 0;
+
+	if (ret)
+	{
+		dprintf(CRITICAL, "PMIC batch %s failed at 0x%x\n",
+			bu->type == PM_BATCH_WRITE ? "write" : "read", bu->addr);
+		return ERR_IO;
+	}
+
+	return NO_ERROR;
+}
+
+/* Append an access, issuing the pending burst first if it cannot be extended */
+static int pm_batch_queue(struct pm_batch_burst *bu, struct pm_batch_shadow *sh,
+			  uint8_t type, uint32_t addr, uint8_t val, uint8_t *out)
+{
+	int ret;
+
+	if (bu->len && (bu->type != type ||
+			addr != bu->addr + bu->len ||
+			PERIPH_BASE(addr) != PERIPH_BASE(bu->addr) ||
+			bu->len == PM_BATCH_MAX_BURST))
+	{
+		ret = pm_batch_flush(bu, sh);
+		if (ret)
+			return ret;
+	}
+
+	if (!bu->len)
+	{
+		bu->type = type;
+		bu->addr = addr;
+	}
+
+	bu->buf[bu->len] = val;
+	bu->out[bu->len] = out;
+	bu->len++;
+
+	if (type == PM_BATCH_WRITE)
+		pm_batch_shadow_set(sh, addr, val);
+
+	return NO_ERROR;
+}
+
+static int pm_batch_rmw_op(struct pm_batch_burst *bu, struct pm_batch_shadow *sh,
+			   struct pm_batch_op *op)
+{
+	uint8_t cur, val;
+	int ret;
+
+	if (!pm_batch_shadow_get(sh, op->addr, &cur))
+	{
+		/* The register may be in the pending read burst */
+		ret = pm_batch_flush(bu, sh);
+		if (ret)
+			return ret;
+
+		if (!pm_batch_shadow_get(sh, op->addr, &cur))
+		{
+			ret = pm_batch_queue(bu, sh, PM_BATCH_READ, op->addr, 0, NULL);
+			if (!ret)
+				ret = pm_batch_flush(bu, sh);
+			if (ret)
+				return ret;
+
+			pm_batch_shadow_get(sh, op->addr, &cur);
+		}
+	}
+
+	val = (cur & ~op->mask) | (op->val & op->mask);
+
+	/* Nothing changes, skip the write */
+	if (val == cur)
+		return NO_ERROR;
+
+	return pm_batch_queue(bu, sh, PM_BATCH_WRITE, op->addr, val, NULL);
+}
+
+static void pm_batch_add(struct pm_batch *b, uint8_t type, uint32_t addr,
+			 uint8_t mask, uint8_t val, uint8_t *out)
+{
+	struct pm_batch_op *op;
+
+	if (b->num == PM_BATCH_MAX_OPS)
+	{
+		dprintf(CRITICAL, "PMIC batch full, dropping access to 0x%x\n", addr);
+		b->err = ERR_TOO_BIG;
+		return;
+	}
+
+	op = &b->ops[b->num++];
+	op->type = type;
+	op->addr = addr;
+	op->mask = mask;
+	op->val  = val;
+	op->out  = out;
+}
+
+void pm_batch_init(struct pm_batch *b)
+{
+	b->num = 0;
+	b->err = NO_ERROR;
+}
+
+void pm_batch_read(struct pm_batch *b, uint32_t addr, uint8_t *out)
+{
+	pm_batch_add(b, PM_BATCH_READ, addr, 0, 0, out);
+}
+
+void pm_batch_write(struct pm_batch *b, uint32_t addr, uint8_t val)
+{
+	pm_batch_add(b, PM_BATCH_WRITE, addr, 0xFF, val, NULL);
+}
+
+void pm_batch_rmw(struct pm_batch *b, uint32_t addr, uint8_t mask, uint8_t val)
+{
+	pm_batch_add(b, PM_BATCH_RMW, addr, mask, val, NULL);
+}
+
+/*
+ * Execute the queued accesses in order and empty the queue. The batch is
+ * atomic with respect to other threads touching the PMIC. A read-modify-write
+ * of a register already read or written by the batch needs no arbiter read,
+ * and one that would not change the register is dropped.
+ * Returns NO_ERROR, or the first error with the rest of the batch skipped.
+ */
+int pm_batch_run(struct pm_batch *b)
+{
+	struct pm_batch_burst bu;
+	struct pm_batch_shadow sh;
+	struct pm_batch_op *op;
+	int ret = b->err;
+	unsigned i;
+
+	bu.len = 0;
+	sh.num = 0;
+
+	enter_critical_section();
+
+	for (i = 0; !ret && i < b->num; i++)
+	{
+		op = &b->ops[i];
+
+		switch (op->type)
+		{
+		case PM_BATCH_READ:
+			ret = pm_batch_queue(&bu, &sh, PM_BATCH_READ, op->addr, 0, op->out);
+			break;
+		case PM_BATCH_WRITE:
+			ret = pm_batch_queue(&bu, &sh, PM_BATCH_WRITE, op->addr, op->val, NULL);
+			break;
+		case PM_BATCH_RMW:
+			ret = pm_batch_rmw_op(&bu, &sh, op);
+			break;
+		}
+	}
+
+	if (!ret)
+		ret = pm_batch_flush(&bu, &sh);
+
+	exit_critical_section();
+
+	pm_batch_init(b);
+
+	return ret;
+}
+
+/* Route arbiter commands to arb, or back to the hardware for NULL */
+void pm_batch_set_arb(const struct pm_batch_arb *arb)
+{
+	batch_arb = arb ? arb : &pm_batch_default_arb;
+}
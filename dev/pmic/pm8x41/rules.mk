@@ -5,6 +5,7 @@ INCLUDES += -I$(LOCAL_DIR)/include
 OBJS += \
 	$(LOCAL_DIR)/pm8x41.o \
 	$(LOCAL_DIR)/pm8x41_adc.o \
+	$(LOCAL_DIR)/pm8x41_batch.o \
 	$(LOCAL_DIR)/pm8x41_wled.o
 
 ifeq ($(ENABLE_PON_VIB_SUPPORT),true)
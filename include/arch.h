@@ -30,6 +30,9 @@ extern "C" {
 void arch_early_init(void);
 void arch_init(void);
 
+/* physical entry point secondary cpus are released at */
+void arch_secondary_start(void);
+
 #if defined(__cplusplus)
 }
 #endif
@@ -40,6 +40,17 @@ int atomic_add(volatile int *ptr, int val);
 int atomic_and(volatile int *ptr, int val);
 int atomic_or(volatile int *ptr, int val);
 
+/* disable interrupts, returning the previous state to hand to arch_restore_ints() */
+uint32_t arch_save_disable_ints(void);
+void arch_restore_ints(uint32_t state);
+
+/* lock word is 0 when free. trylock returns nonzero if the lock was taken */
+void arch_spin_lock(volatile int *lock);
+int arch_spin_trylock(volatile int *lock);
+void arch_spin_unlock(volatile int *lock);
+
+uint arch_curr_cpu_num(void);
+
 #endif // !ASSEMBLY
 #define ICACHE 1
 #define DCACHE 2
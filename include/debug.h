@@ -49,13 +49,23 @@ extern "C" {
 
 /* output */
 void _dputc(char c); // XXX for now, platform implements
+void _dflush(void); // drain output the platform buffers, no-op by default
 int _dputs(const char *str);
 int _dprintf(const char *fmt, ...) __PRINTFLIKE(1, 2);
 int _dvprintf(const char *fmt, va_list ap);
 
 #define dputc(level, str) do { if ((level) <= DEBUGLEVEL) { _dputc(str); } } while (0)
 #define dputs(level, str) do { if ((level) <= DEBUGLEVEL) { _dputs(str); } } while (0)
+#if WITH_DLOG
+/* levels at or above DLOG_LEVEL go through the deferred log ring, see lib/dlog.h */
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL INFO
+#endif
+int _dlog_printf(const char *fmt, ...) __PRINTFLIKE(1, 2);
+#define dprintf(level, x...) do { if ((level) <= DEBUGLEVEL) { if ((level) >= DLOG_LEVEL) _dlog_printf(x); else _dprintf(x); } } while (0)
+#else
 #define dprintf(level, x...) do { if ((level) <= DEBUGLEVEL) { _dprintf(x); } } while (0)
+#endif
 #define dvprintf(level, x...) do { if ((level) <= DEBUGLEVEL) { _dvprintf(x); } } while (0)
 
 /* input */
@@ -81,11 +81,21 @@
 #define KEY_HOME	0x122
 #define KEY_BACK	0x123
 #define KEY_MENU	0x124
+#define KEY_POWER	0x125
 
 #define MAX_KEYS	0x1ff
 
+struct key_event {
+	uint16_t code;
+	int16_t value;	/* 1 pressed, 0 released */
+};
+
 void keys_init(void);
 void keys_post_event(uint16_t code, int16_t value);
 int keys_get_state(uint16_t code);
 
+int keys_add_source(uint16_t code, int (*get_state)(void));
+int keys_get_event(struct key_event *ev);
+int keys_wait_event(struct key_event *ev, time_t timeout);
+
 #endif /* __DEV_KEYS_H */
@@ -0,0 +1,80 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __KERNEL_MP_H
+#define __KERNEL_MP_H
+
+#include <sys/types.h>
+#include <compiler.h>
+#include <arch/ops.h>
+
+/*
+ * Optional symmetric multiprocessing support. With WITH_SMP=1 the kernel
+ * keeps one run queue per cpu, idle cpus steal runnable threads from busy
+ * ones and cpus kick each other with inter processor interrupts. Threads
+ * stay on the boot cpu unless made migratable, critical sections only
+ * mask the local cpu and the scheduler state has its own thread lock.
+ */
+#if WITH_SMP
+#ifndef SMP_MAX_CPUS
+#define SMP_MAX_CPUS 4
+#endif
+#define curr_cpu_num() arch_curr_cpu_num()
+#else
+#undef SMP_MAX_CPUS
+#define SMP_MAX_CPUS 1
+#define curr_cpu_num() (0)
+#endif
+
+enum mp_ipi {
+	MP_IPI_GENERIC,
+	MP_IPI_RESCHEDULE,
+	MP_IPI_MAX,
+};
+
+#define MP_CPU_ALL_BUT_LOCAL (0xffffffff)
+
+/* mask of cpus which have reached the scheduler */
+#if WITH_SMP
+extern volatile uint32_t mp_active_cpus;
+#else
+#define mp_active_cpus (1U)
+#endif
+
+/* start the secondary cpus, called once from bootstrap2() */
+void mp_init(void);
+
+/* ask the cpus in the mask to run the scheduler */
+void mp_reschedule(uint32_t cpu_mask);
+
+/* called by platform interrupt glue when an ipi arrives */
+enum handler_return mp_ipi_handler(enum mp_ipi ipi);
+
+/* called by the arch layer once a secondary cpu has its mmu and stacks set up */
+void mp_secondary_entry(uint cpu) __NO_RETURN;
+
+static inline uint mp_num_active_cpus(void)
+{
+	return __builtin_popcount(mp_active_cpus);
+}
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __KERNEL_SPINLOCK_H
+#define __KERNEL_SPINLOCK_H
+
+#include <sys/types.h>
+#include <compiler.h>
+#include <arch/ops.h>
+
+/*
+ * spinlocks only protect against other cpus. callers that may race with
+ * an interrupt handler on the same cpu must have interrupts disabled,
+ * either by hand or by using the irqsave variants below.
+ */
+typedef volatile int spin_lock_t;
+
+#define SPIN_LOCK_INITIAL_VALUE (0)
+
+static inline void spin_lock_init(spin_lock_t *lock)
+{
+	*lock = SPIN_LOCK_INITIAL_VALUE;
+}
+
+static inline __ALWAYS_INLINE void spin_lock(spin_lock_t *lock)
+{
+	arch_spin_lock(lock);
+}
+
+static inline __ALWAYS_INLINE int spin_trylock(spin_lock_t *lock)
+{
+	return arch_spin_trylock(lock);
+}
+
+static inline __ALWAYS_INLINE void spin_unlock(spin_lock_t *lock)
+{
+	arch_spin_unlock(lock);
+}
+
+static inline __ALWAYS_INLINE bool spin_lock_held(spin_lock_t *lock)
+{
+	return *lock != SPIN_LOCK_INITIAL_VALUE;
+}
+
+/* returns the previous interrupt state in *state */
+static inline __ALWAYS_INLINE void spin_lock_irqsave(spin_lock_t *lock, uint32_t *state)
+{
+	*state = arch_save_disable_ints();
+	arch_spin_lock(lock);
+}
+
+static inline __ALWAYS_INLINE void spin_unlock_irqrestore(spin_lock_t *lock, uint32_t state)
+{
+	arch_spin_unlock(lock);
+	arch_restore_ints(state);
+}
+
+#endif
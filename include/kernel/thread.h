@@ -28,6 +28,8 @@
 #include <compiler.h>
 #include <arch/ops.h>
 #include <arch/thread.h>
+#include <kernel/mp.h>
+#include <kernel/spinlock.h>
 
 enum thread_state {
 	THREAD_SUSPENDED = 0,
@@ -47,6 +49,28 @@ enum thread_tls_list {
 
 #define THREAD_MAGIC 'thrd'
 
+/*
+ * per thread scheduler accounting, measured with arch_cycle_count().
+ * costs a couple of cycle counter reads per context switch and per
+ * wait queue block, so it is left on in production builds.
+ */
+#ifndef THREAD_ACCOUNTING
+#define THREAD_ACCOUNTING 1
+#endif
+
+#if THREAD_ACCOUNTING
+struct thread_accounting {
+	uint64_t run_cycles;		/* total cycles spent running */
+	uint64_t blocked_cycles;	/* total cycles blocked on wait queues */
+	uint32_t max_latency;		/* worst ready to running latency, in cycles */
+	uint32_t voluntary_switches;	/* blocked, slept, yielded or exited */
+	uint32_t involuntary_switches;	/* preempted while still runnable */
+	uint32_t run_stamp;		/* cycle count when last switched in */
+	uint32_t ready_stamp;		/* cycle count when last made runnable */
+	bool yielding;
+};
+#endif
+
 typedef struct thread {
 	int magic;
 	struct list_node thread_list_node;
@@ -56,7 +80,12 @@ typedef struct thread {
 	int priority;
 	enum thread_state state;	
 	int saved_critical_section_count;
+#if WITH_SMP
+	int saved_thread_lock_count;
+#endif
 	int remaining_quantum;
+	uint curr_cpu;	/* cpu it is running on, or whose run queue it sits in */
+	uint flags;
 
 	/* if blocked, a pointer to the wait queue */
 	struct wait_queue *blocking_wait_queue;
@@ -79,9 +108,16 @@ typedef struct thread {
 	/* thread local storage */
 	uint32_t tls[MAX_TLS_ENTRY];
 
+#if THREAD_ACCOUNTING
+	struct thread_accounting acct;
+#endif
+
 	char name[32];
 } thread_t;
 
+/* thread flags */
+#define THREAD_FLAG_MIGRATABLE 0x1	/* may run on any cpu, see thread_set_migratable() */
+
 /* thread priority */
 #define NUM_PRIORITIES 32
 #define LOWEST_PRIORITY 0
@@ -98,11 +134,15 @@ typedef struct thread {
 /* functions */
 void thread_init_early(void);
 void thread_init(void);
+#if WITH_SMP
+void thread_secondary_cpu_init_early(uint cpu);
+#endif
 void thread_become_idle(void) __NO_RETURN;
 void thread_set_name(const char *name);
 void thread_set_priority(int priority);
 thread_t *thread_create(const char *name, thread_start_routine entry, void *arg, int priority, size_t stack_size);
 status_t thread_resume(thread_t *);
+void thread_set_migratable(thread_t *);
 void thread_exit(int retcode) __NO_RETURN;
 void thread_sleep(time_t delay);
 
@@ -117,6 +157,62 @@ void thread_block(void); /* block on something and reschedule */
 /* called on every timer tick for the scheduler to do quantum expiration */
 enum handler_return thread_timer_tick(void);
 
+#if WITH_SMP
+/* per cpu copies of the scheduler globals below */
+extern thread_t *_current_thread[SMP_MAX_CPUS];
+extern thread_t *_idle_thread[SMP_MAX_CPUS];
+extern int _critical_section_count[SMP_MAX_CPUS];
+extern int _thread_lock_count[SMP_MAX_CPUS];
+
+#define current_thread (_current_thread[curr_cpu_num()])
+#define idle_thread (_idle_thread[curr_cpu_num()])
+#define critical_section_count (_critical_section_count[curr_cpu_num()])
+#define thread_lock_count (_thread_lock_count[curr_cpu_num()])
+
+/*
+ * critical sections only mask interrupts on the local cpu. interrupts go
+ * off before the cpu number is looked up, a preempted thread may come back
+ * on another cpu.
+ */
+static inline __ALWAYS_INLINE void enter_critical_section(void)
+{
+	arch_disable_ints();
+	critical_section_count++;
+}
+
+static inline __ALWAYS_INLINE void exit_critical_section(void)
+{
+	if (--critical_section_count == 0)
+		arch_enable_ints();
+}
+
+/*
+ * the thread lock serializes the scheduler state between cpus: the run
+ * queues, the thread list and the wait queues under mutexes and events.
+ * it nests, and is handed across context switches along with the critical
+ * section count.
+ */
+extern spin_lock_t thread_lock;
+
+static inline __ALWAYS_INLINE void thread_lock_acquire(void)
+{
+	enter_critical_section();
+	if (++thread_lock_count == 1)
+		spin_lock(&thread_lock);
+}
+
+static inline __ALWAYS_INLINE void thread_lock_release(void)
+{
+	if (--thread_lock_count == 0)
+		spin_unlock(&thread_lock);
+	exit_critical_section();
+}
+
+static inline __ALWAYS_INLINE bool thread_lock_held(void)
+{
+	return thread_lock_count > 0;
+}
+#else
 /* the current thread */
 extern thread_t *current_thread;
 
@@ -140,15 +236,38 @@ static inline __ALWAYS_INLINE void exit_critical_section(void)
 		arch_enable_ints();
 }
 
+/* with one cpu the scheduler state only needs interrupts off */
+static inline __ALWAYS_INLINE void thread_lock_acquire(void)
+{
+	enter_critical_section();
+}
+
+static inline __ALWAYS_INLINE void thread_lock_release(void)
+{
+	exit_critical_section();
+}
+#endif
+
 static inline __ALWAYS_INLINE bool in_critical_section(void)
 {
 	return critical_section_count > 0;
 }
 
+#if !WITH_SMP
+static inline __ALWAYS_INLINE bool thread_lock_held(void)
+{
+	return in_critical_section();
+}
+#endif
+
 /* only used by interrupt glue */
 static inline void inc_critical_section(void) { critical_section_count++; }
 static inline void dec_critical_section(void) { critical_section_count--; }
 
+/* out of line versions for the assembly irq entry path */
+void thread_irq_enter(void);
+void thread_irq_exit(void);
+
 /* thread local storage */
 static inline __ALWAYS_INLINE uint32_t tls_get(uint entry)
 {
@@ -172,7 +291,7 @@ typedef struct wait_queue {
 } wait_queue_t;
 
 /* wait queue primitive */
-/* NOTE: must be inside critical section when using these */
+/* NOTE: must hold the thread lock when using these */
 void wait_queue_init(wait_queue_t *);
 
 /* 
@@ -227,5 +346,13 @@ extern struct thread_stats thread_stats;
 
 #endif
 
+#if THREAD_ACCOUNTING
+/* system wide scheduling latency histogram, bucket n counts latencies of [2^n, 2^(n+1)) cycles */
+#define SCHED_LATENCY_BUCKETS 32
+extern uint32_t sched_latency_hist[SCHED_LATENCY_BUCKETS];
+
+void dump_sched_latency(void);
+#endif
+
 #endif
 
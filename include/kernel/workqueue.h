@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __KERNEL_WORKQUEUE_H
+#define __KERNEL_WORKQUEUE_H
+
+#include <list.h>
+#include <sys/types.h>
+#include <kernel/thread.h>
+#include <kernel/event.h>
+
+/*
+ * Fork/join work queues. Work items are run by a small pool of worker
+ * threads; a work group counts outstanding items so the submitter can
+ * wait for all of them at once. On SMP builds the workers spread over
+ * all cpus, on a single core they still let blocking steps overlap.
+ * There is no shared queue: users create theirs on first use, so boots
+ * that never queue work never start a worker.
+ */
+
+struct work;
+
+typedef int (*work_func)(void *arg);
+typedef void (*work_done_func)(struct work *work);
+
+#define WORK_GROUP_MAGIC 'wgrp'
+
+typedef struct work_group {
+	int magic;
+	int pending;
+	status_t status;	/* first failure among the group's items */
+	event_t done;
+} work_group_t;
+
+typedef struct work {
+	struct list_node node;
+	work_func func;
+	void *arg;
+	work_done_func done;	/* optional, runs on the worker after func */
+	int result;
+	work_group_t *group;
+} work_t;
+
+#define WORKQUEUE_MAGIC 'wrkq'
+#define WORKQUEUE_MAX_WORKERS 8
+
+typedef struct workqueue {
+	int magic;
+	struct list_node queue;
+	event_t event;
+	int num_workers;
+	thread_t *workers[WORKQUEUE_MAX_WORKERS];
+} workqueue_t;
+
+status_t workqueue_create(workqueue_t *wq, const char *name, int num_workers, int priority);
+
+void work_init(work_t *work, work_func func, void *arg, work_done_func done);
+void work_group_init(work_group_t *group);
+
+/* queue a work item, optionally accounting it to a group */
+status_t workqueue_submit(workqueue_t *wq, work_t *work, work_group_t *group);
+
+/* wait until every item submitted to the group has finished */
+status_t work_group_wait(work_group_t *group, time_t timeout);
+
+#endif
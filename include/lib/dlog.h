@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#ifndef __LIB_DLOG_H
+#define __LIB_DLOG_H
+
+#include <sys/types.h>
+#include <compiler.h>
+
+/*
+ * deferred binary logging.
+ *
+ * with WITH_DLOG set, dprintf() at or above DLOG_LEVEL records the format
+ * string pointer, the raw arguments and a timestamp into an in-memory ring
+ * instead of formatting on the spot. a low priority thread formats and
+ * prints the records later; dlog_flush() does it synchronously (panic,
+ * kernel entry) and dlog_dump() replays whatever is still retained.
+ *
+ * format strings must outlive the record, which is true for the string
+ * literals dprintf is used with. %s arguments are copied into the record.
+ */
+
+/* size of the ring in bytes, power of two */
+#ifndef DLOG_BUF_SIZE
+#define DLOG_BUF_SIZE 16384
+#endif
+
+/* records with more arguments than this are printed synchronously */
+#define DLOG_MAX_ARGS 8
+
+/* upper bound on a single record, including copied strings */
+#define DLOG_MAX_REC 256
+
+/* how often the log thread drains the ring */
+#define DLOG_FLUSH_INTERVAL 50 /* msecs */
+
+typedef void (*dlog_dump_func)(const char *text, void *arg);
+
+void dlog_init(void);
+int _dlog_printf(const char *fmt, ...) __PRINTFLIKE(1, 2);
+
+/* print all pending records to the debug console from the calling context */
+void dlog_flush(void);
+
+/*
+ * format every record still in the ring, printed or not, oldest first.
+ * returns the number of records handed to func.
+ */
+int dlog_dump(dlog_dump_func func, void *arg);
+
+/* number of records lost because the ring was full of unprinted records */
+uint32_t dlog_dropped(void);
+
+#endif
@@ -63,4 +63,10 @@ int platform_is_msm8939();
 int platform_is_msm8909();
 int boot_device_mask(int);
 uint32_t platform_detect_panel();
+
+/* smp support, see kernel/mp.h */
+void platform_mp_init(void);
+status_t platform_cpu_start(uint cpu, addr_t entry);
+void platform_secondary_init(uint cpu);
+void platform_send_ipi(uint32_t cpu_mask, uint ipi);
 #endif
@@ -27,6 +27,9 @@ typedef enum handler_return (*platform_timer_callback)(void *arg, time_t now);
 
 status_t platform_set_periodic_timer(platform_timer_callback callback, void *arg, time_t interval);
 
+/* periodic tick private to the calling cpu, an interval of 0 stops it */
+status_t platform_set_cpu_tick(platform_timer_callback callback, void *arg, time_t interval);
+
 void mdelay(unsigned msecs);
 void udelay(unsigned usecs);
 
@@ -37,6 +37,19 @@ int snprintf(char *str, size_t len, const char *fmt, ...) __PRINTFLIKE(3, 4);
 int vsprintf(char *str, const char *fmt, va_list ap);
 int vsnprintf(char *str, size_t len, const char *fmt, va_list ap);
 
+/*
+ * allocation free formatting core. the output routine is called once per
+ * character and may return a negative value to stop formatting early. the
+ * return value is the number of characters accepted by the output routine.
+ */
+typedef int (*_printf_engine_output_func)(char c, void *state);
+
+int _printf_engine(_printf_engine_output_func out, void *state, const char *fmt, va_list ap);
+
+/* same, but the arguments are pre-widened values in format order */
+int _printf_engine_args(_printf_engine_output_func out, void *state, const char *fmt,
+		const unsigned long long *args);
+
 #if defined(__cplusplus)
 }
 #endif
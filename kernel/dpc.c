@@ -35,6 +35,7 @@ struct dpc {
 	void *arg;
 };
 
+/* queued by thread_exit() on any cpu, so kept under the thread lock */
 static struct list_node dpc_list = LIST_INITIAL_VALUE(dpc_list);
 static event_t dpc_event;
 
@@ -55,10 +56,10 @@ status_t dpc_queue(dpc_callback cb, void *arg, uint flags)
 
 	dpc->cb = cb;
 	dpc->arg = arg;
-	enter_critical_section();
+	thread_lock_acquire();
 	list_add_tail(&dpc_list, &dpc->node);
 	event_signal(&dpc_event, (flags & DPC_FLAG_NORESCHED) ? false : true);
-	exit_critical_section();
+	thread_lock_release();
 
 	return NO_ERROR;
 }
@@ -68,11 +69,11 @@ static int dpc_thread_routine(void *arg)
 	for (;;) {
 		event_wait(&dpc_event);
 
-		enter_critical_section();
+		thread_lock_acquire();
 		struct dpc *dpc = list_remove_head_type(&dpc_list, struct dpc, node);
 		if (!dpc)
 			event_unsignal(&dpc_event);
-		exit_critical_section();
+		thread_lock_release();
 
 		if (dpc) {
 //			dprintf("dpc calling %p, arg %p\n", dpc->cb, dpc->arg);
@@ -78,7 +78,7 @@ void event_init(event_t *e, bool initial, uint flags)
  */
 void event_destroy(event_t *e)
 {
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if EVENT_CHECK
 	ASSERT(e->magic == EVENT_MAGIC);
@@ -89,7 +89,7 @@ void event_destroy(event_t *e)
 	e->flags = 0;
 	wait_queue_destroy(&e->wait, true);
 
-	exit_critical_section();
+	thread_lock_release();
 }
 
 /**
@@ -111,7 +111,7 @@ status_t event_wait_timeout(event_t *e, time_t timeout)
 {
 	status_t ret = NO_ERROR;
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if EVENT_CHECK
 	ASSERT(e->magic == EVENT_MAGIC);
@@ -131,7 +131,7 @@ status_t event_wait_timeout(event_t *e, time_t timeout)
 	}
 
 err:
-	exit_critical_section();
+	thread_lock_release();
 
 	return ret;
 }
@@ -163,7 +163,7 @@ status_t event_wait(event_t *e)
  */
 status_t event_signal(event_t *e, bool reschedule)
 {
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if EVENT_CHECK
 	ASSERT(e->magic == EVENT_MAGIC);
@@ -187,7 +187,7 @@ status_t event_signal(event_t *e, bool reschedule)
 		}
 	}
 
-	exit_critical_section();
+	thread_lock_release();
 
 	return NO_ERROR;
 }
@@ -206,7 +206,7 @@ status_t event_signal(event_t *e, bool reschedule)
  */
 status_t event_unsignal(event_t *e)
 {
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if EVENT_CHECK
 	ASSERT(e->magic == EVENT_MAGIC);
@@ -214,7 +214,7 @@ status_t event_unsignal(event_t *e)
 
 	e->signalled = false;
 
-	exit_critical_section();
+	thread_lock_release();
 
 	return NO_ERROR;
 }
@@ -34,6 +34,10 @@
 #include <kernel/timer.h>
 #include <kernel/dpc.h>
 #include <boot_stats.h>
+#include <lib/bio.h>
+#if WITH_DLOG
+#include <lib/dlog.h>
+#endif
 
 extern void *__ctor_list;
 extern void *__ctor_end;
@@ -121,6 +125,11 @@ int main(void);
 
 static int bootstrap2(void *arg)
 {
+#if WITH_DLOG
+	// start draining the deferred log ring
+	dlog_init();
+#endif
+
 	dprintf(SPEW, "top of bootstrap2()\n");
 
 	arch_init();
@@ -137,6 +146,12 @@ static int bootstrap2(void *arg)
 	dprintf(SPEW, "initializing platform\n");
 	platform_init();
 
+#if WITH_SMP
+	// bring up the secondary cpus
+	dprintf(SPEW, "starting secondary cpus\n");
+	mp_init();
+#endif
+
 	// initialize the target
 	dprintf(SPEW, "initializing target\n");
 	target_init();
@@ -150,6 +165,11 @@ static int bootstrap2(void *arg)
 #if (ENABLE_NANDWRITE)
 void bootstrap_nandwrite(void)
 {
+#if WITH_DLOG
+	// start draining the deferred log ring
+	dlog_init();
+#endif
+
 	dprintf(SPEW, "top of bootstrap2()\n");
 
 	arch_init();
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief  Secondary cpu bring-up and inter processor interrupts
+ *
+ * @defgroup mp Multiprocessing
+ * @{
+ */
+#include <debug.h>
+#include <err.h>
+#include <arch.h>
+#include <arch/ops.h>
+#include <kernel/mp.h>
+#include <kernel/thread.h>
+#include <platform.h>
+
+/* how long to wait for a secondary to report in, in ms */
+#define MP_CPU_START_TIMEOUT 100
+
+volatile uint32_t mp_active_cpus = 1;
+
+/**
+ * @brief  Start all secondary cpus
+ *
+ * Asks the platform to release each secondary cpu at the arch entry point
+ * and waits for it to reach the scheduler. Cpus which fail to start are
+ * skipped, the system keeps running on whatever came up.
+ */
+void mp_init(void)
+{
+	uint cpu;
+	status_t err;
+
+	platform_mp_init();
+
+	for (cpu = 1; cpu < SMP_MAX_CPUS; cpu++) {
+		err = platform_cpu_start(cpu, PA((addr_t)&arch_secondary_start));
+		if (err < 0) {
+			dprintf(INFO, "mp: cpu %u not started (%d)\n", cpu, err);
+			continue;
+		}
+
+		time_t start = current_time();
+		while (!(mp_active_cpus & (1U << cpu))) {
+			if (current_time() - start > MP_CPU_START_TIMEOUT) {
+				dprintf(CRITICAL, "mp: cpu %u failed to come online\n", cpu);
+				break;
+			}
+			thread_sleep(1);
+		}
+	}
+
+	dprintf(INFO, "mp: %u cpus active (mask 0x%x)\n", mp_num_active_cpus(), mp_active_cpus);
+}
+
+/**
+ * @brief  C entry point of a secondary cpu
+ *
+ * Runs on the secondary with its mmu, caches and exception stacks set up.
+ */
+void mp_secondary_entry(uint cpu)
+{
+	thread_secondary_cpu_init_early(cpu);
+
+	/* local interrupt controller interface, ipis have to get through */
+	platform_secondary_init(cpu);
+
+	atomic_or((volatile int *)&mp_active_cpus, 1 << cpu);
+	dprintf(SPEW, "mp: cpu %u online\n", cpu);
+
+	exit_critical_section();
+
+	thread_become_idle();
+}
+
+/**
+ * @brief  Make other cpus run the scheduler
+ *
+ * @param cpu_mask  Cpus to kick, the local cpu and inactive cpus are ignored
+ */
+void mp_reschedule(uint32_t cpu_mask)
+{
+	cpu_mask &= mp_active_cpus & ~(1U << curr_cpu_num());
+	if (cpu_mask)
+		platform_send_ipi(cpu_mask, MP_IPI_RESCHEDULE);
+}
+
+enum handler_return mp_ipi_handler(enum mp_ipi ipi)
+{
+	switch (ipi) {
+		case MP_IPI_RESCHEDULE:
+			return INT_RESCHEDULE;
+		case MP_IPI_GENERIC:
+		default:
+			return INT_NO_RESCHEDULE;
+	}
+}
+
+/** @} */
@@ -61,7 +61,7 @@ void mutex_init(mutex_t *m)
  */
 void mutex_destroy(mutex_t *m)
 {
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if MUTEX_CHECK
 	ASSERT(m->magic == MUTEX_MAGIC);
@@ -74,7 +74,7 @@ void mutex_destroy(mutex_t *m)
 	m->magic = 0;
 	m->count = 0;
 	wait_queue_destroy(&m->wait, true);
-	exit_critical_section();
+	thread_lock_release();
 }
 
 /**
@@ -93,7 +93,7 @@ status_t mutex_acquire(mutex_t *m)
 		panic("mutex_acquire: thread %p (%s) tried to acquire mutex %p it already owns.\n",
 				current_thread, current_thread->name, m);
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if MUTEX_CHECK
 	ASSERT(m->magic == MUTEX_MAGIC);
@@ -115,7 +115,7 @@ status_t mutex_acquire(mutex_t *m)
 	m->holder = current_thread;	
 
 err:
-	exit_critical_section();
+	thread_lock_release();
 
 	return ret;
 }
@@ -141,7 +141,7 @@ status_t mutex_acquire_timeout(mutex_t *m, time_t timeout)
 	if (timeout == INFINITE_TIME)
 		return mutex_acquire(m);
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if MUTEX_CHECK
 	ASSERT(m->magic == MUTEX_MAGIC);
@@ -171,7 +171,7 @@ status_t mutex_acquire_timeout(mutex_t *m, time_t timeout)
 	m->holder = current_thread;	
 
 err:
-	exit_critical_section();
+	thread_lock_release();
 
 	return ret;
 }
@@ -185,7 +185,7 @@ status_t mutex_release(mutex_t *m)
 		panic("mutex_release: thread %p (%s) tried to release mutex %p it doesn't own. owned by %p (%s)\n", 
 				current_thread, current_thread->name, m, m->holder, m->holder ? m->holder->name : "none");
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if MUTEX_CHECK
 	ASSERT(m->magic == MUTEX_MAGIC);
@@ -201,7 +201,7 @@ status_t mutex_release(mutex_t *m)
 		wait_queue_wake_one(&m->wait, true, NO_ERROR);
 	}
 
-	exit_critical_section();
+	thread_lock_release();
 
 	return NO_ERROR;
 }
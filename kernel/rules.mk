@@ -12,5 +12,16 @@ OBJS += \
 	$(LOCAL_DIR)/main.o \
 	$(LOCAL_DIR)/mutex.o \
 	$(LOCAL_DIR)/thread.o \
-	$(LOCAL_DIR)/timer.o
+	$(LOCAL_DIR)/timer.o \
+	$(LOCAL_DIR)/workqueue.o
 
+# build with WITH_SMP=1 to run the scheduler on all cpus the platform can start
+ifeq ($(WITH_SMP),1)
+SMP_MAX_CPUS ?= 4
+DEFINES += \
+	WITH_SMP=1 \
+	SMP_MAX_CPUS=$(SMP_MAX_CPUS)
+
+OBJS += \
+	$(LOCAL_DIR)/mp.o
+endif
@@ -35,12 +35,14 @@
 #include <debug.h>
 #include <list.h>
 #include <malloc.h>
+#include <stdlib.h>
 #include <string.h>
 #include <err.h>
 #include <kernel/thread.h>
 #include <kernel/timer.h>
 #include <kernel/dpc.h>
 #include <platform.h>
+#include <platform/timer.h>
 
 #if DEBUGLEVEL > 1
 #define THREAD_CHECKS 1
@@ -50,25 +52,43 @@
 struct thread_stats thread_stats;
 #endif
 
+#if THREAD_ACCOUNTING
+uint32_t sched_latency_hist[SCHED_LATENCY_BUCKETS];
+#endif
+
 /* global thread list */
 static struct list_node thread_list;
 
+#if WITH_SMP
+/* per cpu current thread, idle thread and critical section count */
+thread_t *_current_thread[SMP_MAX_CPUS];
+thread_t *_idle_thread[SMP_MAX_CPUS];
+int _critical_section_count[SMP_MAX_CPUS] = { 1 };
+
+/* scheduler state lock and how deep each cpu holds it */
+spin_lock_t thread_lock = SPIN_LOCK_INITIAL_VALUE;
+int _thread_lock_count[SMP_MAX_CPUS];
+
+/* the secondary cpus start out running these */
+static thread_t secondary_bootstrap_thread[SMP_MAX_CPUS - 1];
+#else
 /* the current thread */
 thread_t *current_thread;
 
 /* the global critical section count */
 int critical_section_count = 1;
 
-/* the run queue */
-static struct list_node run_queue[NUM_PRIORITIES];
-static uint32_t run_queue_bitmap;
+/* the idle thread */
+thread_t *idle_thread;
+#endif
+
+/* the run queues, one set per cpu */
+static struct list_node run_queue[SMP_MAX_CPUS][NUM_PRIORITIES];
+static uint32_t run_queue_bitmap[SMP_MAX_CPUS];
 
 /* the bootstrap thread (statically allocated) */
 static thread_t bootstrap_thread;
 
-/* the idle thread */
-thread_t *idle_thread;
-
 /* local routines */
 static void thread_resched(void);
 static void idle_thread_routine(void) __NO_RETURN;
@@ -78,6 +98,114 @@ static void idle_thread_routine(void) __NO_RETURN;
 static timer_t preempt_timer;
 #endif
 
+#if WITH_SMP
+/* preemption tick of the secondary cpus */
+static enum handler_return thread_cpu_tick(void *arg, time_t now)
+{
+	return thread_timer_tick();
+}
+#endif
+
+#if THREAD_ACCOUNTING
+static inline void thread_acct_ready(thread_t *t)
+{
+	t->acct.ready_stamp = arch_cycle_count();
+}
+
+/* charge the outgoing thread and start the clock on the incoming one */
+static void thread_acct_switch(thread_t *oldthread, thread_t *newthread)
+{
+	uint32_t now = arch_cycle_count();
+	uint32_t latency = now - newthread->acct.ready_stamp;
+
+	oldthread->acct.run_cycles += now - oldthread->acct.run_stamp;
+	if (oldthread->state == THREAD_READY && !oldthread->acct.yielding)
+		oldthread->acct.involuntary_switches++;
+	else
+		oldthread->acct.voluntary_switches++;
+	oldthread->acct.yielding = false;
+
+	if (latency > newthread->acct.max_latency)
+		newthread->acct.max_latency = latency;
+	sched_latency_hist[latency ? 31 - __builtin_clz(latency) : 0]++;
+	newthread->acct.run_stamp = now;
+}
+#else
+static inline void thread_acct_ready(thread_t *t) {}
+#endif
+
+/* highest priority with a runnable thread in the bitmap, which must be nonzero */
+static inline int run_queue_highest(uint32_t bitmap)
+{
+	return HIGHEST_PRIORITY - __builtin_clz(bitmap) - (32 - NUM_PRIORITIES);
+}
+
+#if WITH_SMP
+/* poke the cpus that may run the new thread and are running something less important */
+static void kick_cpus(thread_t *t)
+{
+	uint32_t mask = 0;
+	uint cpu;
+
+	for (cpu = 0; cpu < SMP_MAX_CPUS; cpu++) {
+		if (cpu != t->curr_cpu && !(t->flags & THREAD_FLAG_MIGRATABLE))
+			continue;
+		if (_current_thread[cpu] && _current_thread[cpu]->priority < t->priority)
+			mask |= (1U << cpu);
+	}
+
+	if (mask)
+		mp_reschedule(mask);
+}
+
+/*
+ * Look for a migratable thread on another cpu's run queue with a higher
+ * priority than the best one we have locally. Idle threads are never
+ * migratable, which keeps every idle thread on its own cpu.
+ */
+static thread_t *steal_thread(uint cpu, int local_best)
+{
+	thread_t *t;
+	thread_t *best_thread = NULL;
+	uint victim;
+	int best = MAX(local_best, IDLE_PRIORITY);
+
+	for (victim = 0; victim < SMP_MAX_CPUS; victim++) {
+		uint32_t bitmap = run_queue_bitmap[victim];
+
+		if (victim == cpu)
+			continue;
+
+		while (bitmap) {
+			int prio = run_queue_highest(bitmap);
+			if (prio <= best)
+				break;
+			bitmap &= ~(1<<prio);
+
+			list_for_every_entry(&run_queue[victim][prio], t, thread_t, queue_node) {
+				if (t->flags & THREAD_FLAG_MIGRATABLE) {
+					best = prio;
+					best_thread = t;
+					break;
+				}
+			}
+		}
+	}
+
+	if (!best_thread)
+		return NULL;
+
+	t = best_thread;
+	list_delete(&t->queue_node);
+	if (list_is_empty(&run_queue[t->curr_cpu][best]))
+		run_queue_bitmap[t->curr_cpu] &= ~(1<<best);
+
+	t->curr_cpu = cpu;
+
+	return t;
+}
+#endif
+
 /* run queue manipulation */
 static void insert_in_run_queue_head(thread_t *t)
 {
@@ -85,11 +213,16 @@ static void insert_in_run_queue_head(thread_t *t)
 	ASSERT(t->magic == THREAD_MAGIC);
 	ASSERT(t->state == THREAD_READY);
 	ASSERT(!list_in_list(&t->queue_node));
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 
-	list_add_head(&run_queue[t->priority], &t->queue_node);
-	run_queue_bitmap |= (1<<t->priority);
+	thread_acct_ready(t);
+	list_add_head(&run_queue[t->curr_cpu][t->priority], &t->queue_node);
+	run_queue_bitmap[t->curr_cpu] |= (1<<t->priority);
+#if WITH_SMP
+	if (t != current_thread)
+		kick_cpus(t);
+#endif
 }
 
 static void insert_in_run_queue_tail(thread_t *t)
@@ -98,11 +231,16 @@ static void insert_in_run_queue_tail(thread_t *t)
 	ASSERT(t->magic == THREAD_MAGIC);
 	ASSERT(t->state == THREAD_READY);
 	ASSERT(!list_in_list(&t->queue_node));
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 
-	list_add_tail(&run_queue[t->priority], &t->queue_node);
-	run_queue_bitmap |= (1<<t->priority);
+	thread_acct_ready(t);
+	list_add_tail(&run_queue[t->curr_cpu][t->priority], &t->queue_node);
+	run_queue_bitmap[t->curr_cpu] |= (1<<t->priority);
+#if WITH_SMP
+	if (t != current_thread)
+		kick_cpus(t);
+#endif
 }
 
 static void init_thread_struct(thread_t *t, const char *name)
@@ -152,7 +290,11 @@ thread_t *thread_create(const char *name, thread_start_routine entry, void *arg,
 	t->entry = entry;
 	t->arg = arg;
 	t->priority = priority;
+	t->curr_cpu = 0; /* stays on the boot cpu unless made migratable */
 	t->saved_critical_section_count = 1; /* we always start inside a critical section */
+#if WITH_SMP
+	t->saved_thread_lock_count = 1; /* ... holding the thread lock */
+#endif
 	t->state = THREAD_SUSPENDED;
 	t->blocking_wait_queue = NULL;
 	t->wait_queue_block_ret = NO_ERROR;
@@ -175,13 +317,33 @@ thread_t *thread_create(const char *name, thread_start_routine entry, void *arg,
 	arch_thread_initialize(t);
 
 	/* add it to the global thread list */
-	enter_critical_section();
+	thread_lock_acquire();
 	list_add_head(&thread_list, &t->thread_list_node);
-	exit_critical_section();
+	thread_lock_release();
 
 	return t;
 }
 
+/**
+ * @brief  Let a thread run on any cpu
+ *
+ * Threads start out on the boot cpu and stay there, a critical section
+ * only keeps the local cpu out. Only threads that stick to the thread,
+ * mutex, event, dpc, timer and heap calls may be made migratable, drivers
+ * still count on running on the boot cpu.
+ *
+ * @param t  Thread to let go, before it is resumed
+ */
+void thread_set_migratable(thread_t *t)
+{
+#if THREAD_CHECKS
+	ASSERT(t->magic == THREAD_MAGIC);
+	ASSERT(t->state == THREAD_SUSPENDED);
+#endif
+
+	t->flags |= THREAD_FLAG_MIGRATABLE;
+}
+
 /**
  * @brief  Make a suspended thread executable.
  *
@@ -202,11 +364,11 @@ status_t thread_resume(thread_t *t)
 	if (t->state == THREAD_READY || t->state == THREAD_RUNNING)
 		return ERR_NOT_SUSPENDED;
 
-	enter_critical_section();
+	thread_lock_acquire();
 	t->state = THREAD_READY;
 	insert_in_run_queue_head(t);
 	thread_yield();
-	exit_critical_section();
+	thread_lock_release();
 
 	return NO_ERROR;
 }
@@ -224,9 +386,9 @@ static void thread_cleanup_dpc(void *thread)
 #endif
 
 	/* remove it from the master thread list */
-	enter_critical_section();
+	thread_lock_acquire();
 	list_delete(&t->thread_list_node);
-	exit_critical_section();
+	thread_lock_release();
 
 	/* free its stack and the thread structure itself */
 	if (t->stack)
@@ -251,7 +413,7 @@ void thread_exit(int retcode)
 
 //	dprintf("thread_exit: current %p\n", current_thread);
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 	/* enter the dead state */
 	current_thread->state = THREAD_DEATH;
@@ -287,12 +449,13 @@ void thread_resched(void)
 {
 	thread_t *oldthread;
 	thread_t *newthread;
+	uint cpu = curr_cpu_num();
 
 //	dprintf("thread_resched: current %p: ", current_thread);
 //	dump_thread(current_thread);
 
 #if THREAD_CHECKS
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 
 #if THREAD_STATS
@@ -306,20 +469,26 @@ void thread_resched(void)
 
 	// should at least find the idle thread
 #if THREAD_CHECKS
-	ASSERT(run_queue_bitmap != 0);
+	ASSERT(run_queue_bitmap[cpu] != 0);
 #endif
 
-	int next_queue = HIGHEST_PRIORITY - __builtin_clz(run_queue_bitmap) - (32 - NUM_PRIORITIES);
-	//dprintf(SPEW, "bitmap 0x%x, next %d\n", run_queue_bitmap, next_queue);
+	int next_queue = run_queue_highest(run_queue_bitmap[cpu]);
+	//dprintf(SPEW, "bitmap 0x%x, next %d\n", run_queue_bitmap[cpu], next_queue);
 
-	newthread = list_remove_head_type(&run_queue[next_queue], thread_t, queue_node);
+#if WITH_SMP
+	newthread = steal_thread(cpu, next_queue);
+	if (!newthread)
+#endif
+	{
+		newthread = list_remove_head_type(&run_queue[cpu][next_queue], thread_t, queue_node);
 
 #if THREAD_CHECKS
-	ASSERT(newthread);
+		ASSERT(newthread);
 #endif
 
-	if (list_is_empty(&run_queue[next_queue]))
-		run_queue_bitmap &= ~(1<<next_queue);
+		if (list_is_empty(&run_queue[cpu][next_queue]))
+			run_queue_bitmap[cpu] &= ~(1<<next_queue);
+	}
 
 #if 0
 	// XXX make this more efficient
@@ -336,8 +505,12 @@ void thread_resched(void)
 
 	newthread->state = THREAD_RUNNING;
 
-	if (newthread == oldthread)
+	if (newthread == oldthread) {
+#if THREAD_ACCOUNTING
+		oldthread->acct.yielding = false;
+#endif
 		return;
+	}
 
 	/* set up quantum for the new thread if it was consumed */
 	if (newthread->remaining_quantum <= 0) {
@@ -359,23 +532,51 @@ void thread_resched(void)
 #if THREAD_CHECKS
 	ASSERT(critical_section_count > 0);
 	ASSERT(newthread->saved_critical_section_count > 0);
+#if WITH_SMP
+	ASSERT(newthread->saved_thread_lock_count > 0);
+#endif
+#endif
+
+#if WITH_SMP
+	/* the timer queue runs on the boot cpu, the others take the
+	 * preemption tick from their own timer while running a real thread.
+	 */
+	if (cpu != 0) {
+		if (oldthread == idle_thread) {
+			platform_set_cpu_tick(thread_cpu_tick, NULL, 10);
+		} else if (newthread == idle_thread) {
+			platform_set_cpu_tick(NULL, NULL, 0);
+		}
+	}
 #endif
 
 #if PLATFORM_HAS_DYNAMIC_TIMER
 	/* if we're switching from idle to a real thread, set up a periodic
 	 * timer to run our preemption tick.
 	 */
-	if (oldthread == idle_thread) {
-		timer_set_periodic(&preempt_timer, 10, (timer_callback)thread_timer_tick, NULL);
-	} else if (newthread == idle_thread) {
-		timer_cancel(&preempt_timer);
+	if (cpu == 0) {
+		if (oldthread == idle_thread) {
+			timer_set_periodic(&preempt_timer, 10, (timer_callback)thread_timer_tick, NULL);
+		} else if (newthread == idle_thread) {
+			timer_cancel(&preempt_timer);
+		}
 	}
 #endif
 
+#if THREAD_ACCOUNTING
+	thread_acct_switch(oldthread, newthread);
+#endif
+
 	/* do the switch */
 	oldthread->saved_critical_section_count = critical_section_count;
+#if WITH_SMP
+	oldthread->saved_thread_lock_count = thread_lock_count;
+#endif
 	current_thread = newthread;
 	critical_section_count = newthread->saved_critical_section_count;
+#if WITH_SMP
+	thread_lock_count = newthread->saved_thread_lock_count;
+#endif
 	arch_context_switch(oldthread, newthread);
 }
 
@@ -395,7 +596,7 @@ void thread_yield(void)
 	ASSERT(current_thread->state == THREAD_RUNNING);
 #endif
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if THREAD_STATS
 	thread_stats.yields++;
@@ -404,10 +605,13 @@ void thread_yield(void)
 	/* we are yielding the cpu, so stick ourselves into the tail of the run queue and reschedule */
 	current_thread->state = THREAD_READY;
 	current_thread->remaining_quantum = 0;
+#if THREAD_ACCOUNTING
+	current_thread->acct.yielding = true;
+#endif
 	insert_in_run_queue_tail(current_thread);
 	thread_resched();
 
-	exit_critical_section();
+	thread_lock_release();
 }
 
 /**
@@ -432,7 +636,7 @@ void thread_preempt(void)
 	ASSERT(current_thread->state == THREAD_RUNNING);
 #endif
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if THREAD_STATS
 	if (current_thread != idle_thread)
@@ -447,7 +651,7 @@ void thread_preempt(void)
 		insert_in_run_queue_tail(current_thread); /* if we're out of quantum, go to the tail of the queue */
 	thread_resched();
 
-	exit_critical_section();
+	thread_lock_release();
 }
 
 /**
@@ -467,12 +671,23 @@ void thread_block(void)
 	ASSERT(current_thread->state == THREAD_BLOCKED);
 #endif
 
-	enter_critical_section();
+	thread_lock_acquire();
 
 	/* we are blocking on something. the blocking code should have already stuck us on a queue */
 	thread_resched();
 
-	exit_critical_section();
+	thread_lock_release();
+}
+
+/* the assembly irq entry path cannot use the inline versions */
+void thread_irq_enter(void)
+{
+	inc_critical_section();
+}
+
+void thread_irq_exit(void)
+{
+	dec_critical_section();
 }
 
 enum handler_return thread_timer_tick(void)
@@ -497,8 +712,10 @@ static enum handler_return thread_sleep_handler(timer_t *timer, time_t now, void
 	ASSERT(t->state == THREAD_SLEEPING);
 #endif
 
+	thread_lock_acquire();
 	t->state = THREAD_READY;
 	insert_in_run_queue_head(t);
+	thread_lock_release();
 
 	return INT_RESCHEDULE;
 }
@@ -524,11 +741,11 @@ void thread_sleep(time_t delay)
 
 	timer_initialize(&timer);
 
-	enter_critical_section();
+	thread_lock_acquire();
 	timer_set_oneshot(&timer, delay, thread_sleep_handler, (void *)current_thread);
 	current_thread->state = THREAD_SLEEPING;
 	thread_resched();
-	exit_critical_section();
+	thread_lock_release();
 }
 
 /**
@@ -541,8 +758,11 @@ void thread_init_early(void)
 	int i;
 
 	/* initialize the run queues */
-	for (i=0; i < NUM_PRIORITIES; i++)
-		list_initialize(&run_queue[i]);
+	uint cpu;
+	for (cpu=0; cpu < SMP_MAX_CPUS; cpu++) {
+		for (i=0; i < NUM_PRIORITIES; i++)
+			list_initialize(&run_queue[cpu][i]);
+	}
 
 	/* initialize the thread list */
 	list_initialize(&thread_list);
@@ -559,6 +779,36 @@ void thread_init_early(void)
 	current_thread = t;
 }
 
+#if WITH_SMP
+/**
+ * @brief  Give a secondary cpu a thread context
+ *
+ * Called on the secondary cpu itself before it turns on interrupts. Returns
+ * inside a critical section, the caller is expected to become the idle thread.
+ */
+void thread_secondary_cpu_init_early(uint cpu)
+{
+	thread_t *t = &secondary_bootstrap_thread[cpu - 1];
+
+	ASSERT(cpu > 0 && cpu < SMP_MAX_CPUS);
+
+	enter_critical_section();
+
+	init_thread_struct(t, "secondary");
+	t->priority = HIGHEST_PRIORITY;
+	t->state = THREAD_RUNNING;
+	t->curr_cpu = cpu;
+	t->saved_critical_section_count = 1;
+#if THREAD_ACCOUNTING
+	t->acct.run_stamp = arch_cycle_count();
+#endif
+	thread_lock_acquire();
+	list_add_head(&thread_list, &t->thread_list_node);
+	thread_lock_release();
+	current_thread = t;
+}
+#endif
+
 /**
  * @brief Complete thread initialization
  *
@@ -569,6 +819,10 @@ void thread_init(void)
 #if PLATFORM_HAS_DYNAMIC_TIMER
 	timer_initialize(&preempt_timer);
 #endif
+#if THREAD_ACCOUNTING
+	/* the cycle counter is only running once arch_early_init() is done */
+	current_thread->acct.run_stamp = arch_cycle_count();
+#endif
 }
 
 /**
@@ -615,9 +869,21 @@ void dump_thread(thread_t *t)
 {
 	dprintf(INFO, "dump_thread: t %p (%s)\n", t, t->name);
 	dprintf(INFO, "\tstate %d, priority %d, remaining quantum %d, critical section %d\n", t->state, t->priority, t->remaining_quantum, t->saved_critical_section_count);
+#if WITH_SMP
+	dprintf(INFO, "\tcpu %u\n", t->curr_cpu);
+#endif
 	dprintf(INFO, "\tstack %p, stack_size %zd\n", t->stack, t->stack_size);
 	dprintf(INFO, "\tentry %p, arg %p\n", t->entry, t->arg);
 	dprintf(INFO, "\twait queue %p, wait queue ret %d\n", t->blocking_wait_queue, t->wait_queue_block_ret);
+#if THREAD_ACCOUNTING
+	uint64_t run_cycles = t->acct.run_cycles;
+	if (t == current_thread)
+		run_cycles += arch_cycle_count() - t->acct.run_stamp;
+	dprintf(INFO, "\trun cycles %llu, blocked cycles %llu, max latency %u\n",
+			run_cycles, t->acct.blocked_cycles, t->acct.max_latency);
+	dprintf(INFO, "\tvoluntary switches %u, involuntary switches %u\n",
+			t->acct.voluntary_switches, t->acct.involuntary_switches);
+#endif
 	dprintf(INFO, "\ttls:");
 	int i;
 	for (i=0; i < MAX_TLS_ENTRY; i++) {
@@ -633,12 +899,31 @@ void dump_all_threads(void)
 {
 	thread_t *t;
 
-	enter_critical_section();
+	thread_lock_acquire();
 	list_for_every_entry(&thread_list, t, thread_t, thread_list_node) {
 		dump_thread(t);
 	}
-	exit_critical_section();
+#if THREAD_ACCOUNTING
+	dump_sched_latency();
+#endif
+	thread_lock_release();
+}
+
+#if THREAD_ACCOUNTING
+/**
+ * @brief  Dump the scheduling latency histogram
+ */
+void dump_sched_latency(void)
+{
+	int i;
+
+	dprintf(INFO, "sched latency (cycles):\n");
+	for (i=0; i < SCHED_LATENCY_BUCKETS; i++) {
+		if (sched_latency_hist[i])
+			dprintf(INFO, "\t>= %u: %u\n", 1U << i, sched_latency_hist[i]);
+	}
 }
+#endif
 
 /** @} */
 
@@ -697,7 +982,7 @@ status_t wait_queue_block(wait_queue_t *wait, time_t timeout)
 #if THREAD_CHECKS
 	ASSERT(wait->magic == WAIT_QUEUE_MAGIC);
 	ASSERT(current_thread->state == THREAD_RUNNING);
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 
 	if (timeout == 0)
@@ -715,8 +1000,17 @@ status_t wait_queue_block(wait_queue_t *wait, time_t timeout)
 		timer_set_oneshot(&timer, timeout, wait_queue_timeout_handler, (void *)current_thread);
 	}
 
+#if THREAD_ACCOUNTING
+	uint32_t block_stamp = arch_cycle_count();
+#endif
+
 	thread_block();
 
+#if THREAD_ACCOUNTING
+	/* we were made runnable at ready_stamp, anything after that is scheduling latency */
+	current_thread->acct.blocked_cycles += current_thread->acct.ready_stamp - block_stamp;
+#endif
+
 	/* we don't really know if the timer fired or not, so it's better safe to try to cancel it */
 	if (timeout != INFINITE_TIME) {
 		timer_cancel(&timer);
@@ -746,7 +1040,7 @@ int wait_queue_wake_one(wait_queue_t *wait, bool reschedule, status_t wait_queue
 
 #if THREAD_CHECKS
 	ASSERT(wait->magic == WAIT_QUEUE_MAGIC);
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 
 	t = list_remove_head_type(&wait->list, thread_t, queue_node);
@@ -798,7 +1092,7 @@ int wait_queue_wake_all(wait_queue_t *wait, bool reschedule, status_t wait_queue
 
 #if THREAD_CHECKS
 	ASSERT(wait->magic == WAIT_QUEUE_MAGIC);
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 
 	if (reschedule && wait->count > 0) {
@@ -843,7 +1137,7 @@ void wait_queue_destroy(wait_queue_t *wait, bool reschedule)
 {
 #if THREAD_CHECKS
 	ASSERT(wait->magic == WAIT_QUEUE_MAGIC);
-	ASSERT(in_critical_section());
+	ASSERT(thread_lock_held());
 #endif
 	wait_queue_wake_all(wait, reschedule, ERR_OBJECT_DESTROYED);
 	wait->magic = 0;
@@ -864,14 +1158,16 @@ void wait_queue_destroy(wait_queue_t *wait, bool reschedule)
  */
 status_t thread_unblock_from_wait_queue(thread_t *t, bool reschedule, status_t wait_queue_error)
 {
-	enter_critical_section();
+	thread_lock_acquire();
 
 #if THREAD_CHECKS
 	ASSERT(t->magic == THREAD_MAGIC);
 #endif
 
-	if (t->state != THREAD_BLOCKED)
+	if (t->state != THREAD_BLOCKED) {
+		thread_lock_release();
 		return ERR_NOT_BLOCKED;
+	}
 
 #if THREAD_CHECKS
 	ASSERT(t->blocking_wait_queue != NULL);
@@ -889,7 +1185,7 @@ status_t thread_unblock_from_wait_queue(thread_t *t, bool reschedule, status_t w
 	if (reschedule)
 		thread_resched();
 
-	exit_critical_section();
+	thread_lock_release();
 
 	return NO_ERROR;
 }
@@ -45,8 +45,29 @@
 
 static struct list_node timer_queue;
 
+#if WITH_SMP
+/* timers are set and cancelled on every cpu, the boot cpu's tick runs them */
+static spin_lock_t timer_lock = SPIN_LOCK_INITIAL_VALUE;
+#endif
+
 static enum handler_return timer_tick(void *arg, time_t now);
 
+static inline void timer_queue_lock(void)
+{
+	enter_critical_section();
+#if WITH_SMP
+	spin_lock(&timer_lock);
+#endif
+}
+
+static inline void timer_queue_unlock(void)
+{
+#if WITH_SMP
+	spin_unlock(&timer_lock);
+#endif
+	exit_critical_section();
+}
+
 /**
  * @brief  Initialize a timer object
  */
@@ -97,7 +118,7 @@ static void timer_set(timer_t *timer, time_t delay, time_t period, timer_callbac
 
 //	TRACEF("scheduled time %u\n", timer->scheduled_time);
 
-	enter_critical_section();
+	timer_queue_lock();
 
 	insert_timer_in_queue(timer);
 
@@ -109,7 +130,7 @@ static void timer_set(timer_t *timer, time_t delay, time_t period, timer_callbac
 	}
 #endif
 
-	exit_critical_section();
+	timer_queue_unlock();
 }
 
 /**
@@ -161,7 +182,7 @@ void timer_cancel(timer_t *timer)
 {
 	DEBUG_ASSERT(timer->magic == TIMER_MAGIC);
 
-	enter_critical_section();
+	timer_queue_lock();
 
 #if PLATFORM_HAS_DYNAMIC_TIMER
 	timer_t *oldhead = list_peek_head_type(&timer_queue, timer_t, node);
@@ -197,7 +218,7 @@ void timer_cancel(timer_t *timer)
 	}
 #endif
 
-	exit_critical_section();
+	timer_queue_unlock();
 }
 
 /* called at interrupt time to process any pending timers */
@@ -212,6 +233,8 @@ static enum handler_return timer_tick(void *arg, time_t now)
 
 //	TRACEF("now %d\n", now);
 
+	timer_queue_lock();
+
 	for (;;) {
 		/* see if there's an event to process */
 		timer = list_peek_head_type(&timer_queue, timer_t, node);
@@ -231,11 +254,18 @@ static enum handler_return timer_tick(void *arg, time_t now)
 #endif
 
 		bool periodic = timer->periodic_time > 0;
+		timer_callback callback = timer->callback;
+		void *callback_arg = timer->arg;
+
+		/* the callback may set timers or take the thread lock */
+		timer_queue_unlock();
 
-//		TRACEF("timer %p firing callback %p, arg %p\n", timer, timer->callback, timer->arg);
-		if (timer->callback(timer, now, timer->arg) == INT_RESCHEDULE)
+//		TRACEF("timer %p firing callback %p, arg %p\n", timer, callback, callback_arg);
+		if (callback(timer, now, callback_arg) == INT_RESCHEDULE)
 			ret = INT_RESCHEDULE;
 
+		timer_queue_lock();
+
 		/* if it was a periodic timer and it hasn't been requeued
 		 * by the callback put it back in the list
 		 */
@@ -265,6 +295,8 @@ static enum handler_return timer_tick(void *arg, time_t now)
 		ret = INT_RESCHEDULE;
 #endif
 
+	timer_queue_unlock();
+
 	// XXX fix this, should return ret
 	ret = INT_RESCHEDULE;
 	return ret;
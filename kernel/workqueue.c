@@ -0,0 +1,197 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * @file
+ * @brief  Work queues for fork/join style boot tasks
+ *
+ * @defgroup workqueue Work Queues
+ * @{
+ */
+#include <debug.h>
+#include <list.h>
+#include <err.h>
+#include <stdlib.h>
+#include <kernel/thread.h>
+#include <kernel/event.h>
+#include <kernel/workqueue.h>
+
+static int workqueue_thread_routine(void *arg);
+
+/**
+ * @brief  Create a work queue with its own pool of worker threads
+ *
+ * @param wq           Work queue to initialize
+ * @param name         Name given to the worker threads
+ * @param num_workers  Number of threads, at most WORKQUEUE_MAX_WORKERS
+ * @param priority     Priority the workers run at
+ *
+ * @return NO_ERROR, or ERR_NO_MEMORY if no worker could be created.
+ */
+status_t workqueue_create(workqueue_t *wq, const char *name, int num_workers, int priority)
+{
+	int i;
+
+	if (num_workers <= 0 || num_workers > WORKQUEUE_MAX_WORKERS)
+		return ERR_INVALID_ARGS;
+
+	wq->magic = WORKQUEUE_MAGIC;
+	list_initialize(&wq->queue);
+	event_init(&wq->event, false, 0);
+	wq->num_workers = 0;
+
+	for (i = 0; i < num_workers; i++) {
+		thread_t *t = thread_create(name, &workqueue_thread_routine, wq, priority, DEFAULT_STACK_SIZE);
+		if (!t)
+			break;
+
+		wq->workers[wq->num_workers++] = t;
+		thread_resume(t);
+	}
+
+	return wq->num_workers ? NO_ERROR : ERR_NO_MEMORY;
+}
+
+/**
+ * @brief  Initialize a work item
+ *
+ * @param work  Work item, must stay valid until it has completed
+ * @param func  Function run on a worker thread, its return value lands in work->result
+ * @param arg   Argument passed to func
+ * @param done  Optional completion callback, run on the worker after func
+ */
+void work_init(work_t *work, work_func func, void *arg, work_done_func done)
+{
+	list_clear_node(&work->node);
+	work->func = func;
+	work->arg = arg;
+	work->done = done;
+	work->result = NO_ERROR;
+	work->group = NULL;
+}
+
+/**
+ * @brief  Initialize an empty work group
+ */
+void work_group_init(work_group_t *group)
+{
+	group->magic = WORK_GROUP_MAGIC;
+	group->pending = 0;
+	group->status = NO_ERROR;
+	event_init(&group->done, true, 0);
+}
+
+/**
+ * @brief  Queue a work item
+ *
+ * @param wq     Work queue to run the item on
+ * @param work   Initialized work item
+ * @param group  Optional group the item is counted against
+ */
+status_t workqueue_submit(workqueue_t *wq, work_t *work, work_group_t *group)
+{
+	ASSERT(wq->magic == WORKQUEUE_MAGIC);
+	ASSERT(!group || group->magic == WORK_GROUP_MAGIC);
+
+	enter_critical_section();
+
+	work->group = group;
+	if (group) {
+		if (group->pending++ == 0)
+			event_unsignal(&group->done);
+	}
+
+	list_add_tail(&wq->queue, &work->node);
+	event_signal(&wq->event, false);
+
+	exit_critical_section();
+
+	return NO_ERROR;
+}
+
+/**
+ * @brief  Wait for all work in a group to complete
+ *
+ * @param group    Work group
+ * @param timeout  Maximum time to wait, in ms, or INFINITE_TIME
+ *
+ * @return The first error returned by a work function in the group,
+ * NO_ERROR if all succeeded, or ERR_TIMED_OUT.
+ */
+status_t work_group_wait(work_group_t *group, time_t timeout)
+{
+	status_t err;
+
+	ASSERT(group->magic == WORK_GROUP_MAGIC);
+
+	err = event_wait_timeout(&group->done, timeout);
+	if (err < 0)
+		return err;
+
+	return group->status;
+}
+
+static void work_complete(work_t *work)
+{
+	/* the completion callback is allowed to free the work item */
+	work_group_t *group = work->group;
+	int result = work->result;
+
+	if (work->done)
+		work->done(work);
+
+	if (!group)
+		return;
+
+	enter_critical_section();
+	if (result < 0 && group->status == NO_ERROR)
+		group->status = result;
+	if (--group->pending == 0)
+		event_signal(&group->done, false);
+	exit_critical_section();
+}
+
+static int workqueue_thread_routine(void *arg)
+{
+	workqueue_t *wq = (workqueue_t *)arg;
+	work_t *work;
+
+	for (;;) {
+		event_wait(&wq->event);
+
+		enter_critical_section();
+		work = list_remove_head_type(&wq->queue, work_t, node);
+		if (!work)
+			event_unsignal(&wq->event);
+		exit_critical_section();
+
+		if (work) {
+			work->result = work->func(work->arg);
+			work_complete(work);
+		}
+	}
+
+	return 0;
+}
+
+/** @} */
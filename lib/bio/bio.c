@@ -193,6 +193,8 @@ static ssize_t bio_default_erase(struct bdev *dev, off_t offset, size_t len)
 	uint8_t *zero_buf;
 
 	zero_buf = calloc(1, ERASE_BUF_SIZE);
+	if (!zero_buf)
+		return ERR_NO_MEMORY;
 
 	size_t remaining = len;
 	off_t pos = offset;
@@ -201,26 +203,30 @@ static ssize_t bio_default_erase(struct bdev *dev, off_t offset, size_t len)
 
 		ssize_t written = bio_write(dev, zero_buf, pos, towrite);
 		if (written < 0)
-			return pos;
+			break;
 
 		pos += written;
 		remaining -= written;
 
 		if (written < towrite)
-			return pos;
+			break;
 	}
 
-	return len;
+	free(zero_buf);
+
+	return remaining ? pos : (off_t) len;
 }
 
 static ssize_t bio_default_read_block(struct bdev *dev, void *buf, bnum_t block, uint count)
 {
 	panic("%s no reasonable default operation\n", __PRETTY_FUNCTION__);
+	return ERR_NOT_SUPPORTED;
 }
 
 static ssize_t bio_default_write_block(struct bdev *dev, const void *buf, bnum_t block, uint count)
 {
 	panic("%s no reasonable default operation\n", __PRETTY_FUNCTION__);
+	return ERR_NOT_SUPPORTED;
 }
 
 static void bdev_inc_ref(bdev_t *dev)
@@ -35,6 +35,9 @@
 #include <kernel/thread.h>
 #include <kernel/timer.h>
 #include <rand.h>
+#if WITH_DLOG
+#include <lib/dlog.h>
+#endif
 #if ARCH_ARM
 #include <arch/arm.h>
 #endif
@@ -54,9 +57,14 @@ void spin(uint32_t usecs)
 		;	
 }
 
+__WEAK void _dflush(void)
+{
+}
+
 void halt(void)
 {
 	enter_critical_section(); // disable ints
+	_dflush();
 	platform_halt();
 }
 
@@ -71,6 +79,10 @@ void dump_frame(void *frame)
 
 void _panic(void *caller, const char *fmt, ...)
 {
+#if WITH_DLOG
+	/* get the history out before the panic message */
+	dlog_flush();
+#endif
 	dprintf(ALWAYS, "panic (frame %p): \n", __GET_FRAME());
 	dump_frame(__GET_FRAME());
 	dprintf(ALWAYS, "panic (caller %p): ", caller);
@@ -98,6 +110,11 @@ int _dprintf(const char *fmt, ...)
 	char ts_buf[13];
 	int err;
 
+#if WITH_DLOG
+	/* keep synchronous output ordered behind deferred records */
+	dlog_flush();
+#endif
+
 	snprintf(ts_buf, sizeof(ts_buf), "[%u] ",(unsigned int)current_time());
 	dputs(ALWAYS, ts_buf);
 
@@ -0,0 +1,453 @@
+/*
+ * Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files
+ * (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY
+ * CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <debug.h>
+#include <string.h>
+#include <printf.h>
+#include <lib/dlog.h>
+#include <kernel/thread.h>
+#include <kernel/event.h>
+#include <kernel/timer.h>
+#include <kernel/spinlock.h>
+#include <platform.h>
+
+#if (DLOG_BUF_SIZE & (DLOG_BUF_SIZE - 1)) || DLOG_BUF_SIZE > 32768
+#error DLOG_BUF_SIZE must be a power of two no larger than 32k
+#endif
+
+#define DLOG_FLAG_COMMITTED 0x1
+#define DLOG_FLAG_PAD       0x2
+
+/* longest string copied for a single %s argument, including the terminator */
+#define DLOG_MAX_STR 64
+
+/* records are 8 byte aligned so the argument array can be read in place */
+#define DLOG_ALIGN(x) (((x) + 7) & ~7)
+
+struct dlog_rec {
+	uint16_t len;		/* whole record in bytes, including padding */
+	uint8_t flags;
+	uint8_t nargs;
+	uint32_t time;
+	const char *fmt;
+	uint32_t strmask;	/* args holding an offset to a copied string */
+	unsigned long long args[];
+};
+
+static uint8_t dlog_buf[DLOG_BUF_SIZE] __ALIGNED(8);
+
+/*
+ * free running byte positions. records between tail and printed have been
+ * printed and are kept for dlog_dump() until the space is needed, records
+ * between printed and head are pending.
+ */
+static uint32_t dlog_head;
+static uint32_t dlog_printed;
+static uint32_t dlog_tail;
+static uint32_t dlog_drops;
+
+static spin_lock_t dlog_lock = SPIN_LOCK_INITIAL_VALUE;
+
+static event_t dlog_event;
+static bool dlog_running;
+
+/* target for %n, which can't point back into the caller's frame */
+static unsigned long long dlog_dummy_n;
+
+#define DLOG_REC(pos) ((struct dlog_rec *)&dlog_buf[(pos) & (DLOG_BUF_SIZE - 1)])
+
+static struct dlog_rec *dlog_reserve(uint len)
+{
+	struct dlog_rec *rec = NULL;
+	struct dlog_rec *pad;
+	uint32_t state;
+	uint room, need;
+
+	spin_lock_irqsave(&dlog_lock, &state);
+
+	/* records never wrap, burn the rest of the ring with a pad record */
+	room = DLOG_BUF_SIZE - (dlog_head & (DLOG_BUF_SIZE - 1));
+	need = (room < len) ? room + len : len;
+
+	/* reclaim already printed records, oldest first */
+	while (dlog_head + need - dlog_tail > DLOG_BUF_SIZE && dlog_tail != dlog_printed)
+		dlog_tail += DLOG_REC(dlog_tail)->len;
+
+	if (dlog_head + need - dlog_tail > DLOG_BUF_SIZE) {
+		dlog_drops++;
+		goto out;
+	}
+
+	if (room < len) {
+		pad = DLOG_REC(dlog_head);
+		pad->len = room;
+		pad->flags = DLOG_FLAG_PAD | DLOG_FLAG_COMMITTED;
+		dlog_head += room;
+	}
+
+	rec = DLOG_REC(dlog_head);
+	rec->len = len;
+	rec->flags = 0;
+	dlog_head += len;
+
+out:
+	spin_unlock_irqrestore(&dlog_lock, state);
+	return rec;
+}
+
+static void dlog_commit(struct dlog_rec *rec)
+{
+	uint32_t state;
+	bool kick;
+
+	/* the lock orders the record contents before the flag for the reader */
+	spin_lock_irqsave(&dlog_lock, &state);
+	rec->flags |= DLOG_FLAG_COMMITTED;
+	kick = (dlog_head - dlog_printed) > DLOG_BUF_SIZE / 2;
+	spin_unlock_irqrestore(&dlog_lock, state);
+
+	/* don't wait for the next interval if the ring is filling up */
+	if (kick && dlog_running)
+		event_signal(&dlog_event, false);
+}
+
+/*
+ * copy the record at *pos into buf under the lock and advance *pos past it.
+ * returns 1 if a printable record was copied, 0 for a pad record, and -1 if
+ * there is nothing (committed) left before the head.
+ */
+static int dlog_fetch(uint32_t *pos, struct dlog_rec *buf)
+{
+	struct dlog_rec *rec;
+	uint32_t state;
+	int ret = -1;
+
+	spin_lock_irqsave(&dlog_lock, &state);
+
+	/* the reader fell behind and its record was reclaimed */
+	if ((int32_t)(*pos - dlog_tail) < 0)
+		*pos = dlog_tail;
+
+	if (*pos == dlog_head)
+		goto out;
+
+	rec = DLOG_REC(*pos);
+	if (!(rec->flags & DLOG_FLAG_COMMITTED))
+		goto out;
+
+	*pos += rec->len;
+	if (rec->flags & DLOG_FLAG_PAD) {
+		ret = 0;
+		goto out;
+	}
+
+	memcpy(buf, rec, rec->len);
+	ret = 1;
+
+out:
+	spin_unlock_irqrestore(&dlog_lock, state);
+	return ret;
+}
+
+static int dlog_format(const struct dlog_rec *rec, _printf_engine_output_func out, void *state)
+{
+	unsigned long long args[DLOG_MAX_ARGS];
+	unsigned long long ts = rec->time;
+	uint i;
+
+	for (i = 0; i < rec->nargs; i++) {
+		args[i] = rec->args[i];
+		if (rec->strmask & (1U << i))
+			args[i] = (uintptr_t)((const char *)rec + (uint)args[i]);
+	}
+
+	return _printf_engine_args(out, state, "[%u] ", &ts) +
+		_printf_engine_args(out, state, rec->fmt, args);
+}
+
+static int dlog_dputc(char c, void *state)
+{
+	_dputc(c);
+	return 0;
+}
+
+void dlog_flush(void)
+{
+	unsigned long long buf[DLOG_MAX_REC / sizeof(unsigned long long)];
+	struct dlog_rec *rec = (struct dlog_rec *)buf;
+	int ret;
+
+	/* advancing dlog_printed under the lock keeps concurrent flushes from repeating records */
+	while ((ret = dlog_fetch(&dlog_printed, rec)) >= 0) {
+		if (ret > 0)
+			dlog_format(rec, &dlog_dputc, NULL);
+	}
+}
+
+struct dlog_text {
+	char *buf;
+	size_t len;
+	size_t pos;
+};
+
+static int dlog_text_output(char c, void *_state)
+{
+	struct dlog_text *state = _state;
+
+	if (state->pos + 1 >= state->len)
+		return -1;
+
+	state->buf[state->pos++] = c;
+	return 0;
+}
+
+int dlog_dump(dlog_dump_func func, void *arg)
+{
+	unsigned long long buf[DLOG_MAX_REC / sizeof(unsigned long long)];
+	struct dlog_rec *rec = (struct dlog_rec *)buf;
+	char line[DLOG_MAX_REC];
+	struct dlog_text text = { line, sizeof(line), 0 };
+	uint32_t pos = dlog_tail;
+	uint32_t end = dlog_head;
+	int count = 0;
+	int ret;
+
+	/* stop at the head as of the call so a busy logger can't keep us here */
+	while ((int32_t)(pos - end) < 0 && (ret = dlog_fetch(&pos, rec)) >= 0) {
+		if (ret == 0)
+			continue;
+
+		text.pos = 0;
+		dlog_format(rec, &dlog_text_output, &text);
+		line[text.pos] = '\0';
+
+		func(line, arg);
+		count++;
+	}
+
+	return count;
+}
+
+uint32_t dlog_dropped(void)
+{
+	return dlog_drops;
+}
+
+int _dlog_printf(const char *fmt, ...)
+{
+	unsigned long long args[DLOG_MAX_ARGS];
+	const char *strs[DLOG_MAX_ARGS];
+	size_t strlens[DLOG_MAX_ARGS];
+	struct dlog_rec *rec;
+	const char *p;
+	uint nargs = 0;
+	uint32_t strmask = 0;
+	uint len, off, i;
+	int flags;
+	char ts_buf[13];
+	va_list ap;
+
+#define LONGFLAG     0x1
+#define LONGLONGFLAG 0x2
+#define SIZETFLAG    0x4
+
+	/*
+	 * pull the arguments off the va_list using the same rules the printf
+	 * engine will use to consume them again later. no formatting happens here.
+	 */
+	va_start(ap, fmt);
+	for (p = fmt; *p; p++) {
+		if (*p != '%')
+			continue;
+
+		flags = 0;
+next_format:
+		switch (*++p) {
+			case 0:
+				p--;
+				break;
+			case '0'...'9':
+			case '.':
+			case '-':
+			case '+':
+			case '#':
+			case 'h':
+				goto next_format;
+			case 'l':
+				flags |= (flags & LONGFLAG) ? LONGLONGFLAG : LONGFLAG;
+				goto next_format;
+			case 'z':
+				flags |= SIZETFLAG;
+				goto next_format;
+			case 's':
+			case 'n':
+			case 'c':
+			case 'd':
+			case 'i':
+			case 'D':
+			case 'u':
+			case 'U':
+			case 'x':
+			case 'X':
+			case 'p':
+				if (nargs == DLOG_MAX_ARGS) {
+					va_end(ap);
+					goto sync;
+				}
+
+				if (*p == 's') {
+					strs[nargs] = va_arg(ap, const char *);
+					if (!strs[nargs])
+						strs[nargs] = "<null>";
+					strmask |= 1U << nargs;
+					args[nargs++] = 0;
+				} else if (*p == 'n') {
+					(void)va_arg(ap, void *);
+					args[nargs++] = (uintptr_t)&dlog_dummy_n;
+				} else if (*p == 'p' || *p == 'D' || *p == 'U') {
+					args[nargs++] = va_arg(ap, unsigned long);
+				} else if (flags & LONGLONGFLAG) {
+					args[nargs++] = va_arg(ap, unsigned long long);
+				} else if (flags & LONGFLAG) {
+					args[nargs++] = va_arg(ap, unsigned long);
+				} else if (flags & SIZETFLAG) {
+					args[nargs++] = va_arg(ap, size_t);
+				} else {
+					args[nargs++] = va_arg(ap, unsigned int);
+				}
+				break;
+			default:
+				/* '%%' and anything the engine prints literally */
+				break;
+		}
+	}
+	va_end(ap);
+
+#undef LONGFLAG
+#undef LONGLONGFLAG
+#undef SIZETFLAG
+
+	/* size the record, truncating copied strings to what fits */
+	len = sizeof(struct dlog_rec) + nargs * sizeof(unsigned long long);
+	for (i = 0; i < nargs; i++) {
+		if (!(strmask & (1U << i)))
+			continue;
+
+		strlens[i] = strnlen(strs[i], DLOG_MAX_STR - 1);
+		if (len + strlens[i] + 1 > DLOG_MAX_REC)
+			strlens[i] = (len + 1 < DLOG_MAX_REC) ? DLOG_MAX_REC - len - 1 : 0;
+		len += strlens[i] + 1;
+	}
+	if (len > DLOG_MAX_REC)
+		goto sync;
+	len = DLOG_ALIGN(len);
+
+	rec = dlog_reserve(len);
+	if (!rec)
+		return 0;
+
+	rec->nargs = nargs;
+	rec->time = current_time();
+	rec->fmt = fmt;
+	rec->strmask = strmask;
+
+	off = sizeof(struct dlog_rec) + nargs * sizeof(unsigned long long);
+	for (i = 0; i < nargs; i++) {
+		if (strmask & (1U << i)) {
+			memcpy((char *)rec + off, strs[i], strlens[i]);
+			((char *)rec)[off + strlens[i]] = '\0';
+			args[i] = off;
+			off += strlens[i] + 1;
+		}
+		rec->args[i] = args[i];
+	}
+
+	dlog_commit(rec);
+	return 0;
+
+sync:
+	/* too big to record, print it the old way behind whatever is pending */
+	dlog_flush();
+	snprintf(ts_buf, sizeof(ts_buf), "[%u] ", (unsigned int)current_time());
+	_dputs(ts_buf);
+
+	va_start(ap, fmt);
+	i = _dvprintf(fmt, ap);
+	va_end(ap);
+
+	return i;
+}
+
+static int dlog_thread(void *arg)
+{
+	for (;;) {
+		event_wait_timeout(&dlog_event, DLOG_FLUSH_INTERVAL);
+		dlog_flush();
+	}
+
+	return 0;
+}
+
+void dlog_init(void)
+{
+	thread_t *t;
+
+	event_init(&dlog_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+
+	t = thread_create("dlog", &dlog_thread, NULL, LOW_PRIORITY, DEFAULT_STACK_SIZE);
+	if (!t) {
+		dprintf(CRITICAL, "dlog: failed to create log thread\n");
+		return;
+	}
+
+	dlog_running = true;
+	thread_resume(t);
+}
+
+#if defined(WITH_LIB_CONSOLE)
+#include <lib/console.h>
+
+static void dlog_console_dump(const char *text, void *arg)
+{
+	_dputs(text);
+}
+
+static int cmd_dlog(int argc, const cmd_args *argv)
+{
+	if (argc >= 2 && !strcmp(argv[1].str, "dump")) {
+		dlog_dump(&dlog_console_dump, NULL);
+	} else if (argc >= 2 && !strcmp(argv[1].str, "flush")) {
+		dlog_flush();
+	} else {
+		printf("head %u printed %u tail %u, %u bytes pending, %u dropped\n",
+			dlog_head, dlog_printed, dlog_tail, dlog_head - dlog_printed, dlog_drops);
+		printf("usage: %s [dump|flush]\n", argv[0].str);
+	}
+
+	return 0;
+}
+
+STATIC_COMMAND_START
+	{ "dlog", "deferred log ring", &cmd_dlog },
+STATIC_COMMAND_END(dlog);
+
+#endif
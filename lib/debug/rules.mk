@@ -2,3 +2,9 @@ LOCAL_DIR := $(GET_LOCAL_DIR)
 
 OBJS += \
 	$(LOCAL_DIR)/debug.o
+
+ifeq ($(WITH_DLOG),1)
+DEFINES += WITH_DLOG=1
+OBJS += \
+	$(LOCAL_DIR)/dlog.o
+endif
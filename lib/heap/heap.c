@@ -72,6 +72,27 @@ struct heap {
 // heap static vars
 static struct heap theheap;
 
+#if WITH_SMP
+// migratable threads allocate on every cpu
+static spin_lock_t heap_lock = SPIN_LOCK_INITIAL_VALUE;
+#endif
+
+static inline void heap_lock_acquire(void)
+{
+	enter_critical_section();
+#if WITH_SMP
+	spin_lock(&heap_lock);
+#endif
+}
+
+static inline void heap_lock_release(void)
+{
+#if WITH_SMP
+	spin_unlock(&heap_lock);
+#endif
+	exit_critical_section();
+}
+
 // structure placed at the beginning every allocation
 struct alloc_struct_begin {
 	unsigned int magic;
@@ -272,7 +293,7 @@ void *heap_alloc(size_t size, unsigned int alignment)
 	}
 
 	// critical section
-	enter_critical_section();
+	heap_lock_acquire();
 
 	// walk through the list
 	ptr = NULL;
@@ -338,7 +359,7 @@ void *heap_alloc(size_t size, unsigned int alignment)
 
 //	heap_dump();
 
-	exit_critical_section();
+	heap_lock_release();
 
 	return ptr;
 }
@@ -396,9 +417,9 @@ void heap_free(void *ptr)
 	LTRACEF("allocation was %zd bytes long at ptr %p\n", as->size, as->ptr);
 
 	// looks good, create a free chunk and add it to the pool
-	enter_critical_section();
+	heap_lock_acquire();
 	heap_insert_free_chunk(heap_create_free_chunk(as->ptr, as->size));
-	exit_critical_section();
+	heap_lock_release();
 
 //	heap_dump();
 }
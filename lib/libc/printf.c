@@ -149,7 +149,14 @@ int vsprintf(char *str, const char *fmt, va_list ap)
 	return vsnprintf(str, INT_MAX, fmt, ap);
 }
 
-int vsnprintf(char *str, size_t len, const char *fmt, va_list ap)
+/*
+ * the formatting core. it keeps all of its state on the stack and never
+ * allocates, so it is safe to run from any context. arguments come either
+ * from a va_list or, for records captured by the deferred logger, from an
+ * array of pre-widened values in the order the format consumes them.
+ */
+static int printf_engine(_printf_engine_output_func out, void *state, const char *fmt,
+		va_list *ap, const unsigned long long *args)
 {
 	char c;
 	unsigned char uc;
@@ -161,8 +168,9 @@ int vsnprintf(char *str, size_t len, const char *fmt, va_list ap)
 	size_t chars_written = 0;
 	char num_buffer[32];
 
-#define OUTPUT_CHAR(c) do { (*str++ = c); chars_written++; if (chars_written + 1 == len) goto done; } while(0)
-#define OUTPUT_CHAR_NOLENCHECK(c) do { (*str++ = c); chars_written++; } while(0)
+#define OUTPUT_CHAR(c) do { if (out(c, state) < 0) goto done; chars_written++; } while(0)
+#define NEXT_ARG(type) (args ? (type)*args++ : va_arg(*ap, type))
+#define NEXT_PTR(type) (args ? (type)(uintptr_t)*args++ : va_arg(*ap, type))
 
 	for(;;) {	
 		/* handle regular chars that aren't format related */
@@ -200,11 +208,11 @@ next_format:
 				OUTPUT_CHAR('%');
 				break;
 			case 'c':
-				uc = va_arg(ap, unsigned int);
+				uc = NEXT_ARG(unsigned int);
 				OUTPUT_CHAR(uc);
 				break;
 			case 's':
-				s = va_arg(ap, const char *);
+				s = NEXT_PTR(const char *);
 				if(s == 0)
 					s = "<null>";
 				goto _output_string;
@@ -235,12 +243,12 @@ next_format:
 				/* fallthrough */
 			case 'i':
 			case 'd':
-				n = (flags & LONGLONGFLAG) ? va_arg(ap, long long) :
-					(flags & LONGFLAG) ? va_arg(ap, long) : 
-					(flags & HALFHALFFLAG) ? (signed char)va_arg(ap, int) :
-					(flags & HALFFLAG) ? (short)va_arg(ap, int) :
-					(flags & SIZETFLAG) ? va_arg(ap, ssize_t) :
-					va_arg(ap, int);
+				n = (flags & LONGLONGFLAG) ? NEXT_ARG(long long) :
+					(flags & LONGFLAG) ? NEXT_ARG(long) : 
+					(flags & HALFHALFFLAG) ? (signed char)NEXT_ARG(int) :
+					(flags & HALFFLAG) ? (short)NEXT_ARG(int) :
+					(flags & SIZETFLAG) ? NEXT_ARG(ssize_t) :
+					NEXT_ARG(int);
 				flags |= SIGNEDFLAG;
 				s = longlong_to_string(num_buffer, n, sizeof(num_buffer), flags);
 				goto _output_string;
@@ -248,12 +256,12 @@ next_format:
 				flags |= LONGFLAG;
 				/* fallthrough */
 			case 'u':
-				n = (flags & LONGLONGFLAG) ? va_arg(ap, unsigned long long) :
-					(flags & LONGFLAG) ? va_arg(ap, unsigned long) : 
-					(flags & HALFHALFFLAG) ? (unsigned char)va_arg(ap, unsigned int) :
-					(flags & HALFFLAG) ? (unsigned short)va_arg(ap, unsigned int) :
-					(flags & SIZETFLAG) ? va_arg(ap, size_t) :
-					va_arg(ap, unsigned int);
+				n = (flags & LONGLONGFLAG) ? NEXT_ARG(unsigned long long) :
+					(flags & LONGFLAG) ? NEXT_ARG(unsigned long) : 
+					(flags & HALFHALFFLAG) ? (unsigned char)NEXT_ARG(unsigned int) :
+					(flags & HALFFLAG) ? (unsigned short)NEXT_ARG(unsigned int) :
+					(flags & SIZETFLAG) ? NEXT_ARG(size_t) :
+					NEXT_ARG(unsigned int);
 				s = longlong_to_string(num_buffer, n, sizeof(num_buffer), flags);
 				goto _output_string;
 			case 'p':
@@ -264,12 +272,12 @@ next_format:
 				/* fallthrough */
 hex:
 			case 'x':
-				n = (flags & LONGLONGFLAG) ? va_arg(ap, unsigned long long) :
-				    (flags & LONGFLAG) ? va_arg(ap, unsigned long) : 
-					(flags & HALFHALFFLAG) ? (unsigned char)va_arg(ap, unsigned int) :
-					(flags & HALFFLAG) ? (unsigned short)va_arg(ap, unsigned int) :
-					(flags & SIZETFLAG) ? va_arg(ap, size_t) :
-					va_arg(ap, unsigned int);
+				n = (flags & LONGLONGFLAG) ? NEXT_ARG(unsigned long long) :
+				    (flags & LONGFLAG) ? NEXT_ARG(unsigned long) : 
+					(flags & HALFHALFFLAG) ? (unsigned char)NEXT_ARG(unsigned int) :
+					(flags & HALFFLAG) ? (unsigned short)NEXT_ARG(unsigned int) :
+					(flags & SIZETFLAG) ? NEXT_ARG(size_t) :
+					NEXT_ARG(unsigned int);
 				s = longlong_to_hexstring(num_buffer, n, sizeof(num_buffer), flags);
 				if(flags & ALTFLAG) {
 					OUTPUT_CHAR('0');
@@ -277,7 +285,7 @@ hex:
 				}
 				goto _output_string;
 			case 'n':
-				ptr = va_arg(ap, void *);
+				ptr = NEXT_PTR(void *);
 				if(flags & LONGLONGFLAG)
 					*(long long *)ptr = chars_written;
 				else if(flags & LONGFLAG)
@@ -328,14 +336,59 @@ _output_string:
 	}
 
 done:
-	/* null terminate */
-	OUTPUT_CHAR_NOLENCHECK('\0');
-	chars_written--; /* don't count the null */
-
 #undef OUTPUT_CHAR
-#undef OUTPUT_CHAR_NOLENCHECK
+#undef NEXT_ARG
+#undef NEXT_PTR
 
 	return chars_written;
 }
 
+int _printf_engine(_printf_engine_output_func out, void *state, const char *fmt, va_list ap)
+{
+	int err;
+	va_list ap2;
+
+	va_copy(ap2, ap);
+	err = printf_engine(out, state, fmt, &ap2, NULL);
+	va_end(ap2);
+
+	return err;
+}
+
+int _printf_engine_args(_printf_engine_output_func out, void *state, const char *fmt,
+		const unsigned long long *args)
+{
+	return printf_engine(out, state, fmt, NULL, args);
+}
+
+struct snprintf_state {
+	char *str;
+	size_t len;
+	size_t pos;
+};
+
+static int snprintf_output(char c, void *_state)
+{
+	struct snprintf_state *state = _state;
+
+	/* always leave room for the terminator */
+	if (state->pos + 1 >= state->len)
+		return -1;
+
+	state->str[state->pos++] = c;
+	return 0;
+}
+
+int vsnprintf(char *str, size_t len, const char *fmt, va_list ap)
+{
+	struct snprintf_state state = { str, len, 0 };
+	int err;
+
+	err = _printf_engine(&snprintf_output, &state, fmt, ap);
+	if (len > 0)
+		str[state.pos] = '\0';
+
+	return err;
+}
+
 
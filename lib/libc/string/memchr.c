@@ -27,16 +27,40 @@
 #include <string.h>
 #include <sys/types.h>
 
+typedef unsigned long word;
+
+#define lsize sizeof(word)
+#define lmask (lsize - 1)
+
+#define ONES  ((word)-1 / 0xff)
+#define HIGHS (ONES * 0x80)
+
+/* nonzero if any byte in x is zero */
+#define HASZERO(x) (((x) - ONES) & ~(x) & HIGHS)
+
 void *
 memchr(void const *buf, int c, size_t len)
 {
-	size_t i;
 	unsigned char const *b= buf;
 	unsigned char        x= (c&0xff);
+	word                 mask= ONES * x;
+
+	for(; len > 0 && ((long)b & lmask); b++, len--) {
+		if(*b== x) {
+			return (void*)b;
+		}
+	}
+
+	// skip whole words that don't contain the byte
+	for(; len >= lsize; b += lsize, len -= lsize) {
+		if(HASZERO(*(word const *)b ^ mask)) {
+			break;
+		}
+	}
 
-	for(i= 0; i< len; i++) {
-		if(b[i]== x) {
-			return (void*)(b+i);
+	for(; len > 0; b++, len--) {
+		if(*b== x) {
+			return (void*)b;
 		}
 	}
 
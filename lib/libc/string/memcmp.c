@@ -27,14 +27,31 @@
 #include <string.h>
 #include <sys/types.h>
 
+typedef unsigned long word;
+
+#define lsize sizeof(word)
+#define lmask (lsize - 1)
+
 int
 memcmp(const void *cs, const void *ct, size_t count)
 {
-	const unsigned char *su1, *su2;
-	signed char res = 0;
+	const unsigned char *su1 = cs, *su2 = ct;
+	int res;
+
+	if(!(((long)su1 ^ (long)su2) & lmask)) {
+		// similarly aligned, get up to a word boundary and compare a word at a time
+		for(; count > 0 && ((long)su1 & lmask); ++su1, ++su2, count--)
+			if((res = *su1 - *su2) != 0)
+				return res;
+
+		// stop at the first differing word and let the byte loop find the byte
+		for(; count >= lsize; su1 += lsize, su2 += lsize, count -= lsize)
+			if(*(const word *)su1 != *(const word *)su2)
+				break;
+	}
 
-	for(su1 = cs, su2 = ct; 0 < count; ++su1, ++su2, count--)
+	for(; count > 0; ++su1, ++su2, count--)
 		if((res = *su1 - *su2) != 0)
-			break;
-	return res;
+			return res;
+	return 0;
 }
@@ -27,15 +27,34 @@
 #include <string.h>
 #include <sys/types.h>
 
+typedef unsigned long word;
+
+#define lsize sizeof(word)
+#define lmask (lsize - 1)
+
+#define ONES  ((word)-1 / 0xff)
+#define HIGHS (ONES * 0x80)
+
+/* nonzero if any byte in x is zero */
+#define HASZERO(x) (((x) - ONES) & ~(x) & HIGHS)
+
 size_t
 strlen(char const *s)
 {
-	size_t i;
+	const char *p = s;
+	const word *w;
+
+	// bytewise up to a word boundary
+	for(; (long)p & lmask; p++)
+		if(!*p)
+			return p - s;
+
+	// aligned word loads never cross into a page the string doesn't touch
+	for(w = (const word *)p; !HASZERO(*w); w++)
+		;
 
-	i= 0;
-	while(s[i]) {
-		i+= 1;
-	}
+	for(p = (const char *)w; *p; p++)
+		;
 
-	return i;
+	return p - s;
 }
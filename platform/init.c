@@ -25,6 +25,7 @@
 #include <err.h>
 #include <debug.h>
 #include <platform.h>
+#include <platform/timer.h>
 #include <boot_stats.h>
 #include <platform/iomap.h>
 
@@ -140,3 +141,25 @@ __WEAK uint32_t platform_detect_panel()
 {
 	return 0;
 }
+
+__WEAK void platform_mp_init(void)
+{
+}
+
+__WEAK status_t platform_cpu_start(uint cpu, addr_t entry)
+{
+	return ERR_NOT_SUPPORTED;
+}
+
+__WEAK void platform_secondary_init(uint cpu)
+{
+}
+
+__WEAK void platform_send_ipi(uint32_t cpu_mask, uint ipi)
+{
+}
+
+__WEAK status_t platform_set_cpu_tick(platform_timer_callback callback, void *arg, time_t interval)
+{
+	return ERR_NOT_SUPPORTED;
+}
@@ -65,4 +65,5 @@ int qtmr_irq();
                                                NR_BOARD_IRQS)
 
 #define BLSP_QUP_IRQ(blsp_id, qup_id)          (GIC_SPI_START + 95 + qup_id)
+#define BLSP1_UART_IRQ(uart_id)                (GIC_SPI_START + 107 + (uart_id))
 #endif /* __IRQS_MSM8916_H */
@@ -48,6 +48,9 @@
 #define USB30_EE1_IRQ                          (GIC_SPI_START + 131)
 #define USB1_HS_IRQ                            (GIC_SPI_START + 134)
 
+#define SDCC1_IRQ                              (GIC_SPI_START + 123)
+#define SDCC2_IRQ                              (GIC_SPI_START + 125)
+
 #define SDCC1_PWRCTL_IRQ                       (GIC_SPI_START + 138)
 #define SDCC2_PWRCTL_IRQ                       (GIC_SPI_START + 221)
 #define SDCC3_PWRCTL_IRQ                       (GIC_SPI_START + 224)
@@ -57,6 +60,8 @@
 
 #define SMD_IRQ                                (GIC_SPI_START + 168)
 
+#define BLSP1_UART_IRQ(uart_id)                (GIC_SPI_START + 107 + (uart_id))
+
 /* Retrofit universal macro names */
 #define INT_USB_HS                             USB1_HS_IRQ
 
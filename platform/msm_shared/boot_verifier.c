@@ -42,6 +42,10 @@ static KEYSTORE *user_keystore;
 static uint32_t dev_boot_state = RED;
 BUF_DMA_ALIGN(keystore_buf, 4096);
 char KEYSTORE_PTN_NAME[] = "keystore";
+#if MMC_SDHCI_SUPPORT
+static struct mmc_async_req keystore_req;
+static bool keystore_queued;
+#endif
 
 static char *VERIFIED_FLASH_ALLOWED_PTN[] = {
 	"aboot",
@@ -166,13 +170,12 @@ static int add_attribute_to_img(unsigned char *ptr, AUTH_ATTR *input)
 	return i2d_AUTH_ATTR(input, &ptr);
 }
 
-static bool boot_verify_compare_sha256(unsigned char *image_ptr,
-		unsigned int image_size, unsigned char *signature_ptr, RSA *rsa)
+static bool boot_verify_compare_sha256(unsigned char *digest,
+		unsigned char *signature_ptr, RSA *rsa)
 {
 	int ret = -1;
 	bool auth = false;
 	unsigned char *plain_text = NULL;
-	unsigned int digest[8];
 
 	plain_text = (unsigned char *)calloc(sizeof(char), SIGNATURE_SIZE);
 	if (plain_text == NULL) {
@@ -180,17 +183,17 @@ static bool boot_verify_compare_sha256(unsigned char *image_ptr,
 		goto cleanup;
 	}
 
-	/* Calculate SHA256sum */
-	image_find_digest(image_ptr, image_size, CRYPTO_AUTH_ALG_SHA256,
-			(unsigned char *)&digest);
-
 	/* Find digest from the image */
 	ret = image_decrypt_signature_rsa(signature_ptr, plain_text, rsa);
 
 	dprintf(SPEW, "boot_verifier: Return of RSA_public_decrypt = %d\n",
 			ret);
 
-	ret = verify_digest(plain_text, (unsigned char*)digest, SHA256_SIZE);
+	/* Standard DigestInfo is compared in place, anything else is parsed */
+	ret = image_verify_sha256_digest_info(plain_text, ret,
+			(unsigned char*)digest);
+	if(ret > 0)
+		ret = verify_digest(plain_text, (unsigned char*)digest, SHA256_SIZE);
 	if(ret == 0)
 	{
 		auth = true;
@@ -206,14 +209,21 @@ cleanup:
 
 }
 
+/*
+ * ctx, if not NULL, already holds the SHA256 of the image itself, fed to it
+ * while the image was read. Only the authenticated attributes are added.
+ */
 static bool verify_image_with_sig(unsigned char* img_addr, uint32_t img_size,
-		char *pname, VERIFIED_BOOT_SIG *sig, KEYSTORE *ks)
+		char *pname, VERIFIED_BOOT_SIG *sig, KEYSTORE *ks,
+		struct hash_ctx *ctx)
 {
 	bool ret = false;
 	uint32_t len;
+	uint32_t attr_len = 0;
 	int shift_bytes;
 	RSA *rsa = NULL;
 	bool keystore_verification = false;
+	unsigned int digest[8];
 
 	if(!strcmp(pname, "keystore"))
 		keystore_verification = true;
@@ -253,14 +263,27 @@ static bool verify_image_with_sig(unsigned char* img_addr, uint32_t img_size,
 
 	/* append attribute to image */
 	if(!keystore_verification)
-		img_size += add_attribute_to_img((unsigned char*)(img_addr + img_size),
+		attr_len = add_attribute_to_img((unsigned char*)(img_addr + img_size),
 				sig->auth_attr);
 
+	/* Calculate SHA256sum */
+	if(ctx != NULL)
+	{
+		if(hash_update(ctx, img_addr + img_size, attr_len) != CRYPTO_SHA_ERR_NONE ||
+			image_final_digest(ctx, CRYPTO_AUTH_ALG_SHA256, (unsigned char *)&digest))
+			goto verify_image_with_sig_error;
+	}
+	else
+	{
+		image_find_digest(img_addr, img_size + attr_len, CRYPTO_AUTH_ALG_SHA256,
+				(unsigned char *)&digest);
+	}
+
 	/* compare SHA256SUM of image with value in signature */
 	if(ks != NULL)
 		rsa = ks->mykeybag->mykey->key_material;
 
-	ret = boot_verify_compare_sha256(img_addr, img_size,
+	ret = boot_verify_compare_sha256((unsigned char *)digest,
 			(unsigned char*)sig->sig->data, rsa);
 
 	if(!ret)
@@ -300,7 +323,7 @@ static bool verify_keystore(unsigned char * ks_addr, KEYSTORE *ks)
 	unsigned char * ptr = ks_addr;
 	uint32_t inner_len = encode_inner_keystore(ptr, ks);
 	ret = verify_image_with_sig(ks_addr, inner_len, "keystore", ks->sig,
-			oem_keystore);
+			oem_keystore, NULL);
 	return ret;
 }
 
@@ -323,16 +346,48 @@ static void read_oem_keystore()
 	ks = d2i_KEYSTORE(NULL, &input, len);
 	if(ks != NULL)
 	{
+		image_rsa_key_prepare(ks->mykeybag->mykey->key_material);
 		oem_keystore = ks;
 		user_keystore = ks;
 	}
 }
 
+/*
+ * Queue the read of the user keystore with the early boot reads, so it
+ * runs while aboot is busy with keys and display. read_user_keystore_ptn()
+ * collects it.
+ */
+void boot_verify_keystore_prefetch()
+{
+#if MMC_SDHCI_SUPPORT
+	int index;
+	unsigned long long ptn;
+
+	index = partition_get_index(KEYSTORE_PTN_NAME);
+	ptn = partition_get_offset(index);
+	if (ptn == 0 || keystore_queued)
+		return;
+
+	if (!mmc_read_async(&keystore_req, partition_get_lun(index), ptn,
+			    (uint32_t *) keystore_buf, mmc_page_size(), mmc_boot_reads()))
+		keystore_queued = true;
+#endif
+}
+
 static int read_user_keystore_ptn()
 {
 	int index = INVALID_PTN;
 	unsigned long long ptn = 0;
 
+#if MMC_SDHCI_SUPPORT
+	if (keystore_queued) {
+		keystore_queued = false;
+		mmc_boot_reads_wait();
+		if (!keystore_req.ret)
+			return 0;
+	}
+#endif
+
 	index = partition_get_index(KEYSTORE_PTN_NAME);
 	ptn = partition_get_offset(index);
 	if(ptn == 0) {
@@ -368,6 +423,7 @@ static void read_user_keystore(unsigned char *user_addr)
 		}
 		else
 			dprintf(CRITICAL, "boot_verifier: Keystore verification success!\n");
+		image_rsa_key_prepare(ks->mykeybag->mykey->key_material);
 		user_keystore = ks;
 	}
 	else
@@ -388,6 +444,12 @@ uint32_t boot_verify_keystore_init()
 }
 
 bool boot_verify_image(unsigned char* img_addr, uint32_t img_size, char *pname)
+{
+	return boot_verify_image_hashed(img_addr, img_size, pname, NULL);
+}
+
+bool boot_verify_image_hashed(unsigned char* img_addr, uint32_t img_size, char *pname,
+		struct hash_ctx *ctx)
 {
 	bool ret = false;
 	VERIFIED_BOOT_SIG *sig = NULL;
@@ -414,7 +476,7 @@ bool boot_verify_image(unsigned char* img_addr, uint32_t img_size, char *pname)
 		goto verify_image_error;
 	}
 
-	ret = verify_image_with_sig(img_addr, img_size, pname, sig, user_keystore);
+	ret = verify_image_with_sig(img_addr, img_size, pname, sig, user_keystore, ctx);
 
 verify_image_error:
 	if(sig != NULL)
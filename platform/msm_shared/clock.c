@@ -34,15 +34,103 @@
 #include <bits.h>
 #include <clock.h>
 #include <string.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
 
 static struct clk_list msm_clk_list;
 
+/*
+ * Serializes the refcounts and the enable/vote register read-modify-writes
+ * between threads, e.g. the display init thread and crypto on the main
+ * thread. Clock ops enable their parents and sources through the public
+ * calls, so the holder may take it again. Unused before clk_init().
+ */
+static mutex_t clk_mutex;
+static unsigned clk_mutex_depth;
+
+static void clk_lock(void)
+{
+	if (clk_mutex.magic != MUTEX_MAGIC)
+		return;
+
+	if (clk_mutex.holder == current_thread) {
+		clk_mutex_depth++;
+		return;
+	}
+
+	mutex_acquire(&clk_mutex);
+	clk_mutex_depth = 1;
+}
+
+static void clk_unlock(void)
+{
+	if (clk_mutex.magic != MUTEX_MAGIC)
+		return;
+
+	if (--clk_mutex_depth == 0)
+		mutex_release(&clk_mutex);
+}
+
+/*
+ * Name lookup index over msm_clk_list, built once by clk_init(). Open
+ * addressing with linear probing; a slot holds the list index + 1 and 0
+ * marks it empty. The heap is not up at clk_init() time, hence the static
+ * table; lists that do not fit fall back to the linear scan.
+ */
+#define CLK_HASH_SLOTS 256
+
+static uint8_t clk_hash[CLK_HASH_SLOTS];
+static bool clk_hash_valid;
+
+/* FNV-1a */
+static uint32_t clk_name_hash(const char *name)
+{
+	uint32_t h = 2166136261u;
+
+	while (*name)
+	{
+		h ^= (uint8_t)*name++;
+		h *= 16777619u;
+	}
+
+	return h;
+}
+
+static void clk_hash_build(struct clk_lookup *clist, unsigned num)
+{
+	unsigned i;
+	uint32_t slot;
+
+	memset(clk_hash, 0, sizeof(clk_hash));
+	clk_hash_valid = false;
+
+	/* keep the load factor at or below 1/2 */
+	if (num > CLK_HASH_SLOTS / 2)
+		return;
+
+	for (i = 0; i < num; i++)
+	{
+		slot = clk_name_hash(clist[i].con_id) & (CLK_HASH_SLOTS - 1);
+		while (clk_hash[slot])
+			slot = (slot + 1) & (CLK_HASH_SLOTS - 1);
+		clk_hash[slot] = i + 1;
+	}
+
+	clk_hash_valid = true;
+}
+
 int clk_set_parent(struct clk *clk, struct clk *parent)
 {
+	int ret;
+
 	if (!clk->ops->set_parent)
 		return 0;
 
-	return clk->ops->set_parent(clk, parent);
+	clk_lock();
+	ret = clk->ops->set_parent(clk, parent);
+	clk_unlock();
+
+	return ret;
 }
 
 struct clk *clk_get_parent(struct clk *clk)
@@ -55,13 +143,19 @@ struct clk *clk_get_parent(struct clk *clk)
 
 int clk_reset(struct clk *clk, enum clk_reset_action action)
 {
+	int ret;
+
 	if (!clk)
 		return 0;
 
 	if (!clk->ops->reset)
 		return 0;
 
-	return clk->ops->reset(clk, action);
+	clk_lock();
+	ret = clk->ops->reset(clk, action);
+	clk_unlock();
+
+	return ret;
 }
 
 /*
@@ -75,6 +169,7 @@ int clk_enable(struct clk *clk)
 	if (!clk)
 		return 0;
 
+	clk_lock();
 	if (clk->count == 0) {
 		parent = clk_get_parent(clk);
 		ret = clk_enable(parent);
@@ -90,6 +185,7 @@ int clk_enable(struct clk *clk)
 	}
 	clk->count++;
 out:
+	clk_unlock();
 	return ret;
 }
 
@@ -100,6 +196,7 @@ void clk_disable(struct clk *clk)
 	if (!clk)
 		return;
 
+	clk_lock();
 	if (clk->count == 0)
 		goto out;
 	if (clk->count == 1) {
@@ -110,7 +207,7 @@ void clk_disable(struct clk *clk)
 	}
 	clk->count--;
 out:
-	return;
+	clk_unlock();
 }
 
 unsigned long clk_get_rate(struct clk *clk)
@@ -123,10 +220,16 @@ unsigned long clk_get_rate(struct clk *clk)
 
 int clk_set_rate(struct clk *clk, unsigned long rate)
 {
+	int ret;
+
 	if (!clk->ops->set_rate)
 		return ERR_NOT_VALID;
 
-	return clk->ops->set_rate(clk, rate);
+	clk_lock();
+	ret = clk->ops->set_rate(clk, rate);
+	clk_unlock();
+
+	return ret;
 }
 
 void clk_init(struct clk_lookup *clist, unsigned num)
@@ -135,6 +238,8 @@ void clk_init(struct clk_lookup *clist, unsigned num)
 	{
 		msm_clk_list.clist = (struct clk_lookup *)clist;
 		msm_clk_list.num = num;
+		clk_hash_build(clist, num);
+		mutex_init(&clk_mutex);
 	}
 }
 
@@ -149,6 +254,22 @@ struct clk *clk_get (const char * cid)
 		dprintf (CRITICAL, "Alert!! clock list not defined!\n");
 		return NULL;
 	}
+
+	if (clk_hash_valid)
+	{
+		uint32_t slot = clk_name_hash(cid) & (CLK_HASH_SLOTS - 1);
+
+		/* the table is never full, so the probe ends on an empty slot */
+		while (clk_hash[slot])
+		{
+			i = clk_hash[slot] - 1;
+			if (!strcmp(cl[i].con_id, cid))
+				return cl[i].clk;
+			slot = (slot + 1) & (CLK_HASH_SLOTS - 1);
+		}
+		goto not_found;
+	}
+
 	for(i=0; i < num; i++, cl++)
 	{
 		if(!strcmp(cl->con_id, cid))
@@ -157,6 +278,7 @@ struct clk *clk_get (const char * cid)
 		}
 	}
 
+not_found:
 	dprintf(CRITICAL, "Alert!! Requested clock \"%s\" is not supported!", cid);
 	return NULL;
 }
@@ -175,6 +297,9 @@ int clk_get_set_enable(char *id, unsigned long rate, bool enable)
 		goto get_set_enable_error;
 	}
 
+	/* Rate and enable in one go, another thread may share the source */
+	clk_lock();
+
 	/* Set rate */
 	if(rate)
 	{
@@ -182,6 +307,7 @@ int clk_get_set_enable(char *id, unsigned long rate, bool enable)
 		if(ret)
 		{
 			dprintf(CRITICAL, "Clock set rate failed.\n");
+			clk_unlock();
 			goto get_set_enable_error;
 		}
 	}
@@ -196,6 +322,8 @@ int clk_get_set_enable(char *id, unsigned long rate, bool enable)
 		}
 	}
 
+	clk_unlock();
+
 get_set_enable_error:
 	return ret;
 }
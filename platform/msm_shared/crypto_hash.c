@@ -27,10 +27,15 @@
  */
 
 #include <string.h>
+#include <stdlib.h>
 #include <sha.h>
 #include <debug.h>
+#include <err.h>
 #include <sys/types.h>
 #include "crypto_hash.h"
+#if CRYPTO_SHA_ARMV8
+#include <sha_armv8.h>
+#endif
 
 static crypto_SHA256_ctx g_sha256_ctx;
 static crypto_SHA1_ctx g_sha1_ctx;
@@ -38,6 +43,48 @@ static bool crypto_init_done;
 
 extern void ce_clock_init(void);
 
+#if CRYPTO_SHA_ARMV8
+#define sw_sha1_update		sha1_armv8_update
+#define sw_sha256_update	sha256_armv8_update
+#else
+#define sw_sha1_update		SHA1_Update
+#define sw_sha256_update	SHA256_Update
+#endif
+
+/*
+ * Engine used for hashing. The ARMv8 SHA instructions outrun the BAM
+ * crypto engine, so cpus that have them hash in software.
+ */
+static crypto_engine_type hash_engine_type(void)
+{
+	crypto_engine_type type = board_ce_type();
+
+#if CRYPTO_SHA_ARMV8
+	if (type == CRYPTO_ENGINE_TYPE_HW && sha_armv8_supported())
+		type = CRYPTO_ENGINE_TYPE_SW;
+#endif
+
+	return type;
+}
+
+static void sw_sha1(unsigned char *addr, unsigned int size, unsigned char *digest)
+{
+	SHA_CTX c;
+
+	SHA1_Init(&c);
+	sw_sha1_update(&c, addr, size);
+	SHA1_Final(digest, &c);
+}
+
+static void sw_sha256(unsigned char *addr, unsigned int size, unsigned char *digest)
+{
+	SHA256_CTX c;
+
+	SHA256_Init(&c);
+	sw_sha256_update(&c, addr, size);
+	SHA256_Final(digest, &c);
+}
+
 /*
  * Top level function which calculates SHAx digest with given data and size.
  * Digest varies based on the authentication algorithm.
@@ -49,12 +96,12 @@ hash_find(unsigned char *addr, unsigned int size, unsigned char *digest,
 	  unsigned char auth_alg)
 {
 	crypto_result_type ret_val = CRYPTO_SHA_ERR_NONE;
-	crypto_engine_type platform_ce_type = board_ce_type();
+	crypto_engine_type platform_ce_type = hash_engine_type();
 
 	if (auth_alg == CRYPTO_AUTH_ALG_SHA1) {
 		if(platform_ce_type == CRYPTO_ENGINE_TYPE_SW)
 			/* Hardware CE is not present , use software hashing */
-			digest = SHA1(addr, size, digest);
+			sw_sha1(addr, size, digest);
 		else if (platform_ce_type == CRYPTO_ENGINE_TYPE_HW)
 			ret_val = crypto_sha1(addr, size, digest);
 		else
@@ -62,7 +109,7 @@ hash_find(unsigned char *addr, unsigned int size, unsigned char *digest,
 	} else if (auth_alg == CRYPTO_AUTH_ALG_SHA256) {
 		if(platform_ce_type == CRYPTO_ENGINE_TYPE_SW)
 			/* Hardware CE is not present , use software hashing */
-			digest = SHA256(addr, size, digest);
+			sw_sha256(addr, size, digest);
 		else if (platform_ce_type == CRYPTO_ENGINE_TYPE_HW)
 			ret_val = crypto_sha256(addr, size, digest);
 		else
@@ -77,8 +124,9 @@ hash_find(unsigned char *addr, unsigned int size, unsigned char *digest,
 }
 
 /*
- * Function to reset and init crypto engine. It resets the engine for the
- * first time. Used for multiple SHA operations.
+ * Function to reset and init crypto engine. The engine is brought up by
+ * the first SHA operation and stays up until crypto_eng_cleanup() at
+ * kernel handoff, so later operations and streamed hashes reuse it.
  */
 
 static void crypto_init(void)
@@ -86,9 +134,9 @@ static void crypto_init(void)
 	if (crypto_init_done != TRUE) {
 		ce_clock_init();
 		crypto_eng_reset();
+		crypto_eng_init();
 		crypto_init_done = TRUE;
 	}
-	crypto_eng_init();
 }
 
 /*
@@ -100,6 +148,270 @@ bool crypto_initialized()
 	return crypto_init_done;
 }
 
+/*
+ * Streaming hash API. Data is accepted in any number of pieces and, on
+ * the crypto engine, handed to the hardware straight from the caller's
+ * buffers in whole SHA blocks. The trailing 1..64 bytes are always held
+ * back in the context so the last CE submission carries the LAST flag.
+ * Every CE submission loads the full context (IV and byte count), so
+ * several contexts may be in flight at once.
+ */
+
+static crypto_result_type crypto_sha256_init(crypto_SHA256_ctx * ctx_ptr);
+static crypto_result_type crypto_sha1_init(crypto_SHA1_ctx * ctx_ptr);
+
+uint32_t hash_digest_len(crypto_auth_alg_type auth_alg)
+{
+	if (auth_alg == CRYPTO_AUTH_ALG_SHA1)
+		return SHA_DIGEST_LENGTH;
+	else if (auth_alg == CRYPTO_AUTH_ALG_SHA256)
+		return SHA256_DIGEST_LENGTH;
+
+	return 0;
+}
+
+crypto_result_type hash_init(struct hash_ctx *ctx, crypto_auth_alg_type auth_alg)
+{
+	return hash_init_engine(ctx, auth_alg, hash_engine_type());
+}
+
+/* Same as hash_init() on a given engine, for tests and benchmarks */
+crypto_result_type hash_init_engine(struct hash_ctx *ctx, crypto_auth_alg_type auth_alg,
+				    crypto_engine_type engine)
+{
+	if (ctx == NULL || !hash_digest_len(auth_alg))
+		return CRYPTO_SHA_ERR_INVALID_PARAM;
+
+	memset(ctx, 0, sizeof(*ctx));
+	ctx->auth_alg = auth_alg;
+	ctx->engine = engine;
+	ctx->first = TRUE;
+
+	if (ctx->engine == CRYPTO_ENGINE_TYPE_SW) {
+		if (auth_alg == CRYPTO_AUTH_ALG_SHA1)
+			SHA1_Init(&ctx->u.sw_sha1);
+		else
+			SHA256_Init(&ctx->u.sw_sha256);
+	} else if (ctx->engine == CRYPTO_ENGINE_TYPE_HW) {
+		crypto_init();
+		if (auth_alg == CRYPTO_AUTH_ALG_SHA1)
+			crypto_sha1_init(&ctx->u.ce_sha1);
+		else
+			crypto_sha256_init(&ctx->u.ce_sha256);
+	} else {
+		return CRYPTO_SHA_ERR_FAIL;
+	}
+
+	return CRYPTO_SHA_ERR_NONE;
+}
+
+/*
+ * Send one piece to the CE. Anything but the last piece must be a
+ * multiple of the SHA block size.
+ */
+static crypto_result_type
+hash_ce_submit(struct hash_ctx *ctx, const unsigned char *buf, uint32_t len,
+	       bool last)
+{
+	unsigned int ret_val = CRYPTO_ERR_NONE;
+	/* Offsets are the same in the SHA1 and SHA256 contexts */
+	crypto_SHA1_ctx *sha1_ctx = &ctx->u.ce_sha1;
+
+	crypto_set_sha_ctx(sha1_ctx, len, ctx->auth_alg, ctx->first, last);
+
+	crypto_send_data(sha1_ctx, (unsigned char *)buf, len, len, &ret_val);
+	if (ret_val != CRYPTO_ERR_NONE) {
+		dprintf(CRITICAL, "hash_ce_submit: crypto_send_data failed\n");
+		return CRYPTO_SHA_ERR_FAIL;
+	}
+
+	crypto_get_digest((unsigned char *)(sha1_ctx->auth_iv), &ret_val,
+			  ctx->auth_alg, last);
+	if (ret_val != CRYPTO_ERR_NONE) {
+		dprintf(CRITICAL, "hash_ce_submit: crypto_get_digest failed\n");
+		return CRYPTO_SHA_ERR_FAIL;
+	}
+
+	if (!last)
+		crypto_get_ctx(sha1_ctx);
+
+	ctx->first = FALSE;
+
+	return CRYPTO_SHA_ERR_NONE;
+}
+
+crypto_result_type hash_update(struct hash_ctx *ctx, const void *buf, uint32_t len)
+{
+	const unsigned char *ptr = buf;
+	crypto_result_type ret_val;
+	uint32_t bulk;
+	uint32_t tail;
+	uint32_t max_blk;
+	uint32_t n;
+
+	if (ctx == NULL || (buf == NULL && len))
+		return CRYPTO_SHA_ERR_INVALID_PARAM;
+
+	if (!len)
+		return CRYPTO_SHA_ERR_NONE;
+
+	ctx->total += len;
+
+	if (ctx->engine == CRYPTO_ENGINE_TYPE_SW) {
+		if (ctx->auth_alg == CRYPTO_AUTH_ALG_SHA1)
+			sw_sha1_update(&ctx->u.sw_sha1, ptr, len);
+		else
+			sw_sha256_update(&ctx->u.sw_sha256, ptr, len);
+		return CRYPTO_SHA_ERR_NONE;
+	}
+
+	if (ctx->engine != CRYPTO_ENGINE_TYPE_HW)
+		return CRYPTO_SHA_ERR_FAIL;
+
+	/* Top up the held back block first */
+	if (ctx->partial_len) {
+		n = MIN(CRYPTO_SHA_BLOCK_SIZE - ctx->partial_len, len);
+		memcpy(ctx->partial + ctx->partial_len, ptr, n);
+		ctx->partial_len += n;
+		ptr += n;
+		len -= n;
+
+		if (!len)
+			return CRYPTO_SHA_ERR_NONE;
+
+		/* More data follows, so this full block is not the last one */
+		ret_val = hash_ce_submit(ctx, ctx->partial, CRYPTO_SHA_BLOCK_SIZE, FALSE);
+		if (ret_val != CRYPTO_SHA_ERR_NONE)
+			return ret_val;
+		ctx->partial_len = 0;
+	}
+
+	tail = len % CRYPTO_SHA_BLOCK_SIZE;
+	if (!tail)
+		tail = CRYPTO_SHA_BLOCK_SIZE;
+	bulk = len - tail;
+
+	max_blk = ROUNDDOWN(crypto_get_max_auth_blk_size(), CRYPTO_SHA_BLOCK_SIZE);
+
+	while (bulk) {
+		n = MIN(bulk, max_blk);
+		ret_val = hash_ce_submit(ctx, ptr, n, FALSE);
+		if (ret_val != CRYPTO_SHA_ERR_NONE)
+			return ret_val;
+		ptr += n;
+		bulk -= n;
+	}
+
+	memcpy(ctx->partial, ptr, tail);
+	ctx->partial_len = tail;
+
+	return CRYPTO_SHA_ERR_NONE;
+}
+
+crypto_result_type hash_update_sg(struct hash_ctx *ctx, const struct hash_sg *sg,
+				  uint32_t cnt)
+{
+	crypto_result_type ret_val;
+	uint32_t i;
+
+	if (sg == NULL && cnt)
+		return CRYPTO_SHA_ERR_INVALID_PARAM;
+
+	for (i = 0; i < cnt; i++) {
+		ret_val = hash_update(ctx, sg[i].addr, sg[i].len);
+		if (ret_val != CRYPTO_SHA_ERR_NONE)
+			return ret_val;
+	}
+
+	return CRYPTO_SHA_ERR_NONE;
+}
+
+crypto_result_type hash_final(struct hash_ctx *ctx, unsigned char *digest)
+{
+	crypto_result_type ret_val;
+
+	if (ctx == NULL || digest == NULL)
+		return CRYPTO_SHA_ERR_INVALID_PARAM;
+
+	if (ctx->engine == CRYPTO_ENGINE_TYPE_SW) {
+		if (ctx->auth_alg == CRYPTO_AUTH_ALG_SHA1)
+			SHA1_Final(digest, &ctx->u.sw_sha1);
+		else
+			SHA256_Final(digest, &ctx->u.sw_sha256);
+		return CRYPTO_SHA_ERR_NONE;
+	}
+
+	if (ctx->engine != CRYPTO_ENGINE_TYPE_HW)
+		return CRYPTO_SHA_ERR_FAIL;
+
+	/* The CE cannot run an empty last chunk, the digest of nothing is fixed */
+	if (!ctx->total) {
+		if (ctx->auth_alg == CRYPTO_AUTH_ALG_SHA1)
+			SHA1((const unsigned char *)"", 0, digest);
+		else
+			SHA256((const unsigned char *)"", 0, digest);
+		return CRYPTO_SHA_ERR_NONE;
+	}
+
+	ret_val = hash_ce_submit(ctx, ctx->partial, ctx->partial_len, TRUE);
+	if (ret_val != CRYPTO_SHA_ERR_NONE)
+		return ret_val;
+
+	memcpy(digest, (unsigned char *)ctx->u.ce_sha1.auth_iv,
+	       hash_digest_len(ctx->auth_alg));
+	ctx->partial_len = 0;
+
+	return CRYPTO_SHA_ERR_NONE;
+}
+
+/* Single worker, so queued updates run in order and never drive the CE concurrently */
+static workqueue_t crypto_wq;
+static bool crypto_wq_ready;
+
+static int hash_update_work(void *arg)
+{
+	struct hash_async_req *req = (struct hash_async_req *)arg;
+
+	req->ret = hash_update_sg(req->ctx, req->sg, req->cnt);
+
+	return req->ret == CRYPTO_SHA_ERR_NONE ? NO_ERROR : ERR_IO;
+}
+
+/*
+ * Queue hash_update_sg() on the crypto worker. Completion is signalled
+ * through the work group (may be NULL); req->ret holds the result. The
+ * request, context and sg list must stay valid until then. Updates to a
+ * context run in submission order; hash_final() and synchronous CE
+ * hashing must wait until its requests are complete.
+ */
+crypto_result_type hash_update_async(struct hash_async_req *req, struct hash_ctx *ctx,
+				     const struct hash_sg *sg, uint32_t cnt,
+				     work_group_t *group)
+{
+	if (req == NULL || ctx == NULL)
+		return CRYPTO_SHA_ERR_INVALID_PARAM;
+
+	if (!crypto_wq_ready) {
+		if (workqueue_create(&crypto_wq, "crypto", 1, HIGH_PRIORITY)) {
+			dprintf(CRITICAL, "Failed to create crypto work queue\n");
+			return CRYPTO_SHA_ERR_FAIL;
+		}
+		crypto_wq_ready = TRUE;
+	}
+
+	req->ctx = ctx;
+	req->sg = sg;
+	req->cnt = cnt;
+	req->ret = CRYPTO_SHA_ERR_BUSY;
+
+	work_init(&req->work, hash_update_work, req, NULL);
+
+	if (workqueue_submit(&crypto_wq, &req->work, group))
+		return CRYPTO_SHA_ERR_FAIL;
+
+	return CRYPTO_SHA_ERR_NONE;
+}
+
 /*
  * Function to initialize SHA256 context
  */
@@ -118,6 +118,13 @@ void _dputc(char c)
 #endif
 }
 
+void _dflush(void)
+{
+#if WITH_DEBUG_UART && UART_DM_TX_BUFFERED
+	uart_flush_tx(0);
+#endif
+}
+
 int dgetc(char *c, bool wait)
 {
 	int n;
@@ -30,9 +30,181 @@
 #include <crypto_hash.h>
 #include <string.h>
 #include <openssl/err.h>
+#include <openssl/bn.h>
 #include "image_verify.h"
 #include "scm.h"
 
+/* Key decoded from certBuffer, kept for the whole boot */
+static RSA *cert_rsa_key;
+
+/*
+ * Shared by every verification. Verifications never run concurrently,
+ * and after the first one the context's BIGNUM pool is reused as is.
+ */
+static BN_CTX *rsa_bn_ctx;
+
+/* Public operation output for the fast path */
+static unsigned char rsa_em[IMAGE_RSA_MAX_BYTES];
+
+/* DER DigestInfo header for SHA-256, followed by the digest */
+static const unsigned char sha256_digest_info[] = {
+	0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+	0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+};
+
+static BN_CTX *image_rsa_bn_ctx(void)
+{
+	if (rsa_bn_ctx == NULL)
+		rsa_bn_ctx = BN_CTX_new();
+
+	return rsa_bn_ctx;
+}
+
+/*
+ * Prepare a trusted key for repeated use. The Montgomery context for the
+ * modulus is computed now and cached on the RSA object, so no later
+ * verification with this key has to rebuild it.
+ * Returns 0 on success.
+ */
+int image_rsa_key_prepare(RSA *rsa)
+{
+	BN_CTX *ctx = image_rsa_bn_ctx();
+
+	if (rsa == NULL || rsa->n == NULL || ctx == NULL)
+		return -1;
+
+	rsa->flags |= RSA_FLAG_CACHE_PUBLIC;
+
+	if (!BN_MONT_CTX_set_locked(&rsa->_method_mod_n, CRYPTO_LOCK_RSA,
+				    rsa->n, ctx))
+		return -1;
+
+	return 0;
+}
+
+/*
+ * Check EMSA-PKCS1-v1_5 block type 1 padding in place:
+ * 00 01 FF..FF 00 payload, with at least 8 bytes of FF.
+ * Returns the payload length copied to out, or -1.
+ */
+static int image_rsa_check_pkcs1(const unsigned char *em, unsigned int k,
+				 unsigned char *out, unsigned int out_len)
+{
+	unsigned int i;
+	unsigned int len;
+
+	if (k < 11 || em[0] != 0x00 || em[1] != 0x01)
+		return -1;
+
+	for (i = 2; i < k && em[i] == 0xff; i++);
+
+	if (i == k || em[i] != 0x00 || i < 10)
+		return -1;
+	i++;
+
+	len = k - i;
+	if (len > out_len)
+		return -1;
+
+	memcpy(out, em + i, len);
+
+	return len;
+}
+
+/*
+ * s^65537 mod n: one conversion into Montgomery form, sixteen squarings,
+ * one multiply and a conversion back, all on the key's cached context.
+ */
+static int image_rsa_public_f4(RSA *rsa, const unsigned char *sig,
+			       unsigned int k)
+{
+	BN_CTX *ctx = image_rsa_bn_ctx();
+	BN_MONT_CTX *mont = rsa->_method_mod_n;
+	BIGNUM *s, *sm, *r;
+	int i, n;
+	int ret = -1;
+
+	BN_CTX_start(ctx);
+	s = BN_CTX_get(ctx);
+	sm = BN_CTX_get(ctx);
+	r = BN_CTX_get(ctx);
+	if (r == NULL)
+		goto err;
+
+	if (BN_bin2bn(sig, k, s) == NULL || BN_ucmp(s, rsa->n) >= 0)
+		goto err;
+
+	if (!BN_to_montgomery(sm, s, mont, ctx) || !BN_copy(r, sm))
+		goto err;
+
+	for (i = 0; i < 16; i++)
+		if (!BN_mod_mul_montgomery(r, r, r, mont, ctx))
+			goto err;
+
+	if (!BN_mod_mul_montgomery(r, r, sm, mont, ctx) ||
+	    !BN_from_montgomery(r, r, mont, ctx))
+		goto err;
+
+	/* Left pad to the modulus size */
+	n = BN_num_bytes(r);
+	memset(rsa_em, 0, k - n);
+	BN_bn2bin(r, rsa_em + k - n);
+	ret = 0;
+
+err:
+	BN_CTX_end(ctx);
+	return ret;
+}
+
+/*
+ * RSA public decrypt with PKCS#1 v1.5 padding, same contract as
+ * RSA_public_decrypt(). Keys with e = 65537 up to IMAGE_RSA_MAX_BYTES
+ * take the fast path, anything else goes through OpenSSL.
+ * Returns the payload length, or -1.
+ */
+int image_rsa_public_decrypt(RSA *rsa, const unsigned char *sig,
+			     unsigned int sig_len, unsigned char *out,
+			     unsigned int out_len)
+{
+	unsigned int k;
+
+	if (rsa == NULL || rsa->n == NULL || rsa->e == NULL)
+		return -1;
+
+	k = RSA_size(rsa);
+
+	if (!BN_is_word(rsa->e, RSA_F4) || k > IMAGE_RSA_MAX_BYTES ||
+	    sig_len != k || out_len < k - 11)
+		return RSA_public_decrypt(sig_len, sig, out, rsa,
+					  RSA_PKCS1_PADDING);
+
+	if (rsa->_method_mod_n == NULL && image_rsa_key_prepare(rsa))
+		return -1;
+
+	if (image_rsa_public_f4(rsa, sig, k))
+		return -1;
+
+	return image_rsa_check_pkcs1(rsa_em, k, out, out_len);
+}
+
+/*
+ * Compare a decrypted SHA-256 DigestInfo against digest without an ASN.1
+ * decode. Returns 0 on match, -1 on mismatch and 1 when plain_text is
+ * not the standard DER encoding, so that the caller can fall back to a
+ * full parse.
+ */
+int image_verify_sha256_digest_info(const unsigned char *plain_text, int len,
+				    const unsigned char *digest)
+{
+	if (len != (int)(sizeof(sha256_digest_info) + SHA256_SIZE) ||
+	    memcmp(plain_text, sha256_digest_info, sizeof(sha256_digest_info)))
+		return 1;
+
+	if (memcmp(plain_text + sizeof(sha256_digest_info), digest, SHA256_SIZE))
+		return -1;
+
+	return 0;
+}
 
 /*
  * Returns -1 if decryption failed otherwise size of plain_text in bytes
@@ -47,8 +219,8 @@ int image_decrypt_signature_rsa(unsigned char *signature_ptr,
 		return ret;
 	}
 
-	ret = RSA_public_decrypt(SIGNATURE_SIZE, signature_ptr, plain_text,
-				 rsa_key, RSA_PKCS1_PADDING);
+	ret = image_rsa_public_decrypt(rsa_key, signature_ptr, SIGNATURE_SIZE,
+				       plain_text, SIGNATURE_SIZE);
 	dprintf(SPEW, "DEBUG openssl: Return of RSA_public_decrypt = %d\n",
 		ret);
 
@@ -71,6 +243,10 @@ image_decrypt_signature(unsigned char *signature_ptr, unsigned char *plain_text)
 	EVP_PKEY *pub_key = NULL;
 	RSA *rsa_key = NULL;
 
+	if (cert_rsa_key != NULL)
+		return image_decrypt_signature_rsa(signature_ptr, plain_text,
+						   cert_rsa_key);
+
 	/*
 	 * Get Pubkey and Convert the internal EVP_PKEY to RSA internal struct
 	 */
@@ -91,7 +267,16 @@ image_decrypt_signature(unsigned char *signature_ptr, unsigned char *plain_text)
 		goto cleanup;
 	}
 
-	ret = image_decrypt_signature_rsa(signature_ptr, plain_text, rsa_key);
+	/* Keep the key, later verifications in this boot reuse it */
+	if (image_rsa_key_prepare(rsa_key) == 0) {
+		cert_rsa_key = rsa_key;
+		rsa_key = NULL;
+		ret = image_decrypt_signature_rsa(signature_ptr, plain_text,
+						  cert_rsa_key);
+	} else {
+		ret = image_decrypt_signature_rsa(signature_ptr, plain_text,
+						  rsa_key);
+	}
 	dprintf(SPEW, "DEBUG openssl: Return of RSA_public_decrypt = %d\n",
 		ret);
 
@@ -105,14 +290,9 @@ image_decrypt_signature(unsigned char *signature_ptr, unsigned char *plain_text)
 	return ret;
 }
 
-/* Calculates digest of an image and save it in digest buffer */
-void image_find_digest(unsigned char *image_ptr, unsigned int image_size,
-		unsigned hash_type, unsigned char *digest)
+/* Saves the digest of the image being booted on TZ */
+static void image_save_digest(unsigned hash_type, unsigned char *digest)
 {
-	/*
-	 * Calculate hash of image and save calculated hash on TZ.
-	 */
-	hash_find(image_ptr, image_size, (unsigned char *)digest, hash_type);
 #ifdef TZ_SAVE_KERNEL_HASH
 	if (hash_type == CRYPTO_AUTH_ALG_SHA256) {
 		save_kernel_hash_cmd(digest);
@@ -122,21 +302,47 @@ void image_find_digest(unsigned char *image_ptr, unsigned int image_size,
 #endif
 }
 
+/* Calculates digest of an image and save it in digest buffer */
+void image_find_digest(unsigned char *image_ptr, unsigned int image_size,
+		unsigned hash_type, unsigned char *digest)
+{
+	/*
+	 * Calculate hash of image and save calculated hash on TZ.
+	 */
+	hash_find(image_ptr, image_size, (unsigned char *)digest, hash_type);
+	image_save_digest(hash_type, digest);
+}
+
 /*
+ * Same as image_find_digest() for an image that was fed to ctx while it
+ * was read, e.g. with hash_update() on each chunk.
+ */
+int image_final_digest(struct hash_ctx *ctx, unsigned hash_type,
+		unsigned char *digest)
+{
+	if (ctx->auth_alg != hash_type ||
+	    hash_final(ctx, digest) != CRYPTO_SHA_ERR_NONE) {
+		dprintf(CRITICAL, "ERROR: Cannot finish image hash\n");
+		return -1;
+	}
+
+	image_save_digest(hash_type, digest);
+	return 0;
+}
+
+/*
+ * Check the digest of an image against its signature.
  * Returns 1 when image is signed and authorized.
  * Returns 0 when image is unauthorized.
- * Expects a pointer to the start of image and pointer to start of sig
  */
-int
-image_verify(unsigned char *image_ptr,
-	     unsigned char *signature_ptr,
-	     unsigned int image_size, unsigned hash_type)
+static int
+image_verify_digest(unsigned char *digest,
+		    unsigned char *signature_ptr, unsigned hash_type)
 {
 
 	int ret = -1;
 	int auth = 0;
 	unsigned char *plain_text = NULL;
-	unsigned int digest[8];
 	int hash_size;
 
 	plain_text = (unsigned char *)calloc(sizeof(char), SIGNATURE_SIZE);
@@ -145,13 +351,8 @@ image_verify(unsigned char *image_ptr,
 		goto cleanup;
 	}
 
-	/*
-	 * Calculate hash of image and save calculated hash on TZ.
-	 */
 	hash_size =
 	    (hash_type == CRYPTO_AUTH_ALG_SHA256) ? SHA256_SIZE : SHA1_SIZE;
-	image_find_digest(image_ptr, image_size, hash_type,
-			(unsigned char *)&digest);
 
 	/*
 	 * Decrypt the pre-calculated expected image hash.
@@ -186,3 +387,42 @@ image_verify(unsigned char *image_ptr,
 	ERR_remove_thread_state(NULL);
 	return auth;
 }
+
+/*
+ * Returns 1 when image is signed and authorized.
+ * Returns 0 when image is unauthorized.
+ * Expects a pointer to the start of image and pointer to start of sig
+ */
+int
+image_verify(unsigned char *image_ptr,
+	     unsigned char *signature_ptr,
+	     unsigned int image_size, unsigned hash_type)
+{
+	unsigned int digest[8];
+
+	/*
+	 * Calculate hash of image and save calculated hash on TZ.
+	 */
+	image_find_digest(image_ptr, image_size, hash_type,
+			(unsigned char *)&digest);
+
+	return image_verify_digest((unsigned char *)digest, signature_ptr,
+				   hash_type);
+}
+
+/*
+ * Same as image_verify() for an image that was hashed into ctx while it
+ * was read. Returns 1 when image is signed and authorized, 0 otherwise.
+ */
+int
+image_verify_hashed(struct hash_ctx *ctx,
+		    unsigned char *signature_ptr, unsigned hash_type)
+{
+	unsigned int digest[8];
+
+	if (image_final_digest(ctx, hash_type, (unsigned char *)&digest))
+		return 0;
+
+	return image_verify_digest((unsigned char *)digest, signature_ptr,
+				   hash_type);
+}
@@ -143,10 +143,16 @@ enum boot_verfiy_event
 };
 
 extern char KEYSTORE_PTN_NAME[];
+/* Function to start reading the user keystore ahead of keystore init */
+void boot_verify_keystore_prefetch();
 /* Function to initialize keystore */
 uint32_t boot_verify_keystore_init();
 /* Function to verify boot/recovery image */
 bool boot_verify_image(unsigned char* img_addr, uint32_t img_size, char *pname);
+/* Same, with the SHA256 of the image already streamed into ctx */
+struct hash_ctx;
+bool boot_verify_image_hashed(unsigned char* img_addr, uint32_t img_size, char *pname,
+		struct hash_ctx *ctx);
 /* Function to send event to boot state machine */
 void boot_verify_send_event(uint32_t event);
 /* Read current boot state */
@@ -27,7 +27,11 @@
  */
 
 #ifndef __CRYPTO_HASH_H__
-#define __CRYPYO_HASH_H__
+#define __CRYPTO_HASH_H__
+
+#include <sha.h>
+#include <arch/defines.h>
+#include <kernel/workqueue.h>
 
 #ifndef NULL
 #define NULL		0
@@ -131,6 +135,50 @@ static crypto_result_type crypto_sha1(unsigned char *buff_ptr,
 				      unsigned int buff_size,
 				      unsigned char *digest_ptr);
 
+/* Streaming hash over either the crypto engine or the software fallback */
+struct hash_ctx {
+	crypto_auth_alg_type auth_alg;
+	crypto_engine_type engine;
+	bool first;		/* next CE submission starts the hash */
+	uint64_t total;		/* bytes accepted so far */
+	union {
+		crypto_SHA1_ctx ce_sha1;
+		crypto_SHA256_ctx ce_sha256;
+		SHA_CTX sw_sha1;
+		SHA256_CTX sw_sha256;
+	} u;
+	/* Tail held back for the CE: 1..64 bytes once any data was seen */
+	uint32_t partial_len;
+	unsigned char partial[CRYPTO_SHA_BLOCK_SIZE] __attribute__ ((aligned(CACHE_LINE)));
+};
+
+/* One piece of a scatter-gather input list */
+struct hash_sg {
+	const void *addr;
+	uint32_t len;
+};
+
+/* Asynchronous update, run in submission order on a dedicated crypto worker */
+struct hash_async_req {
+	work_t work;
+	struct hash_ctx *ctx;
+	const struct hash_sg *sg;
+	uint32_t cnt;
+	crypto_result_type ret;	/* hash_update_sg() result once complete */
+};
+
+crypto_result_type hash_init(struct hash_ctx *ctx, crypto_auth_alg_type auth_alg);
+crypto_result_type hash_init_engine(struct hash_ctx *ctx, crypto_auth_alg_type auth_alg,
+				    crypto_engine_type engine);
+crypto_result_type hash_update(struct hash_ctx *ctx, const void *buf, uint32_t len);
+crypto_result_type hash_update_sg(struct hash_ctx *ctx, const struct hash_sg *sg,
+				  uint32_t cnt);
+crypto_result_type hash_final(struct hash_ctx *ctx, unsigned char *digest);
+uint32_t hash_digest_len(crypto_auth_alg_type auth_alg);
+crypto_result_type hash_update_async(struct hash_async_req *req, struct hash_ctx *ctx,
+				     const struct hash_sg *sg, uint32_t cnt,
+				     work_group_t *group);
+
 bool crypto_initialized(void);
 void
 hash_find(unsigned char *addr, unsigned int size, unsigned char *digest,
@@ -29,23 +29,44 @@
 
 #include <x509.h>
 
+struct hash_ctx;
+
 #define SHA1_SIZE      16
 #define SHA256_SIZE    32
 /* For keys of length 2048 bits */
 #define SIGNATURE_SIZE 256
+/* Largest modulus handled by the e = 65537 fast path, RSA-4096 */
+#define IMAGE_RSA_MAX_BYTES 512
 
 static int image_decrypt_signature(unsigned char *signature_ptr,
 				   unsigned char *plain_text);
 int image_verify(unsigned char *image_ptr,
 		 unsigned char *signature_ptr,
 		 unsigned int image_size, unsigned hash_type);
+/* Same as image_verify() for an image already hashed into ctx */
+int image_verify_hashed(struct hash_ctx *ctx,
+		 unsigned char *signature_ptr, unsigned hash_type);
 
 /* Decrypt signature with RSA public key */
 int image_decrypt_signature_rsa(unsigned char *signature_ptr,
 		unsigned char *plain_text, RSA *rsa_key);
 
+/* Cache the Montgomery context of a trusted key for the rest of the boot */
+int image_rsa_key_prepare(RSA *rsa);
+
+/* RSA_public_decrypt() with PKCS#1 v1.5 padding and an e = 65537 fast path */
+int image_rsa_public_decrypt(RSA *rsa, const unsigned char *sig,
+		unsigned int sig_len, unsigned char *out, unsigned int out_len);
+
+/* 0 on match, -1 on mismatch, 1 if not a standard SHA-256 DigestInfo */
+int image_verify_sha256_digest_info(const unsigned char *plain_text, int len,
+		const unsigned char *digest);
+
 /* Find hash of image */
 void image_find_digest(unsigned char *image_ptr, unsigned int image_size,
 		unsigned hash_type, unsigned char *digest);
+/* Finish the hash of an image streamed into ctx, 0 on success */
+int image_final_digest(struct hash_ctx *ctx, unsigned hash_type,
+		unsigned char *digest);
 void save_kernel_hash_cmd(void *digest);
 #endif
@@ -302,6 +302,7 @@ struct mmc_card {
 struct mmc_config_data {
 	uint8_t slot;          /* Sdcc slot used */
 	uint32_t pwr_irq;       /* Power Irq from card to host */
+	uint32_t hc_irq;        /* Host controller irq, 0 to poll for completion */
 	uint32_t sdhc_base;    /* Base address for the sdhc */
 	uint32_t pwrctl_base;  /* Base address for power control registers */
 	uint16_t bus_width;    /* Bus width used */
@@ -327,6 +328,10 @@ struct mmc_device *mmc_init(struct mmc_config_data *);
 uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest, uint64_t blk_addr, uint32_t num_blocks);
 /* API: Write requried number of blocks from source to card */
 uint32_t mmc_sdhci_write(struct mmc_device *dev, void *src, uint64_t blk_addr, uint32_t num_blocks);
+/* API: Read contiguous blocks from card into a scatter gather list */
+uint32_t mmc_sdhci_read_sg(struct mmc_device *dev, struct mmc_sg *sg, uint32_t sg_cnt, uint64_t blk_addr);
+/* API: Write a scatter gather list to contiguous blocks on the card */
+uint32_t mmc_sdhci_write_sg(struct mmc_device *dev, struct mmc_sg *sg, uint32_t sg_cnt, uint64_t blk_addr);
 /* API: Erase len bytes (after converting to number of erase groups), from specified address */
 uint32_t mmc_sdhci_erase(struct mmc_device *dev, uint32_t blk_addr, uint64_t len);
 /* API: Write protect or release len bytes (after converting to number of write protect groups) from specified start address*/
@@ -30,6 +30,7 @@
 #define __MMC_WRAPPER_H__
 
 #include <mmc_sdhci.h>
+#include <kernel/workqueue.h>
 
 #define BOARD_KERNEL_PAGESIZE                2048
 /* Wrapper APIs */
@@ -38,6 +39,7 @@ struct mmc_device *get_mmc_device();
 uint32_t mmc_get_psn(void);
 
 uint32_t mmc_read(uint64_t data_addr, uint32_t *out, uint32_t data_len);
+uint32_t mmc_read_sg(uint64_t data_addr, struct mmc_sg *sg, uint32_t sg_cnt);
 uint32_t mmc_write(uint64_t data_addr, uint32_t data_len, void *in);
 uint32_t mmc_erase_card(uint64_t, uint64_t);
 uint64_t mmc_get_device_capacity(void);
@@ -49,4 +51,22 @@ void mmc_set_lun(uint8_t lun);
 uint8_t mmc_get_lun(void);
 void  mmc_read_partition_table(uint8_t arg);
 uint32_t mmc_write_protect(const char *name, int set_clr);
+
+/* Asynchronous reads, run one at a time on a dedicated storage worker */
+struct mmc_async_req {
+	work_t work;
+	uint64_t data_addr;
+	uint32_t *out;
+	uint32_t data_len;
+	uint8_t lun;
+	uint32_t ret;	/* mmc_read() return value once complete */
+};
+
+uint32_t mmc_read_async(struct mmc_async_req *req, uint8_t lun, uint64_t data_addr,
+			uint32_t *out, uint32_t data_len, work_group_t *group);
+uint32_t mmc_queue_work(work_t *work, work_group_t *group);
+
+/* Reads queued early in boot and joined before the next synchronous access */
+work_group_t *mmc_boot_reads(void);
+status_t mmc_boot_reads_wait(void);
 #endif
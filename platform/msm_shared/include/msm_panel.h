@@ -36,6 +36,9 @@
 #define TRUE	1
 #define FALSE	0
 
+/* Panel sequencing delay, sleeps instead of spinning under DISPLAY_INIT_ASYNC */
+void msm_display_delay(unsigned msecs);
+
 /* panel type list */
 #define NO_PANEL		0xffff	/* No Panel */
 #define MDDI_PANEL		1	/* MDDI */
@@ -182,4 +182,5 @@ struct partition_info partition_get_info(const char *name);
 void partition_dump(void);
 /* Read only attribute for partition */
 int partition_read_only(int index);
+unsigned int calculate_crc32(unsigned char *buffer, int len);
 #endif
@@ -212,6 +212,9 @@
 /* Number of max cw's the driver allows to flash. */
 #define QPIC_NAND_MAX_CWS_IN_PAGE                          10
 
+/* Max number of pages queued on the BAM pipes by one read */
+#define QPIC_NAND_READ_BATCH_PAGES                         8
+
 /* Reset Values for Status registers */
 #define NAND_FLASH_STATUS_RESET                            0x00000020
 #define NAND_READ_STATUS_RESET                             0x000000C0
@@ -227,12 +230,7 @@ typedef enum {
 	NANDC_RESULT_BAD_BLOCK = 6,
 } nand_result_t;
 
-enum nand_bad_block_value
-{
-	NAND_BAD_BLK_VALUE_NOT_READ,
-	NAND_BAD_BLK_VALUE_IS_BAD,
-	NAND_BAD_BLK_VALUE_IS_GOOD,
-};
+#define QPIC_NAND_INVALID_BLOCK                            0xFFFFFFFF
 
 enum nand_cfg_value
 {
@@ -354,6 +352,8 @@ nand_result_t qpic_nand_read(uint32_t start_page, uint32_t num_pages,
 nand_result_t qpic_nand_write(uint32_t start_page, uint32_t num_pages,
 		unsigned char* buffer, unsigned  write_extra_bytes);
 nand_result_t qpic_nand_block_isbad(unsigned page);
+uint32_t qpic_nand_bbt_map(uint32_t start_blk, uint32_t num_blks, uint32_t lblk);
+uint32_t qpic_nand_set_read_batch(uint32_t pages);
 nand_result_t qpic_nand_blk_erase(uint32_t page);
 
 #endif
@@ -293,6 +293,15 @@ int scm_protect_keystore(uint32_t * img_ptr, uint32_t  img_len);
 #define SCM_SVC_MILESTONE_32_64_ID      0x1
 #define SCM_SVC_MILESTONE_CMD_ID        0xf
 
+/* legacy cold boot address for the secondary cpus */
+#define SCM_BOOT_ADDR                   0x1
+#define SCM_FLAG_COLDBOOT_CPU1          0x01
+#define SCM_FLAG_COLDBOOT_CPU2          0x08
+#define SCM_FLAG_COLDBOOT_CPU3          0x20
+
+/* PSCI 0.2 function ids, SMC32 calling convention */
+#define PSCI_0_2_FN_CPU_ON              0x84000003
+
 enum ap_ce_channel_type {
 AP_CE_REGISTER_USE = 0,
 AP_CE_ADM_USE = 1
@@ -315,6 +324,10 @@ void *get_canary();
 /* API to configure XPU violations as fatal */
 int scm_xpu_err_fatal_init();
 
+/* secondary cpu start, see platform/msm_shared/mp.c */
+int scm_set_boot_addr(paddr_t addr, uint32_t cpu_flags);
+int psci_cpu_on(uint32_t mpidr, paddr_t entry);
+
 /* APIs to support ARM scm standard
  * Takes arguments : x0-x5 and returns result
  * in x0-x3*/
@@ -41,6 +41,20 @@
 #define DBG(...)
 #endif
 
+/*
+ * ADMA descriptor pool: tables of SDHCI_ADMA_TABLE_ENTRIES chained through
+ * their last entry, each line moving up to 64KB, i.e. ~32MB per table.
+ */
+#define SDHCI_ADMA_TABLE_SZ                       4096
+#define SDHCI_ADMA_TABLE_ENTRIES                  (SDHCI_ADMA_TABLE_SZ / 8)
+#define SDHCI_ADMA_MAX_TABLES                     32
+
+/*
+ * Block count & auto cmd23 are 16 bit, a bigger transfer runs as back to back
+ * commands of up to SDHCI_MAX_BLK_CNT blocks out of the same chained table.
+ */
+#define SDHCI_ADMA_MAX_CMDS                       (SDHCI_ADMA_MAX_TABLES + 1)
+
 /*
  * Capabilities for the host controller
  * These values are read from the capabilities
@@ -73,8 +87,21 @@ struct sdhci_host {
 	uint16_t minor;          /* host controller major ver */
 	bool use_cdclp533;       /* Use cdclp533 calibration circuit */
 	event_t* sdhc_event;     /* Event for power control irqs */
+	uint32_t hc_irq;         /* Host controller irq, 0 to poll for completion */
+	event_t int_event;       /* Event for cmd/transfer completion irqs */
 	struct host_caps caps;   /* Host capabilities */
 	struct sdhci_msm_data *msm_host; /* MSM specific host info */
+	struct desc_entry *adma_table[SDHCI_ADMA_MAX_TABLES]; /* Persistent chained adma tables */
+	uint32_t adma_tables;    /* Number of adma tables allocated */
+	struct desc_entry *adma_cmd_start[SDHCI_ADMA_MAX_CMDS]; /* First descriptor of each command */
+};
+
+/*
+ * Scatter gather entry for a data transfer
+ */
+struct mmc_sg {
+	void *addr;          /* Start of the segment */
+	uint32_t len;        /* Length of the segment in bytes */
 };
 
 /*
@@ -84,6 +111,8 @@ struct mmc_data {
 	void *data_ptr;      /* Points to stream of data */
 	uint32_t blk_sz;     /* Block size for the data */
 	uint32_t num_blocks; /* num of blocks, each always of size SDHCI_MMC_BLK_SZ */
+	struct mmc_sg *sg;   /* Optional sg list, used instead of data_ptr */
+	uint32_t sg_cnt;     /* Number of entries in sg */
 };
 
 /*
@@ -99,6 +128,7 @@ struct mmc_command {
 	uint32_t trans_mode;    /* Transfer mode, read/write */
 	uint32_t cmd_retry;     /* Retry the command, if card is busy */
 	uint32_t cmd23_support; /* If card supports cmd23 */
+	uint32_t blk_arg_step;  /* Argument increment per block, for transfers split into several commands */
 	uint64_t cmd_timeout;   /* Command timeout in us */
 	struct mmc_data data;   /* Data pointer */
 };
@@ -252,10 +282,11 @@ enum {
 #define SDHCI_INT_STS_CMD_COMPLETE                BIT(0)
 #define SDHCI_ERR_INT_STAT_MASK                   0x8000
 #define SDHCI_ADMA_DESC_LINE_SZ                   65536
-#define SDHCI_ADMA_MAX_TRANS_SZ                   (65535 * 512)
 #define SDHCI_ADMA_TRANS_VALID                    BIT(0)
 #define SDHCI_ADMA_TRANS_END                      BIT(1)
 #define SDHCI_ADMA_TRANS_DATA                     BIT(5)
+#define SDHCI_ADMA_TRANS_LINK                     (BIT(4) | BIT(5))
+#define SDHCI_MAX_BLK_CNT                         0xFFFF
 #define SDHCI_MMC_BLK_SZ                          512
 #define SDHCI_MMC_CUR_BLK_CNT_BIT                 16
 #define SDHCI_MMC_BLK_SZ_BIT                      0
@@ -292,6 +323,16 @@ enum {
 #define SDHCI_MAX_CMD_RETRY                       5000000
 #define SDHCI_MAX_TRANS_RETRY                     10000000
 
+/*
+ * Completion wait: with SDHCI_IRQ_COMPLETION the cmd & transfer loops sleep on
+ * the host controller irq (when the target provides one) instead of spinning
+ * in udelay(1). Wakeups are bounded so a lost irq only costs latency.
+ */
+#ifndef SDHCI_IRQ_COMPLETION
+#define SDHCI_IRQ_COMPLETION                      1
+#endif
+#define SDHCI_INT_WAIT_MS                         10
+
 #define SDHCI_PREP_CMD(c, f)                      ((((c) & 0xff) << 8) | ((f) & 0xff))
 
 /*
@@ -0,0 +1,52 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Fundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef __SHA_ARMV8_H__
+#define __SHA_ARMV8_H__
+
+#include <sys/types.h>
+#include <sha.h>
+
+/* true when the cpu implements the ARMv8 SHA1 and SHA2 instructions */
+bool sha_armv8_supported(void);
+
+/*
+ * Drop in replacements for SHA1_Update/SHA256_Update on an OpenSSL
+ * context. Whole blocks go through the SHA instructions, the context
+ * stays compatible with SHAx_Final. They fall back to OpenSSL when the
+ * instructions are not implemented.
+ */
+int sha1_armv8_update(SHA_CTX *c, const void *data, size_t len);
+int sha256_armv8_update(SHA256_CTX *c, const void *data, size_t len);
+
+/* Block functions in sha_armv8_core.S, state is the native word array */
+void sha1_armv8_block(uint32_t *state, const void *data, uint32_t blocks);
+void sha256_armv8_block(uint32_t *state, const void *data, uint32_t blocks);
+
+#endif
@@ -98,6 +98,13 @@ typedef struct
 	uint32_t priority;
 } smd_pkt_hdr;
 
+/* One piece of a packet for smd_writev() */
+typedef struct
+{
+	const void *base;
+	uint32_t len;		/* multiple of 4 */
+} smd_iovec;
+
 typedef struct
 {
 	smd_shared_stream_info_type ch0;
@@ -120,6 +127,8 @@ int smd_init(smd_channel_info_t *ch, uint32_t ch_type);
 void smd_uninit(smd_channel_info_t *ch);
 void smd_read(smd_channel_info_t *ch, uint32_t *len, int ch_type, uint32_t *response);
 int smd_write(smd_channel_info_t *ch, void *data, uint32_t len, int type);
+int smd_writev(smd_channel_info_t *ch, const smd_iovec *iov, uint32_t iovcnt, int type);
+bool smd_write_room(smd_channel_info_t *ch, uint32_t len);
 int smd_get_channel_info(smd_channel_info_t *ch, uint32_t ch_type);
 int smd_get_channel_entry(smd_channel_info_t *ch, uint32_t ch_type);
 void smd_notify_rpm();
@@ -266,4 +266,5 @@ enum MSM_BOOT_UART_DM_BITS_PER_CHAR {
 void uart_dm_init(uint8_t id,
 				  uint32_t gsbi_base,
 				  uint32_t uart_dm_base);
+void uart_dm_tx_irq_init(uint32_t uart_dm_base, uint32_t irq);
 #endif				/* __UART_DM_H__ */
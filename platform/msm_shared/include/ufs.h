@@ -59,6 +59,41 @@ struct ufs_utp_req_meta_data
 	uint64_t            list_base_addr;
 };
 
+/* Sleep on the UTRCS interrupt instead of polling the doorbell. Requests
+ * issued from a critical section always poll.
+ */
+#ifndef UFS_IRQ_COMPLETION
+#define UFS_IRQ_COMPLETION       1
+#endif
+
+/* Log2 usec buckets for the per command latency histogram. */
+#define UFS_QUEUE_LAT_BUCKETS    24
+#define UFS_MAX_UTRD_SLOTS       32
+
+struct ufs_queue_stats
+{
+	uint32_t cmds;
+	uint32_t errors;
+	uint32_t doorbells;                  /* Doorbell writes, each may start several slots. */
+	uint32_t reaps;                      /* Completion batches. */
+	uint32_t max_depth;
+	uint64_t depth_sum;                  /* Queue depth after each doorbell, for the average. */
+	uint64_t lat_sum_us;
+	uint32_t lat_max_us;
+	uint32_t lat_hist[UFS_QUEUE_LAT_BUCKETS];
+};
+
+/* Multi slot read/write queue on top of the UTRD list. */
+struct ufs_utp_queue
+{
+	addr_t                 slot_desc_base;  /* Per slot command descriptors. */
+	uint32_t               depth;           /* Max slots used at once. */
+	uint32_t               outstanding;     /* Doorbell bits owned by the queue. */
+	event_t                event;           /* Signalled on UTRCS while slots are outstanding. */
+	bigtime_t              issue_time[UFS_MAX_UTRD_SLOTS];
+	struct ufs_queue_stats stats;
+};
+
 struct ufs_uic_meta_data
 {
 	mutex_t  uic_mutex;
@@ -103,6 +138,7 @@ struct ufs_dev
 	/* UTRD maintainance data structures.*/
 	struct ufs_utp_req_meta_data utrd_data;
 	struct ufs_utp_req_meta_data utmrd_data;
+	struct ufs_utp_queue         utrd_queue;
 
 	/* UIC maintainance data structures.*/
 	struct ufs_uic_meta_data     uic_data;
@@ -124,4 +160,6 @@ uint8_t ufs_get_num_of_luns(struct ufs_dev* dev);
 uint32_t ufs_get_erase_blk_size(struct ufs_dev* dev);
 void ufs_dump_is_register(struct ufs_dev* dev);
 void ufs_dump_hc_registers(struct ufs_dev* dev);
+void ufs_dump_queue_stats(struct ufs_dev* dev, void (*report)(const char *line, void *arg), void *arg);
+void ufs_reset_queue_stats(struct ufs_dev* dev);
 #endif
@@ -48,6 +48,22 @@
 
 #define UTP_GENERIC_CMD_TIMEOUT                            40000
 #define UTP_MAX_COMMAND_RETRY                              5000000
+/* Same budget as the polling loops, in ms, for the interrupt driven waits. */
+#define UTP_IRQ_WAIT_TIMEOUT                               (UTP_MAX_COMMAND_RETRY / 1000)
+
+/* Multi slot queue used for READ10/WRITE10.
+ * Each slot owns a command descriptor with room for UTP_QUEUE_MAX_PRDT
+ * PRDT entries, so a single queued command moves at most
+ * UTP_QUEUE_MAX_XFER_LEN bytes and larger transfers use several slots.
+ */
+#ifndef UTP_QUEUE_DEPTH
+#define UTP_QUEUE_DEPTH                                    16
+#endif
+#define UTP_QUEUE_MAX_PRDT                                 16
+#define UTP_QUEUE_MAX_XFER_LEN                             (UTP_QUEUE_MAX_PRDT * UTP_MAX_PRD_DATA_BYTE_CNT)
+#define UTP_QUEUE_RESP_OFFSET                              UPIU_HDR_LEN
+#define UTP_QUEUE_PRDT_OFFSET                              (2 * UPIU_HDR_LEN)
+#define UTP_QUEUE_SLOT_DESC_LEN                            ROUNDUP(UTP_QUEUE_PRDT_OFFSET + UTP_QUEUE_MAX_PRDT * sizeof(struct utp_prdt_entry), UTP_CMD_DESC_BASE_ALIGNMENT_SIZE)
 
 struct utp_prdt_entry
 {
@@ -145,6 +161,22 @@ struct utp_bitmap_access_type
 };
 
 int utp_enqueue_upiu(struct ufs_dev *dev, struct upiu_req_build_type *upiu_data);
+
+/* Multi slot queue.
+ * utp_queue_get_slot() reserves a free slot, utp_queue_prep() fills its
+ * pre-built command UPIU/UTRD for a data transfer and returns the CDB to
+ * fill in. utp_queue_ring() starts a batch of prepared slots with a single
+ * doorbell write and utp_queue_reap() waits for at least one of the
+ * outstanding slots to complete, frees all the completed ones and returns
+ * them in *done. Slots that failed are also set in *failed, and the SCSI
+ * status of the last failed slot is returned in *status.
+ */
+int utp_queue_init(struct ufs_dev *dev);
+int utp_queue_get_slot(struct ufs_dev *dev);
+uint8_t *utp_queue_prep(struct ufs_dev *dev, int slot, uint8_t lun, uint8_t flags,
+						enum upiu_dd_type dd, addr_t buf, uint32_t len);
+void utp_queue_ring(struct ufs_dev *dev, uint32_t slots);
+int utp_queue_reap(struct ufs_dev *dev, uint32_t *done, uint32_t *failed, uint8_t *status);
 void utp_process_req_completion(struct ufs_req_irq_type *irq);
 int utp_poll_utrd_complete(struct ufs_dev *dev);
 #endif
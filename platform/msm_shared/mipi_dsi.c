@@ -39,6 +39,7 @@
 #include <platform/iomap.h>
 #include <platform/clock.h>
 #include <platform/timer.h>
+#include <kernel/thread.h>
 #include <err.h>
 #include <msm_panel.h>
 
@@ -72,6 +73,21 @@ uint32_t secure_readl(uint32_t);
 
 static uint32_t response_value = 0;
 
+/*
+ * Panel sequencing delay. With DISPLAY_INIT_ASYNC the display is brought
+ * up on its own thread, so sleep and let the boot thread run meanwhile.
+ */
+void msm_display_delay(unsigned msecs)
+{
+#if DISPLAY_INIT_ASYNC
+	if (!in_critical_section()) {
+		thread_sleep(msecs);
+		return;
+	}
+#endif
+	mdelay(msecs);
+}
+
 static uint32_t mdss_dsi_read_panel_signature(struct mipi_panel_info *mipi)
 {
 	uint32_t rec_buf[1];
@@ -228,7 +244,7 @@ int mdss_dsi_cmds_tx(struct mipi_panel_info *mipi,
 		ret += mdss_dsi_cmd_dma_trigger_for_panel(dual_dsi, ctl_base,
 			sctl_base);
 		if (cm->wait)
-			mdelay(cm->wait);
+			msm_display_delay(cm->wait);
 		else
 			udelay(80);
 		cm++;
@@ -808,7 +824,7 @@ int mipi_dsi_cmds_tx(struct mipi_dsi_cmd *cmds, int count)
 		ret += dsi_cmd_dma_trigger_for_panel();
 		dsb();
 		if (cm->wait)
-			mdelay(cm->wait);
+			msm_display_delay(cm->wait);
 		else
 			udelay(80);
 		cm++;
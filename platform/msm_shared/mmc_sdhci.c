@@ -1083,6 +1083,7 @@ static uint8_t mmc_host_init(struct mmc_device *dev)
 
 	host->base = cfg->sdhc_base;
 	host->sdhc_event = &sdhc_event;
+	host->hc_irq = cfg->hc_irq;
 	host->caps.hs200_support = cfg->hs200_support;
 	host->caps.hs400_support = cfg->hs400_support;
 
@@ -1726,6 +1727,9 @@ struct mmc_device *mmc_init(struct mmc_config_data *data)
 
 	memset((struct mmc_card *)&dev->card, 0, sizeof(struct mmc_card));
 
+	/* Host keeps state across commands (adma pool), start from a clean slate */
+	memset((struct sdhci_host *)&dev->host, 0, sizeof(struct sdhci_host));
+
 	/* Initialize the host & clock */
 	dprintf(SPEW, " Initializing MMC host data structure and clock!\n");
 
@@ -1823,13 +1827,14 @@ static uint32_t mmc_stop_command(struct mmc_device *dev)
 }
 
 /*
- * Function: mmc sdhci read
- * Arg     : mmc device structure, block address, number of blocks & destination
- * Return  : 0 on Success, non zero on success
- * Flow    : Fill in the command structure & send the command
+ * Function: mmc sdhci rw
+ * Arg     : mmc device structure, data descriptor, block address & direction
+ * Return  : 0 on Success, non zero on failure
+ * Flow    : Fill in the command structure & send the command, sdhci builds
+ *           one chained adma table for the whole transfer
  */
-uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest,
-						uint64_t blk_addr, uint32_t num_blocks)
+static uint32_t mmc_sdhci_rw(struct mmc_device *dev, struct mmc_data *data,
+							 uint64_t blk_addr, uint32_t trans_mode)
 {
 	uint32_t mmc_ret = 0;
 	struct mmc_command cmd;
@@ -1837,13 +1842,13 @@ uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest,
 
 	memset((struct mmc_command *)&cmd, 0, sizeof(struct mmc_command));
 
-	/* CMD17/18 Format:
+	/* CMD17/18/24/25 Format:
 	 * [31:0] Data Address
 	 */
-	if (num_blocks == 1)
-		cmd.cmd_index = CMD17_READ_SINGLE_BLOCK;
+	if (trans_mode == SDHCI_MMC_READ)
+		cmd.cmd_index = (data->num_blocks == 1) ? CMD17_READ_SINGLE_BLOCK : CMD18_READ_MULTIPLE_BLOCK;
 	else
-		cmd.cmd_index = CMD18_READ_MULTIPLE_BLOCK;
+		cmd.cmd_index = (data->num_blocks == 1) ? CMD24_WRITE_SINGLE_BLOCK : CMD25_WRITE_MULTIPLE_BLOCK;
 
 	/*
 	 * Standard emmc cards use byte mode addressing
@@ -1851,13 +1856,19 @@ uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest,
 	 * sending the command
 	 */
 	if (card->type == MMC_TYPE_STD_MMC)
+	{
 		cmd.argument = blk_addr * card->block_size;
+		cmd.blk_arg_step = card->block_size;
+	}
 	else
+	{
 		cmd.argument = blk_addr;
+		cmd.blk_arg_step = 1;
+	}
 
 	cmd.cmd_type = SDHCI_CMD_TYPE_NORMAL;
 	cmd.resp_type = SDHCI_CMD_RESP_R1;
-	cmd.trans_mode = SDHCI_MMC_READ;
+	cmd.trans_mode = trans_mode;
 	cmd.data_present = 0x1;
 
 	/* Use CMD23 If card supports CMD23:
@@ -1872,14 +1883,13 @@ uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest,
 	else
 		cmd.cmd23_support = 0x1;
 
-	cmd.data.data_ptr = dest;
-	cmd.data.num_blocks = num_blocks;
+	cmd.data = *data;
 
 	/* send command */
 	mmc_ret = sdhci_send_command(&dev->host, &cmd);
 
-	/* For multi block read failures send stop command */
-	if (mmc_ret && num_blocks > 1)
+	/* For multi block read/write failures send stop command */
+	if (mmc_ret && data->num_blocks > 1)
 	{
 		return mmc_stop_command(dev);
 	}
@@ -1891,73 +1901,101 @@ uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest,
 	return mmc_parse_response(cmd.resp[0]);
 }
 
+/*
+ * Function: mmc sdhci read
+ * Arg     : mmc device structure, block address, number of blocks & destination
+ * Return  : 0 on Success, non zero on success
+ * Flow    : Read num_blocks into dest, one command per SDHCI_MAX_BLK_CNT blocks
+ */
+uint32_t mmc_sdhci_read(struct mmc_device *dev, void *dest,
+						uint64_t blk_addr, uint32_t num_blocks)
+{
+	struct mmc_data data = {0};
+
+	data.data_ptr = dest;
+	data.num_blocks = num_blocks;
+
+	return mmc_sdhci_rw(dev, &data, blk_addr, SDHCI_MMC_READ);
+}
+
 /*
  * Function: mmc sdhci write
  * Arg     : mmc device structure, block address, number of blocks & source
  * Return  : 0 on Success, non zero on success
- * Flow    : Fill in the command structure & send the command
+ * Flow    : Write num_blocks from src, one command per SDHCI_MAX_BLK_CNT blocks
  */
 uint32_t mmc_sdhci_write(struct mmc_device *dev, void *src,
 						 uint64_t blk_addr, uint32_t num_blocks)
 {
-	uint32_t mmc_ret = 0;
-	struct mmc_command cmd;
-	struct mmc_card *card = &dev->card;
+	struct mmc_data data = {0};
 
-	memset((struct mmc_command *)&cmd, 0, sizeof(struct mmc_command));
+	data.data_ptr = src;
+	data.num_blocks = num_blocks;
 
-	/* CMD24/25 Format:
-	 * [31:0] Data Address
-	 */
+	return mmc_sdhci_rw(dev, &data, blk_addr, SDHCI_MMC_WRITE);
+}
 
-	if (num_blocks == 1)
-		cmd.cmd_index = CMD24_WRITE_SINGLE_BLOCK;
-	else
-		cmd.cmd_index = CMD25_WRITE_MULTIPLE_BLOCK;
+/*
+ * Function: mmc sdhci sg count
+ * Arg     : sg list & number of entries
+ * Return  : Number of blocks covered, 0 if a segment is not block aligned
+ */
+static uint32_t mmc_sdhci_sg_blocks(struct mmc_sg *sg, uint32_t sg_cnt)
+{
+	uint32_t len = 0;
+	uint32_t i;
 
-	/*
-	 * Standard emmc cards use byte mode addressing
-	 * convert the block address to byte address before
-	 * sending the command
-	 */
-	if (card->type == MMC_TYPE_STD_MMC)
-		cmd.argument = blk_addr * card->block_size;
-	else
-		cmd.argument = blk_addr;
-	cmd.cmd_type = SDHCI_CMD_TYPE_NORMAL;
-	cmd.resp_type = SDHCI_CMD_RESP_R1;
-	cmd.trans_mode = SDHCI_MMC_WRITE;
+	for (i = 0; i < sg_cnt; i++) {
+		if (!sg[i].len || (sg[i].len % MMC_BLK_SZ))
+			return 0;
+		len += sg[i].len;
+	}
 
-	/* Use CMD23 If card supports CMD23:
-	 * For SD card use the value read from SCR register
-	 * For emmc by default use CMD23.
-	 * Also as per SDCC spec always use CMD23 to stop
-	 * multiblock read/write if UHS (Ultra High Speed) is
-	 * enabled
-	 */
-	if (MMC_CARD_SD(card))
-		cmd.cmd23_support = dev->card.scr.cmd23_support;
-	else
-		cmd.cmd23_support = 0x1;
+	return len / MMC_BLK_SZ;
+}
 
-	cmd.data_present = 0x1;
-	cmd.data.data_ptr = src;
-	cmd.data.num_blocks = num_blocks;
+/*
+ * Function: mmc sdhci read sg
+ * Arg     : mmc device structure, sg list, number of sg entries & block address
+ * Return  : 0 on Success, non zero on failure
+ * Flow    : Read contiguous blocks from the card into the segments of the
+ *           sg list, in order, out of a single descriptor table
+ */
+uint32_t mmc_sdhci_read_sg(struct mmc_device *dev, struct mmc_sg *sg,
+						   uint32_t sg_cnt, uint64_t blk_addr)
+{
+	struct mmc_data data = {0};
 
-	/* send command */
-	mmc_ret = sdhci_send_command(&dev->host, &cmd);
+	data.sg = sg;
+	data.sg_cnt = sg_cnt;
+	data.num_blocks = mmc_sdhci_sg_blocks(sg, sg_cnt);
 
-	/* For multi block write failures send stop command */
-	if (mmc_ret && num_blocks > 1)
-	{
-		return mmc_stop_command(dev);
-	}
+	if (!data.num_blocks)
+		return 1;
 
-	/*
-	 * Response contains 32 bit Card status.
-	 * Parse the errors & provide relevant information
-	 */
-	return mmc_parse_response(cmd.resp[0]);
+	return mmc_sdhci_rw(dev, &data, blk_addr, SDHCI_MMC_READ);
+}
+
+/*
+ * Function: mmc sdhci write sg
+ * Arg     : mmc device structure, sg list, number of sg entries & block address
+ * Return  : 0 on Success, non zero on failure
+ * Flow    : Write the segments of the sg list, in order, to contiguous
+ *           blocks on the card, out of a single descriptor table
+ */
+uint32_t mmc_sdhci_write_sg(struct mmc_device *dev, struct mmc_sg *sg,
+							uint32_t sg_cnt, uint64_t blk_addr)
+{
+	struct mmc_data data = {0};
+
+	data.sg = sg;
+	data.sg_cnt = sg_cnt;
+	data.num_blocks = mmc_sdhci_sg_blocks(sg, sg_cnt);
+
+	if (!data.num_blocks)
+		return 1;
+
+	return mmc_sdhci_rw(dev, &data, blk_addr, SDHCI_MMC_WRITE);
 }
 
 /*
@@ -37,6 +37,8 @@
 #include <partition_parser.h>
 #include <boot_device.h>
 #include <dme.h>
+#include <err.h>
+#include <debug.h>
 /*
  * Weak function for UFS.
  * These are needed to avoid link errors for platforms which
@@ -100,6 +102,111 @@ static struct mmc_card *get_mmc_card()
 	return card;
 }
 
+/* Single worker, so queued requests never touch the controller concurrently */
+static workqueue_t storage_wq;
+static bool storage_wq_ready;
+
+/* Early boot reads, see mmc_boot_reads() */
+static work_group_t boot_reads;
+static bool boot_reads_ready;
+
+static int mmc_read_work(void *arg)
+{
+	struct mmc_async_req *req = (struct mmc_async_req *)arg;
+
+	mmc_set_lun(req->lun);
+	req->ret = mmc_read(req->data_addr, req->out, req->data_len);
+
+	return req->ret ? ERR_IO : NO_ERROR;
+}
+
+/*
+ * Function: mmc_queue_work
+ * Arg     : Initialized work item, work group to account it to (may be NULL)
+ * Return  : 0 if the work was queued, non zero otherwise
+ * Flow    : Run any storage access, e.g. a partition table read, on the
+ *           storage worker behind the requests already queued.
+ */
+uint32_t mmc_queue_work(work_t *work, work_group_t *group)
+{
+	if (!storage_wq_ready)
+	{
+		if (workqueue_create(&storage_wq, "storage", 1, HIGH_PRIORITY))
+		{
+			dprintf(CRITICAL, "Failed to create storage work queue\n");
+			return 1;
+		}
+		storage_wq_ready = true;
+	}
+
+	return workqueue_submit(&storage_wq, work, group) ? 1 : 0;
+}
+
+/*
+ * Function: mmc_boot_reads
+ * Arg     : None
+ * Return  : The work group of the early boot reads
+ * Flow    : Boot steps that only need their data later (partition table,
+ *           devinfo, keystore, splash header) queue their reads here and
+ *           go on with non storage work. mmc_boot_reads_wait() joins them
+ *           all, it must be called before the next synchronous access.
+ */
+work_group_t *mmc_boot_reads(void)
+{
+	if (!boot_reads_ready)
+	{
+		work_group_init(&boot_reads);
+		boot_reads_ready = true;
+	}
+
+	return &boot_reads;
+}
+
+/*
+ * Function: mmc_boot_reads_wait
+ * Arg     : None
+ * Return  : NO_ERROR, or the first failure among the joined reads
+ * Flow    : Wait for everything queued to mmc_boot_reads() so far.
+ */
+status_t mmc_boot_reads_wait(void)
+{
+	status_t err;
+
+	if (!boot_reads_ready)
+		return NO_ERROR;
+
+	err = work_group_wait(&boot_reads, INFINITE_TIME);
+	boot_reads.status = NO_ERROR;
+
+	return err;
+}
+
+/*
+ * Function: mmc_read_async
+ * Arg     : Request storage, LUN (ignored on eMMC), data address on card,
+ *           o/p buffer, data length, work group to account the request to
+ *           (may be NULL)
+ * Return  : 0 if the request was queued, non zero otherwise
+ * Flow    : Queue an mmc_read of the given LUN on the storage worker.
+ *           Completion is signalled through the work group; req->ret holds
+ *           the mmc_read result.
+ *           Synchronous reads/writes, and LUN changes, must not be issued
+ *           while requests are outstanding.
+ */
+uint32_t mmc_read_async(struct mmc_async_req *req, uint8_t lun, uint64_t data_addr,
+			uint32_t *out, uint32_t data_len, work_group_t *group)
+{
+	req->lun = lun;
+	req->data_addr = data_addr;
+	req->out = out;
+	req->data_len = data_len;
+	req->ret = 0;
+
+	work_init(&req->work, mmc_read_work, req, NULL);
+
+	return mmc_queue_work(&req->work, group);
+}
+
 /*
  * Function: mmc_write
  * Arg     : Data address on card, data length, i/p buffer
@@ -111,8 +218,6 @@ uint32_t mmc_write(uint64_t data_addr, uint32_t data_len, void *in)
 	uint32_t val = 0;
 	int ret = 0;
 	uint32_t block_size = 0;
-	uint32_t write_size = SDHCI_ADMA_MAX_TRANS_SZ;
-	uint8_t *sptr = (uint8_t *)in;
 	void *dev;
 
 	dev = target_mmc_device();
@@ -126,25 +231,9 @@ uint32_t mmc_write(uint64_t data_addr, uint32_t data_len, void *in)
 
 	if (platform_boot_dev_isemmc())
 	{
-		/* TODO: This function is aware of max data that can be
-		 * tranferred using sdhci adma mode, need to have a cleaner
-		 * implementation to keep this function independent of sdhci
-		 * limitations
-		 */
-		while (data_len > write_size) {
-			val = mmc_sdhci_write((struct mmc_device *)dev, (void *)sptr, (data_addr / block_size), (write_size / block_size));
-			if (val)
-			{
-				dprintf(CRITICAL, "Failed Writing block @ %x\n",(unsigned int)(data_addr / block_size));
-				return val;
-			}
-			sptr += write_size;
-			data_addr += write_size;
-			data_len -= write_size;
-		}
-
+		/* sdhci chains as many adma tables as needed, one command does it all */
 		if (data_len)
-			val = mmc_sdhci_write((struct mmc_device *)dev, (void *)sptr, (data_addr / block_size), (data_len / block_size));
+			val = mmc_sdhci_write((struct mmc_device *)dev, in, (data_addr / block_size), (data_len / block_size));
 
 		if (val)
 			dprintf(CRITICAL, "Failed Writing block @ %x\n",(unsigned int)(data_addr / block_size));
@@ -175,9 +264,7 @@ uint32_t mmc_read(uint64_t data_addr, uint32_t *out, uint32_t data_len)
 {
 	uint32_t ret = 0;
 	uint32_t block_size;
-	uint32_t read_size = SDHCI_ADMA_MAX_TRANS_SZ;
 	void *dev;
-	uint8_t *sptr = (uint8_t *)out;
 
 	dev = target_mmc_device();
 	block_size = mmc_get_device_blocksize();
@@ -188,25 +275,9 @@ uint32_t mmc_read(uint64_t data_addr, uint32_t *out, uint32_t data_len)
 
 	if (platform_boot_dev_isemmc())
 	{
-		/* TODO: This function is aware of max data that can be
-		 * tranferred using sdhci adma mode, need to have a cleaner
-		 * implementation to keep this function independent of sdhci
-		 * limitations
-		 */
-		while (data_len > read_size) {
-			ret = mmc_sdhci_read((struct mmc_device *)dev, (void *)sptr, (data_addr / block_size), (read_size / block_size));
-			if (ret)
-			{
-				dprintf(CRITICAL, "Failed Reading block @ %x\n",(unsigned int) (data_addr / block_size));
-				return ret;
-			}
-			sptr += read_size;
-			data_addr += read_size;
-			data_len -= read_size;
-		}
-
+		/* sdhci chains as many adma tables as needed, one command does it all */
 		if (data_len)
-			ret = mmc_sdhci_read((struct mmc_device *)dev, (void *)sptr, (data_addr / block_size), (data_len / block_size));
+			ret = mmc_sdhci_read((struct mmc_device *)dev, (void *)out, (data_addr / block_size), (data_len / block_size));
 
 		if (ret)
 			dprintf(CRITICAL, "Failed Reading block @ %x\n",(unsigned int) (data_addr / block_size));
@@ -225,6 +296,45 @@ uint32_t mmc_read(uint64_t data_addr, uint32_t *out, uint32_t data_len)
 	return ret;
 }
 
+/*
+ * Function: mmc read sg
+ * Arg     : Data address on card, sg list & number of sg entries
+ * Return  : 0 on Success, non zero on failure
+ * Flow    : Read contiguous data from the card into the segments of the sg
+ *           list, in order. eMMC fills all of them from one descriptor
+ *           table, UFS reads them one by one.
+ */
+uint32_t mmc_read_sg(uint64_t data_addr, struct mmc_sg *sg, uint32_t sg_cnt)
+{
+	uint32_t ret = 0;
+	uint32_t block_size;
+	uint32_t i;
+	void *dev;
+
+	dev = target_mmc_device();
+	block_size = mmc_get_device_blocksize();
+
+	ASSERT(!(data_addr % block_size));
+
+	if (platform_boot_dev_isemmc())
+	{
+		ret = mmc_sdhci_read_sg((struct mmc_device *)dev, sg, sg_cnt, (data_addr / block_size));
+
+		if (ret)
+			dprintf(CRITICAL, "Failed Reading block @ %x\n",(unsigned int) (data_addr / block_size));
+
+		return ret;
+	}
+
+	for (i = 0; i < sg_cnt && !ret; i++)
+	{
+		ret = mmc_read(data_addr, (uint32_t *)sg[i].addr, sg[i].len);
+		data_addr += sg[i].len;
+	}
+
+	return ret;
+}
+
 
 /*
  * Function: mmc get erase unit size
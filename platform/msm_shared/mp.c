@@ -0,0 +1,151 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Fundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <debug.h>
+#include <err.h>
+#include <reg.h>
+#include <compiler.h>
+#include <arch/defines.h>
+#include <kernel/mp.h>
+#include <platform.h>
+#include <platform/interrupts.h>
+#include <platform/irqs.h>
+#include <platform/timer.h>
+#include <qgic.h>
+#include <qtimer.h>
+#include <scm.h>
+
+/* ipis are delivered as GIC software generated interrupts 0..MP_IPI_MAX-1 */
+#define MP_IPI_SGI_BASE 0
+
+extern bool scm_arm_support;
+
+static const uint32_t coldboot_flags[] = {
+	0,
+	SCM_FLAG_COLDBOOT_CPU1,
+	SCM_FLAG_COLDBOOT_CPU2,
+	SCM_FLAG_COLDBOOT_CPU3,
+};
+
+/*
+ * Per cpu scheduler tick from the virtual timer of the cp15 generic timer,
+ * which is banked per cpu along with its PPI. The QTimer frame behind
+ * current_time() only interrupts the boot cpu.
+ */
+static platform_timer_callback cpu_tick_callback[SMP_MAX_CPUS];
+static void *cpu_tick_arg[SMP_MAX_CPUS];
+static uint32_t cpu_tick_count[SMP_MAX_CPUS];
+
+static void cpu_tick_program(uint32_t tval, uint32_t ctrl)
+{
+	/* CNTV_TVAL, CNTV_CTL */
+	__asm__ volatile("mcr p15, 0, %0, c14, c3, 0" : : "r" (tval));
+	__asm__ volatile("mcr p15, 0, %0, c14, c3, 1" : : "r" (ctrl));
+	isb();
+}
+
+static enum handler_return cpu_tick_irq(void *arg)
+{
+	uint cpu = curr_cpu_num();
+
+	cpu_tick_program(cpu_tick_count[cpu], QTMR_TIMER_CTRL_ENABLE);
+
+	return cpu_tick_callback[cpu](cpu_tick_arg[cpu], current_time());
+}
+
+status_t platform_set_cpu_tick(platform_timer_callback callback, void *arg, time_t interval)
+{
+	uint cpu = curr_cpu_num();
+
+	if (!interval) {
+		mask_interrupt(INT_QTMR_VIRTUAL_TIMER_EXP);
+		cpu_tick_program(0, QTMR_TIMER_CTRL_INT_MASK);
+		return NO_ERROR;
+	}
+
+	cpu_tick_callback[cpu] = callback;
+	cpu_tick_arg[cpu] = arg;
+	cpu_tick_count[cpu] = interval * qtimer_tick_rate() / 1000;
+
+	cpu_tick_program(cpu_tick_count[cpu], QTMR_TIMER_CTRL_ENABLE);
+	unmask_interrupt(INT_QTMR_VIRTUAL_TIMER_EXP);
+
+	return NO_ERROR;
+}
+
+static enum handler_return mp_sgi_handler(void *arg)
+{
+	return mp_ipi_handler((enum mp_ipi)arg);
+}
+
+void platform_mp_init(void)
+{
+	uint ipi;
+
+	for (ipi = 0; ipi < MP_IPI_MAX; ipi++)
+		register_int_handler(MP_IPI_SGI_BASE + ipi, mp_sgi_handler, (void *)ipi);
+
+	/* the handler table is shared, the PPI enable is per cpu */
+	register_int_handler(INT_QTMR_VIRTUAL_TIMER_EXP, cpu_tick_irq, NULL);
+}
+
+/* Releasing a core from reset on pre PSCI TZ is chipset specific */
+__WEAK status_t platform_cpu_power_up(uint cpu)
+{
+	return ERR_NOT_SUPPORTED;
+}
+
+status_t platform_cpu_start(uint cpu, addr_t entry)
+{
+	/* TZ with the ARMv8 calling convention implements PSCI */
+	if (scm_arm_support)
+		return psci_cpu_on(cpu, entry) ? ERROR : NO_ERROR;
+
+	if (cpu >= countof(coldboot_flags))
+		return ERR_NOT_SUPPORTED;
+
+	if (scm_set_boot_addr(entry, coldboot_flags[cpu]))
+		return ERROR;
+
+	return platform_cpu_power_up(cpu);
+}
+
+void platform_secondary_init(uint cpu)
+{
+	/* the SGI/PPI enables and the cpu interface are banked per cpu */
+	writel(0x0000ffff, GIC_DIST_ENABLE_SET);
+	qgic_cpu_init();
+}
+
+void platform_send_ipi(uint32_t cpu_mask, uint ipi)
+{
+	/* make our run queue updates visible before the target looks */
+	dsb();
+	writel(((cpu_mask & 0xff) << 16) | (MP_IPI_SGI_BASE + ipi), GIC_DIST_SOFTINT);
+}
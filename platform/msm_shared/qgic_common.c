@@ -77,16 +77,18 @@ void qgic_init(void)
 /* IRQ handler */
 enum handler_return gic_platform_irq(struct arm_iframe *frame)
 {
-	uint32_t num;
+	uint32_t num, vector;
 	enum handler_return ret;
 
 	/* Read the interrupt number to be served*/
 	num = qgic_read_iar();
 
-	if (num >= NR_IRQS)
+	/* SGIs carry the source cpu in bits 12:10, which the EOI must echo */
+	vector = num & 0x3ff;
+	if (vector >= NR_IRQS)
 		return 0;
 
-	ret = handler[num].func(handler[num].arg);
+	ret = handler[vector].func(handler[vector].arg);
 
 	/* End of interrupt */
 	qgic_write_eoi(num);
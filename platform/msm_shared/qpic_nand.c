@@ -32,11 +32,14 @@
 #include <lib/ptable.h>
 #include <debug.h>
 #include <string.h>
+#include <stdlib.h>
 #include <malloc.h>
 #include <sys/types.h>
 #include <platform.h>
 #include <platform/clock.h>
 #include <platform/iomap.h>
+#include <arch/ops.h>
+#include <arch/defines.h>
 
 static uint32_t nand_base;
 static struct ptable *flash_ptable;
@@ -51,14 +54,40 @@ static uint32_t ecc_bch_cfg;
 struct cmd_element ce_array[100] __attribute__ ((aligned(16)));
 struct cmd_element ce_read_array[20] __attribute__ ((aligned(16)));
 
-#define QPIC_BAM_DATA_FIFO_SIZE          64
-#define QPIC_BAM_CMD_FIFO_SIZE           64
+#define QPIC_BAM_DATA_FIFO_SIZE          256
+#define QPIC_BAM_CMD_FIFO_SIZE           256
+
+/* A page read takes 2 CEs for the erased CW detection reset, 10 for the
+ * first CW, 5 for each middle CW and 7 for the last one.
+ */
+#define QPIC_NAND_RD_CE_PER_PAGE         (5 * QPIC_NAND_MAX_CWS_IN_PAGE + 9)
 
 static struct bam_desc cmd_desc_fifo[QPIC_BAM_CMD_FIFO_SIZE] __attribute__ ((aligned(BAM_DESC_SIZE)));
 static struct bam_desc data_desc_fifo[QPIC_BAM_DATA_FIFO_SIZE] __attribute__ ((aligned(BAM_DESC_SIZE)));
 
 static struct bam_instance bam;
-static uint8_t *bbtbl;
+
+/* Status words the BAM reads back for each page of a batched read */
+struct qpic_nand_rd_sts
+{
+	uint32_t flash_sts[QPIC_NAND_MAX_CWS_IN_PAGE];
+	uint32_t buffer_sts[QPIC_NAND_MAX_CWS_IN_PAGE];
+	uint32_t erased_sts;
+};
+
+static struct cmd_element ce_rd_array[QPIC_NAND_READ_BATCH_PAGES * QPIC_NAND_RD_CE_PER_PAGE] __attribute__ ((aligned(16)));
+static struct qpic_nand_rd_sts rd_sts[QPIC_NAND_READ_BATCH_PAGES] __attribute__ ((aligned(CACHE_LINE)));
+static uint32_t rd_batch_pages = QPIC_NAND_READ_BATCH_PAGES;
+
+/* Bad block table: one bit per block, set for bad blocks, built by
+ * probing every block at init. bbt_rank[i] is the number of good blocks
+ * below block i and bbt_good[n] the n-th good block, so logical to
+ * physical block lookups are O(1).
+ */
+static uint32_t *bbt_bitmap;
+static uint32_t *bbt_rank;
+static uint32_t *bbt_good;
+static bool bbt_ready;
 
 static uint8_t* rdwr_buf;
 
@@ -829,74 +858,58 @@ qpic_nand_block_isbad_exec(struct cfg_params *params,
 }
 
 /**
- * qpic_nand_block_isbad() - Checks is given block is bad
+ * qpic_nand_block_isbad_probe() - Reads the bad block marker of a block
  * @page - number of page the block starts at
  *
  * Returns nand_result_t
  */
-nand_result_t qpic_nand_block_isbad(unsigned page)
+static nand_result_t qpic_nand_block_isbad_probe(unsigned page)
 {
 	unsigned cwperpage;
 	struct cfg_params params;
 	uint8_t bad_block[4];
 	unsigned nand_ret = NANDC_RESULT_SUCCESS;
-	uint32_t blk = page / flash.num_pages_per_blk;
 
-	if (bbtbl[blk] == NAND_BAD_BLK_VALUE_IS_GOOD)
-		return NANDC_RESULT_SUCCESS;
-	else if (bbtbl[blk] == NAND_BAD_BLK_VALUE_IS_BAD)
-		return NANDC_RESULT_BAD_BLOCK;
-	else
+	/* Read the bad block value from the flash.
+	 * Bad block value is stored in the first page of the block.
+	 */
+	/* Read the first page in the block. */
+	cwperpage = flash.cws_per_page;
+
+	/* Read page cmd */
+	params.cmd =  NAND_CMD_PAGE_READ_ECC;
+	/* Clear the CW per page bits */
+	params.cfg0 = cfg0_raw & ~(7U << NAND_DEV0_CFG0_CW_PER_PAGE_SHIFT);
+	params.cfg1 = cfg1_raw;
+	/* addr0 - Write column addr + few bits in row addr upto 32 bits. */
+	params.addr0 = (page << 16) | (USER_DATA_BYTES_PER_CW * cwperpage);
+
+	/* addr1 - Write rest of row addr.
+	 * This will be all 0s.
+	 */
+	params.addr1 = (page >> 16) & 0xff;
+	params.addr_loc_0 = NAND_RD_LOC_OFFSET(0);
+	params.addr_loc_0 |= NAND_RD_LOC_LAST_BIT(1);
+	params.addr_loc_0 |= NAND_RD_LOC_SIZE(4); /* Read 4 bytes */
+	params.ecc_cfg = ecc_bch_cfg | 0x1; /* Disable ECC */
+	params.exec = 1;
+
+	if (qpic_nand_block_isbad_exec(&params, bad_block))
 	{
-		/* Read the bad block value from the flash.
-		 * Bad block value is stored in the first page of the block.
-		 */
-		/* Read the first page in the block. */
-		cwperpage = flash.cws_per_page;
-
-		/* Read page cmd */
-		params.cmd =  NAND_CMD_PAGE_READ_ECC;
-		/* Clear the CW per page bits */
-		params.cfg0 = cfg0_raw & ~(7U << NAND_DEV0_CFG0_CW_PER_PAGE_SHIFT);
-		params.cfg1 = cfg1_raw;
-		/* addr0 - Write column addr + few bits in row addr upto 32 bits. */
-		params.addr0 = (page << 16) | (USER_DATA_BYTES_PER_CW * cwperpage);
-
-		/* addr1 - Write rest of row addr.
-		 * This will be all 0s.
-		 */
-		params.addr1 = (page >> 16) & 0xff;
-		params.addr_loc_0 = NAND_RD_LOC_OFFSET(0);
-		params.addr_loc_0 |= NAND_RD_LOC_LAST_BIT(1);
-		params.addr_loc_0 |= NAND_RD_LOC_SIZE(4); /* Read 4 bytes */
-		params.ecc_cfg = ecc_bch_cfg | 0x1; /* Disable ECC */
-		params.exec = 1;
-
-		if (qpic_nand_block_isbad_exec(&params, bad_block))
-		{
-			dprintf(CRITICAL,
-					"Could not read bad block value\n");
-			return NANDC_RESULT_FAILURE;
-		}
+		dprintf(CRITICAL,
+				"Could not read bad block value\n");
+		return NANDC_RESULT_FAILURE;
+	}
 
-		if (flash.widebus)
-		{
-			if (bad_block[0] != 0xFF && bad_block[1] != 0xFF)
-			{
-				bbtbl[blk] = NAND_BAD_BLK_VALUE_IS_BAD;
-				nand_ret = NANDC_RESULT_BAD_BLOCK;
-			}
-		}
-		else if (bad_block[0] != 0xFF)
-		{
-			bbtbl[blk] = NAND_BAD_BLK_VALUE_IS_BAD;
+	if (flash.widebus)
+	{
+		if (bad_block[0] != 0xFF && bad_block[1] != 0xFF)
 			nand_ret = NANDC_RESULT_BAD_BLOCK;
-		}
-		else
-			bbtbl[blk] = NAND_BAD_BLK_VALUE_IS_GOOD;
-
-		return nand_ret;
 	}
+	else if (bad_block[0] != 0xFF)
+		nand_ret = NANDC_RESULT_BAD_BLOCK;
+
+	return nand_ret;
 }
 
 /* Function to erase a block on the nand.
@@ -1194,10 +1207,149 @@ qpic_nand_write_page(uint32_t pg_addr,
 	return nand_ret;
 }
 
+static inline bool qpic_nand_bbt_test(uint32_t blk)
+{
+	return !!(bbt_bitmap[blk >> 5] & (1U << (blk & 31)));
+}
+
+/**
+ * qpic_nand_block_isbad() - Checks is given block is bad
+ * @page - number of page the block starts at
+ *
+ * Looks the block up in the bad block table once it is built, only
+ * probing the flash while the table is not available.
+ *
+ * Returns nand_result_t
+ */
+nand_result_t qpic_nand_block_isbad(unsigned page)
+{
+	uint32_t blk = page / flash.num_pages_per_blk;
+
+	if (bbt_ready && blk < flash.num_blocks)
+		return qpic_nand_bbt_test(blk) ? NANDC_RESULT_BAD_BLOCK : NANDC_RESULT_SUCCESS;
+
+	return qpic_nand_block_isbad_probe(page);
+}
+
+/* Recompute the good block rank/index arrays from the bitmap. */
+static void qpic_nand_bbt_rebuild_index()
+{
+	uint32_t blk;
+	uint32_t good = 0;
+
+	for (blk = 0; blk < flash.num_blocks; blk++)
+	{
+		bbt_rank[blk] = good;
+		if (!qpic_nand_bbt_test(blk))
+			bbt_good[good++] = blk;
+	}
+	bbt_rank[flash.num_blocks] = good;
+}
+
+/* Probe the bad block marker of every block on the device. A marker that
+ * cannot be read counts as bad for this boot.
+ */
+static void qpic_nand_bbt_scan()
+{
+	uint32_t blk;
+
+	for (blk = 0; blk < flash.num_blocks; blk++)
+	{
+		if (qpic_nand_block_isbad_probe(blk * flash.num_pages_per_blk) != NANDC_RESULT_SUCCESS)
+			bbt_bitmap[blk >> 5] |= 1U << (blk & 31);
+	}
+}
+
+/* Record a newly grown bad block in the table. */
+static void qpic_nand_bbt_mark(uint32_t blk)
+{
+	if (!bbt_ready || blk >= flash.num_blocks || qpic_nand_bbt_test(blk))
+		return;
+
+	bbt_bitmap[blk >> 5] |= 1U << (blk & 31);
+	qpic_nand_bbt_rebuild_index();
+}
+
+/* Build the bad block table at init, so the read/write/erase paths never
+ * have to go to the flash to check a bad block marker.
+ *
+ * The scan is one 4 byte raw read per block, i.e. about one array read
+ * (tR, 25us on the supported parts) plus the BAM round trip each: 2048 to
+ * 4096 blocks on the parts in supported_flash[]. Probing lazily does not
+ * save most of that, the logical to physical mapping of a partition has
+ * to know every block below the one asked for, so the boot and recovery
+ * reads and any fastboot erase/flash walk whole partitions anyway. Doing
+ * it once also leaves a single place where a marker read can fail.
+ */
+static void qpic_nand_bbt_init()
+{
+	uint32_t words = (flash.num_blocks + 31) / 32;
+	time_t start = current_time();
+
+	bbt_bitmap = (uint32_t *) malloc(words * sizeof(uint32_t));
+	bbt_rank = (uint32_t *) malloc((flash.num_blocks + 1) * sizeof(uint32_t));
+	bbt_good = (uint32_t *) malloc(flash.num_blocks * sizeof(uint32_t));
+
+	if (bbt_bitmap == NULL || bbt_rank == NULL || bbt_good == NULL)
+	{
+		dprintf(CRITICAL, "Failed to allocate memory for bad block table\n");
+		return;
+	}
+
+	memset(bbt_bitmap, 0, words * sizeof(uint32_t));
+
+	qpic_nand_bbt_scan();
+	qpic_nand_bbt_rebuild_index();
+	bbt_ready = true;
+
+	dprintf(INFO, "NAND: %u of %u blocks good, scanned in %u ms\n",
+			bbt_rank[flash.num_blocks], flash.num_blocks,
+			(unsigned) (current_time() - start));
+}
+
+/**
+ * qpic_nand_bbt_map() - Translates a logical block to a physical block
+ * @start_blk: first physical block of the range, e.g. a partition
+ * @num_blks: number of physical blocks in the range
+ * @lblk: logical block, counting only the good blocks from @start_blk
+ *
+ * Returns the physical block or QPIC_NAND_INVALID_BLOCK if the range does
+ * not hold that many good blocks.
+ */
+uint32_t qpic_nand_bbt_map(uint32_t start_blk, uint32_t num_blks, uint32_t lblk)
+{
+	uint32_t end_blk = start_blk + num_blks;
+	uint32_t blk;
+
+	if (end_blk > flash.num_blocks || end_blk < start_blk)
+		end_blk = flash.num_blocks;
+
+	if (start_blk >= end_blk)
+		return QPIC_NAND_INVALID_BLOCK;
+
+	if (bbt_ready)
+	{
+		if (lblk >= bbt_rank[end_blk] - bbt_rank[start_blk])
+			return QPIC_NAND_INVALID_BLOCK;
+		return bbt_good[bbt_rank[start_blk] + lblk];
+	}
+
+	for (blk = start_blk; blk < end_blk; blk++)
+	{
+		if (qpic_nand_block_isbad(blk * flash.num_pages_per_blk))
+			continue;
+		if (!lblk--)
+			return blk;
+	}
+
+	return QPIC_NAND_INVALID_BLOCK;
+}
+
 static int
 qpic_nand_mark_badblock(uint32_t page)
 {
 	char empty_buf[NAND_CW_SIZE_8_BIT_ECC];
+	int ret;
 
 	memset(empty_buf, 0, NAND_CW_SIZE_8_BIT_ECC);
 
@@ -1205,7 +1357,12 @@ qpic_nand_mark_badblock(uint32_t page)
 	if (page & flash.num_pages_per_blk_mask)
 		page = page - (page & flash.num_pages_per_blk_mask);
 
-	return qpic_nand_write_page(page, NAND_CFG_RAW, empty_buf, 0);
+	ret = qpic_nand_write_page(page, NAND_CFG_RAW, empty_buf, 0);
+
+	/* Keep the table in sync even if the marker could not be written */
+	qpic_nand_bbt_mark(page / flash.num_pages_per_blk);
+
+	return ret;
 }
 
 static void
@@ -1283,8 +1440,6 @@ qpic_nand_non_onfi_probe(struct flash_info *flash)
 void
 qpic_nand_init(struct qpic_nand_init_config *config)
 {
-	uint32_t i;
-
 	nand_base = config->nand_base;
 
 	qpic_bam_init(config);
@@ -1302,18 +1457,6 @@ qpic_nand_init(struct qpic_nand_init_config *config)
 		return;
 	}
 
-	/* Create a bad block table */
-	bbtbl = (uint8_t *) malloc(sizeof(uint8_t) * flash.num_blocks);
-
-	if (bbtbl == NULL)
-	{
-		dprintf(CRITICAL, "Failed to allocate memory for bad block table\n");
-		return;
-	}
-
-	for (i = 0; i < flash.num_blocks; i++)
-		bbtbl[i] = NAND_BAD_BLK_VALUE_NOT_READ;
-
 	/* Set aside contiguous memory for reads/writes.
 	 * This is needed as the BAM transfers only work with
 	 * physically contiguous buffers.
@@ -1328,6 +1471,8 @@ qpic_nand_init(struct qpic_nand_init_config *config)
 		return;
 	}
 
+	/* Create the bad block table */
+	qpic_nand_bbt_init();
 }
 
 unsigned
@@ -1375,23 +1520,28 @@ flash_set_ptable(struct ptable *new_ptable)
 	flash_ptable = new_ptable;
 }
 
-/* Note: No support for raw reads. */
-static int
-qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* spareaddr)
+/* Queue the command and data descriptors to read one page into buffer.
+ * The descriptors are handed to the BAM as they are added, so the
+ * controller can start on this page while the rest of the batch is still
+ * being queued. Returns the next free command element.
+ */
+static struct cmd_element *
+qpic_nand_add_read_page_desc(uint32_t page,
+							 unsigned char *buffer,
+							 unsigned char *spareaddr,
+							 struct cmd_element *cmd_list_ptr,
+							 struct qpic_nand_rd_sts *sts,
+							 uint8_t lock_flags,
+							 bool last)
 {
 	struct cfg_params params;
 	uint32_t ecc;
-	uint32_t flash_sts[QPIC_NAND_MAX_CWS_IN_PAGE];
-	uint32_t buffer_sts[QPIC_NAND_MAX_CWS_IN_PAGE];
 	uint32_t addr_loc_0;
 	uint32_t addr_loc_1;
-	struct cmd_element *cmd_list_ptr = ce_array;
-	struct cmd_element *cmd_list_ptr_start = ce_array;
+	struct cmd_element *cmd_list_ptr_start = cmd_list_ptr;
 	uint32_t num_cmd_desc = 0;
 	uint32_t num_data_desc = 0;
-	uint32_t status;
 	uint32_t i;
-	int nand_ret = NANDC_RESULT_SUCCESS;
 	uint8_t flags = 0;
 	uint32_t *cmd_list_temp = NULL;
 
@@ -1419,20 +1569,28 @@ qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* sparead
 	addr_loc_1 |= NAND_RD_LOC_SIZE(oob_bytes);
 	addr_loc_1 |= NAND_RD_LOC_LAST_BIT(1);
 
-	status = qpic_nand_block_isbad(page);
-
-	if (status)
-		return status;
-
 	/* Reset and Configure erased CW/page detection controller */
-	qpic_nand_erased_status_reset(ce_array, BAM_DESC_LOCK_FLAG);
+	bam_add_cmd_element(cmd_list_ptr, NAND_ERASED_CW_DETECT_CFG,
+						NAND_ERASED_CW_DETECT_CFG_RESET_CTRL, CE_WRITE_TYPE);
+	cmd_list_ptr++;
+	bam_add_cmd_element(cmd_list_ptr, NAND_ERASED_CW_DETECT_CFG,
+						NAND_ERASED_CW_DETECT_CFG_ACTIVATE_CTRL | NAND_ERASED_CW_DETECT_ERASED_CW_ECC_MASK,
+						CE_WRITE_TYPE);
+	cmd_list_ptr++;
+
+	bam_add_one_desc(&bam,
+					 CMD_PIPE_INDEX,
+					 (unsigned char*)cmd_list_ptr_start,
+					 PA((uint32_t)cmd_list_ptr - (uint32_t)cmd_list_ptr_start),
+					 BAM_DESC_CMD_FLAG | lock_flags);
+	bam_sys_gen_event(&bam, CMD_PIPE_INDEX, 1);
 
-	/* Queue up the command and data descriptors for all the codewords in a page
-	 * and do a single bam transfer at the end.*/
+	/* Queue up the command and data descriptors for all the codewords in a page */
 	for (i = 0; i < flash.cws_per_page; i++)
 	{
 		num_cmd_desc = 0;
 		num_data_desc = 0;
+		cmd_list_ptr_start = cmd_list_ptr;
 
 		if (i == 0)
 		{
@@ -1441,8 +1599,6 @@ qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* sparead
 			bam_add_cmd_element(cmd_list_ptr, NAND_DEV0_ECC_CFG,(uint32_t)ecc, CE_WRITE_TYPE);
 			cmd_list_ptr++;
 		}
-		else
-			cmd_list_ptr_start = cmd_list_ptr;
 
 		bam_add_cmd_element(cmd_list_ptr, NAND_FLASH_CMD, (uint32_t)params.cmd, CE_WRITE_TYPE);
 		cmd_list_ptr++;
@@ -1465,11 +1621,12 @@ qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* sparead
 							 0);
 			num_data_desc++;
 
+			/* Interrupt only once the whole batch has landed */
 			bam_add_one_desc(&bam,
 							 DATA_PRODUCER_PIPE_INDEX,
 							 (unsigned char *)PA((addr_t)spareaddr),
 							 oob_bytes,
-							 BAM_DESC_INT_FLAG);
+							 last ? BAM_DESC_INT_FLAG : 0);
 			num_data_desc++;
 
 			bam_sys_gen_event(&bam, DATA_PRODUCER_PIPE_INDEX, num_data_desc);
@@ -1507,18 +1664,26 @@ qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* sparead
 					 BAM_DESC_NWD_FLAG | BAM_DESC_CMD_FLAG);
 		num_cmd_desc++;
 
-		bam_add_cmd_element(cmd_list_ptr, NAND_FLASH_STATUS, (uint32_t)PA((addr_t)&(flash_sts[i])), CE_READ_TYPE);
+		bam_add_cmd_element(cmd_list_ptr, NAND_FLASH_STATUS, (uint32_t)PA((addr_t)&(sts->flash_sts[i])), CE_READ_TYPE);
 
 		cmd_list_temp = (uint32_t *)cmd_list_ptr;
 
 		cmd_list_ptr++;
 
-		bam_add_cmd_element(cmd_list_ptr, NAND_BUFFER_STATUS, (uint32_t)PA((addr_t)&(buffer_sts[i])), CE_READ_TYPE);
+		bam_add_cmd_element(cmd_list_ptr, NAND_BUFFER_STATUS, (uint32_t)PA((addr_t)&(sts->buffer_sts[i])), CE_READ_TYPE);
 		cmd_list_ptr++;
 
 		if (i == flash.cws_per_page - 1)
 		{
-			flags = BAM_DESC_CMD_FLAG | BAM_DESC_UNLOCK_FLAG;
+			/* The erased page status is only valid until the next page
+			 * read resets it, so capture it along with the last CW.
+			 */
+			bam_add_cmd_element(cmd_list_ptr, NAND_ERASED_CW_DETECT_STATUS, (uint32_t)PA((addr_t)&(sts->erased_sts)), CE_READ_TYPE);
+			cmd_list_ptr++;
+
+			flags = BAM_DESC_CMD_FLAG;
+			if (last)
+				flags |= BAM_DESC_UNLOCK_FLAG;
 		}
 		else
 			flags = BAM_DESC_CMD_FLAG;
@@ -1537,21 +1702,143 @@ qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* sparead
 		bam_sys_gen_event(&bam, CMD_PIPE_INDEX, num_cmd_desc);
 	}
 
-	qpic_nand_wait_for_data(DATA_PRODUCER_PIPE_INDEX);
+	return cmd_list_ptr;
+}
+
+/* Check the status words captured for one page read. */
+static nand_result_t
+qpic_nand_check_read_status(uint32_t page, struct qpic_nand_rd_sts *sts)
+{
+	uint32_t status;
+	uint32_t i;
 
-	/* Check status */
-	for (i = 0; i < flash.cws_per_page ; i ++)
+	for (i = 0; i < flash.cws_per_page; i++)
 	{
-		flash_sts[i] = qpic_nand_check_status(flash_sts[i]);
-		if (flash_sts[i])
+		status = sts->flash_sts[i];
+
+		/* ECC error flagged on an erased page read is not an error. */
+		if ((status & NAND_FLASH_OP_ERR) &&
+			(sts->erased_sts & (1 << NAND_ERASED_CW_DETECT_STATUS_PAGE_ALL_ERASED)))
+			status &= ~NAND_FLASH_OP_ERR;
+
+		if (status & NAND_FLASH_ERR)
 		{
-			nand_ret = NANDC_RESULT_BAD_PAGE;
-			dprintf(CRITICAL, "NAND page read failed. page: %x status %x\n", page, flash_sts[i]);
-			goto qpic_nand_read_page_error;
+			dprintf(CRITICAL, "NAND page read failed. page: %x status %x\n", page, status);
+			return NANDC_RESULT_BAD_PAGE;
 		}
 	}
-qpic_nand_read_page_error:
-return nand_ret;
+
+	return NANDC_RESULT_SUCCESS;
+}
+
+/**
+ * qpic_nand_read_pages() - Reads consecutive pages
+ * @page: first page to read
+ * @num_pages: number of pages to read
+ * @buffer: buffer for num_pages * page_size bytes of data
+ * @spareaddr: buffer for the spare bytes of each page, overwritten page
+ *             after page. If null, spare data is discarded.
+ * @num_read: number of pages read successfully
+ *
+ * Up to rd_batch_pages pages are queued on the BAM pipes at once and the
+ * data is transferred straight into @buffer, with a single wait per batch.
+ * Stops at the first page that fails or belongs to a bad block.
+ *
+ * Returns nand_result_t
+ */
+static nand_result_t
+qpic_nand_read_pages(uint32_t page, uint32_t num_pages, unsigned char *buffer,
+					 unsigned char *spareaddr, uint32_t *num_read)
+{
+	struct cmd_element *cmd_list_ptr;
+	nand_result_t isbad = NANDC_RESULT_SUCCESS;
+	nand_result_t ret;
+	uint32_t batch;
+	uint32_t i;
+
+	*num_read = 0;
+
+	if (!spareaddr)
+		spareaddr = flash_spare_bytes;
+
+	while (num_pages)
+	{
+		batch = MIN(num_pages, rd_batch_pages);
+
+		/* Only queue the pages up to the first bad block */
+		for (i = 0; i < batch; i++)
+		{
+			isbad = qpic_nand_block_isbad(page + i);
+			if (isbad)
+				break;
+		}
+		batch = i;
+
+		if (batch)
+		{
+			arch_clean_invalidate_cache_range((addr_t) buffer, batch * flash.page_size);
+			arch_clean_invalidate_cache_range((addr_t) rd_sts, batch * sizeof(rd_sts[0]));
+
+			cmd_list_ptr = ce_rd_array;
+			for (i = 0; i < batch; i++)
+				cmd_list_ptr = qpic_nand_add_read_page_desc(page + i,
+															buffer + i * flash.page_size,
+															spareaddr,
+															cmd_list_ptr,
+															&rd_sts[i],
+															i ? 0 : BAM_DESC_LOCK_FLAG,
+															i == batch - 1);
+
+			qpic_nand_wait_for_data(DATA_PRODUCER_PIPE_INDEX);
+
+			arch_invalidate_cache_range((addr_t) buffer, batch * flash.page_size);
+			arch_invalidate_cache_range((addr_t) rd_sts, batch * sizeof(rd_sts[0]));
+
+			for (i = 0; i < batch; i++)
+			{
+				ret = qpic_nand_check_read_status(page + i, &rd_sts[i]);
+				if (ret)
+					return ret;
+				(*num_read)++;
+			}
+		}
+
+		if (isbad)
+			return isbad;
+
+		page += batch;
+		buffer += batch * flash.page_size;
+		num_pages -= batch;
+	}
+
+	return NANDC_RESULT_SUCCESS;
+}
+
+/**
+ * qpic_nand_set_read_batch() - Sets the number of pages queued per BAM transfer
+ * @pages: 1 reads page by page, up to QPIC_NAND_READ_BATCH_PAGES
+ *
+ * Returns the batch size in use.
+ */
+uint32_t qpic_nand_set_read_batch(uint32_t pages)
+{
+	if (pages < 1)
+		pages = 1;
+	else if (pages > QPIC_NAND_READ_BATCH_PAGES)
+		pages = QPIC_NAND_READ_BATCH_PAGES;
+
+	rd_batch_pages = pages;
+
+	return rd_batch_pages;
+}
+
+/* Note: No support for raw reads. */
+static int
+qpic_nand_read_page(uint32_t page, unsigned char* buffer, unsigned char* spareaddr)
+{
+	uint32_t num_read;
+
+	return qpic_nand_read_pages(page, 1, buffer, spareaddr, &num_read);
 }
 
 /**
@@ -1571,24 +1858,21 @@ return nand_ret;
 nand_result_t qpic_nand_read(uint32_t start_page, uint32_t num_pages,
 		unsigned char* buffer, unsigned char* spareaddr)
 {
-	unsigned i = 0, ret = 0;
+	uint32_t i = 0;
+	unsigned ret = 0;
 
 	if (!buffer) {
 		dprintf(CRITICAL, "qpic_nand_read: buffer = null\n");
 		return NANDC_RESULT_PARAM_INVALID;
 	}
-	while (i < num_pages) {
-		ret = qpic_nand_read_page(start_page + i, buffer + flash.page_size * i,
-				spareaddr);
-		i++;
-		if (ret == NANDC_RESULT_BAD_PAGE)
-			qpic_nand_mark_badblock(start_page + i);
-		if (ret) {
-			dprintf(CRITICAL,
-					"qpic_nand_read: reading page %d failed with %d err\n",
-					start_page + i, ret);
-			return ret;
-		}
+	ret = qpic_nand_read_pages(start_page, num_pages, buffer, spareaddr, &i);
+	if (ret == NANDC_RESULT_BAD_PAGE)
+		qpic_nand_mark_badblock(start_page + i);
+	if (ret) {
+		dprintf(CRITICAL,
+				"qpic_nand_read: reading page %d failed with %d err\n",
+				start_page + i, ret);
+		return ret;
 	}
 	return NANDC_RESULT_SUCCESS;
 }
@@ -1680,10 +1964,7 @@ flash_read_ext(struct ptentry *ptn,
 	int result = 0;
 	uint32_t current_block =
 	    (page - (page & flash.num_pages_per_blk_mask)) / flash.num_pages_per_blk;
-	uint32_t start_block = ptn->start;
-	uint32_t start_block_count = 0;
-	uint32_t isbad = 0;
-	uint32_t current_page;
+	uint32_t num_read;
 
 	/* Verify first byte is at page boundary. */
 	if (offset & (flash.page_size - 1))
@@ -1693,25 +1974,19 @@ flash_read_ext(struct ptentry *ptn,
 		return NANDC_RESULT_PARAM_INVALID;
 	}
 
-	current_page = start_block * flash.num_pages_per_blk;
 	/* Adjust page offset based on number of bad blocks from start to current page */
-	if (start_block < current_block)
+	if (ptn->start < current_block)
 	{
-		start_block_count = (current_block - start_block);
-		while (start_block_count
-			   && (start_block < (ptn->start + ptn->length)))
-		{
-			isbad = qpic_nand_block_isbad(current_page);
-			if (isbad)
-				page += flash.num_pages_per_blk;
-			else
-				start_block_count--;
-			start_block++;
-			current_page += flash.num_pages_per_blk;
-		}
+		current_block = qpic_nand_bbt_map(ptn->start, ptn->length,
+										  current_block - ptn->start);
+		if (current_block == QPIC_NAND_INVALID_BLOCK)
+			page = lastpage;
+		else
+			page = (current_block * flash.num_pages_per_blk) +
+				(page & flash.num_pages_per_blk_mask);
 	}
 
-	while ((page < lastpage) && !start_block_count)
+	while (page < lastpage)
 	{
 		if (count == 0)
 		{
@@ -1720,11 +1995,30 @@ flash_read_ext(struct ptentry *ptn,
 			return NANDC_RESULT_SUCCESS;
 		}
 
+		if (!extra_per_page)
+		{
+			/* Read straight into the image up to the end of the block */
+			num_read = MIN(count, flash.num_pages_per_blk - (page & flash.num_pages_per_blk_mask));
+			result = qpic_nand_read_pages(page, num_read, image, NULL, &num_read);
+
+			page += num_read;
+			image += num_read * flash.page_size;
+			count -= num_read;
+
+			if (result == NANDC_RESULT_SUCCESS)
+				continue;
+			if (result != NANDC_RESULT_BAD_BLOCK)
+				result = NANDC_RESULT_BAD_PAGE;
+		}
+		else
+		{
 #if CONTIGUOUS_MEMORY
-		result = qpic_nand_read_page(page, image, (unsigned char *) spare);
+			result = qpic_nand_read_page(page, image, (unsigned char *) spare);
 #else
-		result = qpic_nand_read_page(page, rdwr_buf, (unsigned char *) spare);
+			result = qpic_nand_read_page(page, rdwr_buf, (unsigned char *) spare);
 #endif
+		}
+
 		if (result == NANDC_RESULT_BAD_PAGE)
 		{
 			/* bad page, go to next page. */
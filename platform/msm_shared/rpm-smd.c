@@ -35,6 +35,8 @@
 #include <debug.h>
 #include <stdlib.h>
 #include <platform/timer.h>
+#include <kernel/mutex.h>
+#include <kernel/thread.h>
 
 #define RPM_REQ_MAGIC 0x00716572
 #define RPM_CMD_MAGIC 0x00646d63
@@ -45,9 +47,29 @@
 static uint32_t msg_id;
 smd_channel_info_t ch;
 
+/*
+ * Taken by every request and ack read, the display init thread votes for
+ * regulators while the main thread may vote for clocks. Unused before
+ * rpm_smd_init().
+ */
+static mutex_t rpm_mutex;
+
+static void rpm_lock(void)
+{
+	if (rpm_mutex.magic == MUTEX_MAGIC)
+		mutex_acquire(&rpm_mutex);
+}
+
+static void rpm_unlock(void)
+{
+	if (rpm_mutex.magic == MUTEX_MAGIC)
+		mutex_release(&rpm_mutex);
+}
+
 void rpm_smd_init()
 {
 	smd_init(&ch, SMD_APPS_RPM);
+	mutex_init(&rpm_mutex);
 }
 
 void rpm_smd_uninit()
@@ -55,33 +77,117 @@ void rpm_smd_uninit()
 	smd_uninit(&ch);
 }
 
-static void fill_kvp_object(kvp_data **kdata, uint32_t *data, uint32_t len)
+/*
+ * Requests written by rpm_send_data_nowait(), oldest first, until their
+ * sender collects the result in rpm_wait_for_acks(). The RPM acks in
+ * request order, so an ack read by any thread belongs to the oldest entry
+ * not acked yet, and those are always the last rpm_acks_pending entries.
+ */
+#define RPM_MAX_QUEUED 32
+
+struct rpm_queued
+{
+	thread_t *owner;
+	int errors;
+};
+
+static struct rpm_queued rpm_queued[RPM_MAX_QUEUED];
+static uint32_t rpm_queued_num;
+static uint32_t rpm_acks_pending;
+
+/* Read the ack of the oldest unacked request */
+static void rpm_read_ack(void)
+{
+	struct rpm_queued *q = &rpm_queued[rpm_queued_num - rpm_acks_pending];
+	uint32_t ack_msg_len;
+	uint32_t rlen = 0;
+
+	ack_msg_len = rpm_recv_data(&rlen);
+	q->errors = ack_msg_len == 1;
+
+	smd_signal_read_complete(&ch, ack_msg_len);
+	rpm_acks_pending--;
+}
+
+static void rpm_read_acks(void)
 {
-	*kdata = (kvp_data *) memalign(CACHE_LINE, ROUNDUP(len, CACHE_LINE));
-	ASSERT(*kdata);
+	while (rpm_acks_pending)
+		rpm_read_ack();
+}
+
+/* Merge the acked entries of each thread into one, to make room */
+static void rpm_fold_acked(void)
+{
+	uint32_t acked = rpm_queued_num - rpm_acks_pending;
+	uint32_t i;
+	uint32_t j;
+	uint32_t k;
 
-	memcpy(*kdata, data+2, len);
+	for (i = 0, j = 0; i < acked; i++)
+	{
+		for (k = 0; k < j; k++)
+		{
+			if (rpm_queued[k].owner == rpm_queued[i].owner)
+			{
+				rpm_queued[k].errors += rpm_queued[i].errors;
+				break;
+			}
+		}
+		if (k == j)
+			rpm_queued[j++] = rpm_queued[i];
+	}
+
+	for (i = acked; i < rpm_queued_num; i++)
+		rpm_queued[j++] = rpm_queued[i];
+
+	rpm_queued_num = j;
 }
 
-static void free_kvp_object(kvp_data **kdata)
+/*
+ * The RPM stops taking requests while its acks fill our receive fifo, so
+ * read the pending ones before waiting on a full send fifo.
+ */
+static void rpm_make_room(uint32_t len)
 {
-	if(*kdata)
-		free(*kdata);
+	if (rpm_acks_pending && !smd_write_room(&ch, len))
+		rpm_read_acks();
 }
 
-int rpm_send_data(uint32_t *data, uint32_t len, msg_type type)
+/*
+ * Queue a request without waiting for the RPM to ack it. The KVP part of
+ * the caller's pre-encoded array (key, length, value ...) goes straight into
+ * the SMD fifo behind the headers, nothing is allocated or staged.
+ * rpm_wait_for_acks() collects the acks of all queued requests.
+ */
+int rpm_send_data_nowait(uint32_t *data, uint32_t len, msg_type type)
 {
-	rpm_req req;
+	struct {
+		rpm_gen_hdr hdr;
+		rpm_req_hdr req_hdr;
+	} req;
 	rpm_cmd cmd;
-	uint32_t len_to_smd = 0;
+	/* requests have always carried this much after the KVPs */
+	static const uint32_t req_pad[(0x28 - sizeof(req)) / 4];
+	smd_iovec iov[3];
 	int ret = 0;
-	uint32_t ack_msg_len = 0;
-	uint32_t rlen = 0;
-	void *smd_data = NULL;
+
+	rpm_lock();
 
 	switch(type)
 	{
 		case RPM_REQUEST_TYPE:
+			if (rpm_queued_num == RPM_MAX_QUEUED)
+			{
+				rpm_read_acks();
+				rpm_fold_acked();
+			}
+			if (rpm_queued_num == RPM_MAX_QUEUED)
+			{
+				dprintf(CRITICAL, "%s: too many requests in flight\n", __func__);
+				ret = -1;
+				break;
+			}
+
 			req.hdr.type = RPM_REQ_MAGIC;
 			req.hdr.len = len + REQ_MSG_LENGTH;//20
 			req.req_hdr.id = ++msg_id;
@@ -90,40 +196,87 @@ int rpm_send_data(uint32_t *data, uint32_t len, msg_type type)
 			req.req_hdr.resourceId = data[RESOURCEID];
 			req.req_hdr.dataLength = len;
 
-			fill_kvp_object(&req.data, data, len);
-			len_to_smd = req.req_hdr.dataLength + 0x28;
-
-			smd_data = (void*) malloc(len_to_smd);
-			ASSERT(smd_data);
-
-			memcpy(smd_data, &req.hdr, sizeof(rpm_gen_hdr));
-			memcpy(smd_data + sizeof(rpm_gen_hdr), &req.req_hdr, sizeof(rpm_req_hdr));
-			memcpy(smd_data + sizeof(rpm_gen_hdr)+ sizeof(rpm_req_hdr), req.data, len);
+			iov[0].base = &req;
+			iov[0].len = sizeof(req);
+			iov[1].base = data + KVP_KEY;
+			iov[1].len = len;
+			iov[2].base = req_pad;
+			iov[2].len = sizeof(req_pad);
 
-			ret = smd_write(&ch, smd_data, len_to_smd, SMD_APPS_RPM);
-
-			/* Read the response */
-			ack_msg_len = rpm_recv_data(&rlen);
-
-			smd_signal_read_complete(&ch, ack_msg_len);
-
-			free(smd_data);
-			free_kvp_object(&req.data);
+			rpm_make_room(sizeof(req) + len + sizeof(req_pad));
+			ret = smd_writev(&ch, iov, 3, SMD_APPS_RPM);
+			if (!ret)
+			{
+				rpm_queued[rpm_queued_num].owner = current_thread;
+				rpm_queued[rpm_queued_num].errors = 0;
+				rpm_queued_num++;
+				rpm_acks_pending++;
+			}
 		break;
 		case RPM_CMD_TYPE:
 			cmd.hdr.type = RPM_CMD_MAGIC;
 			cmd.hdr.len = CMD_MSG_LENGTH;//0x8;
-			len_to_smd  = sizeof(rpm_cmd);
-
-			fill_kvp_object(&cmd.data, data, len);
-			ret = smd_write(&ch, (void *)&cmd, len_to_smd, SMD_APPS_RPM);
+			cmd.data = (kvp_data *)(data + KVP_KEY);
 
-			free_kvp_object(&cmd.data);
+			rpm_make_room(sizeof(rpm_cmd));
+			ret = smd_write(&ch, (void *)&cmd, sizeof(rpm_cmd), SMD_APPS_RPM);
 		break;
 		default:
 		break;
 	}
 
+	rpm_unlock();
+
+	return ret;
+}
+
+/*
+ * Read the acks of every request the calling thread queued so far,
+ * returns how many of them failed. Acks of other threads' requests read
+ * on the way are kept for their own rpm_wait_for_acks().
+ */
+int rpm_wait_for_acks(void)
+{
+	uint32_t i;
+	uint32_t j;
+	int errors = 0;
+
+	rpm_lock();
+
+	for (i = rpm_queued_num - rpm_acks_pending; i < rpm_queued_num; i++)
+	{
+		if (rpm_queued[i].owner == current_thread)
+		{
+			while (rpm_queued_num - rpm_acks_pending <= i)
+				rpm_read_ack();
+		}
+	}
+
+	for (i = 0, j = 0; i < rpm_queued_num; i++)
+	{
+		if (i < rpm_queued_num - rpm_acks_pending && rpm_queued[i].owner == current_thread)
+		{
+			errors += rpm_queued[i].errors;
+			continue;
+		}
+		rpm_queued[j++] = rpm_queued[i];
+	}
+	rpm_queued_num = j;
+
+	rpm_unlock();
+
+	return errors;
+}
+
+int rpm_send_data(uint32_t *data, uint32_t len, msg_type type)
+{
+	int ret;
+
+	ret = rpm_send_data_nowait(data, len, type);
+
+	/* Read the response */
+	rpm_wait_for_acks();
+
 	return ret;
 }
 
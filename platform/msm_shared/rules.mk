@@ -21,6 +21,10 @@ ifeq ($(ENABLE_QGIC3), 1)
 OBJS += $(LOCAL_DIR)/qgic_v3.o
 endif
 
+ifeq ($(WITH_SMP),1)
+OBJS += $(LOCAL_DIR)/mp.o
+endif
+
 ifeq ($(ENABLE_SMD_SUPPORT),1)
 OBJS += \
 	$(LOCAL_DIR)/rpm-smd.o \
@@ -155,6 +159,7 @@ endif
 
 ifeq ($(PLATFORM),msm8916)
 DEFINES += DISPLAY_TYPE_MDSS=1
+DEFINES += CRYPTO_SHA_ARMV8=1
 	OBJS += $(LOCAL_DIR)/qgic.o \
 		$(LOCAL_DIR)/qtimer.o \
 		$(LOCAL_DIR)/qtimer_mmap.o \
@@ -182,6 +187,8 @@ DEFINES += DISPLAY_TYPE_MDSS=1
 		$(LOCAL_DIR)/crypto_hash.o \
 		$(LOCAL_DIR)/crypto5_eng.o \
 		$(LOCAL_DIR)/crypto5_wrapper.o \
+		$(LOCAL_DIR)/sha_armv8.o \
+		$(LOCAL_DIR)/sha_armv8_core.o \
 		$(LOCAL_DIR)/i2c_qup.o
 
 endif
@@ -424,6 +431,7 @@ endif
 
 ifeq ($(PLATFORM),msm8994)
 DEFINES += DISPLAY_TYPE_MDSS=1
+DEFINES += CRYPTO_SHA_ARMV8=1
 	OBJS += $(LOCAL_DIR)/qgic.o \
 			$(LOCAL_DIR)/qtimer.o \
 			$(LOCAL_DIR)/qtimer_mmap.o \
@@ -451,6 +459,8 @@ DEFINES += DISPLAY_TYPE_MDSS=1
 			$(LOCAL_DIR)/crypto_hash.o \
 			$(LOCAL_DIR)/crypto5_eng.o \
 			$(LOCAL_DIR)/crypto5_wrapper.o \
+			$(LOCAL_DIR)/sha_armv8.o \
+			$(LOCAL_DIR)/sha_armv8_core.o \
 			$(LOCAL_DIR)/qusb2_phy.o \
 			$(LOCAL_DIR)/mdp5.o \
 			$(LOCAL_DIR)/display.o \
@@ -1022,3 +1022,35 @@ uint32_t scm_call2(scmcall_arg *arg, scmcall_ret *ret)
 
 	return 0;
 }
+
+/**
+ * scm_set_boot_addr() - Set the address secondary cpus start at
+ * @addr: physical entry point
+ * @cpu_flags: SCM_FLAG_COLDBOOT_CPUx bits of the cpus to point at @addr
+ *
+ * Older TZ only; the platform still has to release the cpus from reset.
+ */
+int scm_set_boot_addr(paddr_t addr, uint32_t cpu_flags)
+{
+	struct {
+		uint32_t flags;
+		uint32_t addr;
+	} cmd_buf;
+
+	cmd_buf.flags = cpu_flags;
+	cmd_buf.addr = addr;
+
+	return scm_call(SCM_SVC_BOOT, SCM_BOOT_ADDR, &cmd_buf, sizeof(cmd_buf), NULL, 0);
+}
+
+/**
+ * psci_cpu_on() - Power up a cpu through the PSCI interface of TZ
+ * @mpidr: affinity of the cpu to start
+ * @entry: physical entry point
+ *
+ * Returns 0 on success, a negative PSCI error code otherwise.
+ */
+int psci_cpu_on(uint32_t mpidr, paddr_t entry)
+{
+	return scm_call_a32(PSCI_0_2_FN_CPU_ON, mpidr, entry, 0, 0, 0, NULL);
+}
@@ -31,6 +31,8 @@
 #include <platform/interrupts.h>
 #include <platform/timer.h>
 #include <kernel/event.h>
+#include <kernel/thread.h>
+#include <platform.h>
 #include <target.h>
 #include <string.h>
 #include <stdlib.h>
@@ -138,6 +140,59 @@ static void sdhci_error_status_enable(struct sdhci_host *host)
 	REG_WRITE16(host, SDHCI_ERR_INT_SIG_EN, SDHCI_ERR_INT_SIG_EN_REG);
 }
 
+#if SDHCI_IRQ_COMPLETION
+/*
+ * Function: sdhci hc int handler
+ * Arg     : Host structure
+ * Return  : INT_RESCHEDULE
+ * Flow:   : 1. Mask the interrupt signals so the level irq drops
+ *           2. Wake up the waiter, which reads & clears the status itself
+ */
+static enum handler_return sdhci_hc_int_handler(void *arg)
+{
+	struct sdhci_host *host = (struct sdhci_host *) arg;
+
+	REG_WRITE16(host, 0, SDHCI_NRML_INT_SIG_EN_REG);
+	REG_WRITE16(host, 0, SDHCI_ERR_INT_SIG_EN_REG);
+
+	event_signal(&host->int_event, false);
+
+	return INT_RESCHEDULE;
+}
+#endif
+
+/*
+ * Function: sdhci wait int
+ * Arg     : Host structure, retry count in usec
+ * Return  : None
+ * Flow:   : If the host irq is available & we are allowed to block, unmask
+ *           the signals & sleep until the controller raises an interrupt.
+ *           Otherwise fall back to a 1 usec busy wait.
+ */
+static void sdhci_wait_int(struct sdhci_host *host, uint64_t *retry)
+{
+#if SDHCI_IRQ_COMPLETION
+	time_t start;
+	time_t elapsed;
+
+	if (host->hc_irq && !in_critical_section())
+	{
+		start = current_time();
+
+		REG_WRITE16(host, SDHCI_NRML_INT_SIG_EN, SDHCI_NRML_INT_SIG_EN_REG);
+		REG_WRITE16(host, SDHCI_ERR_INT_SIG_EN, SDHCI_ERR_INT_SIG_EN_REG);
+
+		event_wait_timeout(&host->int_event, SDHCI_INT_WAIT_MS);
+
+		elapsed = current_time() - start;
+		*retry += elapsed ? (uint64_t) elapsed * 1000 : 1;
+		return;
+	}
+#endif
+	udelay(1);
+	(*retry)++;
+}
+
 /*
  * Function: sdhci clock supply
  * Arg     : Host structure
@@ -458,9 +513,8 @@ static uint8_t sdhci_cmd_complete(struct sdhci_host *host, struct mmc_command *c
 			}
 		}
 
-		retry++;
-		udelay(1);
-		if (retry == SDHCI_MAX_CMD_RETRY) {
+		sdhci_wait_int(host, &retry);
+		if (retry >= SDHCI_MAX_CMD_RETRY) {
 			dprintf(CRITICAL, "Error: Command never completed\n");
 			ret = 1;
 			goto err;
@@ -521,9 +575,8 @@ static uint8_t sdhci_cmd_complete(struct sdhci_host *host, struct mmc_command *c
 				}
 			}
 
-			retry++;
-			udelay(1);
-			if (retry == max_trans_retry) {
+			sdhci_wait_int(host, &retry);
+			if (retry >= max_trans_retry) {
 				dprintf(CRITICAL, "Error: Transfer never completed\n");
 				ret = 1;
 				goto err;
@@ -576,115 +629,169 @@ err:
 }
 
 /*
- * Function: sdhci prep desc table
- * Arg     : Pointer data & length
- * Return  : Pointer to desc table
- * Flow:   : Prepare the adma table as per the sd spec v 3.0
+ * Function: sdhci adma table
+ * Arg     : Host structure & index of the table in the chain
+ * Return  : Pointer to the table, NULL if the pool is exhausted
+ * Flow:   : Descriptor tables are allocated on first use & kept for the
+ *           life of the host, so steady state transfers never hit the heap
  */
-static struct desc_entry *sdhci_prep_desc_table(void *data, uint32_t len)
+static struct desc_entry *sdhci_adma_table(struct sdhci_host *host, uint32_t idx)
 {
-	struct desc_entry *sg_list;
-	uint32_t sg_len = 0;
-	uint32_t remain = 0;
-	uint32_t i;
-	uint32_t table_len = 0;
+	if (idx < host->adma_tables)
+		return host->adma_table[idx];
 
-	if (len <= SDHCI_ADMA_DESC_LINE_SZ) {
-		/* Allocate only one descriptor */
-		sg_list = (struct desc_entry *) memalign(lcm(4, CACHE_LINE), ROUNDUP(sizeof(struct desc_entry), CACHE_LINE));
-
-		if (!sg_list) {
-			dprintf(CRITICAL, "Error allocating memory\n");
-			ASSERT(0);
-		}
+	if (idx >= SDHCI_ADMA_MAX_TABLES) {
+		dprintf(CRITICAL, "Error: Transfer needs more than %u adma tables\n", SDHCI_ADMA_MAX_TABLES);
+		return NULL;
+	}
 
-		sg_list[0].addr = (uint32_t)data;
-		sg_list[0].len = (len < SDHCI_ADMA_DESC_LINE_SZ) ? len : (SDHCI_ADMA_DESC_LINE_SZ & 0xffff);
-		sg_list[0].tran_att = SDHCI_ADMA_TRANS_VALID | SDHCI_ADMA_TRANS_DATA
-							  | SDHCI_ADMA_TRANS_END;
+	host->adma_table[idx] = (struct desc_entry *) memalign(lcm(4, CACHE_LINE), SDHCI_ADMA_TABLE_SZ);
+	if (!host->adma_table[idx]) {
+		dprintf(CRITICAL, "Error allocating memory\n");
+		return NULL;
+	}
 
-		sg_len = 1;
-		table_len = sizeof(struct desc_entry);
-	} else {
-		/* Calculate the number of entries in desc table */
-		sg_len = len / SDHCI_ADMA_DESC_LINE_SZ;
-		remain = len - (sg_len * SDHCI_ADMA_DESC_LINE_SZ);
+	host->adma_tables++;
 
-		/* Allocate sg_len + 1 entries if there are remaining bytes at the end */
-		if (remain)
-			sg_len++;
+	return host->adma_table[idx];
+}
 
-		table_len = (sg_len * sizeof(struct desc_entry));
+/*
+ * Function: sdhci prep desc table
+ * Arg     : Host structure, data, length & bytes moved by one command
+ * Return  : 0 on Success, 1 on Failure
+ * Flow:   : Prepare the adma table as per the sd spec v 3.0.
+ *           Each data segment (the buffer, or every entry of the sg list)
+ *           is split into SDHCI_ADMA_DESC_LINE_SZ lines. When a table fills
+ *           up its last entry links to the next table in the pool.
+ *           Every cmd_len bytes the line is cut & marked as end, the next
+ *           line starts the next command in host->adma_cmd_start.
+ */
+static uint8_t sdhci_prep_desc_table(struct sdhci_host *host, struct mmc_data *data,
+									 uint32_t len, uint32_t cmd_len)
+{
+	struct desc_entry *table;
+	struct desc_entry *next;
+	struct mmc_sg single;
+	struct mmc_sg *sg;
+	uint32_t sg_cnt;
+	uint32_t total = 0;
+	uint32_t table_idx = 0;
+	uint32_t idx = 0;
+	uint32_t cmd_left = 0;
+	uint32_t cmds = 0;
+	uint32_t remain;
+	uint32_t chunk;
+	uint32_t addr;
+	uint32_t i;
 
-		sg_list = (struct desc_entry *) memalign(lcm(4, CACHE_LINE), ROUNDUP(table_len, CACHE_LINE));
+	if (data->sg) {
+		sg = data->sg;
+		sg_cnt = data->sg_cnt;
+	} else {
+		single.addr = data->data_ptr;
+		single.len = len;
+		sg = &single;
+		sg_cnt = 1;
+	}
 
-		if (!sg_list) {
-			dprintf(CRITICAL, "Error allocating memory\n");
-			ASSERT(0);
-		}
+	table = sdhci_adma_table(host, 0);
+	if (!table)
+		return 1;
 
-		memset((void *) sg_list, 0, table_len);
+	/*
+	 * Prepare sglist in the format:
+	 *  ___________________________________________________
+	 * |Transfer Len | Transfer ATTR | Data Address        |
+	 * | (16 bit)    | (16 bit)      | (32 bit)            |
+	 * |_____________|_______________|_____________________|
+	 */
+	for (i = 0; i < sg_cnt; i++) {
+		addr = (uint32_t) sg[i].addr;
+		remain = sg[i].len;
+		total += remain;
+
+		while (remain) {
+			/* Last entry of a table is reserved for the link */
+			if (idx == SDHCI_ADMA_TABLE_ENTRIES - 1) {
+				next = sdhci_adma_table(host, table_idx + 1);
+				if (!next)
+					return 1;
+
+				table[idx].addr = (uint32_t) next;
+				table[idx].len = 0;
+				table[idx].tran_att = SDHCI_ADMA_TRANS_VALID | SDHCI_ADMA_TRANS_LINK;
+				arch_clean_invalidate_cache_range((addr_t) table, SDHCI_ADMA_TABLE_SZ);
+
+				table = next;
+				table_idx++;
+				idx = 0;
+			}
 
-		/*
-		 * Prepare sglist in the format:
-		 *  ___________________________________________________
-		 * |Transfer Len | Transfer ATTR | Data Address        |
-		 * | (16 bit)    | (16 bit)      | (32 bit)            |
-		 * |_____________|_______________|_____________________|
-		 */
-		for (i = 0; i < (sg_len - 1); i++) {
-				sg_list[i].addr = (uint32_t)data;
-				/*
-				 * Length attribute is 16 bit value & max transfer size for one
-				 * descriptor line is 65536 bytes, As per SD Spec3.0 'len = 0'
-				 * implies 65536 bytes. Truncate the length to limit to 16 bit
-				 * range.
-				 */
-				sg_list[i].len = (SDHCI_ADMA_DESC_LINE_SZ & 0xffff);
-				sg_list[i].tran_att = SDHCI_ADMA_TRANS_VALID | SDHCI_ADMA_TRANS_DATA;
-				data += SDHCI_ADMA_DESC_LINE_SZ;
-				len -= SDHCI_ADMA_DESC_LINE_SZ;
+			if (!cmd_left) {
+				if (cmds == SDHCI_ADMA_MAX_CMDS) {
+					dprintf(CRITICAL, "Error: Transfer needs more than %u commands\n", SDHCI_ADMA_MAX_CMDS);
+					return 1;
+				}
+				host->adma_cmd_start[cmds++] = &table[idx];
+				cmd_left = cmd_len;
 			}
 
-			/* Fill the last entry of the table with Valid & End
-			 * attributes
+			/*
+			 * Length attribute is 16 bit value & max transfer size for one
+			 * descriptor line is 65536 bytes, As per SD Spec3.0 'len = 0'
+			 * implies 65536 bytes. Truncate the length to limit to 16 bit
+			 * range.
 			 */
-			sg_list[sg_len - 1].addr = (uint32_t)data;
-			sg_list[sg_len - 1].len = (len < SDHCI_ADMA_DESC_LINE_SZ) ? len : (SDHCI_ADMA_DESC_LINE_SZ & 0xffff);
-			sg_list[sg_len - 1].tran_att = SDHCI_ADMA_TRANS_VALID | SDHCI_ADMA_TRANS_DATA |
-										   SDHCI_ADMA_TRANS_END;
-		}
+			chunk = MIN(remain, SDHCI_ADMA_DESC_LINE_SZ);
+			chunk = MIN(chunk, cmd_left);
 
-	arch_clean_invalidate_cache_range((addr_t)sg_list, table_len);
+			table[idx].addr = addr;
+			table[idx].len = (chunk & 0xffff);
+			table[idx].tran_att = SDHCI_ADMA_TRANS_VALID | SDHCI_ADMA_TRANS_DATA;
 
-	for (i = 0; i < sg_len; i++)
-	{
-		DBG("\n %s: sg_list: addr: 0x%08x len: 0x%04x attr: 0x%04x\n", __func__, sg_list[i].addr,
-			(sg_list[i].len ? sg_list[i].len : SDHCI_ADMA_DESC_LINE_SZ), sg_list[i].tran_att);
+			cmd_left -= chunk;
+			if (!cmd_left)
+				table[idx].tran_att |= SDHCI_ADMA_TRANS_END;
+
+			DBG("\n %s: sg_list: addr: 0x%08x len: 0x%04x attr: 0x%04x\n", __func__, table[idx].addr,
+				chunk, table[idx].tran_att);
+
+			addr += chunk;
+			remain -= chunk;
+			idx++;
+		}
+	}
+
+	if (!idx || total != len) {
+		dprintf(CRITICAL, "Error: sg list covers %u bytes, transfer is %u bytes\n", total, len);
+		return 1;
 	}
 
-	return sg_list;
+	/* Fill the last entry of the table with Valid & End attributes */
+	table[idx - 1].tran_att |= SDHCI_ADMA_TRANS_END;
+
+	arch_clean_invalidate_cache_range((addr_t) table, idx * sizeof(struct desc_entry));
+
+	return 0;
 }
 
 /*
  * Function: sdhci adma transfer
  * Arg     : Host structure & command stucture
- * Return  : Pointer to desc table
+ * Return  : 0 on Success, 1 on Failure
  * Flow    : 1. Prepare descriptor table
  *           2. Write adma register
  *           3. Write block size & block count register
  */
-static struct desc_entry *sdhci_adma_transfer(struct sdhci_host *host,
-											  struct mmc_command *cmd)
+static uint8_t sdhci_adma_transfer(struct sdhci_host *host,
+								   struct mmc_command *cmd)
 {
 	uint32_t num_blks = 0;
+	uint32_t blk_sz;
 	uint32_t sz;
-	void *data;
-	struct desc_entry *adma_addr;
-
 
 	num_blks = cmd->data.num_blocks;
-	data = cmd->data.data_ptr;
 
 	/*
 	 * Some commands send data on DAT lines which is less
@@ -695,28 +802,55 @@ static struct desc_entry *sdhci_adma_transfer(struct sdhci_host *host,
 	 * passed use the default value
 	 */
 	if (cmd->data.blk_sz)
-		sz = num_blks * cmd->data.blk_sz;
+		blk_sz = cmd->data.blk_sz;
 	else
-		sz = num_blks * SDHCI_MMC_BLK_SZ;
+		blk_sz = SDHCI_MMC_BLK_SZ;
 
-	/* Prepare adma descriptor table */
-	adma_addr = sdhci_prep_desc_table(data, sz);
+	sz = num_blks * blk_sz;
+
+	/* Prepare adma descriptor table, cut into commands of SDHCI_MAX_BLK_CNT blocks */
+	if (sdhci_prep_desc_table(host, &cmd->data, sz, SDHCI_MAX_BLK_CNT * blk_sz))
+		return 1;
 
 	/* Write adma address to adma register */
-	REG_WRITE32(host, (uint32_t) adma_addr, SDHCI_ADM_ADDR_REG);
+	REG_WRITE32(host, (uint32_t) host->adma_cmd_start[0], SDHCI_ADM_ADDR_REG);
 
 	/* Write the block size */
-	if (cmd->data.blk_sz)
-		REG_WRITE16(host, cmd->data.blk_sz, SDHCI_BLKSZ_REG);
-	else
-		REG_WRITE16(host, SDHCI_MMC_BLK_SZ, SDHCI_BLKSZ_REG);
+	REG_WRITE16(host, blk_sz, SDHCI_BLKSZ_REG);
 
-	/*
-	 * Set block count in block count register
-	 */
-	REG_WRITE16(host, num_blks, SDHCI_BLK_CNT_REG);
+	/* Set block count in block count register, for the first command */
+	REG_WRITE16(host, MIN(num_blks, SDHCI_MAX_BLK_CNT), SDHCI_BLK_CNT_REG);
 
-	return adma_addr;
+	return 0;
+}
+
+/*
+ * Function: sdhci wait lines free
+ * Arg     : Host structure
+ * Return  : 0 on Success, 1 on Failure
+ * Flow    : Wait for the CMD & DAT lines to be released
+ */
+static uint8_t sdhci_wait_lines_free(struct sdhci_host *host)
+{
+	uint8_t retry = 0;
+	uint32_t present_state;
+
+	do {
+		present_state = REG_READ32(host, SDHCI_PRESENT_STATE_REG);
+		/* check if CMD & DAT lines are free */
+		present_state &= SDHCI_STATE_CMD_DAT_MASK;
+
+		if (!present_state)
+			break;
+		udelay(1000);
+		retry++;
+		if (retry == 10) {
+			dprintf(CRITICAL, "Error: CMD or DAT lines were never freed\n");
+			return 1;
+		}
+	} while(1);
+
+	return 0;
 }
 
 /*
@@ -731,18 +865,22 @@ static struct desc_entry *sdhci_adma_transfer(struct sdhci_host *host,
 uint32_t sdhci_send_command(struct sdhci_host *host, struct mmc_command *cmd)
 {
 	uint32_t ret = 0;
-	uint8_t retry = 0;
 	uint32_t resp_type = 0;
-	uint16_t trans_mode = 0;
-	uint16_t present_state;
+	uint16_t trans_mode;
 	uint32_t flags;
-	struct desc_entry *sg_list = NULL;
+	uint32_t argument;
+	uint32_t blocks;
+	uint32_t left;
+	uint32_t i;
 
 	DBG("\n %s: START: cmd:%04d, arg:0x%08x, resp_type:0x%04x, data_present:%d\n",
 				__func__, cmd->cmd_index, cmd->argument, cmd->resp_type, cmd->data_present);
 
-	if (cmd->data_present)
-		ASSERT(cmd->data.data_ptr);
+	if (cmd->data_present) {
+		ASSERT(cmd->data.data_ptr || cmd->data.sg);
+		/* Split transfers need to know how far each command moves the address */
+		ASSERT(cmd->data.num_blocks <= SDHCI_MAX_BLK_CNT || cmd->blk_arg_step);
+	}
 
 	/*
 	 * Assert if the data buffer is not aligned to cache
@@ -753,23 +891,16 @@ uint32_t sdhci_send_command(struct sdhci_host *host, struct mmc_command *cmd)
 	 * may not be aligned to cache boundary due to
 	 * certain image formats like sparse image.
 	 */
-	if (cmd->trans_mode == SDHCI_READ_MODE)
-		ASSERT(IS_CACHE_LINE_ALIGNED(cmd->data.data_ptr));
-
-	do {
-		present_state = REG_READ32(host, SDHCI_PRESENT_STATE_REG);
-		/* check if CMD & DAT lines are free */
-		present_state &= SDHCI_STATE_CMD_DAT_MASK;
+	if (cmd->trans_mode == SDHCI_READ_MODE) {
+		if (cmd->data.sg) {
+			for (i = 0; i < cmd->data.sg_cnt; i++)
+				ASSERT(IS_CACHE_LINE_ALIGNED(cmd->data.sg[i].addr));
+		} else
+			ASSERT(IS_CACHE_LINE_ALIGNED(cmd->data.data_ptr));
+	}
 
-		if (!present_state)
-			break;
-		udelay(1000);
-		retry++;
-		if (retry == 10) {
-			dprintf(CRITICAL, "Error: CMD or DAT lines were never freed\n");
-			return 1;
-		}
-	} while(1);
+	if (sdhci_wait_lines_free(host))
+		return 1;
 
 	switch(cmd->resp_type) {
 		case SDHCI_CMD_RESP_R1:
@@ -831,65 +962,88 @@ uint32_t sdhci_send_command(struct sdhci_host *host, struct mmc_command *cmd)
 	REG_WRITE8(host, SDHCI_CMD_TIMEOUT, SDHCI_TIMEOUT_REG);
 
 	/* Check if data needs to be processed */
+	if (cmd->data_present && sdhci_adma_transfer(host, cmd))
+		return 1;
+
 	if (cmd->data_present)
-		sg_list = sdhci_adma_transfer(host, cmd);
+		sdhci_msm_toggle_cdr(host, cmd->trans_mode == SDHCI_MMC_READ);
+
+	/*
+	 * Transfers over SDHCI_MAX_BLK_CNT blocks run as back to back commands,
+	 * each sized with cmd23 (or its block count & auto cmd12) & starting on
+	 * its own descriptor of the table, the card is never left open ended.
+	 */
+	argument = cmd->argument;
+	left = cmd->data_present ? cmd->data.num_blocks : 0;
+	i = 0;
 
-	/* Write the argument 1 */
-	REG_WRITE32(host, cmd->argument, SDHCI_ARGUMENT_REG);
+	do {
+		blocks = MIN(left, SDHCI_MAX_BLK_CNT);
 
-	/* Set the Transfer mode */
-	if (cmd->data_present)
-	{
-		/* Enable DMA */
-		trans_mode |= SDHCI_DMA_EN;
+		if (i) {
+			if (sdhci_wait_lines_free(host))
+				return 1;
 
-		if (cmd->trans_mode == SDHCI_MMC_READ)
-		{
-			trans_mode |= SDHCI_READ_MODE;
-			sdhci_msm_toggle_cdr(host, true);
+			REG_WRITE32(host, (uint32_t) host->adma_cmd_start[i], SDHCI_ADM_ADDR_REG);
+			REG_WRITE16(host, blocks, SDHCI_BLK_CNT_REG);
 		}
-		else
+
+		/* Write the argument 1 */
+		REG_WRITE32(host, argument, SDHCI_ARGUMENT_REG);
+
+		/* Set the Transfer mode */
+		trans_mode = 0;
+		if (cmd->data_present)
 		{
-			sdhci_msm_toggle_cdr(host, false);
-		}
+			/* Enable DMA */
+			trans_mode |= SDHCI_DMA_EN;
 
-		/* Enable auto cmd23 or cmd12 for multi block transfer
-		 * based on what command card supports
-		 */
-		if (cmd->data.num_blocks > 1) {
-			if (cmd->cmd23_support) {
-				trans_mode |= SDHCI_TRANS_MULTI | SDHCI_AUTO_CMD23_EN | SDHCI_BLK_CNT_EN;
-				REG_WRITE32(host, cmd->data.num_blocks, SDHCI_ARG2_REG);
+			if (cmd->trans_mode == SDHCI_MMC_READ)
+				trans_mode |= SDHCI_READ_MODE;
+
+			/* Enable auto cmd23 or cmd12 for multi block transfer
+			 * based on what command card supports
+			 */
+			if (cmd->data.num_blocks > 1) {
+				if (cmd->cmd23_support) {
+					trans_mode |= SDHCI_TRANS_MULTI | SDHCI_AUTO_CMD23_EN | SDHCI_BLK_CNT_EN;
+					REG_WRITE32(host, blocks, SDHCI_ARG2_REG);
+				}
+				else
+					trans_mode |= SDHCI_TRANS_MULTI | SDHCI_AUTO_CMD12_EN | SDHCI_BLK_CNT_EN;
 			}
-			else
-				trans_mode |= SDHCI_TRANS_MULTI | SDHCI_AUTO_CMD12_EN | SDHCI_BLK_CNT_EN;
 		}
-	}
 
-	/* Write to transfer mode register */
-	REG_WRITE16(host, trans_mode, SDHCI_TRANS_MODE_REG);
+		/* Write to transfer mode register */
+		REG_WRITE16(host, trans_mode, SDHCI_TRANS_MODE_REG);
 
-	/* Write the command register */
-	REG_WRITE16(host, SDHCI_PREP_CMD(cmd->cmd_index, flags), SDHCI_CMD_REG);
+		/* Write the command register */
+		REG_WRITE16(host, SDHCI_PREP_CMD(cmd->cmd_index, flags), SDHCI_CMD_REG);
 
-	/* Command complete sequence */
-	if (sdhci_cmd_complete(host, cmd))
-	{
-		ret = 1;
-		goto err;
-	}
+		/* Command complete sequence */
+		if (sdhci_cmd_complete(host, cmd))
+		{
+			ret = 1;
+			goto err;
+		}
+
+		argument += blocks * cmd->blk_arg_step;
+		left -= blocks;
+		i++;
+	} while (left);
 
 	/* Invalidate the cache only for read operations */
-	if (cmd->trans_mode == SDHCI_MMC_READ)
-		arch_invalidate_cache_range((addr_t)cmd->data.data_ptr, (cmd->data.num_blocks * SDHCI_MMC_BLK_SZ));
+	if (cmd->trans_mode == SDHCI_MMC_READ) {
+		if (cmd->data.sg) {
+			for (i = 0; i < cmd->data.sg_cnt; i++)
+				arch_invalidate_cache_range((addr_t)cmd->data.sg[i].addr, cmd->data.sg[i].len);
+		} else
+			arch_invalidate_cache_range((addr_t)cmd->data.data_ptr, (cmd->data.num_blocks * SDHCI_MMC_BLK_SZ));
+	}
 
 	DBG("\n %s: END: cmd:%04d, arg:0x%08x, resp:0x%08x 0x%08x 0x%08x 0x%08x\n",
 				__func__, cmd->cmd_index, cmd->argument, cmd->resp[0], cmd->resp[1], cmd->resp[2], cmd->resp[3]);
 err:
-	/* Free the scatter/gather list */
-	if (sg_list)
-		free(sg_list);
-
 	return ret;
 }
 
@@ -974,4 +1128,19 @@ void sdhci_init(struct sdhci_host *host)
 	 * Enable error status
 	 */
 	sdhci_error_status_enable(host);
+
+#if SDHCI_IRQ_COMPLETION
+	/*
+	 * Register the handler for cmd & transfer completion, signals stay
+	 * masked until a waiter is ready to sleep on them
+	 */
+	if (host->hc_irq)
+	{
+		event_init(&host->int_event, false, EVENT_FLAG_AUTOUNSIGNAL);
+		REG_WRITE16(host, 0, SDHCI_NRML_INT_SIG_EN_REG);
+		REG_WRITE16(host, 0, SDHCI_ERR_INT_SIG_EN_REG);
+		register_int_handler(host->hc_irq, sdhci_hc_int_handler, (void *) host);
+		unmask_interrupt(host->hc_irq);
+	}
+#endif
 }
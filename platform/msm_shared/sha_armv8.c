@@ -0,0 +1,150 @@
+/* Copyright (c) 2015, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Fundation, Inc. nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <string.h>
+#include <stdlib.h>
+#include <arch/ops.h>
+#include <sha_armv8.h>
+
+/* ID_ISAR5 fields, RAZ on ARMv7 cores */
+#define ID_ISAR5_SHA1(x)	(((x) >> 8) & 0xf)
+#define ID_ISAR5_SHA2(x)	(((x) >> 12) & 0xf)
+
+/*
+ * The NEON registers are not saved across context switches, so the
+ * block functions run with interrupts off. Bound each run to 16KB.
+ */
+#define SHA_ARMV8_MAX_BLOCKS	256
+
+typedef void (*sha_armv8_block_fn)(uint32_t *state, const void *data, uint32_t blocks);
+
+static int sha_armv8_present = -1;
+
+bool sha_armv8_supported(void)
+{
+	uint32_t isar5;
+
+	if (sha_armv8_present < 0) {
+		__asm__ volatile("mrc	p15, 0, %0, c0, c2, 5" : "=r" (isar5));
+		sha_armv8_present = ID_ISAR5_SHA1(isar5) && ID_ISAR5_SHA2(isar5);
+	}
+
+	return sha_armv8_present;
+}
+
+static void sha_armv8_blocks(sha_armv8_block_fn block, uint32_t *state,
+			     const unsigned char *data, size_t blocks)
+{
+	uint32_t ints;
+	uint32_t n;
+
+	while (blocks) {
+		n = MIN(blocks, SHA_ARMV8_MAX_BLOCKS);
+
+		ints = arch_save_disable_ints();
+		block(state, data, n);
+		arch_restore_ints(ints);
+
+		data += n * SHA_CBLOCK;
+		blocks -= n;
+	}
+}
+
+/*
+ * Same buffering as OpenSSL's md32_common HASH_UPDATE: a partial block
+ * is kept in the context's data[] with num bytes used, and Nl/Nh count
+ * the message length in bits.
+ */
+static void sha_armv8_update(sha_armv8_block_fn block, uint32_t *state,
+			     SHA_LONG *Nl, SHA_LONG *Nh, SHA_LONG *buf,
+			     unsigned int *num, const void *data, size_t len)
+{
+	const unsigned char *ptr = data;
+	unsigned char *p = (unsigned char *)buf;
+	SHA_LONG l;
+	size_t n;
+
+	l = (*Nl + (((SHA_LONG)len) << 3)) & 0xffffffffUL;
+	if (l < *Nl)
+		(*Nh)++;
+	*Nh += (SHA_LONG)(len >> 29);
+	*Nl = l;
+
+	n = *num;
+	if (n) {
+		if (len + n < SHA_CBLOCK) {
+			memcpy(p + n, ptr, len);
+			*num += len;
+			return;
+		}
+
+		memcpy(p + n, ptr, SHA_CBLOCK - n);
+		sha_armv8_blocks(block, state, p, 1);
+		ptr += SHA_CBLOCK - n;
+		len -= SHA_CBLOCK - n;
+		*num = 0;
+		memset(p, 0, SHA_CBLOCK);
+	}
+
+	n = len / SHA_CBLOCK;
+	if (n) {
+		sha_armv8_blocks(block, state, ptr, n);
+		ptr += n * SHA_CBLOCK;
+		len -= n * SHA_CBLOCK;
+	}
+
+	if (len) {
+		memcpy(p, ptr, len);
+		*num = len;
+	}
+}
+
+int sha1_armv8_update(SHA_CTX *c, const void *data, size_t len)
+{
+	if (!sha_armv8_supported())
+		return SHA1_Update(c, data, len);
+
+	if (len)
+		sha_armv8_update(sha1_armv8_block, &c->h0, &c->Nl, &c->Nh,
+				 c->data, &c->num, data, len);
+
+	return 1;
+}
+
+int sha256_armv8_update(SHA256_CTX *c, const void *data, size_t len)
+{
+	if (!sha_armv8_supported())
+		return SHA256_Update(c, data, len);
+
+	if (len)
+		sha_armv8_update(sha256_armv8_block, c->h, &c->Nl, &c->Nh,
+				 c->data, &c->num, data, len);
+
+	return 1;
+}
@@ -28,10 +28,11 @@
 
 #include <debug.h>
 #include <reg.h>
+#include <err.h>
 #include <stdlib.h>
 #include <pm8x41.h>
 #include <pm8x41_hw.h>
-#include <kernel/timer.h>
+#include <dev/keys.h>
 #include <platform/timer.h>
 #include <shutdown_detect.h>
 #include <platform.h>
@@ -41,10 +42,6 @@
 #define MPM_SLEEP_TIMETICK_COUNT    0x8000
 #define PWRKEY_LONG_PRESS_COUNT     0xC000
 #define QPNP_DEFAULT_TIMEOUT        250
-#define PWRKEY_DETECT_FREQUENCY     50
-
-static struct timer pon_timer;
-static uint32_t pon_timer_complete = 0;
 
 /*
  * Function to check if the the power key is pressed long enough.
@@ -78,54 +75,49 @@ static uint32_t is_pwrkey_pon_reason()
 		return 0;
 }
 
-/*
- * Main timer handle: check every PWRKEY_DETECT_FREQUENCY to see
- * if power key is pressed.
- * Shutdown the device if power key is release before
- * (PWRKEY_LONG_PRESS_COUNT/MPM_SLEEP_TIMETICK_COUNT) seconds.
- */
-static enum handler_return long_press_pwrkey_timer_func(struct timer *p_timer,
-	void *arg)
+static int pwrkey_state()
 {
-	uint32_t sclk_count = platform_get_sclk_count();
-
-	/*
-	 * The following condition is treated as the power key
-	 * is pressed long enough.
-	 * 1. if the power key is pressed last for PWRKEY_LONG_PRESS_COUNT.
-	 */
-	if (sclk_count > PWRKEY_LONG_PRESS_COUNT) {
-		timer_cancel(p_timer);
-		pon_timer_complete = 1;
-	} else {
-		if (pm8x41_get_pwrkey_is_pressed()) {
-			/*
-			 * For normal man response is > 0.1 secs, so we use 0.05 secs default
-			 * for software to be safely detect if there is a key release action.
-			 */
-			timer_set_oneshot(p_timer, PWRKEY_DETECT_FREQUENCY,
-				(timer_callback)long_press_pwrkey_timer_func, NULL);
-		} else {
-			shutdown_device();
-		}
-	}
-
-	return INT_RESCHEDULE;
+	return pm8x41_get_pwrkey_is_pressed();
 }
 
 /*
- * Function to wait until the power key is pressed long enough
+ * Function to wait until the power key is pressed long enough.
+ * The key is sampled by the keys debounce timer while we wait for
+ * its release event. Shutdown the device if it comes before
+ * (PWRKEY_LONG_PRESS_COUNT/MPM_SLEEP_TIMETICK_COUNT) seconds.
  */
 static void wait_for_long_pwrkey_pressed()
 {
-	uint32_t sclk_count = 0;
+	struct key_event ev;
+	uint32_t sclk_count;
+	time_t left;
+	int ret;
+
+	/* Taking the current state costs one PMIC read */
+	if (keys_add_source(KEY_POWER, pwrkey_state) != NO_ERROR) {
+		dprintf(CRITICAL, "Cannot watch the power key\n");
+		return;
+	}
 
-	while (!pon_timer_complete) {
+	if (!keys_get_state(KEY_POWER))
+		shutdown_device();
+
+	while (1) {
 		sclk_count = platform_get_sclk_count();
-		if (sclk_count > PWRKEY_LONG_PRESS_COUNT) {
-			timer_cancel(&pon_timer);
+		if (sclk_count > PWRKEY_LONG_PRESS_COUNT)
+			break;
+
+		left = (PWRKEY_LONG_PRESS_COUNT - sclk_count) * 1000 /
+			MPM_SLEEP_TIMETICK_COUNT + 1;
+
+		ret = keys_wait_event(&ev, left);
+		if (ret == ERR_TIMED_OUT)
+			continue;
+		if (ret != NO_ERROR)
 			break;
-		}
+
+		if (ev.code == KEY_POWER && !ev.value)
+			shutdown_device();
 	}
 }
 
@@ -143,13 +135,9 @@ void shutdown_detect()
 {
 	/*
 	 * If it is booted by power key tirigger.
-	 * Initialize pon_timer and call long_press_pwrkey_timer_func
-	 * function to check if the power key is last press long enough.
+	 * Check if the power key is last press long enough.
 	 */
 	if (is_pwrkey_pon_reason() && is_pwrkey_time_expired()) {
-		timer_initialize(&pon_timer);
-		timer_set_oneshot(&pon_timer, 0,(timer_callback)long_press_pwrkey_timer_func, NULL);
-
 		/*
 		 * Wait until long press power key timeout
 		 *
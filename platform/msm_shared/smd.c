@@ -40,6 +40,8 @@
 #include <bits.h>
 
 #define SMD_CHANNEL_ACCESS_RETRY 1000000
+/* smd_writev() gives the remote end this many 10us polls to make room */
+#define SMD_SEND_ROOM_RETRY 100000
 
 smd_channel_alloc_entry_t *smd_channel_alloc_entry;
 static event_t smd_closed;
@@ -185,7 +187,7 @@ bool is_channel_open(smd_channel_info_t *ch)
  * Uses the fifo as circular buffer, if the request data
  * exceeds the max size of the buffer start from the beginning.
  */
-static void memcpy_to_fifo(smd_channel_info_t *ch_ptr, uint32_t *src, size_t len)
+static void memcpy_to_fifo(smd_channel_info_t *ch_ptr, const uint32_t *src, size_t len)
 {
 	uint32_t write_index = ch_ptr->port_info->ch0.write_index;
 	uint32_t *dest = (uint32_t *)(ch_ptr->send_buf + write_index);
@@ -287,14 +289,46 @@ void smd_signal_read_complete(smd_channel_info_t *ch, uint32_t len)
 	smd_notify_rpm();
 }
 
-int smd_write(smd_channel_info_t *ch, void *data, uint32_t len, int ch_type)
+/* Bytes the remote end has not consumed yet from our send fifo */
+static uint32_t smd_send_fifo_used(smd_channel_info_t *ch)
+{
+	return (ch->port_info->ch0.write_index + ch->fifo_size -
+		ch->port_info->ch0.read_index) % ch->fifo_size;
+}
+
+/* True if a len byte packet fits in the send fifo without waiting */
+bool smd_write_room(smd_channel_info_t *ch, uint32_t len)
+{
+	uint32_t size = 0;
+
+	ch->port_info = smem_get_alloc_entry(SMEM_SMD_BASE_ID + ch->alloc_entry.cid,
+                                                        &size);
+	arch_invalidate_cache_range((addr_t) ch->port_info, size);
+
+	return smd_send_fifo_used(ch) + len + sizeof(smd_pkt_hdr) < ch->fifo_size;
+}
+
+/* Write one packet gathered from iov straight into the send fifo, so
+ * callers can send pre-encoded data without staging it in a buffer.
+ */
+int smd_writev(smd_channel_info_t *ch, const smd_iovec *iov, uint32_t iovcnt, int ch_type)
 {
 	smd_pkt_hdr smd_hdr;
+	uint32_t retry = SMD_SEND_ROOM_RETRY;
 	uint32_t size = 0;
+	uint32_t len = 0;
+	uint32_t i;
 
 	memset(&smd_hdr, 0, sizeof(smd_pkt_hdr));
 
-	if(len + sizeof(smd_hdr) > ch->fifo_size)
+	for (i = 0; i < iovcnt; i++)
+	{
+		ASSERT(!(iov[i].len & 3));
+		len += iov[i].len;
+	}
+
+	/* One word stays free so that a full fifo is not mistaken for empty */
+	if(len + sizeof(smd_hdr) >= ch->fifo_size)
 	{
 		dprintf(CRITICAL,"%s: len is greater than fifo sz\n", __func__);
 		return -1;
@@ -316,6 +350,18 @@ int smd_write(smd_channel_info_t *ch, void *data, uint32_t len, int ch_type)
 		return -1;
 	}
 
+	/* Several packets may be in flight, wait for the RPM to make room */
+	while (smd_send_fifo_used(ch) + len + sizeof(smd_hdr) >= ch->fifo_size)
+	{
+		if (!retry--)
+		{
+			dprintf(CRITICAL,"%s: timed out waiting for fifo room\n", __func__);
+			return -1;
+		}
+		udelay(10);
+		arch_invalidate_cache_range((addr_t) ch->port_info, size);
+	}
+
 	/* Clear the data_read flag */
 	ch->port_info->ch1.data_read = 0;
 
@@ -324,7 +370,8 @@ int smd_write(smd_channel_info_t *ch, void *data, uint32_t len, int ch_type)
 
 	memcpy_to_fifo(ch, (uint32_t *)&smd_hdr, sizeof(smd_hdr));
 
-	memcpy_to_fifo(ch, data, len);
+	for (i = 0; i < iovcnt; i++)
+		memcpy_to_fifo(ch, iov[i].base, iov[i].len);
 
 	dsb();
 
@@ -340,6 +387,13 @@ int smd_write(smd_channel_info_t *ch, void *data, uint32_t len, int ch_type)
 	return 0;
 }
 
+int smd_write(smd_channel_info_t *ch, void *data, uint32_t len, int ch_type)
+{
+	smd_iovec iov = { data, len };
+
+	return smd_writev(ch, &iov, 1, ch_type);
+}
+
 void smd_notify_rpm()
 {
 	/* Set BIT 0 to notify RPM via IPC interrupt*/
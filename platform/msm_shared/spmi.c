@@ -34,6 +34,7 @@
 #include <platform/irqs.h>
 #include <platform/interrupts.h>
 #include <malloc.h>
+#include <kernel/thread.h>
 
 #define PMIC_ARB_V2 0x20010000
 #define CHNL_IDX(sid, pid) ((sid << 8) | pid)
@@ -124,8 +125,8 @@ static void write_wdata_from_array(uint8_t *array,
  *
  * return value : 0 if success, the error bit set on error
  */
-unsigned int pmic_arb_write_cmd(struct pmic_arb_cmd *cmd,
-                                struct pmic_arb_param *param)
+static unsigned int __pmic_arb_write_cmd(struct pmic_arb_cmd *cmd,
+                                         struct pmic_arb_param *param)
 {
 	uint32_t bytes_written = 0;
 	uint32_t error;
@@ -197,6 +198,21 @@ unsigned int pmic_arb_write_cmd(struct pmic_arb_cmd *cmd,
 		return 0;
 }
 
+/* The channel registers are shared, so a command is issued and completed
+ * atomically with respect to other threads (e.g. the display init thread).
+ */
+unsigned int pmic_arb_write_cmd(struct pmic_arb_cmd *cmd,
+                                struct pmic_arb_param *param)
+{
+	unsigned int ret;
+
+	enter_critical_section();
+	ret = __pmic_arb_write_cmd(cmd, param);
+	exit_critical_section();
+
+	return ret;
+}
+
 static void read_rdata_into_array(uint8_t *array,
                                   uint8_t reg_num,
                                   uint8_t array_size,
@@ -236,8 +252,8 @@ static void read_rdata_into_array(uint8_t *array,
  *
  * return value : 0 if success, the error bit set on error
  */
-unsigned int pmic_arb_read_cmd(struct pmic_arb_cmd *cmd,
-                               struct pmic_arb_param *param)
+static unsigned int __pmic_arb_read_cmd(struct pmic_arb_cmd *cmd,
+                                        struct pmic_arb_param *param)
 {
 	uint32_t val = 0;
 	uint32_t error;
@@ -319,6 +335,18 @@ unsigned int pmic_arb_read_cmd(struct pmic_arb_cmd *cmd,
 	return 0;
 }
 
+unsigned int pmic_arb_read_cmd(struct pmic_arb_cmd *cmd,
+                               struct pmic_arb_param *param)
+{
+	unsigned int ret;
+
+	enter_critical_section();
+	ret = __pmic_arb_read_cmd(cmd, param);
+	exit_critical_section();
+
+	return ret;
+}
+
 
 /* Funtion to determine if the peripheral that caused the interrupt
  * is of interest.
@@ -54,7 +54,8 @@ static int uart_init_flag = 0;
  *   use of static variables. TX path shouldn't have any problem though. If
  *   multi-threaded support is required, a simple data-structure can
  *   be maintained for each thread.
- * - Right now we are using polling method than interrupt based.
+ * - Right now we are using polling method than interrupt based, except for
+ *   the optional buffered TX path (UART_DM_TX_BUFFERED).
  * - We are using legacy UART protocol without Data Mover.
  * - Not all interrupts and error events are handled.
  * - While waiting Watchdog hasn't been taken into consideration.
@@ -267,8 +268,10 @@ msm_boot_uart_dm_read(uint32_t base, unsigned int *data, int wait)
 
 	/* If RX transfer has not ended yet */
 	if (rx_last_snap_count == 0) {
-		/* Check if we've received stale event */
-		if (readl(MSM_BOOT_UART_DM_MISR(base)) & MSM_BOOT_UART_DM_RXSTALE) {
+		/* Check if we've received stale event. ISR is the unmasked
+		 * status, the IMR may only route TX_READY to the interrupt.
+		 */
+		if (readl(MSM_BOOT_UART_DM_ISR(base)) & MSM_BOOT_UART_DM_RXSTALE) {
 			/* Send command to reset stale interrupt */
 			writel(MSM_BOOT_UART_DM_CMD_RES_STALE_INT, MSM_BOOT_UART_DM_CR(base));
 		}
@@ -374,6 +377,144 @@ msm_boot_uart_dm_write(uint32_t base, char *data, unsigned int num_of_chars)
 	return MSM_BOOT_UART_DM_E_SUCCESS;
 }
 
+#if UART_DM_TX_BUFFERED
+/*
+ * Buffered TX: uart_putc() only appends to a ring, and the TX_READY
+ * interrupt of the previous transfer starts the next one. A transfer is
+ * at most UART_DM_TX_CHUNK characters so it always fits in the TX FIFO
+ * and the interrupt handler never waits on the UART. With interrupts
+ * disabled (early boot, panic, the jump to the kernel) the ring is
+ * drained by polling instead.
+ */
+#ifndef UART_DM_TX_BUF_SIZE
+#define UART_DM_TX_BUF_SIZE 8192	/* must be a power of two */
+#endif
+#define UART_DM_TX_BUF_MASK (UART_DM_TX_BUF_SIZE - 1)
+#define UART_DM_TX_CHUNK    64
+
+static struct {
+	char buf[UART_DM_TX_BUF_SIZE];
+	uint32_t head;			/* free running write index */
+	uint32_t tail;			/* free running read index */
+	uint32_t base;
+	bool enabled;			/* TX_READY interrupt is hooked up */
+	bool busy;			/* a transfer is in flight */
+} uart_tx;
+
+/* Start the next transfer from the ring, called with interrupts disabled */
+static void uart_dm_tx_start(void)
+{
+	uint32_t base = uart_tx.base;
+	uint8_t chunk[UART_DM_TX_CHUNK];
+	uint32_t count = 0;
+	uint32_t word;
+	uint32_t i, j;
+	char c;
+
+	while (uart_tx.tail != uart_tx.head) {
+		c = uart_tx.buf[uart_tx.tail & UART_DM_TX_BUF_MASK];
+		if (c == '\n') {
+			if (count + 2 > UART_DM_TX_CHUNK)
+				break;
+			chunk[count++] = '\r';
+		} else if (count + 1 > UART_DM_TX_CHUNK) {
+			break;
+		}
+		chunk[count++] = c;
+		uart_tx.tail++;
+	}
+
+	if (!count) {
+		uart_tx.busy = false;
+		return;
+	}
+
+	writel(count, MSM_BOOT_UART_DM_NO_CHARS_FOR_TX(base));
+	writel(MSM_BOOT_UART_DM_GCMD_RES_TX_RDY_INT, MSM_BOOT_UART_DM_CR(base));
+
+	for (i = 0; i < count; i += 4) {
+		word = 0;
+		for (j = 0; j < 4 && (i + j) < count; j++)
+			word |= (uint32_t)chunk[i + j] << (j * 8);
+
+		/* Never expected to spin, a chunk fits in the FIFO */
+		while (!(readl(MSM_BOOT_UART_DM_SR(base)) & MSM_BOOT_UART_DM_SR_TXRDY));
+
+		writel(word, MSM_BOOT_UART_DM_TF(base, 0));
+	}
+
+	uart_tx.busy = true;
+}
+
+/* Wait for the transfer in flight, then start the next one */
+static void uart_dm_tx_poll(void)
+{
+	uint32_t base = uart_tx.base;
+
+	if (uart_tx.busy) {
+		while (!(readl(MSM_BOOT_UART_DM_ISR(base)) & MSM_BOOT_UART_DM_TX_READY));
+		uart_tx.busy = false;
+	}
+
+	uart_dm_tx_start();
+}
+
+static enum handler_return uart_dm_tx_irq(void *arg)
+{
+	uint32_t base = uart_tx.base;
+
+	if (readl(MSM_BOOT_UART_DM_ISR(base)) & MSM_BOOT_UART_DM_TX_READY) {
+		writel(MSM_BOOT_UART_DM_GCMD_RES_TX_RDY_INT, MSM_BOOT_UART_DM_CR(base));
+		uart_tx.busy = false;
+		uart_dm_tx_start();
+	}
+
+	return INT_NO_RESCHEDULE;
+}
+
+static void uart_dm_tx_putc(char c)
+{
+	enter_critical_section();
+
+	/* Ring full: the producer outran the line, drain a chunk by hand */
+	while (uart_tx.head - uart_tx.tail >= UART_DM_TX_BUF_SIZE)
+		uart_dm_tx_poll();
+
+	uart_tx.buf[uart_tx.head & UART_DM_TX_BUF_MASK] = c;
+	uart_tx.head++;
+
+	if (!uart_tx.enabled || critical_section_count > 1) {
+		/* Interrupts are off for the caller, so nothing would drain it */
+		while (uart_tx.busy || uart_tx.tail != uart_tx.head)
+			uart_dm_tx_poll();
+	} else if (!uart_tx.busy) {
+		uart_dm_tx_start();
+	}
+
+	exit_critical_section();
+}
+
+/*
+ * Hook up the TX_READY interrupt of the debug port. Until this is called,
+ * and whenever interrupts are disabled, output is written synchronously.
+ */
+void uart_dm_tx_irq_init(uint32_t uart_dm_base, uint32_t irq)
+{
+	enter_critical_section();
+
+	uart_tx.base = uart_dm_base;
+
+	/* Only TX_READY drives the line, RX is polled through ISR */
+	writel(MSM_BOOT_UART_DM_TX_READY, MSM_BOOT_UART_DM_IMR(uart_dm_base));
+
+	register_int_handler(irq, uart_dm_tx_irq, NULL);
+	unmask_interrupt(irq);
+	uart_tx.enabled = true;
+
+	exit_critical_section();
+}
+#endif
+
 /* Defining functions that's exposed to outside world and in coformance to
  * existing uart implemention. These functions are being called to initialize
  * UART and print debug messages in bootloader.
@@ -416,6 +557,11 @@ void uart_dm_init(uint8_t id, uint32_t gsbi_base, uint32_t uart_dm_base)
 	ASSERT(port < ARRAY_SIZE(port_lookup));
 	port_lookup[port++] = uart_dm_base;
 
+#if UART_DM_TX_BUFFERED
+	if (!uart_tx.base)
+		uart_tx.base = uart_dm_base;
+#endif
+
 	/* Set UART init flag */
 	uart_init_flag = 1;
 }
@@ -433,11 +579,32 @@ int uart_putc(int port, char c)
 	if (!uart_init_flag)
 		return -1;
 
+#if UART_DM_TX_BUFFERED
+	if (uart_base == uart_tx.base) {
+		uart_dm_tx_putc(c);
+		return 0;
+	}
+#endif
+
 	msm_boot_uart_dm_write(uart_base, &c, 1);
 
 	return 0;
 }
 
+/* Push out everything buffered for the port before returning */
+void uart_flush_tx(int port)
+{
+#if UART_DM_TX_BUFFERED
+	if (!uart_init_flag || port_lookup[port] != uart_tx.base)
+		return;
+
+	enter_critical_section();
+	while (uart_tx.busy || uart_tx.tail != uart_tx.head)
+		uart_dm_tx_poll();
+	exit_critical_section();
+#endif
+}
+
 /* UART_DM uses four character word FIFO whereas uart_getc
  * is supposed to read only one character. So we need to
  * read a word and keep track of each character in the word.
@@ -181,127 +181,110 @@ int ucs_do_scsi_rpmb_read(struct ufs_dev *dev, uint32_t *req_buf, uint32_t blk_c
 	return UFS_SUCCESS;
 }
 
-int ucs_do_scsi_read(struct ufs_dev *dev, struct scsi_rdwr_req *req)
+/* Split the transfer over as many UTRD slots as the queue allows, keep the
+ * slots topped up as completions come back and report the failure once
+ * everything in flight has drained.
+ */
+static int ucs_do_scsi_rdwr(struct ufs_dev *dev, struct scsi_rdwr_req *req, uint8_t opcode)
 {
-	STACKBUF_DMA_ALIGN(cdb, sizeof(struct scsi_rdwr_cdb));
-	struct scsi_req_build_type     req_upiu;
 	struct scsi_rdwr_cdb           *cdb_param;
 	uint32_t                       blks_remaining;
-	uint16_t                       blks_to_transfer;
-	uint64_t                       bytes_to_transfer;
+	uint32_t                       blks_to_transfer;
+	uint32_t                       bytes_to_transfer;
 	uint32_t                       start_blk;
 	uint32_t                       buf;
+	uint32_t                       slots;
+	uint32_t                       done;
+	uint32_t                       failed;
+	uint32_t                       all_failed = 0;
+	uint8_t                        status;
+	uint8_t                        last_status = SCSI_STATUS_GOOD;
+	enum scsi_upiu_flags           flags;
+	enum upiu_dd_type              dd;
+	int                            slot;
 
 	blks_remaining = req->num_blocks;
 	buf            = req->data_buffer_base;
 	start_blk      = req->start_lba;
 
-	cdb_param = (struct scsi_rdwr_cdb*) cdb;
-	while (blks_remaining)
+	if (opcode == SCSI_CMD_READ10)
+	{
+		flags = UPIU_FLAGS_READ;
+		dd    = UTRD_TARGET_TO_SYSTEM;
+	}
+	else
+	{
+		flags = UPIU_FLAGS_WRITE;
+		dd    = UTRD_SYSTEM_TO_TARGET;
+	}
+
+	while (blks_remaining || dev->utrd_queue.outstanding)
 	{
-		if (blks_remaining <= SCSI_MAX_DATA_TRANS_BLK_LEN)
+		/* Fill every free slot, stop issuing new commands once something failed. */
+		slots = 0;
+		while (blks_remaining && !all_failed && (slot = utp_queue_get_slot(dev)) >= 0)
 		{
-			blks_to_transfer = blks_remaining;
-			blks_remaining   = 0;
+			blks_to_transfer  = MIN(blks_remaining, UTP_QUEUE_MAX_XFER_LEN / UFS_DEFAULT_SECTORE_SIZE);
+			bytes_to_transfer = blks_to_transfer * UFS_DEFAULT_SECTORE_SIZE;
+
+			cdb_param = (struct scsi_rdwr_cdb *) utp_queue_prep(dev, slot, req->lun, flags, dd,
+																buf, bytes_to_transfer);
+			cdb_param->opcode    = opcode;
+			cdb_param->cdb1      = SCSI_READ_WRITE_10_CDB1(0, 0, 1, 0);
+			cdb_param->lba       = BE32(start_blk);
+			cdb_param->trans_len = BE16(blks_to_transfer);
+
+			slots          |= 1 << slot;
+			buf            += bytes_to_transfer;
+			start_blk      += blks_to_transfer;
+			blks_remaining -= blks_to_transfer;
 		}
-		else
+
+		/* One doorbell write starts the whole batch. */
+		if (slots)
+			utp_queue_ring(dev, slots);
+		else if (!dev->utrd_queue.outstanding)
 		{
-			blks_to_transfer = SCSI_MAX_DATA_TRANS_BLK_LEN;
-			blks_remaining  -= SCSI_MAX_DATA_TRANS_BLK_LEN;
+			if (!all_failed)
+				dprintf(CRITICAL, "%s: no free UTRD slot\n", __func__);
+			return -UFS_FAILURE;
 		}
 
-		bytes_to_transfer = blks_to_transfer * UFS_DEFAULT_SECTORE_SIZE;
-
-		memset(cdb_param, 0, sizeof(struct scsi_rdwr_cdb));
-		cdb_param->opcode    = SCSI_CMD_READ10;
-		cdb_param->cdb1      = SCSI_READ_WRITE_10_CDB1(0, 0, 1, 0);
-		cdb_param->lba       = BE32(start_blk);
-		cdb_param->trans_len = BE16(blks_to_transfer);
-
-
-		dsb();
-		arch_clean_invalidate_cache_range((addr_t) cdb_param, sizeof(struct scsi_rdwr_cdb));
-
-		memset(&req_upiu, 0 , sizeof(struct scsi_req_build_type));
-
-		req_upiu.cdb               = (addr_t) cdb_param;
-		req_upiu.data_buffer_addr  = buf;
-		req_upiu.data_len = bytes_to_transfer;
-		req_upiu.flags             = UPIU_FLAGS_READ;
-		req_upiu.lun               = req->lun;
-		req_upiu.dd                = UTRD_TARGET_TO_SYSTEM;
-
-		if (ucs_do_scsi_cmd(dev, &req_upiu))
+		if (utp_queue_reap(dev, &done, &failed, &status))
 		{
-			dprintf(CRITICAL, "ucs_do_scsi_read: failed\n");
-			return -UFS_FAILURE;
+			all_failed  |= failed;
+			last_status  = status;
 		}
+	}
+
+	if (all_failed)
+	{
+		if (last_status == SCSI_STATUS_CHK_COND && ucs_do_request_sense(dev))
+			dprintf(CRITICAL, "SCSI request sense failed.\n");
 
-		buf       += bytes_to_transfer;
-		start_blk += SCSI_MAX_DATA_TRANS_BLK_LEN;
+		return -UFS_FAILURE;
 	}
 
 	return UFS_SUCCESS;
 }
 
-int ucs_do_scsi_write(struct ufs_dev *dev, struct scsi_rdwr_req *req)
+int ucs_do_scsi_read(struct ufs_dev *dev, struct scsi_rdwr_req *req)
 {
-	struct scsi_req_build_type     req_upiu;
-	STACKBUF_DMA_ALIGN(cdb, sizeof(struct scsi_rdwr_cdb));
-	struct scsi_rdwr_cdb           *cdb_param;
-	uint32_t                       blks_remaining;
-	uint16_t                       blks_to_transfer;
-	uint64_t                       bytes_to_transfer;
-	uint32_t                       start_blk;
-	uint32_t                       buf;
-
-	blks_remaining = req->num_blocks;
-	buf = req->data_buffer_base;
-	start_blk = req->start_lba;
-
-	cdb_param = (struct scsi_rdwr_cdb*) cdb;
-	while (blks_remaining)
+	if (ucs_do_scsi_rdwr(dev, req, SCSI_CMD_READ10))
 	{
-		if (blks_remaining <= SCSI_MAX_DATA_TRANS_BLK_LEN)
-		{
-			blks_to_transfer = blks_remaining;
-			blks_remaining   = 0;
-		}
-		else
-		{
-			blks_to_transfer = SCSI_MAX_DATA_TRANS_BLK_LEN;
-			blks_remaining  -= SCSI_MAX_DATA_TRANS_BLK_LEN;
-		}
-
-		bytes_to_transfer = blks_to_transfer * UFS_DEFAULT_SECTORE_SIZE;
-
-		memset(cdb_param, 0, sizeof(struct scsi_rdwr_cdb));
-		cdb_param->opcode    = SCSI_CMD_WRITE10;
-		cdb_param->cdb1      = SCSI_READ_WRITE_10_CDB1(0, 0, 1, 0);
-		cdb_param->lba       = BE32(start_blk);
-		cdb_param->trans_len = BE16(blks_to_transfer);
-
-		/* Flush cdb to memory. */
-		dsb();
-		arch_clean_invalidate_cache_range((addr_t) cdb_param, sizeof(struct scsi_rdwr_cdb));
-
-		memset(&req_upiu, 0 , sizeof(struct scsi_req_build_type));
-
-		req_upiu.cdb               = (addr_t) cdb_param;
-		req_upiu.data_buffer_addr  = buf;
-		req_upiu.data_len          = bytes_to_transfer;
-		req_upiu.flags             = UPIU_FLAGS_WRITE;
-		req_upiu.lun               = req->lun;
-		req_upiu.dd                = UTRD_SYSTEM_TO_TARGET;
+		dprintf(CRITICAL, "ucs_do_scsi_read: failed\n");
+		return -UFS_FAILURE;
+	}
 
-		if (ucs_do_scsi_cmd(dev, &req_upiu))
-		{
-			dprintf(CRITICAL, "ucs_do_scsi_write: failed\n");
-			return -UFS_FAILURE;
-		}
+	return UFS_SUCCESS;
+}
 
-		buf       += bytes_to_transfer;
-		start_blk += SCSI_MAX_DATA_TRANS_BLK_LEN;
+int ucs_do_scsi_write(struct ufs_dev *dev, struct scsi_rdwr_req *req)
+{
+	if (ucs_do_scsi_rdwr(dev, req, SCSI_CMD_WRITE10))
+	{
+		dprintf(CRITICAL, "ucs_do_scsi_write: failed\n");
+		return -UFS_FAILURE;
 	}
 
 	return UFS_SUCCESS;
@@ -36,6 +36,7 @@
 #include <dme.h>
 #include <qgic.h>
 #include <string.h>
+#include <printf.h>
 #include <platform/iomap.h>
 #include <platform/irqs.h>
 #include <kernel/mutex.h>
@@ -66,6 +67,10 @@ static int ufs_dev_init(struct ufs_dev *dev)
 	if (!dev->utrd_data.list_base_addr || !dev->utmrd_data.list_base_addr)
 		return -UFS_FAILURE;
 
+	/* Per slot command descriptors for queued reads and writes. */
+	if (utp_queue_init(dev))
+		return -UFS_FAILURE;
+
 	return UFS_SUCCESS;
 }
 
@@ -84,6 +89,9 @@ static void ufs_setup_req_lists(struct ufs_dev *dev)
 
 	/* Enable the required irqs. */
 	val = UFS_IE_UEE | UFS_IE_UCCE ;
+#if UFS_IRQ_COMPLETION
+	val |= UFS_IE_UTRCE;
+#endif
 	ufs_irq_enable(dev, val);
 	// Change UFS_IRQ to level based
 	qgic_change_interrupt_cfg(UFS_IRQ, INTERRUPT_LVL_N_TO_N);
@@ -313,3 +321,48 @@ void ufs_dump_hc_registers(struct ufs_dev *dev)
 	dprintf(CRITICAL,"UFS_HCS 0x%x\n", readl(UFS_HCS(base)));
 	dprintf(CRITICAL,"-----------End--------------------------------\n");
 }
+
+static void ufs_dprintf_line(const char *line, void *arg)
+{
+	dprintf(CRITICAL, "%s\n", line);
+}
+
+/* Pass each line of the queue statistics to report, or to the log if NULL */
+void ufs_dump_queue_stats(struct ufs_dev *dev, void (*report)(const char *line, void *arg), void *arg)
+{
+	struct ufs_queue_stats *stats = &dev->utrd_queue.stats;
+	char line[64];
+	int i;
+
+	if (!report)
+		report = ufs_dprintf_line;
+
+	snprintf(line, sizeof(line), "ufs queue depth %u: cmds %u errors %u doorbells %u reaps %u",
+			 dev->utrd_queue.depth, stats->cmds, stats->errors, stats->doorbells, stats->reaps);
+	report(line, arg);
+	if (stats->doorbells)
+	{
+		snprintf(line, sizeof(line), "ufs queue depth max %u avg %llu.%02llu", stats->max_depth,
+				 stats->depth_sum / stats->doorbells, (stats->depth_sum * 100 / stats->doorbells) % 100);
+		report(line, arg);
+	}
+	if (stats->cmds)
+	{
+		snprintf(line, sizeof(line), "ufs latency avg %llu us max %u us",
+				 stats->lat_sum_us / stats->cmds, stats->lat_max_us);
+		report(line, arg);
+	}
+	for (i = 0; i < UFS_QUEUE_LAT_BUCKETS; i++)
+	{
+		if (stats->lat_hist[i])
+		{
+			snprintf(line, sizeof(line), "ufs latency < %u us: %u", 1U << i, stats->lat_hist[i]);
+			report(line, arg);
+		}
+	}
+}
+
+void ufs_reset_queue_stats(struct ufs_dev *dev)
+{
+	memset(&dev->utrd_queue.stats, 0, sizeof(dev->utrd_queue.stats));
+}
@@ -167,7 +167,12 @@ enum handler_return ufs_irq_handler(void* data)
 			writel(irq.irq_handled, UFS_IS(dev->base));
 			val	   &= ~irq.irq_handled;
 
-			utp_process_req_completion(&irq);
+			/* Completion may belong to the legacy list, the read/write queue or both. */
+			if (list_next(irq.list, irq.list) != NULL)
+				utp_process_req_completion(&irq);
+
+			if (dev->utrd_queue.outstanding)
+				event_signal(&(dev->utrd_queue.event), false);
 		}
 		else if (val & UFS_IS_UTMRCS)
 		{
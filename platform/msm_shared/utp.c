@@ -38,6 +38,7 @@
 #include <ufs_hw.h>
 #include <utp.h>
 #include <ufs.h>
+#include <platform.h>
 #include <platform/iomap.h>
 #include <platform/clock.h>
 #include <platform/timer.h>
@@ -214,6 +215,12 @@ utp_get_desc_slot_addr_err:
 	return desc;
 }
 
+/* Completion irqs are only usable if we are allowed to block. */
+static inline bool utp_irq_completion(void)
+{
+	return UFS_IRQ_COMPLETION && !in_critical_section();
+}
+
 int utp_poll_utrd_complete(struct ufs_dev *dev)
 {
 	int ret;
@@ -309,12 +316,22 @@ static int utp_enqueue_utrd(struct ufs_dev *dev, struct utp_utrd_req_build_type
 	// print IS after write
 	ufs_dump_is_register(dev);
 #endif
-	ret = utp_poll_utrd_complete(dev);
+	if (utp_irq_completion())
+		ret = event_wait_timeout(&utrd_evt, UTP_IRQ_WAIT_TIMEOUT);
+	else
+		ret = utp_poll_utrd_complete(dev);
 
 	if (ret == ERR_TIMED_OUT)
 	{
 		/* Transaction not completed even after timeout ms. */
 		dprintf(CRITICAL, "%s:%d Transaction timeout after polling %d times\n",__func__, __LINE__, UTP_MAX_COMMAND_RETRY);
+
+		/* The request node lives on our stack, take it off the list. */
+		enter_critical_section();
+		if (list_in_list(&(req.list_node)))
+			list_delete(&(req.list_node));
+		exit_critical_section();
+
 		ret = utp_utrd_process_timeout_req(dev, utrd_req, &req);
 		goto utp_enqueue_utrd_err;
 	}
@@ -516,3 +533,258 @@ utp_enqueue_upiu_err:
 	free(req_upiu);
 	return ret;
 }
+
+/* Queued slots are spaced so that no two in flight UTRDs share a cache line,
+ * otherwise cleaning one slot's UTRD could write a stale copy over the
+ * completion status the controller just wrote into its neighbour.
+ */
+#define UTP_QUEUE_SLOT_STRIDE MAX(1, CACHE_LINE / sizeof(struct utp_trans_req_desc))
+
+static inline struct upiu_cmd_hdr *utp_queue_slot_upiu(struct ufs_dev *dev, int slot)
+{
+	return (struct upiu_cmd_hdr *) (dev->utrd_queue.slot_desc_base + slot * UTP_QUEUE_SLOT_DESC_LEN);
+}
+
+static inline struct utp_trans_req_desc *utp_queue_slot_utrd(struct ufs_dev *dev, int slot)
+{
+	return (struct utp_trans_req_desc *) ((addr_t) dev->utrd_data.list_base_addr + slot * sizeof(struct utp_trans_req_desc));
+}
+
+int utp_queue_init(struct ufs_dev *dev)
+{
+	struct ufs_utp_queue *queue = &dev->utrd_queue;
+	struct upiu_cmd_hdr  *upiu;
+	int                  slot;
+
+	memset(queue, 0, sizeof(struct ufs_utp_queue));
+	event_init(&queue->event, false, EVENT_FLAG_AUTOUNSIGNAL);
+
+	queue->slot_desc_base = (addr_t) memalign(lcm(CACHE_LINE, UTP_CMD_DESC_BASE_ALIGNMENT_SIZE),
+											  UFS_MAX_UTRD_SLOTS * UTP_QUEUE_SLOT_DESC_LEN);
+	if (!queue->slot_desc_base)
+	{
+		dprintf(CRITICAL, "%s:%d Unable to allocate queue command descriptors\n", __func__, __LINE__);
+		return -UFS_FAILURE;
+	}
+
+	queue->depth = MIN(UTP_QUEUE_DEPTH, UFS_MAX_UTRD_SLOTS / UTP_QUEUE_SLOT_STRIDE);
+
+	/* Pre-build the parts of each command UPIU that never change. */
+	memset((void *) queue->slot_desc_base, 0, UFS_MAX_UTRD_SLOTS * UTP_QUEUE_SLOT_DESC_LEN);
+	for (slot = 0; slot < UFS_MAX_UTRD_SLOTS; slot++)
+	{
+		upiu = utp_queue_slot_upiu(dev, slot);
+		upiu->basic_hdr.trans_type   = UPIU_TYPE_COMMAND;
+		upiu->basic_hdr.cmd_set_type = UPIU_SCSI_CMD_SET;
+	}
+
+	return UFS_SUCCESS;
+}
+
+int utp_queue_get_slot(struct ufs_dev *dev)
+{
+	struct ufs_utp_queue *queue = &dev->utrd_queue;
+	uint32_t             busy;
+	int                  slot = -1;
+	int                  i;
+
+	if ((uint32_t) __builtin_popcount(queue->outstanding) >= queue->depth)
+		return -1;
+
+	if (mutex_acquire(&(dev->utrd_data.bitmap_mutex)))
+		return -1;
+
+	busy = readl(UFS_UTRLDBR(dev->base)) | dev->utrd_data.bitmap;
+	for (i = 0; i < UFS_MAX_UTRD_SLOTS; i += UTP_QUEUE_SLOT_STRIDE)
+	{
+		if (!(busy & (1 << i)))
+		{
+			dev->utrd_data.bitmap |= 1 << i;
+			slot = i;
+			break;
+		}
+	}
+
+	mutex_release(&(dev->utrd_data.bitmap_mutex));
+
+	return slot;
+}
+
+uint8_t *utp_queue_prep(struct ufs_dev *dev, int slot, uint8_t lun, uint8_t flags,
+						enum upiu_dd_type dd, addr_t buf, uint32_t len)
+{
+	struct upiu_cmd_hdr            *upiu = utp_queue_slot_upiu(dev, slot);
+	struct upiu_req_build_type     upiu_data;
+	struct utp_utrd_req_build_type utrd;
+	uint32_t                       num_prdt;
+
+	ASSERT(len <= UTP_QUEUE_MAX_XFER_LEN);
+
+	/* Only the per command fields, the rest was set up in utp_queue_init(). */
+	upiu->basic_hdr.flags    = flags;
+	upiu->basic_hdr.lun      = lun;
+	upiu->basic_hdr.task_tag = atomic_add((int *) &(dev->utrd_data.task_id), 1);
+	upiu->data_expected_len  = BE32(len);
+
+	num_prdt = ROUNDUP(len, UTP_MAX_PRD_DATA_BYTE_CNT) >> UTP_MAX_PRD_DATA_BYTE_CNT_BYTE_SHIFT;
+
+	upiu_data.data_buffer_addr  = buf;
+	upiu_data.expected_data_len = len;
+	utp_fill_prdt_entries(&upiu_data, (struct utp_prdt_entry *) ((addr_t) upiu + UTP_QUEUE_PRDT_OFFSET));
+
+	utrd.cmd_type      = UTRD_SCSCI_CMD;
+	utrd.dd            = dd;
+	utrd.irq           = UTRD_IRQ_CMD;
+	utrd.ocs           = UTRD_OCS_INVALID_OCS_VALUE;
+	utrd.req_upiu      = (struct upiu_basic_hdr *) upiu;
+	utrd.req_upiu_len  = UPIU_HDR_LEN;
+	utrd.resp_upiu_len = UTP_QUEUE_PRDT_OFFSET - UTP_QUEUE_RESP_OFFSET;
+	utrd.prdt_offset   = UTP_QUEUE_PRDT_OFFSET;
+	utrd.prdt_len      = num_prdt;
+	utp_enqueue_utrd_fill_desc(utp_queue_slot_utrd(dev, slot), &utrd);
+
+	/* The CDB lives in the UPIU, no copy from the caller's stack. */
+	memset(upiu->param, 0, sizeof(upiu->param));
+	return upiu->param;
+}
+
+void utp_queue_ring(struct ufs_dev *dev, uint32_t slots)
+{
+	struct ufs_utp_queue *queue = &dev->utrd_queue;
+	bigtime_t            now;
+	uint32_t             depth;
+	uint32_t             pending;
+	int                  slot;
+
+	/* Flush the command descriptors, the UTRDs were flushed when filled. */
+	for (pending = slots; pending; pending &= pending - 1)
+	{
+		slot = __builtin_ctz(pending);
+		arch_clean_invalidate_cache_range((addr_t) utp_queue_slot_upiu(dev, slot), UTP_QUEUE_SLOT_DESC_LEN);
+	}
+
+	dsb();
+
+	now = current_time_hires();
+	for (pending = slots; pending; pending &= pending - 1)
+		queue->issue_time[__builtin_ctz(pending)] = now;
+
+	queue->outstanding |= slots;
+
+	utp_ring_door_bell(UFS_UTRLDBR(dev->base), slots);
+
+	dsb();
+
+	depth = __builtin_popcount(queue->outstanding);
+	queue->stats.doorbells++;
+	queue->stats.depth_sum += depth;
+	if (depth > queue->stats.max_depth)
+		queue->stats.max_depth = depth;
+}
+
+static void utp_queue_account(struct ufs_queue_stats *stats, uint32_t lat_us)
+{
+	uint32_t bucket;
+
+	bucket = lat_us ? 32 - __builtin_clz(lat_us) : 0;
+	if (bucket >= UFS_QUEUE_LAT_BUCKETS)
+		bucket = UFS_QUEUE_LAT_BUCKETS - 1;
+
+	stats->cmds++;
+	stats->lat_hist[bucket]++;
+	stats->lat_sum_us += lat_us;
+	if (lat_us > stats->lat_max_us)
+		stats->lat_max_us = lat_us;
+}
+
+int utp_queue_reap(struct ufs_dev *dev, uint32_t *done, uint32_t *failed, uint8_t *status)
+{
+	struct ufs_utp_queue          *queue = &dev->utrd_queue;
+	struct utp_trans_req_desc     *desc;
+	struct upiu_basic_hdr         *resp;
+	struct utp_bitmap_access_type bitmap_req;
+	bigtime_t                     now;
+	time_t                        start;
+	uint32_t                      completed;
+	uint32_t                      pending;
+	uint32_t                      retry = 0;
+	bool                          timed_out;
+	int                           slot;
+
+	*done   = 0;
+	*failed = 0;
+	*status = SCSI_STATUS_GOOD;
+
+	if (!queue->outstanding)
+		return UFS_SUCCESS;
+
+	start = current_time();
+
+	/* Slots complete when the controller clears their doorbell bit. */
+	while (!(completed = queue->outstanding & ~readl(UFS_UTRLDBR(dev->base))))
+	{
+		if (utp_irq_completion())
+		{
+			/* A completion racing with the doorbell read leaves the event
+			 * signalled, so this cannot miss a wakeup.
+			 */
+			event_wait_timeout(&queue->event, UTP_IRQ_WAIT_TIMEOUT);
+			timed_out = (current_time() - start) >= UTP_IRQ_WAIT_TIMEOUT;
+		}
+		else
+		{
+			udelay(1);
+			timed_out = (++retry == UTP_MAX_COMMAND_RETRY);
+		}
+
+		if (timed_out && !(queue->outstanding & ~readl(UFS_UTRLDBR(dev->base))))
+		{
+			dprintf(CRITICAL, "%s:%d Queued commands 0x%x never completed.\n", __func__, __LINE__, queue->outstanding);
+			writel(~queue->outstanding, UFS_UTRLCLR(dev->base));
+			completed = queue->outstanding;
+			*failed   = completed;
+			break;
+		}
+	}
+
+	/* Don't leave a stale completion status behind for the single slot path. */
+	writel(UFS_IS_UTRCS, UFS_IS(dev->base));
+	dsb();
+
+	now = current_time_hires();
+	queue->stats.reaps++;
+
+	for (pending = completed; pending; pending &= pending - 1)
+	{
+		slot = __builtin_ctz(pending);
+		desc = utp_queue_slot_utrd(dev, slot);
+		resp = (struct upiu_basic_hdr *) ((addr_t) utp_queue_slot_upiu(dev, slot) + UTP_QUEUE_RESP_OFFSET);
+
+		arch_invalidate_cache_range((addr_t) desc, sizeof(struct utp_trans_req_desc));
+		arch_invalidate_cache_range((addr_t) resp, UPIU_HDR_LEN);
+
+		if (desc->overall_cmd_status != UTRD_OCS_SUCCESS || resp->status != SCSI_STATUS_GOOD)
+		{
+			dprintf(CRITICAL, "%s:%d slot %d failed ocs = %x status = %x\n", __func__, __LINE__,
+					slot, desc->overall_cmd_status, resp->status);
+			*failed |= 1 << slot;
+			*status  = resp->status;
+		}
+
+		if (*failed & (1 << slot))
+			queue->stats.errors++;
+
+		utp_queue_account(&queue->stats, now - queue->issue_time[slot]);
+
+		/* Signal slot as free. */
+		bitmap_req.bitmap        = &dev->utrd_data.bitmap;
+		bitmap_req.door_bell_bit = 1 << slot;
+		bitmap_req.mutx          = &(dev->utrd_data.bitmap_mutex);
+		utp_remove_from_bitmap(&bitmap_req);
+	}
+
+	queue->outstanding &= ~completed;
+	*done = completed;
+
+	return *failed ? -UFS_FAILURE : UFS_SUCCESS;
+}
@@ -16,6 +16,11 @@ ENABLE_BOOT_CONFIG_SUPPORT := 1
 
 MODULES += app/aboot
 
+# storage benchmark, overwrites the partition it is pointed at
+ifneq ($(TARGET_BUILD_VARIANT),user)
+MODULES += app/storagebench
+endif
+
 #DEFINES += WITH_DEBUG_DCC=1
 DEFINES += WITH_DEBUG_UART=1
 #DEFINES += WITH_DEBUG_FBCON=1
@@ -6,6 +6,11 @@ TARGET := msm8916
 
 MODULES += app/aboot
 
+# driver tests and benches, "fastboot oem run-test <name>"
+ifneq ($(TARGET_BUILD_VARIANT),user)
+MODULES += app/tests
+endif
+
 ifeq ($(TARGET_BUILD_VARIANT),user)
 DEBUG := 0
 else
@@ -0,0 +1,9 @@
+# top level project rules for the msm8916_smp project, msm8916 with
+# the scheduler on all four cores, "fastboot oem run-test smp"
+#
+LOCAL_DIR := $(GET_LOCAL_DIR)
+
+WITH_SMP := 1
+SMP_MAX_CPUS := 4
+
+include $(LOCAL_DIR)/msm8916.mk
@@ -7,6 +7,21 @@ TARGET := msm8994
 MODULES += app/aboot
 MODULES += app/rpmbtests
 
+# storage benchmark, overwrites the partition it is pointed at
+ifneq ($(TARGET_BUILD_VARIANT),user)
+MODULES += app/storagebench
+endif
+
+# fastboot session replay, runs the replayed commands for real
+ifneq ($(TARGET_BUILD_VARIANT),user)
+MODULES += app/fastbootreplay
+endif
+
+# driver tests and benches, "fastboot oem run-test <name>"
+ifneq ($(TARGET_BUILD_VARIANT),user)
+MODULES += app/tests
+endif
+
 ifeq ($(TARGET_BUILD_VARIANT),user)
 DEBUG := 0
 else
@@ -309,7 +309,7 @@ void *target_mmc_device()
 
 void target_sdc_init()
 {
-	struct mmc_config_data config;
+	struct mmc_config_data config = {0};
 
 	/* Set drive strength & pull ctrl values */
 	set_sdc_power_ctrl();
@@ -162,7 +162,7 @@ int target_is_emmc_boot(void)
 
 void target_sdc_init()
 {
-	struct mmc_config_data config;
+	struct mmc_config_data config = {0};
 
 	/* Set drive strength & pull ctrl values */
 	set_sdc_power_ctrl();
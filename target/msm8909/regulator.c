@@ -85,10 +85,17 @@ static uint32_t ldo17[][11]=
 
 void regulator_enable()
 {
-	rpm_send_data(&ldo2[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
+	int errors = 0;
 
-	rpm_send_data(&ldo17[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
-
-	rpm_send_data(&ldo6[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
+	/* All votes go out back to back, then the acks are collected */
+	if (rpm_send_data_nowait(&ldo2[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
+	if (rpm_send_data_nowait(&ldo17[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
+	if (rpm_send_data_nowait(&ldo6[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
 
+	errors += rpm_wait_for_acks();
+	if (errors)
+		dprintf(CRITICAL, "%d LDO vote(s) failed\n", errors);
 }
@@ -47,6 +47,7 @@
 #include <platform/clock.h>
 #include <crypto5_wrapper.h>
 #include <partition_parser.h>
+#include <err.h>
 #include <stdlib.h>
 
 #if LONG_PRESS_POWER_ON
@@ -93,12 +94,15 @@ void target_early_init(void)
 {
 #if WITH_DEBUG_UART
 	uart_dm_init(2, 0, BLSP1_UART1_BASE);
+#if UART_DM_TX_BUFFERED
+	uart_dm_tx_irq_init(BLSP1_UART1_BASE, BLSP1_UART_IRQ(1));
+#endif
 #endif
 }
 
 void target_sdc_init()
 {
-	struct mmc_config_data config;
+	struct mmc_config_data config = {0};
 
 	/* Set drive strength & pull ctrl values */
 	set_sdc_power_ctrl();
@@ -133,15 +137,18 @@ void *target_mmc_device()
 	return (void *) dev;
 }
 
-/* Return 1 if vol_up pressed */
-static int target_volume_up()
+static void target_volume_up_config()
 {
-	uint8_t status = 0;
-
 	gpio_tlmm_config(TLMM_VOL_UP_BTN_GPIO, 0, GPIO_INPUT, GPIO_PULL_UP, GPIO_2MA, GPIO_ENABLE);
 
 	/* Wait for the gpio config to take effect - debounce time */
 	thread_sleep(10);
+}
+
+/* Return 1 if vol_up pressed */
+static int target_volume_up()
+{
+	uint8_t status = 0;
 
 	/* Get status of GPIO */
 	status = gpio_status(TLMM_VOL_UP_BTN_GPIO);
@@ -157,15 +164,20 @@ uint32_t target_volume_down()
 	return pm8x41_resin_status();
 }
 
+static int target_volume_down_state()
+{
+	return !!target_volume_down();
+}
+
 static void target_keystatus()
 {
 	keys_init();
 
-	if(target_volume_down())
-		keys_post_event(KEY_VOLUMEDOWN, 1);
+	target_volume_up_config();
 
-	if(target_volume_up())
-		keys_post_event(KEY_VOLUMEUP, 1);
+	/* No GPIO/PMIC interrupt is routed here, keys are sampled on demand */
+	keys_add_source(KEY_VOLUMEDOWN, target_volume_down_state);
+	keys_add_source(KEY_VOLUMEUP, target_volume_up);
 }
 
 #if USER_FORCE_RESET_SUPPORT
@@ -185,10 +197,16 @@ uint32_t is_user_force_reset(void)
 }
 #endif
 
+static int target_read_ptable(void *arg)
+{
+	return partition_read_table() ? ERR_IO : NO_ERROR;
+}
+
 void target_init(void)
 {
 	uint32_t base_addr;
 	uint8_t slot;
+	work_t ptable_work;
 
 	dprintf(INFO, "target_init()\n");
 
@@ -197,7 +215,10 @@ void target_init(void)
 	target_keystatus();
 
 	target_sdc_init();
-	if (partition_read_table())
+
+	/* Read the partition table while the power key and vibrator are handled */
+	work_init(&ptable_work, target_read_ptable, NULL, NULL);
+	if (mmc_queue_work(&ptable_work, mmc_boot_reads()) && target_read_ptable(NULL))
 	{
 		dprintf(CRITICAL, "Error reading the partition table info\n");
 		ASSERT(0);
@@ -214,6 +235,12 @@ void target_init(void)
 
 	if (target_use_signed_kernel())
 		target_crypto_init_params();
+
+	if (mmc_boot_reads_wait())
+	{
+		dprintf(CRITICAL, "Error reading the partition table info\n");
+		ASSERT(0);
+	}
 }
 
 void target_serialno(unsigned char *buf)
@@ -12,8 +12,10 @@ BASE_ADDR        := 0x80000000
 SCRATCH_ADDR     := 0x90000000
 
 DEFINES += DISPLAY_SPLASH_SCREEN=1
+DEFINES += DISPLAY_INIT_ASYNC=1
 DEFINES += DISPLAY_TYPE_MIPI=1
 DEFINES += DISPLAY_TYPE_DSI6G=1
+DEFINES += UART_DM_TX_BUFFERED=1
 
 MODULES += \
 	dev/keys \
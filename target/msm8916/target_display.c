@@ -117,7 +117,7 @@ int target_backlight_ctrl(struct backlight *bl, uint8_t enable)
 		pm_pwm_enable(false);
 		pm8x41_enable_mpp(&mpp, MPP_DISABLE);
 	}
-	mdelay(20);
+	msm_display_delay(20);
 	return 0;
 }
 
@@ -371,7 +371,7 @@ int target_panel_reset(uint8_t enable, struct panel_reset_sequence *resetseq,
 				gpio_set_dir(reset_gpio.pin_id, GPIO_STATE_LOW);
 			else
 				gpio_set_dir(reset_gpio.pin_id, GPIO_STATE_HIGH);
-			mdelay(resetseq->sleep[i]);
+			msm_display_delay(resetseq->sleep[i]);
 		}
 	} else if(!target_cont_splash_screen()) {
 		gpio_set_dir(reset_gpio.pin_id, 0);
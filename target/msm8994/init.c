@@ -46,6 +46,7 @@
 #include <hsusb.h>
 #include <clock.h>
 #include <partition_parser.h>
+#include <err.h>
 #include <scm.h>
 #include <platform/clock.h>
 #include <platform/gpio.h>
@@ -89,6 +90,9 @@ static uint32_t mmc_sdhci_base[] =
 static uint32_t  mmc_sdc_pwrctl_irq[] =
 	{ SDCC1_PWRCTL_IRQ, SDCC2_PWRCTL_IRQ };
 
+static uint32_t  mmc_sdc_irq[] =
+	{ SDCC1_IRQ, SDCC2_IRQ };
+
 struct mmc_device *dev;
 struct ufs_dev ufs_device;
 
@@ -99,13 +103,14 @@ void target_early_init(void)
 {
 #if WITH_DEBUG_UART
 	uart_dm_init(2, 0, BLSP1_UART1_BASE);
+#if UART_DM_TX_BUFFERED
+	uart_dm_tx_irq_init(BLSP1_UART1_BASE, BLSP1_UART_IRQ(1));
+#endif
 #endif
 }
 
-/* Return 1 if vol_up pressed */
-static int target_volume_up()
+static void target_volume_up_config()
 {
-	uint8_t status = 0;
 	struct pm8x41_gpio gpio;
 
 	/* Configure the GPIO */
@@ -118,6 +123,12 @@ static int target_volume_up()
 
 	/* Wait for the pmic gpio config to take effect */
 	thread_sleep(1);
+}
+
+/* Return 1 if vol_up pressed */
+static int target_volume_up()
+{
+	uint8_t status = 0;
 
 	/* Get status of P_GPIO_5 */
 	pm8x41_gpio_get(3, &status);
@@ -131,15 +142,20 @@ uint32_t target_volume_down()
 	return pm8x41_resin_status();
 }
 
+static int target_volume_down_state()
+{
+	return !!target_volume_down();
+}
+
 static void target_keystatus()
 {
 	keys_init();
 
-	if(target_volume_down())
-		keys_post_event(KEY_VOLUMEDOWN, 1);
+	target_volume_up_config();
 
-	if(target_volume_up())
-		keys_post_event(KEY_VOLUMEUP, 1);
+	/* PMIC interrupts are not routed here, keys are sampled on demand */
+	keys_add_source(KEY_VOLUMEDOWN, target_volume_down_state);
+	keys_add_source(KEY_VOLUMEUP, target_volume_up);
 }
 
 void target_uninit(void)
@@ -273,6 +289,7 @@ void target_sdc_init()
 	config.sdhc_base = mmc_sdhci_base[config.slot - 1];
 	config.pwrctl_base = mmc_pwrctl_base[config.slot - 1];
 	config.pwr_irq     = mmc_sdc_pwrctl_irq[config.slot - 1];
+	config.hc_irq      = mmc_sdc_irq[config.slot - 1];
 	config.hs400_support = 1;
 
 	/* Set drive strength & pull ctrl values */
@@ -286,6 +303,7 @@ void target_sdc_init()
 		config.sdhc_base = mmc_sdhci_base[config.slot - 1];
 		config.pwrctl_base = mmc_pwrctl_base[config.slot - 1];
 		config.pwr_irq     = mmc_sdc_pwrctl_irq[config.slot - 1];
+		config.hc_irq      = mmc_sdc_irq[config.slot - 1];
 
 		/* Set drive strength & pull ctrl values */
 		set_sdc_power_ctrl(config.slot);
@@ -306,8 +324,16 @@ void *target_mmc_device()
 		return (void *) &ufs_device;
 }
 
+static int target_read_ptable(void *arg)
+{
+	mmc_read_partition_table(0);
+	return NO_ERROR;
+}
+
 void target_init(void)
 {
+	work_t ptable_work;
+
 	dprintf(INFO, "target_init()\n");
 
 	spmi_init(PMIC_ARB_CHANNEL_NUM, PMIC_ARB_OWNER_ID);
@@ -330,10 +356,16 @@ void target_init(void)
 		ufs_init(&ufs_device);
 	}
 
-	/* Storage initialization is complete, read the partition table info */
-	mmc_read_partition_table(0);
+	/* Storage initialization is complete, read the partition table info
+	 * on the storage worker while the RPM channel comes up
+	 */
+	work_init(&ptable_work, target_read_ptable, NULL, NULL);
+	if (mmc_queue_work(&ptable_work, mmc_boot_reads()))
+		mmc_read_partition_table(0);
 
 	rpm_smd_init();
+
+	mmc_boot_reads_wait();
 }
 
 unsigned board_machtype(void)
@@ -27,6 +27,7 @@
  *
  */
 
+#include <debug.h>
 #include <regulator.h>
 #include <rpm-smd.h>
 
@@ -101,13 +102,21 @@ static uint32_t ldo28[][11]=
 
 void regulator_enable()
 {
-	rpm_send_data(&ldo2[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
-
-	rpm_send_data(&ldo12[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
-
-	rpm_send_data(&ldo14[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
-
-	rpm_send_data(&ldo28[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE);
+	int errors = 0;
+
+	/* All votes go out back to back, then the acks are collected */
+	if (rpm_send_data_nowait(&ldo2[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
+	if (rpm_send_data_nowait(&ldo12[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
+	if (rpm_send_data_nowait(&ldo14[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
+	if (rpm_send_data_nowait(&ldo28[GENERIC_ENABLE][0], 36, RPM_REQUEST_TYPE))
+		errors++;
+
+	errors += rpm_wait_for_acks();
+	if (errors)
+		dprintf(CRITICAL, "%d LDO vote(s) failed\n", errors);
 }
 
 void regulator_disable()
@@ -13,8 +13,10 @@ BASE_ADDR    := 0x0000000
 SCRATCH_ADDR := 0x10000000
 
 DEFINES += DISPLAY_SPLASH_SCREEN=1
+DEFINES += DISPLAY_INIT_ASYNC=1
 DEFINES += DISPLAY_TYPE_MIPI=1
 DEFINES += DISPLAY_TYPE_DSI6G=1
+DEFINES += UART_DM_TX_BUFFERED=1
 
 MODULES += \
 	dev/keys \
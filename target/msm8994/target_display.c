@@ -115,7 +115,7 @@ static int msm8994_pwm_backlight_ctrl(uint8_t enable)
 
 		 /* LPG_ENABLE_CONTROL */
                 pm8x41_lpg_write_sid(slave_id, PWM_BL_LPG_CHAN_ID, 0x46, 0x0);
-		mdelay(100);
+		msm_display_delay(100);
 
 		 /* LPG_VALUE_LSB, duty cycle = 0x80/0x200 = 1/4 */
                 pm8x41_lpg_write_sid(slave_id, PWM_BL_LPG_CHAN_ID, 0x44, 0x80);
@@ -222,7 +222,7 @@ int target_backlight_ctrl(struct backlight *bl, uint8_t enable)
 			pm8x41_enable_mpp(&mpp, MPP_DISABLE);
 		}
 		/* Need delay before power on regulators */
-		mdelay(20);
+		msm_display_delay(20);
 		/* Enable WLED backlight control */
 		ret = msm8994_wled_backlight_ctrl(enable);
 		break;
@@ -239,7 +239,7 @@ int target_backlight_ctrl(struct backlight *bl, uint8_t enable)
 			pm8x41_enable_mpp(&mpp, MPP_DISABLE);
 		}
 		/* Need delay before power on regulators */
-		mdelay(20);
+		msm_display_delay(20);
 		ret = msm8994_pwm_backlight_ctrl(enable);
 		break;
 	default:
@@ -315,7 +315,7 @@ int target_panel_reset(uint8_t enable, struct panel_reset_sequence *resetseq,
 				gpio_set(reset_gpio.pin_id, GPIO_STATE_LOW);
 			else
 				gpio_set(reset_gpio.pin_id, GPIO_STATE_HIGH);
-			mdelay(resetseq->sleep[i]);
+			msm_display_delay(resetseq->sleep[i]);
 		}
 		lcd_bklt_reg_enable();
 	} else {
@@ -386,10 +386,10 @@ int target_ldo_ctrl(uint8_t enable, struct msm_panel_info *pinfo)
 {
 	if (enable) {
 		regulator_enable();	/* L2, L12, L14, and L28 */
-		mdelay(10);
+		msm_display_delay(10);
 		wled_init(pinfo);
 		qpnp_ibb_enable(true);	/* +5V and -5V */
-		mdelay(50);
+		msm_display_delay(50);
 
 		if (pinfo->lcd_reg_en)
 			lcd_reg_enable();